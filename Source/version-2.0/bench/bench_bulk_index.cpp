@@ -0,0 +1,91 @@
+// Bulk indexing benchmark: docs/sec of a full reindex through BulkIndexer at
+// 1 / 2 / 4 / 8 requests in flight, against the old approach of one _bulk
+// request carrying every document. Each run writes into a fresh media_bench
+// index, which is dropped at the end.
+//
+//   BENCH_OPENSEARCH_URL=http://localhost:9200 ./bench_bulk_index [docs]
+
+#include "src/infrastructure/search/BulkIndexer.h"
+#include <curl/curl.h>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+constexpr const char* kIndex = "media_bench";
+
+// Shaped like the documents a reindex of the media table produces
+nlohmann::json makeDoc(size_t i) {
+    bool magazine = i % 4 == 3;
+    std::string title = (magazine ? "Bench Magazine " : "Bench Book ") + std::to_string(i);
+    std::string author = magazine ? "Bench Press" : "Author " + std::to_string(i % 1000);
+    return {
+        {"id", i + 1}, {"title", title}, {"author", author},
+        {"category", magazine ? "Magazine" : "Book"},
+        {"suggest", nlohmann::json::array({title, author})}
+    };
+}
+
+void request(const std::string& url, const char* method) {
+    CURL* curl = curl_easy_init();
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION,
+                     +[](char*, size_t size, size_t nmemb, void*) { return size * nmemb; });
+    curl_easy_perform(curl);
+    curl_easy_cleanup(curl);
+}
+
+void run(const std::string& baseUrl, const std::string& name, size_t docs, BulkIndexerOptions options) {
+    request(baseUrl + "/" + kIndex, "DELETE");
+    request(baseUrl + "/" + kIndex, "PUT");
+
+    options.index = kIndex;
+    auto start = Clock::now();
+    BulkIndexStats stats;
+    {
+        BulkIndexer indexer(baseUrl, std::nullopt, options);
+        for (size_t i = 0; i < docs; ++i) indexer.add(makeDoc(i));
+        stats = indexer.close();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << std::left << std::setw(16) << name << std::setw(10) << docs
+              << std::fixed << std::setprecision(2) << seconds << "s  "
+              << std::setprecision(0) << std::setw(10) << stats.indexed / seconds << " docs/sec  "
+              << stats.requests << " requests, " << stats.retried << " retried, "
+              << stats.failed << " failed\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    const char* env = std::getenv("BENCH_OPENSEARCH_URL");
+    std::string url = env ? env : "http://localhost:9200";
+    size_t docs = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    BulkIndexerOptions single;
+    single.maxBatchBytes = std::numeric_limits<size_t>::max();
+    single.maxBatchDocs = std::numeric_limits<size_t>::max();
+    single.concurrency = 1;
+    single.maxRetries = 0;
+    run(url, "single-request", docs, single);
+
+    for (size_t inFlight : {1, 2, 4, 8}) {
+        BulkIndexerOptions options;
+        options.concurrency = inFlight;
+        run(url, "in-flight=" + std::to_string(inFlight), docs, options);
+    }
+
+    request(url + "/" + kIndex, "DELETE");
+    curl_global_cleanup();
+    return 0;
+}
@@ -0,0 +1,132 @@
+// Cache invalidation benchmark: dropping a group of keys from a large
+// keyspace three ways. The first is the old KEYS + DEL-per-key loop. The
+// second is RedisClient::invalidateByPrefix (SCAN + pipelined UNLINK) and
+// the third is invalidateTag (SSCAN of the group's tag set). While each
+// one runs, a probe thread times GETs of an unrelated key, which shows how
+// long Redis stops serving other clients. Keys live under bench_inv: and
+// are removed at the end.
+//
+//   BENCH_REDIS_HOST=localhost BENCH_REDIS_PORT=6379 ./bench_cache_invalidation [keys] [group]
+
+#include "src/infrastructure/cache/RedisClient.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+constexpr int kTtl = 3600;
+
+struct Run {
+    double millis = 0;
+    size_t removed = 0;
+    std::vector<double> probeMicros;
+};
+
+// Times fn while another thread keeps reading an unrelated key
+Run measure(RedisClient& client, const std::function<size_t()>& fn) {
+    std::atomic<bool> done{false};
+    Run run;
+    std::thread probe([&] {
+        while (!done) {
+            auto t0 = Clock::now();
+            client.get("bench_inv:probe");
+            run.probeMicros.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        }
+    });
+    auto start = Clock::now();
+    run.removed = fn();
+    run.millis = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    done = true;
+    probe.join();
+    return run;
+}
+
+void report(const std::string& name, Run& r) {
+    std::sort(r.probeMicros.begin(), r.probeMicros.end());
+    auto pct = [&](double p) {
+        if (r.probeMicros.empty()) return 0.0;
+        return r.probeMicros[static_cast<size_t>(p * static_cast<double>(r.probeMicros.size() - 1))];
+    };
+    std::cout << std::left << std::setw(22) << name << std::fixed << std::setprecision(1)
+              << std::setw(10) << r.millis << "ms  removed " << std::setw(9) << r.removed
+              << "probe p99 " << std::setw(9) << pct(0.99) / 1000 << "ms  max "
+              << pct(1.0) / 1000 << "ms\n";
+}
+
+// Loads [from, to) as bench_inv:<group>:<i>, 1000 keys per round trip
+void load(RedisClient& client, const std::string& group, size_t from, size_t to) {
+    std::vector<std::pair<std::string, std::string>> batch;
+    for (size_t i = from; i < to; ++i) {
+        batch.emplace_back("bench_inv:" + group + ":" + std::to_string(i), "v" + std::to_string(i));
+        if (batch.size() == 1000 || i + 1 == to) {
+            client.mset(batch, kTtl);
+            batch.clear();
+        }
+    }
+}
+
+// The implementation invalidateByPrefix replaced
+size_t keysThenDel(RedisClient& client, const std::string& host, int port, const std::string& prefix) {
+    size_t removed = 0;
+    redisContext* c = redisConnect(host.c_str(), port);
+    if (!c || c->err) return 0;
+    auto* keys = static_cast<redisReply*>(redisCommand(c, "KEYS %s", (prefix + "*").c_str()));
+    if (keys && keys->type == REDIS_REPLY_ARRAY) {
+        for (size_t i = 0; i < keys->elements; ++i)
+            removed += client.del(std::string(keys->element[i]->str, keys->element[i]->len));
+    }
+    if (keys) freeReplyObject(keys);
+    redisFree(c);
+    return removed;
+}
+
+}
+
+int main(int argc, char** argv) {
+    const char* hostEnv = std::getenv("BENCH_REDIS_HOST");
+    const char* portEnv = std::getenv("BENCH_REDIS_PORT");
+    std::string host = hostEnv ? hostEnv : "localhost";
+    int port = portEnv ? std::atoi(portEnv) : 6379;
+    size_t keys = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t group = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000;
+
+    RedisClient client(host, port);
+    if (!client.ping()) {
+        std::cerr << "Redis is not reachable\n";
+        return 1;
+    }
+
+    auto start = Clock::now();
+    load(client, "bg", 0, keys);
+    client.set("bench_inv:probe", "x", kTtl);
+    std::cout << "loaded " << keys << " keys in " << std::fixed << std::setprecision(1)
+              << std::chrono::duration<double>(Clock::now() - start).count() << "s; group of "
+              << group << "\n";
+
+    load(client, "grp", 0, group);
+    Run keysDel = measure(client, [&] { return keysThenDel(client, host, port, "bench_inv:grp:"); });
+    report("KEYS + DEL per key", keysDel);
+
+    load(client, "grp", 0, group);
+    Run scan = measure(client, [&] { return client.invalidateByPrefix("bench_inv:grp:").value_or(0); });
+    report("SCAN + UNLINK", scan);
+
+    for (size_t i = 0; i < group; ++i) {
+        std::string key = "bench_inv:grp:" + std::to_string(i);
+        client.setTagged(key, "v", kTtl, {"bench_inv_grp"});
+    }
+    Run tag = measure(client, [&] { return client.invalidateTag("bench_inv_grp").value_or(0); });
+    report("tag set", tag);
+
+    client.invalidateByPrefix("bench_inv:");
+    return 0;
+}
@@ -0,0 +1,95 @@
+// S3 listing benchmark: objects/sec for a full listing of a prefix with
+// many sub-prefixes, laid out like digital-media/<id>/v<n>. It lists once
+// page by page on one connection, then with ParallelLister at several
+// thread counts, and checks that every run saw the same objects. Needs an
+// S3 or MinIO endpoint (BENCH_S3_ENDPOINT, default http://localhost:9000)
+// with an existing bucket (BENCH_S3_BUCKET, default library-bench). The
+// objects are uploaded on the first run and reused after.
+//
+//   ./bench_s3_list [prefixes] [objects per prefix]
+
+#include "src/infrastructure/storage/ParallelLister.h"
+#include "src/infrastructure/storage/S3StorageClient.h"
+#include "src/utils/ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::string env(const char* name, const char* fallback) {
+    const char* value = std::getenv(name);
+    return value ? value : fallback;
+}
+
+void report(const std::string& label, size_t objects, Clock::duration elapsed) {
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    std::cout << label << ": " << objects << " objects in " << seconds * 1000 << " ms ("
+              << static_cast<size_t>(objects / seconds) << " objects/s)" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t prefixes = argc > 1 ? std::stoul(argv[1]) : 200;
+    size_t perPrefix = argc > 2 ? std::stoul(argv[2]) : 100;
+    const std::string root = "bench-list/";
+
+    auto storage = std::make_shared<S3StorageClient>(
+        env("BENCH_S3_ENDPOINT", "http://localhost:9000"), env("BENCH_S3_ACCESS_KEY", "minioadmin"),
+        env("BENCH_S3_SECRET_KEY", "minioadmin"), env("BENCH_S3_BUCKET", "library-bench"));
+    if (!storage->bucketExists()) {
+        std::cerr << "Bucket not reachable; create it first" << std::endl;
+        return 1;
+    }
+
+    size_t expected = prefixes * perPrefix;
+    size_t existing = 0;
+    storage->forEachObject(root, [&existing](const S3Object&) { ++existing; return true; });
+    if (existing < expected) {
+        std::cout << "Uploading " << expected << " objects..." << std::endl;
+        ThreadPool pool(32);
+        std::atomic<size_t> failed{0};
+        std::vector<std::future<void>> done;
+        for (size_t p = 0; p < prefixes; ++p) {
+            done.push_back(pool.submit([&, p] {
+                for (size_t i = 0; i < perPrefix; ++i) {
+                    std::string key = root + std::to_string(p) + "/v" + std::to_string(i) + ".bin";
+                    if (!storage->uploadFile(key, "x")) ++failed;
+                }
+            }));
+        }
+        for (auto& f : done) f.get();
+        if (failed) {
+            std::cerr << failed << " uploads failed" << std::endl;
+            return 1;
+        }
+    }
+
+    size_t baseline = 0;
+    auto start = Clock::now();
+    bool ok = storage->forEachObject(root, [&baseline](const S3Object&) { ++baseline; return true; });
+    report("sequential pages", baseline, Clock::now() - start);
+    if (!ok) return 1;
+
+    for (size_t threads : {1, 4, 16, 64}) {
+        ParallelLister::Options options;
+        options.threads = threads;
+        ParallelLister lister(storage, options);
+        size_t seen = 0;
+        start = Clock::now();
+        ok = lister.forEachObject(root, [&seen](const S3Object&) { ++seen; return true; });
+        report("parallel, " + std::to_string(threads) + " threads", seen, Clock::now() - start);
+        if (!ok || seen != baseline) {
+            std::cerr << "Listing mismatch: " << seen << " vs " << baseline << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
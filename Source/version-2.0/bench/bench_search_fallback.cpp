@@ -0,0 +1,184 @@
+// Search fallback benchmark: relevance and latency of the in-process
+// FullTextIndex against OpenSearch for the same documents and the same
+// query (OpenSearchClient::fuzzyQuery). Each query is two or three words
+// of a known title, half of them with a typo; a hit is the title's
+// document in the top 10. Also reports how many of OpenSearch's top 10
+// the local index returns. Documents go into a fresh media_bench_search
+// index, which is dropped at the end.
+//
+//   BENCH_OPENSEARCH_URL=http://localhost:9200 ./bench_search_fallback [docs] [queries]
+
+#include "src/infrastructure/http/HttpTransport.h"
+#include "src/infrastructure/search/FullTextIndex.h"
+#include "src/infrastructure/search/OpenSearchClient.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+constexpr const char* kIndex = "media_bench_search";
+
+struct Result {
+    std::vector<double> micros;
+    size_t found = 0;
+    double reciprocalRank = 0;
+};
+
+// Random words with a Zipf-like frequency, so common words have long
+// postings as they do in real titles
+class Words {
+public:
+    explicit Words(std::mt19937& rng) : rng_(rng) {
+        std::unordered_set<std::string> seen;
+        while (words_.size() < 50000) {
+            std::string w;
+            for (size_t i = 0, n = 3 + rng_() % 8; i < n; ++i) w += static_cast<char>('a' + rng_() % 26);
+            if (seen.insert(w).second) words_.push_back(w);
+        }
+    }
+
+    const std::string& pick() {
+        double u = std::uniform_real_distribution<double>(0, 1)(rng_);
+        // Inverse of a Zipf CDF with exponent ~1 over the vocabulary
+        auto i = static_cast<size_t>(std::pow(static_cast<double>(words_.size()), u)) - 1;
+        return words_[std::min(i, words_.size() - 1)];
+    }
+
+private:
+    std::mt19937& rng_;
+    std::vector<std::string> words_;
+};
+
+std::string typo(std::string word, std::mt19937& rng) {
+    if (word.size() < 5) return word;
+    // Never the first character: both engines fix it (prefix_length 1)
+    size_t i = 1 + rng() % (word.size() - 2);
+    std::swap(word[i], word[i + 1]);
+    return word;
+}
+
+std::vector<long> ids(const std::vector<nlohmann::json>& hits) {
+    std::vector<long> out;
+    for (const auto& h : hits) out.push_back(h.value("id", 0L));
+    return out;
+}
+
+void record(Result& r, double micros, const std::vector<long>& hits, long target) {
+    r.micros.push_back(micros);
+    auto it = std::find(hits.begin(), hits.end(), target);
+    if (it != hits.end()) {
+        ++r.found;
+        r.reciprocalRank += 1.0 / static_cast<double>(it - hits.begin() + 1);
+    }
+}
+
+void report(const std::string& name, Result& r) {
+    std::sort(r.micros.begin(), r.micros.end());
+    auto pct = [&](double p) { return r.micros[static_cast<size_t>(p * static_cast<double>(r.micros.size() - 1))]; };
+    double n = static_cast<double>(r.micros.size());
+    std::cout << std::left << std::setw(12) << name << std::fixed << std::setprecision(0)
+              << "p50 " << std::setw(8) << pct(0.5) << "p95 " << std::setw(8) << pct(0.95)
+              << "p99 " << std::setw(8) << pct(0.99) << "us  " << std::setprecision(3)
+              << "hit@10 " << static_cast<double>(r.found) / n << "  MRR " << r.reciprocalRank / n << "\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    const char* env = std::getenv("BENCH_OPENSEARCH_URL");
+    std::string url = env ? env : "http://localhost:9200";
+    size_t docs = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    size_t queries = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000;
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    std::mt19937 rng(42);
+    Words words(rng);
+
+    std::vector<FullTextIndex::Document> documents;
+    documents.reserve(docs);
+    for (size_t i = 0; i < docs; ++i) {
+        std::string title;
+        for (size_t w = 0, n = 2 + rng() % 5; w < n; ++w) title += (w ? " " : "") + words.pick();
+        bool magazine = i % 4 == 3;
+        documents.push_back({static_cast<long>(i + 1), title,
+                             words.pick() + " " + words.pick(), magazine ? "Magazine" : "Book"});
+    }
+
+    auto transport = std::make_shared<HttpTransport>();
+    OpenSearchClient client(url, std::nullopt, transport);
+    client.deleteIndex(kIndex);
+    if (!client.createIndex(kIndex, true)) {
+        std::cerr << "Cannot create " << kIndex << " at " << url << "\n";
+        return 1;
+    }
+    {
+        auto indexer = client.createBulkIndexer(kIndex);
+        for (const auto& d : documents)
+            indexer->add({{"id", d.id}, {"title", d.title}, {"author", d.author},
+                          {"category", d.category}, {"suggest", nlohmann::json::array({d.title, d.author})}});
+        indexer->close();
+    }
+    client.finishBulkLoad(kIndex);
+
+    FullTextIndex local;
+    auto start = Clock::now();
+    local.rebuild(documents);
+    std::cout << "local index build: " << std::fixed << std::setprecision(2)
+              << std::chrono::duration<double>(Clock::now() - start).count() << "s for "
+              << docs << " docs\n";
+
+    Result remote, embedded;
+    double overlap = 0;
+    for (size_t q = 0; q < queries; ++q) {
+        const auto& target = documents[rng() % documents.size()];
+        auto terms = FullTextIndex::tokenize(target.title);
+        size_t first = rng() % terms.size();
+        std::string text;
+        for (size_t i = first; i < std::min(terms.size(), first + 2 + rng() % 2); ++i)
+            text += (text.empty() ? "" : " ") + (q % 2 ? typo(terms[i], rng) : terms[i]);
+
+        std::string body = OpenSearchClient::fuzzyQuery(text, "AUTO", 0, 10).dump();
+        HttpRequest request;
+        request.method = "POST";
+        request.url = url + "/" + kIndex + "/_search";
+        request.headers.push_back("Content-Type: application/json");
+        request.body = body;
+        auto t0 = Clock::now();
+        HttpResponse response = transport->perform(request);
+        double remoteMicros = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+        std::vector<long> remoteIds;
+        auto parsed = nlohmann::json::parse(response.body, nullptr, false);
+        if (!parsed.is_discarded() && parsed.contains("hits"))
+            for (const auto& hit : parsed["hits"]["hits"]) remoteIds.push_back(hit["_source"].value("id", 0L));
+        record(remote, remoteMicros, remoteIds, target.id);
+
+        t0 = Clock::now();
+        auto localIds = ids(local.search(text, "AUTO", 0, 10));
+        record(embedded, std::chrono::duration<double, std::micro>(Clock::now() - t0).count(),
+               localIds, target.id);
+
+        if (!remoteIds.empty()) {
+            std::unordered_set<long> mine(localIds.begin(), localIds.end());
+            size_t shared = 0;
+            for (long id : remoteIds) shared += mine.count(id);
+            overlap += static_cast<double>(shared) / static_cast<double>(remoteIds.size());
+        }
+    }
+
+    report("opensearch", remote);
+    report("local", embedded);
+    std::cout << "top-10 overlap: " << std::setprecision(3) << overlap / static_cast<double>(queries) << "\n";
+
+    client.deleteIndex(kIndex);
+    curl_global_cleanup();
+    return 0;
+}
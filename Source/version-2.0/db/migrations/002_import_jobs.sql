@@ -0,0 +1,41 @@
+-- Migration: Asynchronous import jobs
+-- An upload is split into chunks that workers claim with SKIP LOCKED.
+-- A chunk is marked DONE in the same transaction that writes its rows,
+-- so a crashed import resumes from the first unfinished chunk.
+
+CREATE TABLE IF NOT EXISTS import_job (
+    id BIGSERIAL PRIMARY KEY,
+    format TEXT NOT NULL CHECK (format IN ('csv', 'json')),
+    status TEXT NOT NULL DEFAULT 'QUEUED'
+        CHECK (status IN ('QUEUED', 'RUNNING', 'COMPLETED', 'FAILED')),
+    created_by INT REFERENCES users(id) ON DELETE SET NULL,
+    total_chunks INT NOT NULL DEFAULT 0,
+    rows_total BIGINT NOT NULL DEFAULT 0,
+    last_error TEXT,
+    created_at TIMESTAMPTZ DEFAULT CURRENT_TIMESTAMP,
+    started_at TIMESTAMPTZ,
+    finished_at TIMESTAMPTZ
+);
+
+CREATE INDEX IF NOT EXISTS idx_import_job_status ON import_job(status);
+
+CREATE TABLE IF NOT EXISTS import_job_chunk (
+    job_id BIGINT NOT NULL REFERENCES import_job(id) ON DELETE CASCADE,
+    chunk_no INT NOT NULL,
+    first_row BIGINT NOT NULL,           -- rows before this chunk, for error messages
+    row_count INT NOT NULL,
+    payload TEXT NOT NULL,               -- self-contained CSV (with header) or JSON array; cleared once done
+    status TEXT NOT NULL DEFAULT 'PENDING'
+        CHECK (status IN ('PENDING', 'RUNNING', 'DONE', 'FAILED')),
+    attempts INT NOT NULL DEFAULT 0,
+    rows_imported INT NOT NULL DEFAULT 0,
+    rows_failed INT NOT NULL DEFAULT 0,
+    errors JSONB NOT NULL DEFAULT '[]',
+    last_error TEXT,
+    claimed_at TIMESTAMPTZ,
+    finished_at TIMESTAMPTZ,
+    PRIMARY KEY (job_id, chunk_no)
+);
+
+CREATE INDEX IF NOT EXISTS idx_import_chunk_claimable
+    ON import_job_chunk(job_id, chunk_no) WHERE status IN ('PENDING', 'RUNNING');
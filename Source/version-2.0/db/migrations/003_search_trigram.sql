@@ -0,0 +1,7 @@
+-- Migration: Typo-tolerant PostgreSQL search
+-- Needed for SEARCH_TRIGRAM=1: titles similar to the query match even when
+-- no word does. Word matches use idx_media_title from schema.sql.
+
+CREATE EXTENSION IF NOT EXISTS pg_trgm;
+
+CREATE INDEX IF NOT EXISTS idx_media_title_trgm ON media USING gin (lower(title) gin_trgm_ops);
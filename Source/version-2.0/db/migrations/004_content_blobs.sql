@@ -0,0 +1,20 @@
+-- Migration: Content-addressed storage for digital media versions
+-- Needed for CONTENT_DEDUP=1 (and migration 001). Each distinct file is
+-- stored once, keyed by its SHA-256; versions point at it through
+-- digital_media_version.checksum. ref_count counts those versions. A blob
+-- whose count drops to zero is deleted by the garbage collector once it
+-- has stayed unreferenced for the grace period.
+
+CREATE TABLE IF NOT EXISTS content_blob (
+    sha256 TEXT PRIMARY KEY,
+    s3_key TEXT NOT NULL UNIQUE,
+    size BIGINT NOT NULL,
+    ref_count INT NOT NULL DEFAULT 0 CHECK (ref_count >= 0),
+    created_at TIMESTAMPTZ DEFAULT CURRENT_TIMESTAMP,
+    orphaned_at TIMESTAMPTZ              -- when ref_count last became 0; NULL while referenced
+);
+
+CREATE INDEX IF NOT EXISTS idx_content_blob_orphaned
+    ON content_blob(orphaned_at) WHERE ref_count = 0;
+
+CREATE INDEX IF NOT EXISTS idx_dmv_checksum ON digital_media_version(checksum);
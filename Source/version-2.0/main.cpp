@@ -3,6 +3,8 @@
 #include <csignal>
 #include <memory>
 #include <atomic>
+#include <algorithm>
+#include <chrono>
 
 #include <crow.h>
 #include <grpcpp/grpcpp.h>
@@ -12,7 +14,13 @@
 #include "src/infrastructure/db/MongoConnection.h"
 #include "src/infrastructure/queue/QueueWorker.h"
 #include "src/infrastructure/jwt/JwtHelper.h"
+#include "src/infrastructure/cache/NearCache.h"
 #include "src/infrastructure/cache/RedisClient.h"
+#include "src/infrastructure/cache/SearchCache.h"
+#include "src/infrastructure/http/HttpTransport.h"
+#include "src/infrastructure/storage/DiskCache.h"
+#include "src/infrastructure/storage/MediaBlobStore.h"
+#include "src/infrastructure/storage/MultipartUploader.h"
 #include "src/infrastructure/storage/S3StorageClient.h"
 #include "src/infrastructure/search/OpenSearchClient.h"
 #include "src/infrastructure/messaging/KafkaProducer.h"
@@ -25,6 +33,10 @@
 #include "src/application/services/PgQueueService.h"
 #include "src/application/services/DigitalMediaService.h"
 #include "src/application/services/BatchImportService.h"
+#include "src/application/services/ImportJobService.h"
+#include "src/application/services/ReindexService.h"
+#include "src/application/services/CatalogIndexService.h"
+#include "src/application/services/SearchService.h"
 #include "src/data/PostgresAdapter.h"
 #include "src/data/MongoAdapter.h"
 
@@ -37,6 +49,7 @@
 #include "src/api/controllers/DigitalMediaController.h"
 #include "src/api/controllers/BatchImportController.h"
 #include "src/api/controllers/MetricsController.h"
+#include "src/api/controllers/ReindexController.h"
 #include "src/api/grpc/LogServiceServer.h"
 
 // Global flag for graceful shutdown
@@ -58,27 +71,48 @@ int main() {
 
         // Initialize core infrastructure
 
+        // REST and import worker threads; the PostgreSQL pool is sized so every
+        // worker can hold a connection alongside the queue worker and gRPC service
+        unsigned restThreads = config.restThreads > 0
+            ? static_cast<unsigned>(config.restThreads)
+            : std::max(1u, std::thread::hardware_concurrency());
+        int importWorkers = std::max(1, config.importWorkers);
+        int pgPoolSize = config.postgresPoolSize > 0
+            ? config.postgresPoolSize
+            : static_cast<int>(restThreads) + importWorkers + 4;
+
         // PostgreSQL connection pool
         auto pgPool = std::make_shared<PostgresPool>();
-        pgPool->initialize(config.postgresUri);
-        auto pgConn = pgPool->acquire();
+        pgPool->initialize(config.postgresUri, pgPoolSize,
+                           std::chrono::milliseconds(config.postgresPoolTimeoutMs));
 
         // MongoDB connection
         auto mongoAdapter = std::make_shared<MongoAdapter>(config.mongoUri, config.mongoDb);
 
         // Redis cache
+        RedisClient::Options redisOptions;
+        redisOptions.poolSize = static_cast<size_t>(std::max(1, config.redisPoolSize));
+        redisOptions.connectTimeout = std::chrono::milliseconds(std::max(1, config.redisTimeoutMs));
+        redisOptions.commandTimeout = redisOptions.connectTimeout;
         auto redisClient = std::make_shared<RedisClient>(
-            config.redisHost, config.redisPort, config.redisPassword);
+            config.redisHost, config.redisPort, config.redisPassword, redisOptions);
         if (redisClient->ping()) {
             std::cout << "[Redis] Connected successfully.\n";
         } else {
             std::cerr << "[Redis] Connection failed, caching disabled.\n";
         }
 
+        // Outbound HTTP: one connection pool shared by S3 and OpenSearch
+        HttpTransport::Options httpOptions;
+        httpOptions.maxPerHost = static_cast<size_t>(std::max(1, config.httpMaxPerHost));
+        auto httpTransport = std::make_shared<HttpTransport>(httpOptions);
+
         // S3 / MinIO storage
+        SigV4Signer::Options signerOptions;
+        signerOptions.urlCacheSeconds = std::chrono::seconds(std::max(0, config.s3UrlCacheSeconds));
         auto s3Client = std::make_shared<S3StorageClient>(
             config.s3Endpoint, config.s3AccessKey, config.s3SecretKey,
-            config.s3Bucket, config.s3Region);
+            config.s3Bucket, config.s3Region, httpTransport, signerOptions);
         if (s3Client->bucketExists()) {
             std::cout << "[S3] Bucket '" << config.s3Bucket << "' ready.\n";
         } else {
@@ -86,7 +120,12 @@ int main() {
         }
 
         // OpenSearch
-        auto searchClient = std::make_shared<OpenSearchClient>(config.opensearchUrl);
+        auto searchClient = std::make_shared<OpenSearchClient>(
+            config.opensearchUrl, std::nullopt, httpTransport);
+        BulkIndexerOptions bulkOptions;
+        bulkOptions.concurrency = static_cast<size_t>(std::max(1, config.opensearchBulkConcurrency));
+        bulkOptions.maxBatchBytes = static_cast<size_t>(std::max(1, config.opensearchBulkMaxBytes));
+        searchClient->setBulkOptions(bulkOptions);
         searchClient->createIndexWithMapping();
         std::cout << "[OpenSearch] Index initialized.\n";
 
@@ -109,8 +148,8 @@ int main() {
         });
 
         // Queue + Worker
-        auto queueService = std::make_shared<PgQueueService>(pgConn);
-        auto persistentQueue = std::make_shared<PersistentQueue>(pgConn);
+        auto queueService = std::make_shared<PgQueueService>(pgPool);
+        auto persistentQueue = std::make_shared<PersistentQueue>(pgPool);
         auto queueWorker = std::make_shared<QueueWorker>(persistentQueue, mongoAdapter);
 
         std::thread workerThread([&]() {
@@ -136,14 +175,75 @@ int main() {
 
         // Initialize application services
 
-        auto dbAdapter = std::make_shared<PostgresAdapter>(pgConn);
+        auto dbAdapter = std::make_shared<PostgresAdapter>(pgPool);
         auto userService = std::make_shared<UserService>(dbAdapter);
         auto authService = std::make_shared<AuthService>(dbAdapter, jwtHelper);
         auto libraryService = std::make_shared<LibraryService>(dbAdapter, queueService, searchClient);
+        NearCache::Options nearCacheOptions;
+        nearCacheOptions.maxEntries = static_cast<size_t>(std::max(1, config.nearCacheEntries));
+        nearCacheOptions.localTtl = std::chrono::seconds(std::max(1, config.nearCacheTtlSeconds));
+        auto nearCache = std::make_shared<NearCache>(redisClient, nearCacheOptions);
+        nearCache->start();
+        MultipartUploader::Options uploadOptions;
+        uploadOptions.partSize = static_cast<size_t>(std::max(5, config.s3PartSizeMb)) * 1024 * 1024;
+        uploadOptions.partsInFlight = static_cast<size_t>(std::max(1, config.s3UploadParallelism));
+        uploadOptions.threads = uploadOptions.partsInFlight * 2;
+        auto uploader = std::make_shared<MultipartUploader>(s3Client, uploadOptions);
         auto digitalMediaService = std::make_shared<DigitalMediaService>(
-            dbAdapter, s3Client, kafkaProducer, redisClient);
+            dbAdapter, s3Client, kafkaProducer, nearCache, uploader);
+        digitalMediaService->setMaxResponseBytes(
+            static_cast<uint64_t>(std::max(1, config.downloadMaxChunkMb)) * 1024 * 1024);
+        if (!config.diskCacheDir.empty()) {
+            DiskCache::Options diskOptions;
+            diskOptions.directory = config.diskCacheDir;
+            diskOptions.maxBytes = static_cast<uint64_t>(std::max(1, config.diskCacheMaxMb)) * 1024 * 1024;
+            // Sized for about ten requests per cached object
+            if (config.diskCacheAdmission != "always")
+                diskOptions.admission = std::make_shared<TinyLfuAdmission>(100000);
+            digitalMediaService->setDiskCache(std::make_shared<DiskCache>(s3Client, diskOptions));
+        }
+        std::shared_ptr<MediaBlobStore> blobStore;
+        if (config.contentDedup) {
+            MediaBlobStore::Options blobOptions;
+            blobOptions.gcGrace = std::chrono::seconds(std::max(60, config.blobGcGraceSeconds));
+            blobOptions.gcInterval = std::chrono::seconds(std::max(10, config.blobGcIntervalSeconds));
+            blobStore = std::make_shared<MediaBlobStore>(
+                pgPool, s3Client, uploader, std::make_shared<ParallelLister>(s3Client), blobOptions);
+            blobStore->start();
+            digitalMediaService->setBlobStore(blobStore);
+        }
         auto batchImportService = std::make_shared<BatchImportService>(
             dbAdapter, searchClient, kafkaProducer);
+        auto importJobService = std::make_shared<ImportJobService>(
+            pgPool, batchImportService, static_cast<size_t>(importWorkers));
+        importJobService->start();
+        auto reindexService = std::make_shared<ReindexService>(dbAdapter, searchClient);
+        std::shared_ptr<SearchCache> searchCache;
+        if (config.searchCacheEntries > 0) {
+            SearchCache::Options cacheOptions;
+            cacheOptions.maxEntries = static_cast<size_t>(config.searchCacheEntries);
+            cacheOptions.redisTtlSeconds = std::max(1, config.searchCacheTtlSeconds);
+            cacheOptions.localTtl = std::min(cacheOptions.localTtl,
+                                             std::chrono::milliseconds(cacheOptions.redisTtlSeconds * 1000L));
+            searchCache = std::make_shared<SearchCache>(redisClient, cacheOptions);
+            searchCache->start();
+            searchClient->setWriteListener([searchCache] { searchCache->bumpGeneration(); });
+        }
+        auto catalogIndex = std::make_shared<CatalogIndexService>(
+            dbAdapter, std::chrono::seconds(std::max(1, config.catalogIndexRefreshSeconds)));
+        searchClient->setDocumentListener(
+            [catalogIndex](const std::vector<nlohmann::json>& docs) { catalogIndex->onIndexed(docs); },
+            [catalogIndex](long id) { catalogIndex->onDeleted(id); });
+        catalogIndex->start();
+        auto searchService = std::make_shared<SearchService>(
+            libraryService, searchClient,
+            static_cast<size_t>(std::max(1, config.searchWorkers)),
+            static_cast<size_t>(std::max(1, config.searchMaxQueued)),
+            searchCache, catalogIndex);
+        PostgresSearchOptions postgresSearch;
+        postgresSearch.primary = config.searchBackend == "postgres";
+        postgresSearch.trigram = config.searchTrigram;
+        searchService->setPostgres(dbAdapter, postgresSearch);
 
         // Register controllers
 
@@ -152,10 +252,11 @@ int main() {
         auto returnController      = std::make_shared<ReturnController>(libraryService);
         auto userController        = std::make_shared<UserController>(userService);
         auto loginController       = std::make_shared<LoginController>(authService);
-        auto searchController      = std::make_shared<SearchController>(libraryService, searchClient);
+        auto searchController      = std::make_shared<SearchController>(searchService);
         auto digitalMediaCtrl      = std::make_shared<DigitalMediaController>(digitalMediaService);
-        auto batchImportCtrl       = std::make_shared<BatchImportController>(batchImportService);
+        auto batchImportCtrl       = std::make_shared<BatchImportController>(importJobService);
         auto metricsController     = std::make_shared<MetricsController>();
+        auto reindexController     = std::make_shared<ReindexController>(reindexService);
 
 
         mediaController->registerRoutes(app);
@@ -167,6 +268,7 @@ int main() {
         digitalMediaCtrl->registerRoutes(app);
         batchImportCtrl->registerRoutes(app);
         metricsController->registerRoutes(app);
+        reindexController->registerRoutes(app);
 
         std::cout << "[REST] Routes registered successfully.\n";
 
@@ -174,8 +276,9 @@ int main() {
         // Start Crow REST server
 
         std::thread restThread([&]() {
-            std::cout << "[REST] Server running on port " << config.restPort << "...\n";
-            app.port(config.restPort).multithreaded().run();
+            std::cout << "[REST] Server running on port " << config.restPort
+                      << " with " << restThreads << " threads...\n";
+            app.port(config.restPort).concurrency(restThreads).run();
         });
 
 
@@ -206,6 +309,9 @@ int main() {
 
         std::cout << "\n[System] Shutting down..." << std::endl;
         app.stop();
+        importJobService->stop();
+        if (blobStore) blobStore->stop();
+        catalogIndex->stop();
         queueWorker->stop();
         kafkaConsumer->stop();
         kafkaProducer->flush(5000);
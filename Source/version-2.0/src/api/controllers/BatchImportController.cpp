@@ -2,9 +2,51 @@
 
 using json = nlohmann::json;
 
+namespace {
+
+json toJson(const ImportJobStatus& s) {
+    auto optional = [](const auto& v) { return v ? json(*v) : json(nullptr); };
+    return {
+        {"job_id", s.id},
+        {"format", s.format},
+        {"status", s.status},
+        {"chunks_total", s.chunksTotal},
+        {"chunks_done", s.chunksDone},
+        {"rows_total", s.rowsTotal},
+        {"rows_processed", s.rowsProcessed},
+        {"rows_imported", s.rowsImported},
+        {"rows_failed", s.rowsFailed},
+        {"elapsed_seconds", s.elapsedSeconds},
+        {"rows_per_sec", s.rowsPerSecond},
+        {"eta_seconds", optional(s.etaSeconds)},
+        {"created_at", s.createdAt},
+        {"started_at", optional(s.startedAt)},
+        {"finished_at", optional(s.finishedAt)},
+        {"last_error", optional(s.lastError)},
+        {"errors", s.errors}
+    };
+}
+
+}
+
+void BatchImportController::submit(const std::string& format, const crow::request& req,
+                                   crow::response& res, const JwtMiddleware::context& ctx) {
+    // The body is validated and split into chunks here; rows are written by
+    // the import workers, so the request returns as soon as the job is stored
+    long jobId = service_->submit(format, req.body, std::stoi(ctx.userId));
+
+    std::string statusUrl = "/api/import/jobs/" + std::to_string(jobId);
+    res.code = 202;
+    res.set_header("Location", statusUrl);
+    res.write(json{
+        {"job_id", jobId},
+        {"status_url", statusUrl}
+    }.dump());
+}
+
 void BatchImportController::registerRoutes(crow::App<JwtMiddleware, PermissionMiddleware>& app) {
 
-    // POST /api/import/json - Bulk import from JSON array
+    // POST /api/import/json - Queue a bulk import from JSON
     CROW_ROUTE(app, "/api/import/json").methods(crow::HTTPMethod::POST)(
         [this, &app](const crow::request& req, crow::response& res) {
             try {
@@ -16,46 +58,15 @@ void BatchImportController::registerRoutes(crow::App<JwtMiddleware, PermissionMi
                     return;
                 }
 
-                auto body = json::parse(req.body, nullptr, false);
-                if (body.is_discarded()) {
-                    res.code = 400;
-                    res.write(makeJsonError("Invalid JSON"));
-                    res.end();
-                    return;
-                }
-
-                // Accept either {"records": [...]} or a raw array [...]
-                json records;
-                if (body.is_array()) {
-                    records = body;
-                } else if (body.contains("records") && body["records"].is_array()) {
-                    records = body["records"];
-                } else {
-                    res.code = 400;
-                    res.write(makeJsonError("Expected JSON array or object with 'records' array"));
-                    res.end();
-                    return;
-                }
-
-                auto result = service_->importFromJson(records);
-
-                json resp = {
-                    {"status", result.failureCount == 0 ? "success" : "partial"},
-                    {"total", result.totalRecords},
-                    {"imported", result.successCount},
-                    {"failed", result.failureCount},
-                    {"errors", result.errors}
-                };
-
-                res.code = (result.failureCount == 0) ? 200 : 207;
-                res.write(resp.dump());
+                // Accepts {"records": [...]} or a raw array [...]
+                submit("json", req, res, ctx);
             }
             catch (const ValidationException& e) { res.code = 400; res.write(makeJsonError(e.what())); }
             catch (const std::exception& e) { res.code = 500; res.write(makeJsonError(e.what())); }
             res.end();
         });
 
-    // POST /api/import/csv - Bulk import from CSV
+    // POST /api/import/csv - Queue a bulk import from CSV
     CROW_ROUTE(app, "/api/import/csv").methods(crow::HTTPMethod::POST)(
         [this, &app](const crow::request& req, crow::response& res) {
             try {
@@ -74,20 +85,29 @@ void BatchImportController::registerRoutes(crow::App<JwtMiddleware, PermissionMi
                     return;
                 }
 
-                auto result = service_->importFromCsv(req.body);
+                submit("csv", req, res, ctx);
+            }
+            catch (const ValidationException& e) { res.code = 400; res.write(makeJsonError(e.what())); }
+            catch (const std::exception& e) { res.code = 500; res.write(makeJsonError(e.what())); }
+            res.end();
+        });
 
-                json resp = {
-                    {"status", result.failureCount == 0 ? "success" : "partial"},
-                    {"total", result.totalRecords},
-                    {"imported", result.successCount},
-                    {"failed", result.failureCount},
-                    {"errors", result.errors}
-                };
+    // GET /api/import/jobs/<int> - Progress of an import job
+    CROW_ROUTE(app, "/api/import/jobs/<int>").methods(crow::HTTPMethod::GET)(
+        [this, &app](const crow::request& req, crow::response& res, int jobId) {
+            try {
+                const auto& ctx = app.get_context<JwtMiddleware>(req);
+                if (!ctx.valid) {
+                    res.code = 401;
+                    res.write(makeJsonError("Unauthorized"));
+                    res.end();
+                    return;
+                }
 
-                res.code = (result.failureCount == 0) ? 200 : 207;
-                res.write(resp.dump());
+                res.code = 200;
+                res.write(toJson(service_->getStatus(jobId)).dump());
             }
-            catch (const ValidationException& e) { res.code = 400; res.write(makeJsonError(e.what())); }
+            catch (const NotFoundException& e) { res.code = 404; res.write(makeJsonError(e.what())); }
             catch (const std::exception& e) { res.code = 500; res.write(makeJsonError(e.what())); }
             res.end();
         });
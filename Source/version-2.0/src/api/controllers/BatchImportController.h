@@ -1,7 +1,7 @@
 #pragma once
 #include <crow.h>
 #include <memory>
-#include "src/application/services/BatchImportService.h"
+#include "src/application/services/ImportJobService.h"
 #include "src/api/middleware/JwtMiddleware.h"
 #include "src/api/middleware/PermissionMiddleware.h"
 #include "src/utils/JsonUtils.h"
@@ -9,11 +9,14 @@
 
 class BatchImportController {
 public:
-    explicit BatchImportController(std::shared_ptr<BatchImportService> service)
+    explicit BatchImportController(std::shared_ptr<ImportJobService> service)
         : service_(std::move(service)) {}
 
     void registerRoutes(crow::App<JwtMiddleware, PermissionMiddleware>& app);
 
 private:
-    std::shared_ptr<BatchImportService> service_;
+    void submit(const std::string& format, const crow::request& req, crow::response& res,
+                const JwtMiddleware::context& ctx);
+
+    std::shared_ptr<ImportJobService> service_;
 };
@@ -20,10 +20,26 @@ void BorrowController::registerRoutes(crow::App<JwtMiddleware, PermissionMiddlew
                 if (!body.contains("copy_id"))
                     throw ValidationException("Missing copy_id");
 
-                service_->borrowCopy(std::stoi(ctx.userId), body["copy_id"]);
+                auto outcome = service_->borrowCopy(std::stoi(ctx.userId), body["copy_id"]);
 
-                res.code = 200;
-                res.write(makeJsonSuccess("Borrow successful"));
+                switch (outcome) {
+                    case BorrowOutcome::Borrowed:
+                        res.code = 200;
+                        res.write(makeJsonSuccess("Borrow successful"));
+                        break;
+                    case BorrowOutcome::CopyNotFound:
+                        res.code = 404;
+                        res.write(makeJsonError("Copy not found", res.code));
+                        break;
+                    case BorrowOutcome::UserNotFound:
+                        res.code = 404;
+                        res.write(makeJsonError("User not found", res.code));
+                        break;
+                    case BorrowOutcome::Unavailable:
+                        res.code = 409;
+                        res.write(makeJsonError("Copy not available for borrowing", res.code));
+                        break;
+                }
             }
             catch (const ValidationException& e) { res.code = 400; res.write(makeJsonError(e.what())); }
             catch (const UnauthorizedException& e) { res.code = 401; res.write(makeJsonError(e.what())); }
@@ -16,20 +16,53 @@ void DigitalMediaController::registerRoutes(crow::App<JwtMiddleware, PermissionM
                     return;
                 }
 
-                auto body = parseJsonSafe(req.body);
-                if (!body.contains("title") || !body.contains("mime_type") || !body.contains("file_data")) {
-                    res.code = 400;
-                    res.write(makeJsonError("Missing required fields: title, mime_type, file_data"));
-                    res.end();
-                    return;
-                }
+                std::string contentType = req.get_header_value("Content-Type");
+                json result;
+                if (auto boundary = multipartBoundary(contentType)) {
+                    // multipart/form-data: title, mime_type, drm_protected and a file part
+                    auto parts = parseMultipart(req.body, *boundary);
+                    if (!parts)
+                        throw ValidationException("Malformed multipart body");
+                    std::string title, mimeType;
+                    bool drm = false;
+                    const MultipartPart* file = nullptr;
+                    for (const auto& part : *parts) {
+                        if (part.name == "title") title = part.body;
+                        else if (part.name == "mime_type") mimeType = part.body;
+                        else if (part.name == "drm_protected") drm = part.body == "true" || part.body == "1";
+                        else if (part.name == "file") file = &part;
+                    }
+                    if (!file)
+                        throw ValidationException("Missing file part");
+                    if (mimeType.empty())
+                        mimeType = file->contentType.empty() ? "application/octet-stream" : file->contentType;
+                    result = service_->uploadMedia(title, mimeType, file->body, drm);
+                } else if (contentType.empty() || contentType.rfind("application/json", 0) == 0) {
+                    auto body = parseJsonSafe(req.body);
+                    if (!body.contains("title") || !body.contains("mime_type") || !body.contains("file_data")) {
+                        res.code = 400;
+                        res.write(makeJsonError("Missing required fields: title, mime_type, file_data"));
+                        res.end();
+                        return;
+                    }
 
-                auto result = service_->uploadMedia(
-                    body["title"],
-                    body["mime_type"],
-                    body["file_data"],
-                    body.value("drm_protected", false)
-                );
+                    result = service_->uploadMedia(
+                        body["title"],
+                        body["mime_type"],
+                        body["file_data"].get_ref<const std::string&>(),
+                        body.value("drm_protected", false)
+                    );
+                } else {
+                    // Raw file body; its Content-Type is the media type
+                    const char* title = req.url_params.get("title");
+                    if (!title)
+                        throw ValidationException("Missing title query parameter");
+                    const char* drm = req.url_params.get("drm_protected");
+                    std::string mimeType = contentType.substr(0, contentType.find(';'));
+                    result = service_->uploadMedia(
+                        title, mimeType, std::string_view(req.body),
+                        drm && (std::string(drm) == "true" || std::string(drm) == "1"));
+                }
 
                 res.code = 201;
                 res.write(result.dump());
@@ -67,6 +100,55 @@ void DigitalMediaController::registerRoutes(crow::App<JwtMiddleware, PermissionM
             res.end();
         });
 
+    // GET /api/digital-media/<int>/content - File bytes, with Range and If-None-Match
+    CROW_ROUTE(app, "/api/digital-media/<int>/content").methods(crow::HTTPMethod::GET)(
+        [this, &app](const crow::request& req, crow::response& res, int mediaId) {
+            try {
+                const auto& ctx = app.get_context<JwtMiddleware>(req);
+                if (!ctx.valid) {
+                    res.code = 401;
+                    res.write(makeJsonError("Unauthorized"));
+                    res.end();
+                    return;
+                }
+
+                auto content = service_->prepareContent(mediaId, req.get_header_value("Range"),
+                                                        req.get_header_value("If-None-Match"));
+                res.code = content.status;
+                res.set_header("Accept-Ranges", "bytes");
+                if (!content.etag.empty()) res.set_header("ETag", content.etag);
+
+                if (content.status == 416) {
+                    res.set_header("Content-Range", "bytes */" + std::to_string(content.size));
+                } else if (content.status == 302) {
+                    res.set_header("Location", content.location);
+                } else if (content.status == 200 && !content.localPath.empty()) {
+                    // Crow streams the cached file from disk in small writes
+                    res.set_static_file_info_unsafe(content.localPath);
+                    res.set_header("Content-Type", content.contentType);
+                } else if (content.status != 304) {
+                    res.set_header("Content-Type", content.contentType);
+                    if (content.range) res.set_header("Content-Range", content.range->contentRange(content.size));
+                    // Sized once; S3 chunks are appended as they arrive
+                    res.body.reserve(content.length());
+                    bool ok = service_->streamContent(content, [&res](std::string_view chunk) {
+                        res.body.append(chunk.data(), chunk.size());
+                        return true;
+                    });
+                    if (!ok) {
+                        res.headers.clear();
+                        res.body.clear();
+                        res.code = 502;
+                        res.write(makeJsonError("Failed to read file from storage"));
+                    }
+                }
+            }
+            catch (const NotFoundException& e) { res.code = 404; res.write(makeJsonError(e.what())); }
+            catch (const ValidationException& e) { res.code = 400; res.write(makeJsonError(e.what())); }
+            catch (const std::exception& e) { res.code = 500; res.write(makeJsonError(e.what())); }
+            res.end();
+        });
+
     // GET /api/digital-media/<int>/upload-url - Get presigned upload URL
     CROW_ROUTE(app, "/api/digital-media/<int>/upload-url").methods(crow::HTTPMethod::GET)(
         [this, &app](const crow::request& req, crow::response& res, int mediaId) {
@@ -105,15 +187,21 @@ void DigitalMediaController::registerRoutes(crow::App<JwtMiddleware, PermissionM
                     return;
                 }
 
-                auto body = parseJsonSafe(req.body);
-                if (!body.contains("file_data")) {
-                    res.code = 400;
-                    res.write(makeJsonError("Missing file_data"));
-                    res.end();
-                    return;
+                std::string contentType = req.get_header_value("Content-Type");
+                json result;
+                if (contentType.empty() || contentType.rfind("application/json", 0) == 0) {
+                    auto body = parseJsonSafe(req.body);
+                    if (!body.contains("file_data")) {
+                        res.code = 400;
+                        res.write(makeJsonError("Missing file_data"));
+                        res.end();
+                        return;
+                    }
+                    result = service_->createVersion(mediaId, body["file_data"].get_ref<const std::string&>());
+                } else {
+                    // Raw file body
+                    result = service_->createVersion(mediaId, std::string_view(req.body));
                 }
-
-                auto result = service_->createVersion(mediaId, body["file_data"]);
                 res.code = 201;
                 res.write(result.dump());
             }
@@ -5,6 +5,7 @@
 #include "src/api/middleware/JwtMiddleware.h"
 #include "src/api/middleware/PermissionMiddleware.h"
 #include "src/utils/JsonUtils.h"
+#include "src/utils/MultipartForm.h"
 #include "src/utils/Exceptions.h"
 
 class DigitalMediaController {
@@ -2,24 +2,81 @@
 #include "src/utils/JsonUtils.h"
 #include "src/utils/Exceptions.h"
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstring>
 using json = nlohmann::json;
 
+namespace {
+
+constexpr size_t kDefaultPageSize = 100;
+constexpr size_t kMaxPageSize = 1000;
+
+long parseQueryNumber(const char* value, const std::string& name) {
+    try {
+        size_t pos = 0;
+        long n = std::stol(value, &pos);
+        if (pos != std::strlen(value) || n < 0) throw std::invalid_argument(name);
+        return n;
+    } catch (const std::exception&) {
+        throw ValidationException("Invalid " + name);
+    }
+}
+
+void appendMediaJson(std::string& out, long id, std::string_view title) {
+    out += "{\"id\":";
+    out += std::to_string(id);
+    out += ",\"title\":";
+    out += json(title).dump();
+    out += '}';
+}
+
+}
+
 MediaController::MediaController(std::shared_ptr<LibraryService> libraryService)
     : library_(std::move(libraryService)) {}
 
 void MediaController::registerRoutes(crow::App<JwtMiddleware, PermissionMiddleware>& app) {
-    // GET /api/media
+    // GET /api/media?after_id=&limit=          -> [...], one page; X-Next-After-Id when more remain
+    // GET /api/media?after_id=&envelope=true   -> {"items": [...], "next_after_id": n|null}
     CROW_ROUTE(app, "/api/media")
         .methods(crow::HTTPMethod::GET)
         ([this](const crow::request& req) {
             try {
-                auto list = library_->getAllMedia();
-                json j = json::array();
-                for (auto& m : list) {
-                    j.push_back({{"id", m->getId()}, {"title", m->getTitle()}});
+                const char* envelopeParam = req.url_params.get("envelope");
+                bool envelope = envelopeParam && std::string(envelopeParam) == "true";
+
+                // Every response is bounded; without a limit an array holds
+                // the most a page may
+                long afterId = 0;
+                size_t limit = envelope ? kDefaultPageSize : kMaxPageSize;
+                if (auto v = req.url_params.get("after_id")) afterId = parseQueryNumber(v, "after_id");
+                if (auto v = req.url_params.get("limit"))
+                    limit = std::clamp<size_t>(parseQueryNumber(v, "limit"), 1, kMaxPageSize);
+
+                // Rows go from the COPY stream into the body without building
+                // Media objects or a JSON document
+                std::string body = envelope ? "{\"items\":[" : "[";
+                long lastId = afterId;
+                size_t rows = library_->streamMedia(afterId, limit,
+                    [&](long id, std::string_view title) {
+                        if (lastId != afterId) body += ',';
+                        appendMediaJson(body, id, title);
+                        lastId = id;
+                    });
+                body += ']';
+                bool more = rows == limit;
+                if (envelope) {
+                    body += ",\"next_after_id\":";
+                    body += more ? std::to_string(lastId) : "null";
+                    body += '}';
                 }
-                return crow::response(200, j.dump());
+
+                crow::response res(200, std::move(body));
+                res.set_header("Content-Type", "application/json");
+                if (more && !envelope) res.set_header("X-Next-After-Id", std::to_string(lastId));
+                return res;
             }
+            catch (const ValidationException& e) { return crow::response(400, makeJsonError(e.what())); }
             catch (const std::exception& e) {
                 return crow::response(500, makeJsonError(e.what()));
             }
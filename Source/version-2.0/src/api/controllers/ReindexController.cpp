@@ -0,0 +1,78 @@
+#include "ReindexController.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+json toJson(const ReindexStatus& s) {
+    auto optional = [](const auto& v) { return v ? json(*v) : json(nullptr); };
+    return {
+        {"state", s.state},
+        {"target_index", s.targetIndex},
+        {"docs_read", s.docsRead},
+        {"docs_indexed", s.docsIndexed},
+        {"docs_failed", s.docsFailed},
+        {"elapsed_seconds", s.elapsedSeconds},
+        {"docs_per_sec", s.docsPerSecond},
+        {"started_at", optional(s.startedAt)},
+        {"finished_at", optional(s.finishedAt)},
+        {"error", optional(s.error)}
+    };
+}
+
+}
+
+void ReindexController::registerRoutes(crow::App<JwtMiddleware, PermissionMiddleware>& app) {
+
+    // POST /api/reindex - Rebuild the search index from PostgreSQL
+    CROW_ROUTE(app, "/api/reindex").methods(crow::HTTPMethod::POST)(
+        [this, &app](const crow::request& req, crow::response& res) {
+            try {
+                const auto& ctx = app.get_context<JwtMiddleware>(req);
+                if (!ctx.valid) {
+                    res.code = 401;
+                    res.write(makeJsonError("Unauthorized"));
+                    res.end();
+                    return;
+                }
+                if (ctx.role != "ADMIN") {
+                    res.code = 403;
+                    res.write(makeJsonError("Reindexing requires the ADMIN role", 403));
+                    res.end();
+                    return;
+                }
+
+                if (!service_->start()) {
+                    res.code = 409;
+                    res.write(makeJsonError("A reindex is already running", 409));
+                    res.end();
+                    return;
+                }
+
+                res.code = 202;
+                res.set_header("Location", "/api/reindex");
+                res.write(toJson(service_->status()).dump());
+            }
+            catch (const std::exception& e) { res.code = 500; res.write(makeJsonError(e.what())); }
+            res.end();
+        });
+
+    // GET /api/reindex - Progress of the current or last reindex
+    CROW_ROUTE(app, "/api/reindex").methods(crow::HTTPMethod::GET)(
+        [this, &app](const crow::request& req, crow::response& res) {
+            try {
+                const auto& ctx = app.get_context<JwtMiddleware>(req);
+                if (!ctx.valid) {
+                    res.code = 401;
+                    res.write(makeJsonError("Unauthorized"));
+                    res.end();
+                    return;
+                }
+
+                res.code = 200;
+                res.write(toJson(service_->status()).dump());
+            }
+            catch (const std::exception& e) { res.code = 500; res.write(makeJsonError(e.what())); }
+            res.end();
+        });
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <crow.h>
+#include <memory>
+#include "src/application/services/ReindexService.h"
+#include "src/api/middleware/JwtMiddleware.h"
+#include "src/api/middleware/PermissionMiddleware.h"
+#include "src/utils/JsonUtils.h"
+
+class ReindexController {
+public:
+    explicit ReindexController(std::shared_ptr<ReindexService> service)
+        : service_(std::move(service)) {}
+
+    void registerRoutes(crow::App<JwtMiddleware, PermissionMiddleware>& app);
+
+private:
+    std::shared_ptr<ReindexService> service_;
+};
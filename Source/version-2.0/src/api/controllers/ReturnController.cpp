@@ -19,10 +19,15 @@ void ReturnController::registerRoutes(crow::App<JwtMiddleware, PermissionMiddlew
                 if (!body.contains("copy_id"))
                     throw ValidationException("Missing copy_id field");
 
-                service_->returnCopy(std::stoi(ctx.userId), body["copy_id"]);
+                auto outcome = service_->returnCopy(std::stoi(ctx.userId), body["copy_id"]);
 
-                res.code = 200;
-                res.write(makeJsonSuccess("Return successful"));
+                if (outcome == ReturnOutcome::Returned) {
+                    res.code = 200;
+                    res.write(makeJsonSuccess("Return successful"));
+                } else {
+                    res.code = 409;
+                    res.write(makeJsonError("Copy not borrowed by this user", res.code));
+                }
             }
             catch (const ValidationException& e) { res.code = 400; res.write(makeJsonError(e.what())); }
             catch (const UnauthorizedException& e) { res.code = 401; res.write(makeJsonError(e.what())); }
@@ -1,13 +1,33 @@
 #include "SearchController.h"
 
+namespace {
+
+void rejectOverloaded(crow::response& res) {
+    res.code = 503;
+    res.set_header("Retry-After", "1");
+    res.write(makeJsonError("Search is busy, try again shortly", 503));
+    res.end();
+}
+
+// Completes res on the thread that owns its connection. Search callbacks
+// run on a search worker, and a crow::response may only be touched from
+// its connection's io_context.
+void respondOnConnection(const crow::request& req, crow::response& res, int code, std::string body) {
+    asio::post(*req.io_context, [&res, code, body = std::move(body)] {
+        res.code = code;
+        res.write(body);
+        res.end();
+    });
+}
+
+}
+
 void SearchController::registerRoutes(crow::App<JwtMiddleware, PermissionMiddleware>& app) {
 
     // GET /api/search - Full-text search with fuzzy matching
     CROW_ROUTE(app, "/api/search").methods(crow::HTTPMethod::GET)(
-        [this, &app](const crow::request& req, crow::response& res) {
+        [this](const crow::request& req, crow::response& res) {
             try {
-                const auto& ctx = app.get_context<JwtMiddleware>(req);
-
                 auto query = req.url_params.get("q");
                 if (!query || std::string(query).empty()) {
                     res.code = 400;
@@ -16,43 +36,51 @@ void SearchController::registerRoutes(crow::App<JwtMiddleware, PermissionMiddlew
                     return;
                 }
 
-                int from = 0;
-                int size = 10;
+                SearchQuery q;
+                q.text = query;
                 if (req.url_params.get("from"))
-                    from = std::max(0, std::atoi(req.url_params.get("from")));
+                    q.from = std::max(0, std::atoi(req.url_params.get("from")));
                 if (req.url_params.get("size"))
-                    size = std::max(1, std::atoi(req.url_params.get("size")));
-
-                std::vector<nlohmann::json> results;
-                if (search_) {
-                    // Use fuzzy search with configurable fuzziness
-                    std::string fuzziness = "AUTO";
-                    if (req.url_params.get("fuzziness"))
-                        fuzziness = req.url_params.get("fuzziness");
-                    results = search_->fuzzySearch(query, fuzziness, from, size);
-                } else {
-                    // Fallback to basic search via LibraryService
-                    auto all = library_->searchMedia(query);
-                    int end = std::min(static_cast<int>(all.size()), from + size);
-                    for (int i = from; i < end; ++i)
-                        results.push_back(all[i]);
+                    q.size = std::max(1, std::atoi(req.url_params.get("size")));
+                if (req.url_params.get("fuzziness"))
+                    q.fuzziness = req.url_params.get("fuzziness");
+                if (req.url_params.get("cursor")) {
+                    try {
+                        q.after = SearchService::decodeCursor(req.url_params.get("cursor"));
+                    } catch (const ValidationException& e) {
+                        res.code = 400;
+                        res.write(makeJsonError(e.what()));
+                        res.end();
+                        return;
+                    }
                 }
 
-                nlohmann::json response = {
-                    {"total", results.size()},
-                    {"from", from},
-                    {"size", size},
-                    {"results", results}
-                };
-
-                res.code = 200;
-                res.write(response.dump());
-                res.end();
-            }
-            catch (const DatabaseException& e) {
-                res.code = 500;
-                res.write(makeJsonError(e.what()));
-                res.end();
+                // res stays open, and Crow keeps req and res alive, until
+                // the callback ends it
+                int from = q.from, size = q.size;
+                bool queued = search_->search(q, [&req, &res, from, size](
+                        const SearchService::Results& results, std::exception_ptr error) {
+                    try {
+                        if (error) std::rethrow_exception(error);
+                        const auto& hits = results["hits"];
+                        nlohmann::json response = {
+                            {"total", hits.size()},
+                            {"from", from},
+                            {"size", size},
+                            {"results", hits},
+                            {"next_cursor", results["next_cursor"]}
+                        };
+                        respondOnConnection(req, res, 200, response.dump());
+                    }
+                    catch (const DatabaseException& e) {
+                        respondOnConnection(req, res, 500, makeJsonError(e.what()));
+                    }
+                    catch (const std::exception& e) {
+                        respondOnConnection(req, res, 500,
+                                            makeJsonError(std::string("Search failed: ") + e.what()));
+                    }
+                });
+                if (!queued) rejectOverloaded(res);
             }
             catch (const std::exception& e) {
                 res.code = 500;
@@ -78,24 +106,29 @@ void SearchController::registerRoutes(crow::App<JwtMiddleware, PermissionMiddlew
                 if (req.url_params.get("limit"))
                     maxResults = std::max(1, std::atoi(req.url_params.get("limit")));
 
-                std::vector<std::string> suggestions;
-                if (search_) {
-                    suggestions = search_->autoSuggest(prefix, maxResults);
-                }
-
-                nlohmann::json response = {
-                    {"query", std::string(prefix)},
-                    {"suggestions", suggestions}
-                };
-
-                res.code = 200;
-                res.write(response.dump());
+                std::string text = prefix;
+                bool queued = search_->suggest(text, maxResults, [&req, &res, text](
+                        const SearchService::Suggestions& suggestions, std::exception_ptr error) {
+                    try {
+                        if (error) std::rethrow_exception(error);
+                        nlohmann::json response = {
+                            {"query", text},
+                            {"suggestions", suggestions}
+                        };
+                        respondOnConnection(req, res, 200, response.dump());
+                    }
+                    catch (const std::exception& e) {
+                        respondOnConnection(req, res, 500,
+                                            makeJsonError(std::string("Suggest failed: ") + e.what()));
+                    }
+                });
+                if (!queued) rejectOverloaded(res);
             }
             catch (const std::exception& e) {
                 res.code = 500;
                 res.write(makeJsonError(std::string("Suggest failed: ") + e.what()));
+                res.end();
             }
-            res.end();
         }
     );
 }
@@ -1,21 +1,23 @@
 #pragma once
 #include <crow.h>
 #include <memory>
-#include "src/application/services/LibraryService.h"
-#include "src/infrastructure/search/OpenSearchClient.h"
+#include "src/application/services/SearchService.h"
 #include "src/api/middleware/JwtMiddleware.h"
 #include "src/api/middleware/PermissionMiddleware.h"
+#include "src/utils/Exceptions.h"
 #include "src/utils/JsonUtils.h"
 
+// Search routes answer asynchronously: the handler hands the query to
+// SearchService and returns, and the response is completed from the
+// search worker's callback, which posts the reply back to the
+// connection's own thread.
 class SearchController {
 public:
-    SearchController(std::shared_ptr<LibraryService> library,
-                     std::shared_ptr<OpenSearchClient> search = nullptr)
-        : library_(std::move(library)), search_(std::move(search)) {}
+    explicit SearchController(std::shared_ptr<SearchService> search)
+        : search_(std::move(search)) {}
 
     void registerRoutes(crow::App<JwtMiddleware, PermissionMiddleware>& app);
 
 private:
-    std::shared_ptr<LibraryService> library_;
-    std::shared_ptr<OpenSearchClient> search_;
+    std::shared_ptr<SearchService> search_;
 };
@@ -1,142 +1,274 @@
 #include "BatchImportService.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
 #include "src/utils/Exceptions.h"
-#include "src/utils/StringUtils.h"
+#include "src/utils/CsvTokenizer.h"
+#include "src/utils/JsonRecordReader.h"
 #include "src/utils/DateTimeUtils.h"
-#include <sstream>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
 #include <iostream>
 
-BatchImportService::BatchImportService(std::shared_ptr<PostgresAdapter> db,
-                                       std::shared_ptr<OpenSearchClient> search,
-                                       std::shared_ptr<KafkaProducer> events)
-    : db_(std::move(db)), search_(std::move(search)), events_(std::move(events)) {}
-
-std::vector<nlohmann::json> BatchImportService::parseCsv(const std::string& csvData) {
-    std::vector<nlohmann::json> records;
-    std::istringstream stream(csvData);
-    std::string line;
-
-    // Parse header row
-    std::vector<std::string> headers;
-    if (std::getline(stream, line)) {
-        headers = split(line, ',');
-        for (auto& h : headers) h = trim(h);
+namespace {
+
+// Row errors kept in ImportResult; failureCount still counts every failure
+constexpr size_t kMaxReportedErrors = 1000;
+// Bytes read from the input per tokenizer feed
+constexpr size_t kCsvReadBlock = 64 * 1024;
+
+// A missing type means Book; any other unknown type rejects the row
+int mediaTypeIdFor(std::string_view type) {
+    if (type == "Book") return 1;
+    if (type == "Magazine") return 2;
+    if (type == "DVD") return 3;
+    if (type == "AudioBook") return 4;
+    if (type == "DigitalMedia") return 5;
+    throw std::invalid_argument("unknown media type '" + std::string(type) + "'");
+}
+
+ImportRow toImportRow(const nlohmann::json& rec) {
+    if (!rec.is_object())
+        throw std::invalid_argument("record is not an object");
+
+    std::string title = rec.value("title", "");
+    if (title.empty())
+        throw std::invalid_argument("missing title");
+
+    ImportRow row;
+    row.mediaTypeId = mediaTypeIdFor(rec.value("type", "Book"));
+    row.title = std::move(title);
+    if (row.mediaTypeId == 1) {
+        row.author = rec.value("author", "Unknown");
+        row.isbn = rec.value("isbn", "");
+    } else if (row.mediaTypeId == 2) {
+        if (rec.contains("issue_number")) {
+            auto& iv = rec["issue_number"];
+            row.issueNumber = iv.is_string() ? std::stoi(iv.get<std::string>()) : iv.get<int>();
+        }
+        row.publisher = rec.value("publisher", "Unknown");
     }
+    return row;
+}
 
-    if (headers.empty())
-        throw ValidationException("CSV has no header row");
+void appendError(ImportResult& result, size_t rowNumber, const std::string& message) {
+    result.failureCount++;
+    if (result.errors.size() < kMaxReportedErrors)
+        result.errors.push_back("Row " + std::to_string(rowNumber) + ": " + message);
+}
 
-    // Parse data rows
-    while (std::getline(stream, line)) {
-        if (trim(line).empty()) continue;
-
-        auto values = split(line, ',');
-        nlohmann::json record;
-        for (size_t i = 0; i < headers.size() && i < values.size(); ++i) {
-            std::string val = trim(values[i]);
-            // Remove surrounding quotes if present
-            if (val.size() >= 2 && val.front() == '"' && val.back() == '"') {
-                val = val.substr(1, val.size() - 2);
-            }
-            record[headers[i]] = val;
+std::string_view trimView(std::string_view s) {
+    auto start = s.find_first_not_of(" \t");
+    if (start == std::string_view::npos) return {};
+    auto end = s.find_last_not_of(" \t");
+    return s.substr(start, end - start + 1);
+}
+
+// Column positions resolved from the CSV header; -1 when absent
+struct CsvColumns {
+    int type = -1, title = -1, author = -1, isbn = -1, issueNumber = -1, publisher = -1;
+
+    explicit CsvColumns(const CsvTokenizer::Fields& header) {
+        for (size_t i = 0; i < header.size(); ++i) {
+            auto name = trimView(header[i]);
+            int idx = static_cast<int>(i);
+            if (name == "type") type = idx;
+            else if (name == "title") title = idx;
+            else if (name == "author") author = idx;
+            else if (name == "isbn") isbn = idx;
+            else if (name == "issue_number") issueNumber = idx;
+            else if (name == "publisher") publisher = idx;
         }
-        records.push_back(record);
     }
 
-    return records;
+    std::string_view get(const CsvTokenizer::Fields& fields, int idx) const {
+        return idx >= 0 && static_cast<size_t>(idx) < fields.size() ? trimView(fields[idx]) : std::string_view{};
+    }
+};
+
+// Same rules as the JSON variant, reading straight from the tokenizer's views
+ImportRow toImportRow(const CsvTokenizer::Fields& fields, const CsvColumns& cols) {
+    auto title = cols.get(fields, cols.title);
+    if (title.empty())
+        throw std::invalid_argument("missing title");
+
+    auto type = cols.get(fields, cols.type);
+    ImportRow row;
+    row.mediaTypeId = mediaTypeIdFor(type.empty() ? "Book" : type);
+    row.title = std::string(title);
+    if (row.mediaTypeId == 1) {
+        auto author = cols.get(fields, cols.author);
+        row.author = author.empty() ? "Unknown" : std::string(author);
+        row.isbn = std::string(cols.get(fields, cols.isbn));
+    } else if (row.mediaTypeId == 2) {
+        auto issue = cols.get(fields, cols.issueNumber);
+        if (!issue.empty()) row.issueNumber = std::stoi(std::string(issue));
+        auto publisher = cols.get(fields, cols.publisher);
+        row.publisher = publisher.empty() ? "Unknown" : std::string(publisher);
+    }
+    return row;
+}
+
 }
 
-ImportResult BatchImportService::importFromCsv(const std::string& csvData) {
-    if (csvData.empty())
-        throw ValidationException("CSV data is empty");
+BatchImportService::BatchImportService(std::shared_ptr<PostgresAdapter> db,
+                                       std::shared_ptr<OpenSearchClient> search,
+                                       std::shared_ptr<KafkaProducer> events)
+    : db_(std::move(db)), search_(std::move(search)), events_(std::move(events)),
+      rowsImported_(MetricsRegistry::instance().counter(
+          "import_rows_imported_total", "Rows written by batch imports")),
+      rowsFailed_(MetricsRegistry::instance().counter(
+          "import_rows_failed_total", "Rows rejected by batch imports")) {}
 
-    auto records = parseCsv(csvData);
-    return processRecords(records);
+ImportResult BatchImportService::importChunk(const std::string& format, std::istream& in, size_t firstRow,
+                                             const Checkpoint& checkpoint, bool& checkpointed) {
+    ImportState state;
+    state.rowOffset = firstRow;
+    state.checkpoint = checkpoint;
+
+    if (format == "json") readJson(state, in);
+    else if (format == "csv") readCsv(state, in);
+    else throw ValidationException("Unknown import format: " + format);
+
+    flushBatch(state);
+    checkpointed = state.checkpointed;
+    return state.result;
 }
 
-ImportResult BatchImportService::importFromJson(const nlohmann::json& records) {
-    if (!records.is_array())
-        throw ValidationException("Expected JSON array of records");
+void BatchImportService::readJson(ImportState& state, std::istream& in) {
+    JsonRecordReader reader([&](nlohmann::json&& rec) {
+        size_t rowNumber = state.rowOffset + static_cast<size_t>(++state.result.totalRecords);
+        addRow(state, rowNumber, [&] { return toImportRow(rec); });
+    });
+    nlohmann::json::sax_parse(in, &reader);
 
-    std::vector<nlohmann::json> vec;
-    for (auto& r : records) {
-        vec.push_back(r);
+    if (!reader.sawRecords())
+        throw ValidationException("Expected JSON array or object with 'records' array");
+}
+
+void BatchImportService::readCsv(ImportState& state, std::istream& in) {
+    std::optional<CsvColumns> columns;
+
+    CsvTokenizer tokenizer;
+    auto onRow = [&](const CsvTokenizer::Fields& fields) {
+        if (!columns) {
+            columns.emplace(fields);
+            return;
+        }
+        size_t rowNumber = state.rowOffset + static_cast<size_t>(++state.result.totalRecords);
+        addRow(state, rowNumber, [&] { return toImportRow(fields, *columns); });
+    };
+
+    std::vector<char> block(kCsvReadBlock);
+    while (in.read(block.data(), static_cast<std::streamsize>(block.size())) || in.gcount() > 0)
+        tokenizer.feed(std::string_view(block.data(), static_cast<size_t>(in.gcount())), onRow);
+    tokenizer.finish(onRow);
+
+    if (!columns)
+        throw ValidationException("CSV has no header row");
+}
+
+void BatchImportService::addRow(ImportState& state, size_t rowNumber,
+                                const std::function<ImportRow()>& makeRow) {
+    try {
+        state.batch.emplace_back(rowNumber, makeRow());
+    } catch (const std::exception& e) {
+        recordError(state, rowNumber, e.what());
     }
-    return processRecords(vec);
 }
 
-ImportResult BatchImportService::processRecords(const std::vector<nlohmann::json>& records) {
-    ImportResult result;
-    result.totalRecords = static_cast<int>(records.size());
-    result.successCount = 0;
-    result.failureCount = 0;
+void BatchImportService::recordError(ImportState& state, size_t rowNumber, const std::string& message) {
+    appendError(state.result, rowNumber, message);
+    rowsFailed_.inc();
+}
 
-    std::vector<nlohmann::json> searchDocs;
+void BatchImportService::flushBatch(ImportState& state) {
+    auto& batch = state.batch;
+    if (batch.empty()) return;
 
-    for (size_t i = 0; i < records.size(); ++i) {
-        const auto& rec = records[i];
-        try {
-            std::string type = rec.value("type", "Book");
-            std::string title = rec.value("title", "");
+    std::vector<ImportRow> rows;
+    rows.reserve(batch.size());
+    for (const auto& entry : batch) rows.push_back(entry.second);
 
-            if (title.empty()) {
-                result.errors.push_back("Row " + std::to_string(i + 1) + ": missing title");
-                result.failureCount++;
-                continue;
-            }
+    // Rows the database refused on the row-by-row path: (row number, message)
+    std::vector<std::pair<size_t, std::string>> rejected;
 
-            // Determine media_type_id
-            int mediaTypeId = 1; // Default: Book
-            if (type == "Magazine") mediaTypeId = 2;
-            else if (type == "DVD") mediaTypeId = 3;
-            else if (type == "AudioBook") mediaTypeId = 4;
-            else if (type == "DigitalMedia") mediaTypeId = 5;
-
-            long mediaId = db_->createMedia(mediaTypeId, title);
-
-            if (type == "Book") {
-                std::string author = rec.value("author", "Unknown");
-                std::string isbn = rec.value("isbn", "");
-                db_->attachBook(mediaId, author, isbn);
-
-                searchDocs.push_back({
-                    {"id", mediaId}, {"title", title},
-                    {"author", author}, {"category", "Book"},
-                    {"suggest", nlohmann::json::array({title, author})}
-                });
-            }
-            else if (type == "Magazine") {
-                int issue = 0;
-                if (rec.contains("issue_number")) {
-                    auto& iv = rec["issue_number"];
-                    issue = iv.is_string() ? std::stoi(iv.get<std::string>()) : iv.get<int>();
-                }
-                std::string publisher = rec.value("publisher", "Unknown");
-                db_->attachMagazine(mediaId, issue, publisher);
-
-                searchDocs.push_back({
-                    {"id", mediaId}, {"title", title},
-                    {"author", publisher}, {"category", "Magazine"},
-                    {"suggest", nlohmann::json::array({title, publisher})}
-                });
+    // The checkpoint sees the result as it will be once this batch commits
+    std::function<void(pqxx::work&)> inTransaction;
+    std::exception_ptr checkpointError;
+    if (state.checkpoint) {
+        inTransaction = [&](pqxx::work& txn) {
+            ImportResult committed = state.result;
+            committed.successCount += static_cast<int>(batch.size() - rejected.size());
+            for (const auto& [rowNumber, message] : rejected) appendError(committed, rowNumber, message);
+            try {
+                state.checkpoint(txn, committed);
+            } catch (...) {
+                checkpointError = std::current_exception();
+                throw;
             }
+        };
+    }
+
+    std::vector<long> ids;
+    try {
+        ids = db_->bulkInsertMedia(rows, inTransaction);
+    } catch (const DatabaseException&) {
+        // No connection: retrying row by row would only wait out the pool
+        // timeout again for every row
+        throw;
+    } catch (const std::exception& e) {
+        // A refused checkpoint means the rows must not be written at all
+        if (checkpointError) std::rethrow_exception(checkpointError);
+        // The batch rolled back as a whole; redo it row by row to find the
+        // bad rows, still in one transaction with the checkpoint so a retried
+        // chunk cannot write the good rows twice
+        std::cerr << "[BatchImport] Bulk insert failed, retrying " << batch.size()
+                  << " rows individually: " << e.what() << std::endl;
+        ids = db_->insertMediaRows(rows, [&](size_t i, const std::string& message) {
+            rejected.emplace_back(batch[i].first, message);
+        }, inTransaction);
+    }
+    state.checkpointed = static_cast<bool>(inTransaction);
+    for (const auto& [rowNumber, message] : rejected) recordError(state, rowNumber, message);
 
-            result.successCount++;
+    std::vector<nlohmann::json> searchDocs;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const auto& row = batch[i].second;
+        if (ids[i] == 0) continue;
+        state.result.successCount++;
+        rowsImported_.inc();
 
-        } catch (const std::exception& e) {
-            result.errors.push_back("Row " + std::to_string(i + 1) + ": " + e.what());
-            result.failureCount++;
+        if (row.mediaTypeId == 1) {
+            searchDocs.push_back({
+                {"id", ids[i]}, {"title", row.title},
+                {"author", row.author}, {"category", "Book"},
+                {"suggest", nlohmann::json::array({row.title, row.author})}
+            });
+        } else if (row.mediaTypeId == 2) {
+            searchDocs.push_back({
+                {"id", ids[i]}, {"title", row.title},
+                {"author", row.publisher}, {"category", "Magazine"},
+                {"suggest", nlohmann::json::array({row.title, row.publisher})}
+            });
         }
     }
 
     // Bulk index to OpenSearch
     if (!searchDocs.empty()) {
         try {
-            search_->bulkIndex(searchDocs);
+            if (!search_->bulkIndex(searchDocs))
+                std::cerr << "[BatchImport] OpenSearch rejected some of " << searchDocs.size()
+                          << " documents" << std::endl;
         } catch (const std::exception& e) {
             std::cerr << "[BatchImport] OpenSearch bulk index failed: " << e.what() << std::endl;
         }
     }
 
+    batch.clear();
+}
+
+void BatchImportService::publishCompleted(const ImportResult& result) {
     // Publish import event
     events_->produceJson("media.events", "batch.import", {
         {"event", "BATCH_IMPORT_COMPLETED"},
@@ -145,6 +277,4 @@ ImportResult BatchImportService::processRecords(const std::vector<nlohmann::json
         {"failures", result.failureCount},
         {"timestamp", nowToString()}
     });
-
-    return result;
 }
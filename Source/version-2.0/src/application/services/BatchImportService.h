@@ -1,12 +1,17 @@
 #pragma once
+#include <functional>
+#include <istream>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include <nlohmann/json.hpp>
 #include "src/data/PostgresAdapter.h"
 #include "src/infrastructure/search/OpenSearchClient.h"
 #include "src/infrastructure/messaging/KafkaProducer.h"
 
+class Counter;
+
 struct ImportResult {
     int totalRecords;
     int successCount;
@@ -20,17 +25,47 @@ public:
                        std::shared_ptr<OpenSearchClient> search,
                        std::shared_ptr<KafkaProducer> events);
 
-    // Import from JSON array
-    ImportResult importFromJson(const nlohmann::json& records);
+    // Runs inside the transaction that writes a chunk's rows, with the
+    // chunk's final result, so progress commits atomically with the data
+    using Checkpoint = std::function<void(pqxx::work&, const ImportResult&)>;
+
+    // Imports one self-contained chunk ("csv" or "json") of a larger job as
+    // a single transaction. Row numbers in errors start after firstRow.
+    // A batch the set-wise insert rejects is retried row by row in the same
+    // way, still committing with the checkpoint. checkpointed is false when
+    // no row was valid, so nothing was written; the caller then records
+    // progress itself. No completion event is published for a chunk.
+    // Throws DatabaseException, without trying row by row, when the pool
+    // cannot provide a connection.
+    ImportResult importChunk(const std::string& format, std::istream& in, size_t firstRow,
+                             const Checkpoint& checkpoint, bool& checkpointed);
 
-    // Import from CSV string
-    ImportResult importFromCsv(const std::string& csvData);
+    // Publishes BATCH_IMPORT_COMPLETED for a finished import
+    void publishCompleted(const ImportResult& result);
 
 private:
-    ImportResult processRecords(const std::vector<nlohmann::json>& records);
-    std::vector<nlohmann::json> parseCsv(const std::string& csvData);
+    struct ImportState {
+        ImportResult result{0, 0, 0, {}};
+        // Rows carry their 1-based input row number for error reporting;
+        // a chunk is parsed incrementally and written as one batch
+        std::vector<std::pair<size_t, ImportRow>> batch;
+        // Input rows before this one, for chunks of a larger job
+        size_t rowOffset = 0;
+        Checkpoint checkpoint;
+        bool checkpointed = false;
+    };
+
+    void readJson(ImportState& state, std::istream& in);
+    void readCsv(ImportState& state, std::istream& in);
+
+    void addRow(ImportState& state, size_t rowNumber, const std::function<ImportRow()>& makeRow);
+    void recordError(ImportState& state, size_t rowNumber, const std::string& message);
+    void flushBatch(ImportState& state);
 
     std::shared_ptr<PostgresAdapter> db_;
     std::shared_ptr<OpenSearchClient> search_;
     std::shared_ptr<KafkaProducer> events_;
+
+    Counter& rowsImported_;
+    Counter& rowsFailed_;
 };
@@ -0,0 +1,165 @@
+#include "CatalogIndexService.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
+#include <iostream>
+#include <pqxx/pqxx>
+#include <unordered_map>
+
+using json = nlohmann::json;
+
+namespace {
+
+// How far back each refresh reaches before the previous one, for writers
+// that committed long after they stamped updated_at
+constexpr std::chrono::seconds kChangeOverlap{120};
+
+}
+
+CatalogIndexService::CatalogIndexService(std::shared_ptr<PostgresAdapter> db,
+                                         std::chrono::seconds refreshInterval)
+    : db_(std::move(db)), refreshInterval_(refreshInterval),
+      documents_(MetricsRegistry::instance().gauge(
+          "catalog_index_documents", "Media items in the in-process catalogue indices")),
+      loadSeconds_(MetricsRegistry::instance().histogram(
+          "catalog_index_load_seconds", "Time to load the catalogue indices from PostgreSQL",
+          {0.1, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0, 60.0})) {}
+
+CatalogIndexService::~CatalogIndexService() {
+    stop();
+}
+
+bool CatalogIndexService::load() {
+    auto start = std::chrono::steady_clock::now();
+    autocomplete_.beginRebuild();
+    fullText_.beginRebuild();
+    try {
+        // Taken first, so the next refresh covers everything after this snapshot
+        std::string since = changesAvailable_ ? db_->databaseNow() : "";
+        std::unordered_map<long, long> borrows;
+        db_->streamBorrowCounts([&](long mediaId, long count) { borrows[mediaId] = count; });
+
+        std::vector<AutocompleteIndex::Document> suggestions;
+        std::vector<FullTextIndex::Document> documents;
+        db_->streamSearchRows(0, [&](const MediaSearchRow& row) {
+            auto it = borrows.find(row.id);
+            suggestions.push_back({row.id, std::string(row.title), std::string(row.author),
+                                   it == borrows.end() ? 0.0 : static_cast<double>(it->second)});
+            documents.push_back({row.id, std::string(row.title), std::string(row.author),
+                                 std::string(row.category)});
+        });
+        autocomplete_.rebuild(std::move(suggestions));
+        fullText_.rebuild(std::move(documents));
+        changesSince_ = std::move(since);
+    } catch (const std::exception& e) {
+        // Keep serving the previous contents
+        autocomplete_.abortRebuild();
+        fullText_.abortRebuild();
+        std::cerr << "[CatalogIndex] Load failed: " << e.what() << std::endl;
+        return false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    loadSeconds_.observe(seconds);
+    documents_.set(static_cast<double>(fullText_.documents()));
+    return true;
+}
+
+bool CatalogIndexService::applyChanges() {
+    if (!changesAvailable_ || changesSince_.empty()) return false;
+    std::vector<AutocompleteIndex::Document> suggestions;
+    std::vector<FullTextIndex::Document> documents;
+    std::vector<long> deleted;
+    try {
+        changesSince_ = db_->streamCatalogChanges(changesSince_, kChangeOverlap,
+            [&](const MediaSearchRow& row, long borrows) {
+                suggestions.push_back({row.id, std::string(row.title), std::string(row.author),
+                                       static_cast<double>(borrows)});
+                documents.push_back({row.id, std::string(row.title), std::string(row.author),
+                                     std::string(row.category)});
+            },
+            [&](long id) { deleted.push_back(id); });
+    } catch (const pqxx::sql_error& e) {
+        // 42703 undefined_column, 42P01 undefined_table
+        if (e.sqlstate() == "42703" || e.sqlstate() == "42P01") {
+            changesAvailable_ = false;
+            std::cerr << "[CatalogIndex] Migration 005 is not applied; every refresh reloads "
+                         "the whole catalogue." << std::endl;
+        } else {
+            std::cerr << "[CatalogIndex] Refresh failed: " << e.what() << std::endl;
+        }
+        return false;
+    } catch (const std::exception& e) {
+        std::cerr << "[CatalogIndex] Refresh failed: " << e.what() << std::endl;
+        return false;
+    }
+
+    autocomplete_.upsert(std::move(suggestions));
+    fullText_.upsert(std::move(documents));
+    for (long id : deleted) {
+        autocomplete_.remove(id);
+        fullText_.remove(id);
+    }
+    documents_.set(static_cast<double>(fullText_.documents()));
+    return true;
+}
+
+void CatalogIndexService::refresh() {
+    if (ready_ && applyChanges()) return;
+    if (load()) ready_ = true;
+}
+
+void CatalogIndexService::start() {
+    refresher_ = std::thread([this]() {
+        // Searches and suggestions go to OpenSearch until this is done
+        if (load()) {
+            ready_ = true;
+            std::cout << "[CatalogIndex] Loaded " << fullText_.documents() << " media items." << std::endl;
+        }
+        std::unique_lock lock(refreshMtx_);
+        while (!refreshCv_.wait_for(lock, refreshInterval_, [this] { return stopping_; })) {
+            lock.unlock();
+            refresh();
+            lock.lock();
+        }
+    });
+}
+
+void CatalogIndexService::stop() {
+    {
+        std::scoped_lock lock(refreshMtx_);
+        if (stopping_) return;
+        stopping_ = true;
+    }
+    refreshCv_.notify_all();
+    if (refresher_.joinable()) refresher_.join();
+}
+
+std::vector<std::string> CatalogIndexService::suggest(const std::string& prefix, size_t limit) const {
+    return autocomplete_.suggest(prefix, limit);
+}
+
+std::vector<json> CatalogIndexService::search(const std::string& query, const std::string& fuzziness,
+                                              int from, int size) const {
+    return fullText_.search(query, fuzziness, from, size);
+}
+
+void CatalogIndexService::onIndexed(const std::vector<json>& docs) {
+    std::vector<AutocompleteIndex::Document> suggestions;
+    std::vector<FullTextIndex::Document> documents;
+    suggestions.reserve(docs.size());
+    documents.reserve(docs.size());
+    for (const auto& d : docs) {
+        if (!d.contains("id") || !d["id"].is_number_integer()) continue;
+        long id = d["id"].get<long>();
+        suggestions.push_back({id, d.value("title", ""), d.value("author", ""), 0});
+        documents.push_back({id, d.value("title", ""), d.value("author", ""), d.value("category", "")});
+    }
+    autocomplete_.upsert(std::move(suggestions));
+    fullText_.upsert(std::move(documents));
+    documents_.set(static_cast<double>(fullText_.documents()));
+}
+
+void CatalogIndexService::onDeleted(long id) {
+    autocomplete_.remove(id);
+    fullText_.remove(id);
+    documents_.set(static_cast<double>(fullText_.documents()));
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "src/data/PostgresAdapter.h"
+#include "src/infrastructure/search/AutocompleteIndex.h"
+#include "src/infrastructure/search/FullTextIndex.h"
+
+class Gauge;
+class Histogram;
+
+// Keeps in-process indices of the catalogue: an AutocompleteIndex for
+// suggestions and a FullTextIndex that answers searches without
+// OpenSearch. Both are loaded from Postgres in the background after start,
+// and follow documents as they are indexed or deleted. Every refresh
+// interval they apply the rows changed since the last one (migration 005),
+// which brings in other instances' writes and fresh borrow counts. Without
+// that migration every refresh reloads the whole catalogue.
+class CatalogIndexService {
+public:
+    CatalogIndexService(std::shared_ptr<PostgresAdapter> db, std::chrono::seconds refreshInterval);
+    ~CatalogIndexService();
+
+    // Loads the indices and refreshes them on a background thread;
+    // returns at once
+    void start();
+    void stop();
+
+    // False until the first load has succeeded
+    bool ready() const { return ready_.load(); }
+
+    std::vector<std::string> suggest(const std::string& prefix, size_t limit) const;
+    std::vector<nlohmann::json> search(const std::string& query, const std::string& fuzziness,
+                                       int from, int size) const;
+
+    // Search documents as OpenSearchClient writes them ({id, title, author, category, ...})
+    void onIndexed(const std::vector<nlohmann::json>& docs);
+    void onDeleted(long id);
+
+private:
+    bool load();
+    // Applies the changes since the last load or refresh; false if it
+    // could not, and a full load is needed instead
+    bool applyChanges();
+    void refresh();
+
+    std::shared_ptr<PostgresAdapter> db_;
+    std::chrono::seconds refreshInterval_;
+    AutocompleteIndex autocomplete_;
+    FullTextIndex fullText_;
+    std::atomic<bool> ready_{false};
+    // Refresher thread only: the database time of the last load or
+    // refresh, and whether migration 005 is there to read changes from
+    std::string changesSince_;
+    bool changesAvailable_ = true;
+
+    std::thread refresher_;
+    std::mutex refreshMtx_;
+    std::condition_variable refreshCv_;
+    bool stopping_ = false;
+
+    Gauge& documents_;
+    Histogram& loadSeconds_;
+};
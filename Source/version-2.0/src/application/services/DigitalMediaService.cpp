@@ -7,9 +7,10 @@
 DigitalMediaService::DigitalMediaService(std::shared_ptr<PostgresAdapter> db,
                                          std::shared_ptr<S3StorageClient> storage,
                                          std::shared_ptr<KafkaProducer> events,
-                                         std::shared_ptr<RedisClient> cache)
+                                         std::shared_ptr<NearCache> cache,
+                                         std::shared_ptr<MultipartUploader> uploader)
     : db_(std::move(db)), storage_(std::move(storage)),
-      events_(std::move(events)), cache_(std::move(cache)) {}
+      events_(std::move(events)), cache_(std::move(cache)), uploader_(std::move(uploader)) {}
 
 std::string DigitalMediaService::generateS3Key(long mediaId, const std::string& mimeType, int version) {
     std::string ext = "bin";
@@ -23,39 +24,70 @@ std::string DigitalMediaService::generateS3Key(long mediaId, const std::string&
     return "digital-media/" + std::to_string(mediaId) + "/v" + std::to_string(version) + "." + ext;
 }
 
+DigitalMediaService::Blob DigitalMediaService::store(long mediaId, int version, const std::string& mimeType,
+                                                     std::string_view data) {
+    // Hashed before upload, so a duplicate is not sent at all
+    if (blobs_) return blobs_->put(data, mimeType);
+    return store(mediaId, version, mimeType, MultipartUploader::fromBuffer(data));
+}
+
+DigitalMediaService::Blob DigitalMediaService::store(long mediaId, int version, const std::string& mimeType,
+                                                     const MultipartUploader::Source& source) {
+    if (blobs_) return blobs_->put(source, mimeType);
+    std::string s3Key = generateS3Key(mediaId, mimeType, version);
+    auto stored = uploader_->upload(s3Key, mimeType, source);
+    return {stored.sha256, s3Key, stored.size, false};
+}
+
 nlohmann::json DigitalMediaService::uploadMedia(const std::string& title,
                                                  const std::string& mimeType,
-                                                 const std::string& fileData,
+                                                 std::string_view fileData,
                                                  bool drmProtected) {
-    if (title.empty())
-        throw ValidationException("Title cannot be empty");
     if (fileData.empty())
         throw ValidationException("File data cannot be empty");
+    return uploadMediaWith(title, mimeType, drmProtected, [this, fileData](long id, int version, const std::string& type) {
+        return store(id, version, type, fileData);
+    });
+}
+
+nlohmann::json DigitalMediaService::uploadMedia(const std::string& title,
+                                                 const std::string& mimeType,
+                                                 const MultipartUploader::Source& source,
+                                                 bool drmProtected) {
+    return uploadMediaWith(title, mimeType, drmProtected, [this, &source](long id, int version, const std::string& type) {
+        return store(id, version, type, source);
+    });
+}
+
+nlohmann::json DigitalMediaService::uploadMediaWith(const std::string& title,
+                                                     const std::string& mimeType,
+                                                     bool drmProtected,
+                                                     const StoreFn& storeFile) {
+    if (title.empty())
+        throw ValidationException("Title cannot be empty");
 
     // Create base media record (media_type_id 5 = DigitalMedia)
     long mediaId = db_->createMedia(5, title);
-    std::string s3Key = generateS3Key(mediaId, mimeType, 1);
 
-    // Upload to S3
-    if (!storage_->uploadFile(s3Key, fileData, mimeType)) {
-        throw DatabaseException("Failed to upload file to storage");
-    }
+    // Stream to S3
+    auto stored = storeFile(mediaId, 1, mimeType);
+    if (blobs_) blobs_->recordVersion(mediaId, 1, mimeType, drmProtected, stored);
 
-    // Insert digital_media record via raw SQL through connection
-    // For now, return metadata since we'd need to extend PostgresAdapter
     nlohmann::json metadata = {
         {"media_id", mediaId},
         {"title", title},
         {"mime_type", mimeType},
-        {"s3_key", s3Key},
-        {"file_size", fileData.size()},
+        {"s3_key", stored.s3Key},
+        {"file_size", stored.size},
+        {"sha256", stored.sha256},
+        {"deduplicated", stored.reused},
         {"drm_protected", drmProtected},
         {"current_version", 1},
         {"created_at", nowToString()}
     };
 
     // Cache metadata
-    cache_->setJson("digital_media:" + std::to_string(mediaId), metadata, 3600);
+    cache_->put("digital_media:" + std::to_string(mediaId), metadata, 3600);
 
     // Publish event
     events_->produceJson("media.events", "media.uploaded", {
@@ -63,7 +95,7 @@ nlohmann::json DigitalMediaService::uploadMedia(const std::string& title,
         {"media_id", mediaId},
         {"title", title},
         {"mime_type", mimeType},
-        {"file_size", fileData.size()},
+        {"file_size", stored.size},
         {"timestamp", nowToString()}
     });
 
@@ -75,10 +107,10 @@ std::string DigitalMediaService::getDownloadUrl(long mediaId, int expirySeconds)
         throw ValidationException("Invalid media ID");
 
     // Check cache for s3 key
-    auto cached = cache_->getJson("digital_media:" + std::to_string(mediaId));
+    auto cached = cache_->get("digital_media:" + std::to_string(mediaId));
     std::string s3Key;
-    if (cached.has_value() && cached->contains("s3_key")) {
-        s3Key = (*cached)["s3_key"].get<std::string>();
+    if (cached && cached->contains("s3_key")) {
+        s3Key = cached->at("s3_key").get<std::string>();
     } else {
         throw NotFoundException("Digital media not found: " + std::to_string(mediaId));
     }
@@ -90,39 +122,53 @@ std::string DigitalMediaService::getUploadUrl(long mediaId, const std::string& m
     if (mediaId <= 0)
         throw ValidationException("Invalid media ID");
 
-    auto cached = cache_->getJson("digital_media:" + std::to_string(mediaId));
+    auto cached = cache_->get("digital_media:" + std::to_string(mediaId));
     int nextVersion = 1;
-    if (cached.has_value() && cached->contains("current_version")) {
-        nextVersion = (*cached)["current_version"].get<int>() + 1;
+    if (cached && cached->contains("current_version")) {
+        nextVersion = cached->at("current_version").get<int>() + 1;
     }
 
     std::string s3Key = generateS3Key(mediaId, mimeType, nextVersion);
     return storage_->generatePresignedUploadUrl(s3Key, expirySeconds);
 }
 
-nlohmann::json DigitalMediaService::createVersion(long mediaId, const std::string& fileData) {
-    if (mediaId <= 0)
-        throw ValidationException("Invalid media ID");
+nlohmann::json DigitalMediaService::createVersion(long mediaId, std::string_view fileData) {
     if (fileData.empty())
         throw ValidationException("File data cannot be empty");
+    return createVersionWith(mediaId, [this, fileData](long id, int version, const std::string& type) {
+        return store(id, version, type, fileData);
+    });
+}
 
-    auto cached = cache_->getJson("digital_media:" + std::to_string(mediaId));
-    if (!cached.has_value())
+nlohmann::json DigitalMediaService::createVersion(long mediaId, const MultipartUploader::Source& source) {
+    return createVersionWith(mediaId, [this, &source](long id, int version, const std::string& type) {
+        return store(id, version, type, source);
+    });
+}
+
+nlohmann::json DigitalMediaService::createVersionWith(long mediaId, const StoreFn& storeFile) {
+    if (mediaId <= 0)
+        throw ValidationException("Invalid media ID");
+
+    auto cached = cache_->get("digital_media:" + std::to_string(mediaId));
+    if (!cached)
         throw NotFoundException("Digital media not found: " + std::to_string(mediaId));
 
-    int newVersion = (*cached)["current_version"].get<int>() + 1;
-    std::string mimeType = (*cached)["mime_type"].get<std::string>();
-    std::string s3Key = generateS3Key(mediaId, mimeType, newVersion);
+    int newVersion = cached->at("current_version").get<int>() + 1;
+    std::string mimeType = cached->at("mime_type").get<std::string>();
 
-    if (!storage_->uploadFile(s3Key, fileData, mimeType)) {
-        throw DatabaseException("Failed to upload new version to storage");
-    }
+    auto stored = storeFile(mediaId, newVersion, mimeType);
+    if (blobs_)
+        blobs_->recordVersion(mediaId, newVersion, mimeType, cached->value("drm_protected", false), stored);
 
-    // Update cached metadata
-    (*cached)["current_version"] = newVersion;
-    (*cached)["s3_key"] = s3Key;
-    (*cached)["file_size"] = fileData.size();
-    cache_->setJson("digital_media:" + std::to_string(mediaId), *cached, 3600);
+    // Update cached metadata; the cached object is shared, so edit a copy
+    nlohmann::json metadata = *cached;
+    metadata["current_version"] = newVersion;
+    metadata["s3_key"] = stored.s3Key;
+    metadata["file_size"] = stored.size;
+    metadata["sha256"] = stored.sha256;
+    metadata["deduplicated"] = stored.reused;
+    cache_->put("digital_media:" + std::to_string(mediaId), std::move(metadata), 3600);
 
     events_->produceJson("media.events", "media.versioned", {
         {"event", "DIGITAL_MEDIA_VERSION_CREATED"},
@@ -134,27 +180,45 @@ nlohmann::json DigitalMediaService::createVersion(long mediaId, const std::strin
     return {
         {"media_id", mediaId},
         {"version", newVersion},
-        {"s3_key", s3Key},
-        {"file_size", fileData.size()}
+        {"s3_key", stored.s3Key},
+        {"file_size", stored.size},
+        {"sha256", stored.sha256},
+        {"deduplicated", stored.reused}
     };
 }
 
 std::vector<nlohmann::json> DigitalMediaService::listVersions(long mediaId) {
     if (mediaId <= 0)
         throw ValidationException("Invalid media ID");
-    return storage_->listVersions("digital-media/" + std::to_string(mediaId) + "/");
+    if (blobs_) {
+        // Items stored before content addressing have S3 versions only
+        auto cached = cache_->get("digital_media:" + std::to_string(mediaId));
+        if (!cached || MediaBlobStore::owns(cached->value("s3_key", "")))
+            return blobs_->listVersions(mediaId);
+    }
+    auto versions = storage_->listVersions("digital-media/" + std::to_string(mediaId) + "/");
+    if (!versions)
+        throw DatabaseException("Failed to list versions from storage");
+    return std::move(*versions);
 }
 
 std::optional<nlohmann::json> DigitalMediaService::getMetadata(long mediaId) {
-    return cache_->getJson("digital_media:" + std::to_string(mediaId));
+    auto cached = cache_->get("digital_media:" + std::to_string(mediaId));
+    if (!cached) return std::nullopt;
+    return *cached;
 }
 
 bool DigitalMediaService::deleteMedia(long mediaId) {
-    auto cached = cache_->getJson("digital_media:" + std::to_string(mediaId));
-    if (cached.has_value() && cached->contains("s3_key")) {
-        storage_->deleteFile((*cached)["s3_key"].get<std::string>());
+    auto cached = cache_->get("digital_media:" + std::to_string(mediaId));
+    std::string s3Key = cached ? cached->value("s3_key", "") : "";
+    // Blobs may be shared; the collector deletes them once unreferenced
+    if (blobs_) blobs_->releaseMedia(mediaId);
+    // Not a blob: the item's own object, stored before content addressing or with it off
+    if (!s3Key.empty() && !(blobs_ && MediaBlobStore::owns(s3Key))) {
+        storage_->deleteFile(s3Key);
+        if (diskCache_) diskCache_->erase(s3Key);
     }
-    cache_->del("digital_media:" + std::to_string(mediaId));
+    cache_->invalidate("digital_media:" + std::to_string(mediaId));
 
     events_->produceJson("media.events", "media.deleted", {
         {"event", "DIGITAL_MEDIA_DELETED"},
@@ -164,3 +228,77 @@ bool DigitalMediaService::deleteMedia(long mediaId) {
 
     return true;
 }
+
+MediaContent DigitalMediaService::prepareContent(long mediaId, const std::string& rangeHeader,
+                                                 const std::string& ifNoneMatch) {
+    if (mediaId <= 0)
+        throw ValidationException("Invalid media ID");
+    auto cached = cache_->get("digital_media:" + std::to_string(mediaId));
+    if (!cached || !cached->contains("s3_key"))
+        throw NotFoundException("Digital media not found: " + std::to_string(mediaId));
+
+    MediaContent content;
+    content.s3Key = cached->at("s3_key").get<std::string>();
+    // A disk cache miss comes back with the HEAD it made
+    DiskCache::Lookup lookup;
+    if (diskCache_) lookup = diskCache_->get(content.s3Key);
+    else lookup.head = storage_->headObject(content.s3Key);
+    if (lookup.local) {
+        content.size = lookup.local->size;
+        content.etag = lookup.local->etag;
+        content.contentType = lookup.local->contentType;
+        content.localPath = lookup.local->path;
+    } else if (const auto& object = lookup.head.object) {
+        content.size = object->size;
+        content.etag = object->etag;
+        content.contentType = object->contentType;
+    } else if (lookup.head.status == 404) {
+        throw NotFoundException("Digital media file not found: " + std::to_string(mediaId));
+    } else {
+        throw DatabaseException("Storage unavailable for media " + std::to_string(mediaId));
+    }
+    // A shared blob carries the type it was first uploaded with
+    content.contentType = cached->value("mime_type", content.contentType);
+    if (content.contentType.empty()) content.contentType = "application/octet-stream";
+
+    if (!ifNoneMatch.empty() && etagMatches(ifNoneMatch, content.etag)) {
+        content.status = 304;
+        return content;
+    }
+
+    auto range = parseRange(rangeHeader, content.size);
+    switch (range.kind) {
+    case RangeRequest::Kind::Unsatisfiable:
+        content.status = 416;
+        break;
+    case RangeRequest::Kind::Partial:
+        content.status = 206;
+        if (range.range.length() > maxResponseBytes_)
+            range.range.last = range.range.first + maxResponseBytes_ - 1;
+        content.range = range.range;
+        break;
+    case RangeRequest::Kind::Whole:
+        // A local file is sent from disk, not from memory
+        if (content.localPath.empty() && content.size > maxResponseBytes_) {
+            content.status = 302;
+            content.location = storage_->generatePresignedDownloadUrl(content.s3Key, 3600);
+        }
+        break;
+    }
+    return content;
+}
+
+bool DigitalMediaService::streamContent(const MediaContent& content, const HttpBodySink& sink) {
+    if (!content.localPath.empty()) {
+        uint64_t offset = content.range ? content.range->first : 0;
+        return DiskCache::readRange(content.localPath, offset, content.length(), sink);
+    }
+    uint64_t received = 0;
+    auto res = storage_->downloadStream(content.s3Key, content.range, content.etag,
+                                        [&](std::string_view chunk) {
+                                            received += chunk.size();
+                                            return received <= content.length() && sink(chunk);
+                                        });
+    return res.curlCode == CURLE_OK && (res.status == 200 || res.status == 206)
+        && received == content.length();
+}
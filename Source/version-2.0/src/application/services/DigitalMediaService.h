@@ -1,14 +1,20 @@
 #pragma once
+#include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 #include <nlohmann/json.hpp>
 #include "src/data/PostgresAdapter.h"
+#include "src/infrastructure/storage/DiskCache.h"
+#include "src/infrastructure/storage/MediaBlobStore.h"
+#include "src/infrastructure/storage/MultipartUploader.h"
 #include "src/infrastructure/storage/S3StorageClient.h"
 #include "src/infrastructure/messaging/KafkaProducer.h"
-#include "src/infrastructure/cache/RedisClient.h"
+#include "src/infrastructure/cache/NearCache.h"
 #include "src/domain/media/DigitalMedia.h"
+#include "src/utils/HttpRange.h"
 
 struct DigitalMediaRecord {
     long id;
@@ -20,17 +26,39 @@ struct DigitalMediaRecord {
     int currentVersion;
 };
 
+// How to answer GET /api/digital-media/<id>/content
+struct MediaContent {
+    int status = 200;                  // 200, 206, 302, 304 or 416
+    std::string s3Key;
+    std::string contentType;
+    std::string etag;
+    uint64_t size = 0;                 // whole object
+    std::optional<ByteRange> range;    // the bytes to send, for 206
+    std::string location;              // presigned URL, for 302
+    std::string localPath;             // disk cache copy, when there is one
+
+    uint64_t length() const { return range ? range->length() : size; }
+};
+
 class DigitalMediaService {
 public:
     DigitalMediaService(std::shared_ptr<PostgresAdapter> db,
                         std::shared_ptr<S3StorageClient> storage,
                         std::shared_ptr<KafkaProducer> events,
-                        std::shared_ptr<RedisClient> cache);
+                        std::shared_ptr<NearCache> cache,
+                        std::shared_ptr<MultipartUploader> uploader);
 
     // Upload digital media (creates media + digital_media record + uploads to S3)
     nlohmann::json uploadMedia(const std::string& title,
                                const std::string& mimeType,
-                               const std::string& fileData,
+                               std::string_view fileData,
+                               bool drmProtected = false);
+
+    // Same, reading the file from source a part at a time; the result
+    // carries the file's SHA-256
+    nlohmann::json uploadMedia(const std::string& title,
+                               const std::string& mimeType,
+                               const MultipartUploader::Source& source,
                                bool drmProtected = false);
 
     // Generate presigned download URL
@@ -40,7 +68,8 @@ public:
     std::string getUploadUrl(long mediaId, const std::string& mimeType, int expirySeconds = 3600);
 
     // Create a new version of existing digital media
-    nlohmann::json createVersion(long mediaId, const std::string& fileData);
+    nlohmann::json createVersion(long mediaId, std::string_view fileData);
+    nlohmann::json createVersion(long mediaId, const MultipartUploader::Source& source);
 
     // List versions for a media item
     std::vector<nlohmann::json> listVersions(long mediaId);
@@ -51,11 +80,39 @@ public:
     // Delete digital media (file + record)
     bool deleteMedia(long mediaId);
 
+    // Resolves Range and If-None-Match against the object's size and ETag.
+    // A body over the response cap is cut to the cap when a range was
+    // asked for (players then ask for the next one), and is otherwise
+    // redirected to a presigned URL.
+    MediaContent prepareContent(long mediaId, const std::string& rangeHeader,
+                                const std::string& ifNoneMatch);
+    // Streams a 200 or 206 body from S3; false if S3 failed or the object
+    // changed after prepareContent
+    bool streamContent(const MediaContent& content, const HttpBodySink& sink);
+    void setMaxResponseBytes(uint64_t bytes) { maxResponseBytes_ = bytes; }
+    // Serves /content from local disk where it can
+    void setDiskCache(std::shared_ptr<DiskCache> diskCache) { diskCache_ = std::move(diskCache); }
+    // Stores files by content hash and records versions in Postgres
+    void setBlobStore(std::shared_ptr<MediaBlobStore> blobs) { blobs_ = std::move(blobs); }
+
 private:
+    using Blob = MediaBlobStore::Blob;
+    // Stores one version's bytes, given the media id, version and type
+    using StoreFn = std::function<Blob(long mediaId, int version, const std::string& mimeType)>;
+
     std::string generateS3Key(long mediaId, const std::string& mimeType, int version = 1);
+    Blob store(long mediaId, int version, const std::string& mimeType, std::string_view data);
+    Blob store(long mediaId, int version, const std::string& mimeType, const MultipartUploader::Source& source);
+    nlohmann::json uploadMediaWith(const std::string& title, const std::string& mimeType, bool drmProtected,
+                                   const StoreFn& storeFile);
+    nlohmann::json createVersionWith(long mediaId, const StoreFn& storeFile);
 
     std::shared_ptr<PostgresAdapter> db_;
     std::shared_ptr<S3StorageClient> storage_;
     std::shared_ptr<KafkaProducer> events_;
-    std::shared_ptr<RedisClient> cache_;
+    std::shared_ptr<NearCache> cache_;
+    std::shared_ptr<MultipartUploader> uploader_;
+    uint64_t maxResponseBytes_ = 8 * 1024 * 1024;
+    std::shared_ptr<DiskCache> diskCache_;
+    std::shared_ptr<MediaBlobStore> blobs_;
 };
@@ -0,0 +1,400 @@
+#include "ImportJobService.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
+#include "src/utils/CsvTokenizer.h"
+#include "src/utils/Exceptions.h"
+#include "src/utils/JsonRecordReader.h"
+#include "src/utils/StreamUtils.h"
+#include <chrono>
+#include <iostream>
+#include "pqxx/pqxx"
+
+namespace {
+
+// Rows per chunk; each chunk is imported as one transaction
+constexpr long kChunkRows = 5000;
+// Attempts per chunk before the job is failed
+constexpr int kMaxAttempts = 3;
+// Errors returned by getStatus; every failure is still counted
+constexpr int kMaxStatusErrors = 100;
+// How often the sweeper looks for unfinished or retryable chunks
+constexpr auto kSweepInterval = std::chrono::seconds(5);
+
+bool isBlankRecord(std::string_view record) {
+    if (!record.empty() && record.back() == '\n') record.remove_suffix(1);
+    if (!record.empty() && record.back() == '\r') record.remove_suffix(1);
+    return record.empty();
+}
+
+}
+
+ImportJobService::ImportJobService(std::shared_ptr<PostgresPool> pool,
+                                   std::shared_ptr<BatchImportService> importer,
+                                   size_t workers)
+    : pool_(std::move(pool)), importer_(std::move(importer)),
+      jobsSubmitted_(MetricsRegistry::instance().counter(
+          "import_jobs_submitted_total", "Import jobs accepted")),
+      chunksCompleted_(MetricsRegistry::instance().counter(
+          "import_chunks_completed_total", "Import chunks written and checkpointed")),
+      chunksRetried_(MetricsRegistry::instance().counter(
+          "import_chunks_retried_total", "Import chunk attempts that failed and were requeued")),
+      jobsFailed_(MetricsRegistry::instance().counter(
+          "import_jobs_failed_total", "Import jobs that gave up on a chunk")),
+      workers_(workers) {}
+
+ImportJobService::~ImportJobService() {
+    stop();
+}
+
+void ImportJobService::start() {
+    sweeper_ = std::thread([this]() {
+        std::cout << "[ImportJobs] Started with " << workers_.size() << " workers." << std::endl;
+        std::unique_lock lock(sweepMtx_);
+        while (!stopFlag_) {
+            lock.unlock();
+            scheduleDrains();
+            lock.lock();
+            sweepCv_.wait_for(lock, kSweepInterval, [this] { return stopFlag_.load(); });
+        }
+    });
+}
+
+void ImportJobService::stop() {
+    {
+        std::scoped_lock lock(sweepMtx_);
+        if (stopFlag_) return;
+        stopFlag_ = true;
+    }
+    sweepCv_.notify_all();
+    if (!sweeper_.joinable()) return;
+    sweeper_.join();
+    std::cout << "[ImportJobs] Stopped." << std::endl;
+}
+
+//  SUBMIT
+std::vector<ImportJobService::Chunk> ImportJobService::splitCsv(std::string_view body) {
+    std::vector<Chunk> chunks;
+    std::string_view header;
+    size_t chunkStart = 0;
+    long rows = 0, chunkRows = 0;
+
+    auto cut = [&](size_t end) {
+        if (chunkRows == 0) return;
+        std::string payload(header);
+        payload.append(body.substr(chunkStart, end - chunkStart));
+        chunks.push_back({rows - chunkRows, chunkRows, std::move(payload)});
+        chunkStart = end;
+        chunkRows = 0;
+    };
+
+    // Records are cut on line feeds outside quotes, so a chunk never splits a
+    // quoted field; every chunk repeats the header to stay self-contained
+    size_t pos = 0;
+    while (pos < body.size()) {
+        bool inQuotes = false;
+        size_t end = CsvTokenizer::findRecordEnd(body, pos, inQuotes);
+        if (end == CsvTokenizer::npos) {
+            if (inQuotes) throw ValidationException("CSV ends inside a quoted field");
+            end = body.size() - 1;
+        }
+        auto record = body.substr(pos, end + 1 - pos);
+        pos = end + 1;
+        if (isBlankRecord(record)) continue;
+
+        if (header.empty()) {
+            header = record;
+            chunkStart = pos;
+            continue;
+        }
+        ++rows;
+        if (++chunkRows == kChunkRows) cut(pos);
+    }
+    if (header.empty())
+        throw ValidationException("CSV has no header row");
+    cut(body.size());
+    return chunks;
+}
+
+std::vector<ImportJobService::Chunk> ImportJobService::splitJson(std::string_view body) {
+    std::vector<Chunk> chunks;
+    std::string payload;
+    long rows = 0, chunkRows = 0;
+
+    auto cut = [&]() {
+        if (chunkRows == 0) return;
+        payload.push_back(']');
+        chunks.push_back({rows - chunkRows, chunkRows, std::move(payload)});
+        payload.clear();
+        chunkRows = 0;
+    };
+
+    // Records are re-serialized as plain arrays; invalid records are kept
+    // so they are reported with their row number when the chunk runs
+    JsonRecordReader reader([&](nlohmann::json&& rec) {
+        payload.push_back(chunkRows == 0 ? '[' : ',');
+        payload.append(rec.dump());
+        ++rows;
+        if (++chunkRows == kChunkRows) cut();
+    });
+    MemoryIStream in(body);
+    nlohmann::json::sax_parse(in, &reader);
+
+    if (!reader.sawRecords())
+        throw ValidationException("Expected JSON array or object with 'records' array");
+    cut();
+    return chunks;
+}
+
+long ImportJobService::submit(const std::string& format, std::string_view body, int userId) {
+    std::vector<Chunk> chunks;
+    if (format == "csv") chunks = splitCsv(body);
+    else if (format == "json") chunks = splitJson(body);
+    else throw ValidationException("Unknown import format: " + format);
+
+    long rowsTotal = 0;
+    for (const auto& c : chunks) rowsTotal += c.rowCount;
+
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+
+    // A job without rows has nothing to wait for
+    auto r = txn.exec(
+        "INSERT INTO import_job (format, status, created_by, total_chunks, rows_total, started_at, finished_at) "
+        "VALUES ($1, $2, NULLIF($3, 0), $4, $5, "
+        "        CASE WHEN $4 = 0 THEN now() END, CASE WHEN $4 = 0 THEN now() END) "
+        "RETURNING id;",
+        pqxx::params{format, chunks.empty() ? "COMPLETED" : "QUEUED", userId,
+                     static_cast<int>(chunks.size()), rowsTotal});
+    long jobId = r[0]["id"].as<long>();
+
+    auto stream = pqxx::stream_to::table(txn, {"import_job_chunk"},
+        {"job_id", "chunk_no", "first_row", "row_count", "payload"});
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        const auto& c = chunks[i];
+        stream.write_values(jobId, static_cast<int>(i), c.firstRow, c.rowCount, c.payload);
+    }
+    stream.complete();
+    txn.commit();
+
+    jobsSubmitted_.inc();
+    std::cout << "[ImportJobs] Job " << jobId << " queued: " << rowsTotal << " " << format
+              << " rows in " << chunks.size() << " chunks" << std::endl;
+
+    if (!chunks.empty()) scheduleDrains();
+    return jobId;
+}
+
+//  STATUS
+ImportJobStatus ImportJobService::getStatus(long jobId) {
+    auto conn = pool_->acquire();
+    pqxx::read_transaction txn(*conn);
+
+    auto r = txn.exec(
+        "SELECT j.format, j.status, j.total_chunks, j.rows_total, j.last_error, "
+        "       j.created_at::text AS created_at, j.started_at::text AS started_at, "
+        "       j.finished_at::text AS finished_at, "
+        "       COALESCE(EXTRACT(EPOCH FROM COALESCE(j.finished_at, now()) - j.started_at), 0)::float8 AS elapsed, "
+        "       COUNT(c.chunk_no) FILTER (WHERE c.status = 'DONE') AS chunks_done, "
+        "       COALESCE(SUM(c.row_count) FILTER (WHERE c.status = 'DONE'), 0) AS rows_processed, "
+        "       COALESCE(SUM(c.rows_imported), 0) AS rows_imported, "
+        "       COALESCE(SUM(c.rows_failed), 0) AS rows_failed "
+        "FROM import_job j LEFT JOIN import_job_chunk c ON c.job_id = j.id "
+        "WHERE j.id = $1 GROUP BY j.id;",
+        pqxx::params{jobId});
+    if (r.empty()) throw NotFoundException("Import job " + std::to_string(jobId));
+
+    const auto& row = r[0];
+    ImportJobStatus s{};
+    s.id = jobId;
+    s.format = row["format"].as<std::string>();
+    s.status = row["status"].as<std::string>();
+    s.chunksTotal = row["total_chunks"].as<int>();
+    s.chunksDone = row["chunks_done"].as<int>();
+    s.rowsTotal = row["rows_total"].as<long>();
+    s.rowsProcessed = row["rows_processed"].as<long>();
+    s.rowsImported = row["rows_imported"].as<long>();
+    s.rowsFailed = row["rows_failed"].as<long>();
+    s.elapsedSeconds = row["elapsed"].as<double>();
+    s.createdAt = row["created_at"].as<std::string>();
+    if (!row["started_at"].is_null()) s.startedAt = row["started_at"].as<std::string>();
+    if (!row["finished_at"].is_null()) s.finishedAt = row["finished_at"].as<std::string>();
+    if (!row["last_error"].is_null()) s.lastError = row["last_error"].as<std::string>();
+
+    // Progress advances a chunk at a time, so the rate is averaged over the run
+    s.rowsPerSecond = s.elapsedSeconds > 0 ? s.rowsProcessed / s.elapsedSeconds : 0.0;
+    if (s.status == "COMPLETED")
+        s.etaSeconds = 0.0;
+    else if (s.status != "FAILED" && s.rowsPerSecond > 0)
+        s.etaSeconds = (s.rowsTotal - s.rowsProcessed) / s.rowsPerSecond;
+
+    auto errors = txn.exec(
+        "SELECT e.msg FROM import_job_chunk c "
+        "CROSS JOIN LATERAL jsonb_array_elements_text(c.errors) WITH ORDINALITY AS e(msg, n) "
+        "WHERE c.job_id = $1 ORDER BY c.chunk_no, e.n LIMIT $2;",
+        pqxx::params{jobId, kMaxStatusErrors});
+    for (const auto& e : errors) s.errors.push_back(e["msg"].as<std::string>());
+
+    return s;
+}
+
+//  WORKERS
+void ImportJobService::scheduleDrains() {
+    // One drain per idle worker; each keeps claiming chunks until none are left
+    for (size_t n = activeDrains_.load(); n < workers_.size() && !stopFlag_; n = activeDrains_.load()) {
+        if (activeDrains_.compare_exchange_weak(n, n + 1))
+            workers_.submit([this] { drain(); });
+    }
+}
+
+void ImportJobService::drain() {
+    try {
+        while (!stopFlag_ && processNextChunk()) {}
+    } catch (const std::exception& e) {
+        std::cerr << "[ImportJobs] Worker error: " << e.what() << std::endl;
+    }
+    --activeDrains_;
+}
+
+bool ImportJobService::processNextChunk() {
+    ClaimedChunk chunk;
+    {
+        auto conn = pool_->acquire();
+        pqxx::work txn(*conn);
+
+        // Pending chunks back off between attempts; a RUNNING chunk whose
+        // claim is old belongs to a worker that died and is taken over
+        auto r = txn.exec(
+            "UPDATE import_job_chunk c "
+            "SET status = 'RUNNING', attempts = c.attempts + 1, claimed_at = now() "
+            "FROM import_job j "
+            "WHERE j.id = c.job_id AND (c.job_id, c.chunk_no) = ("
+            "    SELECT k.job_id, k.chunk_no FROM import_job_chunk k "
+            "    JOIN import_job kj ON kj.id = k.job_id AND kj.status IN ('QUEUED', 'RUNNING') "
+            "    WHERE (k.status = 'PENDING' AND (k.claimed_at IS NULL "
+            "               OR k.claimed_at < now() - make_interval(secs => 5 * k.attempts))) "
+            "       OR (k.status = 'RUNNING' AND k.claimed_at < now() - interval '5 minutes') "
+            "    ORDER BY k.job_id, k.chunk_no LIMIT 1 "
+            "    FOR UPDATE OF k SKIP LOCKED) "
+            "RETURNING c.job_id, c.chunk_no, c.first_row, c.attempts, c.payload, j.format;");
+        if (r.empty()) {
+            txn.commit();
+            return false;
+        }
+
+        const auto& row = r[0];
+        chunk = ClaimedChunk{row["job_id"].as<long>(), row["chunk_no"].as<int>(),
+                             row["first_row"].as<long>(), row["attempts"].as<int>(),
+                             row["format"].as<std::string>(), row["payload"].as<std::string>()};
+
+        txn.exec(
+            "UPDATE import_job SET status = 'RUNNING', started_at = COALESCE(started_at, now()) "
+            "WHERE id = $1 AND status = 'QUEUED';",
+            pqxx::params{chunk.jobId});
+        txn.commit();
+    }
+
+    // The connection is released above; the import takes its own from the pool
+    try {
+        if (chunk.attempts > kMaxAttempts)
+            throw std::runtime_error("chunk was abandoned by its worker");
+
+        MemoryIStream in(chunk.payload);
+        bool checkpointed = false;
+        auto result = importer_->importChunk(
+            chunk.format, in, static_cast<size_t>(chunk.firstRow),
+            [&](pqxx::work& txn, const ImportResult& r) { markDone(txn, chunk, r); },
+            checkpointed);
+
+        // No valid rows, so no transaction carried the checkpoint
+        if (!checkpointed) {
+            auto conn = pool_->acquire();
+            pqxx::work txn(*conn);
+            markDone(txn, chunk, result);
+            txn.commit();
+        }
+        chunksCompleted_.inc();
+    } catch (const std::exception& e) {
+        failChunk(chunk, e.what());
+    }
+
+    completeIfDone(chunk.jobId);
+    return true;
+}
+
+void ImportJobService::markDone(pqxx::work& txn, const ClaimedChunk& chunk, const ImportResult& result) {
+    // Matching on attempts makes sure this worker still owns the chunk
+    auto r = txn.exec(
+        "UPDATE import_job_chunk "
+        "SET status = 'DONE', rows_imported = $3, rows_failed = $4, errors = $5::jsonb, "
+        "    payload = '', last_error = NULL, finished_at = now() "
+        "WHERE job_id = $1 AND chunk_no = $2 AND status = 'RUNNING' AND attempts = $6;",
+        pqxx::params{chunk.jobId, chunk.chunkNo, result.successCount, result.failureCount,
+                     nlohmann::json(result.errors).dump(), chunk.attempts});
+    if (r.affected_rows() == 0)
+        throw std::runtime_error("chunk was reclaimed by another worker");
+}
+
+void ImportJobService::failChunk(const ClaimedChunk& chunk, const std::string& error) {
+    std::cerr << "[ImportJobs] Job " << chunk.jobId << " chunk " << chunk.chunkNo
+              << " attempt " << chunk.attempts << " failed: " << error << std::endl;
+    try {
+        auto conn = pool_->acquire();
+        pqxx::work txn(*conn);
+        auto r = txn.exec(
+            "UPDATE import_job_chunk "
+            "SET status = CASE WHEN attempts >= $3 THEN 'FAILED' ELSE 'PENDING' END, "
+            "    last_error = $4, claimed_at = now() "
+            "WHERE job_id = $1 AND chunk_no = $2 AND status = 'RUNNING' AND attempts = $5 "
+            "RETURNING status;",
+            pqxx::params{chunk.jobId, chunk.chunkNo, kMaxAttempts, error, chunk.attempts});
+
+        if (!r.empty() && r[0]["status"].as<std::string>() == "FAILED") {
+            txn.exec(
+                "UPDATE import_job SET status = 'FAILED', finished_at = now(), last_error = $2 "
+                "WHERE id = $1 AND status IN ('QUEUED', 'RUNNING');",
+                pqxx::params{chunk.jobId, "chunk " + std::to_string(chunk.chunkNo) + ": " + error});
+            jobsFailed_.inc();
+        } else if (!r.empty()) {
+            chunksRetried_.inc();
+        }
+        txn.commit();
+    } catch (const std::exception& e) {
+        // The claim expires and the chunk is retried by the sweeper
+        std::cerr << "[ImportJobs] Could not record failure: " << e.what() << std::endl;
+    }
+}
+
+void ImportJobService::completeIfDone(long jobId) {
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+
+    // The job row lock serializes workers finishing the last chunks, so
+    // exactly one of them sees every chunk done and completes the job
+    auto job = txn.exec("SELECT status FROM import_job WHERE id = $1 FOR UPDATE;",
+                        pqxx::params{jobId});
+    if (job.empty() || job[0]["status"].as<std::string>() != "RUNNING") {
+        txn.commit();
+        return;
+    }
+
+    auto r = txn.exec(
+        "SELECT COUNT(*) FILTER (WHERE status <> 'DONE') AS remaining, "
+        "       COALESCE(SUM(row_count), 0) AS total, "
+        "       COALESCE(SUM(rows_imported), 0) AS imported, "
+        "       COALESCE(SUM(rows_failed), 0) AS failed "
+        "FROM import_job_chunk WHERE job_id = $1;",
+        pqxx::params{jobId});
+    if (r[0]["remaining"].as<long>() > 0) {
+        txn.commit();
+        return;
+    }
+
+    txn.exec("UPDATE import_job SET status = 'COMPLETED', finished_at = now() WHERE id = $1;",
+             pqxx::params{jobId});
+    txn.commit();
+
+    ImportResult totals{r[0]["total"].as<int>(), r[0]["imported"].as<int>(),
+                        r[0]["failed"].as<int>(), {}};
+    std::cout << "[ImportJobs] Job " << jobId << " completed: " << totals.successCount
+              << " imported, " << totals.failureCount << " failed" << std::endl;
+    importer_->publishCompleted(totals);
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "src/application/services/BatchImportService.h"
+#include "src/infrastructure/db/PostgresPool.h"
+#include "src/utils/ThreadPool.h"
+
+class Counter;
+
+struct ImportJobStatus {
+    long id;
+    std::string format;
+    std::string status;           // QUEUED, RUNNING, COMPLETED or FAILED
+    int chunksTotal;
+    int chunksDone;
+    long rowsTotal;
+    long rowsProcessed;
+    long rowsImported;
+    long rowsFailed;
+    double elapsedSeconds;
+    double rowsPerSecond;
+    std::optional<double> etaSeconds;
+    std::string createdAt;
+    std::optional<std::string> startedAt;
+    std::optional<std::string> finishedAt;
+    std::optional<std::string> lastError;
+    std::vector<std::string> errors;
+};
+
+// Runs imports in the background. An upload is split into self-contained
+// chunks that are stored in Postgres and claimed by a worker pool; a chunk
+// is marked done in the transaction that writes its rows, so an interrupted
+// import continues from its unfinished chunks.
+class ImportJobService {
+public:
+    ImportJobService(std::shared_ptr<PostgresPool> pool,
+                     std::shared_ptr<BatchImportService> importer,
+                     size_t workers);
+    ~ImportJobService();
+
+    // Validates and stores the upload ("csv" or "json") and returns the job id
+    long submit(const std::string& format, std::string_view body, int userId);
+
+    ImportJobStatus getStatus(long jobId);
+
+    // Starts the sweeper that resumes unfinished and retried chunks
+    void start();
+    void stop();
+
+private:
+    struct Chunk {
+        long firstRow;
+        long rowCount;
+        std::string payload;
+    };
+
+    struct ClaimedChunk {
+        long jobId;
+        int chunkNo;
+        long firstRow;
+        int attempts;
+        std::string format;
+        std::string payload;
+    };
+
+    static std::vector<Chunk> splitCsv(std::string_view body);
+    static std::vector<Chunk> splitJson(std::string_view body);
+
+    void scheduleDrains();
+    void drain();
+    bool processNextChunk();
+    void markDone(pqxx::work& txn, const ClaimedChunk& chunk, const ImportResult& result);
+    void failChunk(const ClaimedChunk& chunk, const std::string& error);
+    void completeIfDone(long jobId);
+
+    std::shared_ptr<PostgresPool> pool_;
+    std::shared_ptr<BatchImportService> importer_;
+
+    Counter& jobsSubmitted_;
+    Counter& chunksCompleted_;
+    Counter& chunksRetried_;
+    Counter& jobsFailed_;
+
+    std::atomic<bool> stopFlag_{false};
+    std::atomic<size_t> activeDrains_{0};
+    std::mutex sweepMtx_;
+    std::condition_variable sweepCv_;
+    std::thread sweeper_;
+
+    // Declared last so workers are joined before anything they use is destroyed
+    ThreadPool workers_;
+};
@@ -15,7 +15,6 @@ long LibraryService::createBook(int mediaTypeId, const std::string& title,
     if (title.empty() || author.empty())
         throw ValidationException("Title and Author cannot be empty");
 
-    std::lock_guard<std::mutex> lock(mtx_);
     try {
         long mediaId = db_->createMedia(mediaTypeId, title);
         db_->attachBook(mediaId, author, isbn);
@@ -38,7 +37,6 @@ long LibraryService::createMagazine(int mediaTypeId, const std::string& title,
     if (title.empty() || publisher.empty())
         throw ValidationException("Title and Publisher cannot be empty");
 
-    std::lock_guard<std::mutex> lock(mtx_);
     try {
         long mediaId = db_->createMedia(mediaTypeId, title);
         db_->attachMagazine(mediaId, issueNumber, publisher);
@@ -60,7 +58,6 @@ long LibraryService::createCopy(long mediaId, const std::string& condition) {
     if (mediaId <= 0)
         throw ValidationException("Invalid media ID");
 
-    std::lock_guard<std::mutex> lock(mtx_);
     try {
         auto copy = db_->createMediaCopy(mediaId, condition);
         enqueueLog("CREATE_COPY", 0, copy.copyId);
@@ -72,42 +69,36 @@ long LibraryService::createCopy(long mediaId, const std::string& condition) {
 
 // --- Borrow / Return ---
 
-void LibraryService::borrowCopy(int userId, long copyId) {
+BorrowOutcome LibraryService::borrowCopy(int userId, long copyId) {
     if (userId <= 0 || copyId <= 0)
         throw ValidationException("Invalid user or copy ID");
 
-    std::lock_guard<std::mutex> lock(mtx_);
+    BorrowOutcome outcome;
     try {
-        auto copy = db_->getCopy(copyId);
-        if (!copy.isAvailable)
-            throw ValidationException("Copy not available for borrowing");
-
-        db_->addActiveBorrow(userId, copyId);
-        enqueueLog("BORROW_COPY", userId, copyId);
-    } catch (const ValidationException&) {
-        throw;
+        outcome = db_->borrowCopy(userId, copyId);
     } catch (const std::exception& e) {
         throw DatabaseException("Borrow operation failed: " + std::string(e.what()));
     }
+
+    if (outcome == BorrowOutcome::Borrowed)
+        enqueueLog("BORROW_COPY", userId, copyId);
+    return outcome;
 }
 
-void LibraryService::returnCopy(int userId, long copyId) {
+ReturnOutcome LibraryService::returnCopy(int userId, long copyId) {
     if (userId <= 0 || copyId <= 0)
         throw ValidationException("Invalid user or copy ID");
 
-    std::lock_guard<std::mutex> lock(mtx_);
+    ReturnOutcome outcome;
     try {
-        auto borrow = db_->findActiveBorrow(userId, copyId);
-        if (!borrow.has_value())
-            throw ValidationException("Copy not borrowed by this user");
-
-        db_->markCopyReturned(copyId);
-        enqueueLog("RETURN_COPY", userId, copyId);
-    } catch (const ValidationException&) {
-        throw;
+        outcome = db_->returnCopy(userId, copyId);
     } catch (const std::exception& e) {
         throw DatabaseException("Return operation failed: " + std::string(e.what()));
     }
+
+    if (outcome == ReturnOutcome::Returned)
+        enqueueLog("RETURN_COPY", userId, copyId);
+    return outcome;
 }
 
 // --- Queries ---
@@ -120,6 +111,18 @@ std::vector<std::shared_ptr<Media>> LibraryService::getAllMedia() {
     }
 }
 
+size_t LibraryService::streamMedia(long afterId, size_t limit,
+                                   const std::function<void(long, std::string_view)>& fn) {
+    if (afterId < 0)
+        throw ValidationException("Invalid after_id");
+
+    try {
+        return db_->streamMediaPage(afterId, limit, fn);
+    } catch (const std::exception& e) {
+        throw DatabaseException("Failed to fetch media: " + std::string(e.what()));
+    }
+}
+
 std::vector<MediaCopy> LibraryService::listCopiesByMedia(long mediaId) {
     if (mediaId <= 0)
         throw ValidationException("Invalid media ID");
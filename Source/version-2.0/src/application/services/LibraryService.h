@@ -1,6 +1,5 @@
 #pragma once
 #include <memory>
-#include <mutex>
 #include <optional>
 #include <vector>
 #include <string>
@@ -8,6 +7,7 @@
 #include "src/domain/media/Media.h"
 #include "src/domain/media/MediaCopy.h"
 #include "src/domain/borrow/BorrowRecord.h"
+#include "src/domain/borrow/BorrowOutcome.h"
 #include "src/data/PostgresAdapter.h"
 #include "src/application/services/QueueService.h"
 #include "src/infrastructure/search/OpenSearchClient.h"
@@ -27,11 +27,15 @@ public:
     long createCopy(long mediaId, const std::string& condition = "GOOD");
 
     // --- Borrow / Return ---
-    void borrowCopy(int userId, long copyId);
-    void returnCopy(int userId, long copyId);
+    // Single atomic statement each; no in-process locking, safe across instances
+    BorrowOutcome borrowCopy(int userId, long copyId);
+    ReturnOutcome returnCopy(int userId, long copyId);
 
     // --- Queries ---
     std::vector<std::shared_ptr<Media>> getAllMedia();
+    // Keyset pagination over the catalogue; see PostgresAdapter::streamMediaPage
+    size_t streamMedia(long afterId, size_t limit,
+                       const std::function<void(long, std::string_view)>& fn);
     std::vector<MediaCopy> listCopiesByMedia(long mediaId);
     std::vector<nlohmann::json> searchMedia(const std::string& query);
 
@@ -41,5 +45,4 @@ private:
     std::shared_ptr<PostgresAdapter> db_;
     std::shared_ptr<QueueService> queue_;
     std::shared_ptr<OpenSearchClient> search_;
-    std::mutex mtx_;
 };
@@ -1,12 +1,13 @@
 #pragma once
 #include "QueueService.h"
-#include <pqxx/pqxx>
+#include <memory>
+#include "src/infrastructure/db/PostgresPool.h"
 
 class PgQueueService : public QueueService {
 public:
-    explicit PgQueueService(std::shared_ptr<pqxx::connection> conn);
+    explicit PgQueueService(std::shared_ptr<PostgresPool> pool);
     void enqueue(const std::string& taskType, const nlohmann::json& payload) override;
 
 private:
-    std::shared_ptr<pqxx::connection> conn_;
+    std::shared_ptr<PostgresPool> pool_;
 };
@@ -0,0 +1,179 @@
+#include "ReindexService.h"
+#include "src/utils/DateTimeUtils.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Passes over rows created during the main scan before giving up on
+// catching up; anything later still reaches the new index via the shadow alias
+constexpr int kCatchUpPasses = 5;
+
+json toSearchDocument(const MediaSearchRow& row) {
+    json suggest = json::array({row.title});
+    if (!row.author.empty()) suggest.push_back(row.author);
+    return {
+        {"id", row.id}, {"title", row.title},
+        {"author", row.author}, {"category", row.category},
+        {"suggest", std::move(suggest)}
+    };
+}
+
+// Version of a media_v<N> index name, or 0
+int indexVersion(const std::string& name) {
+    std::string prefix = std::string(OpenSearchClient::kAlias) + "_v";
+    if (name.rfind(prefix, 0) != 0) return 0;
+    try {
+        return std::stoi(name.substr(prefix.size()));
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+}
+
+ReindexService::ReindexService(std::shared_ptr<PostgresAdapter> db,
+                               std::shared_ptr<OpenSearchClient> search)
+    : db_(std::move(db)), search_(std::move(search)) {}
+
+ReindexService::~ReindexService() {
+    if (worker_.joinable()) worker_.join();
+}
+
+bool ReindexService::claim() {
+    std::scoped_lock lock(mtx_);
+    if (running_) return false;
+    running_ = true;
+    status_ = ReindexStatus{};
+    status_.state = "RUNNING";
+    status_.startedAt = nowToString();
+    started_ = Clock::now();
+    docsRead_ = 0;
+    return true;
+}
+
+bool ReindexService::start() {
+    if (!claim()) return false;
+    if (worker_.joinable()) worker_.join();
+    worker_ = std::thread([this] { reindex(); });
+    return true;
+}
+
+ReindexStatus ReindexService::run() {
+    if (!claim()) throw std::runtime_error("A reindex is already running");
+    reindex();
+    return status();
+}
+
+ReindexStatus ReindexService::status() const {
+    std::scoped_lock lock(mtx_);
+    ReindexStatus s = status_;
+    if (s.state == "RUNNING") {
+        s.docsRead = docsRead_.load();
+        s.elapsedSeconds = std::chrono::duration<double>(Clock::now() - started_).count();
+        s.docsPerSecond = s.elapsedSeconds > 0 ? s.docsRead / s.elapsedSeconds : 0.0;
+    }
+    return s;
+}
+
+void ReindexService::reindex() {
+    std::string target;
+    try {
+        auto previous = search_->aliasTargets();
+        if (!previous) throw std::runtime_error("Could not read the current search index layout");
+
+        int version = 0;
+        for (const auto& name : previous->indices) version = std::max(version, indexVersion(name));
+        target = std::string(OpenSearchClient::kAlias) + "_v" + std::to_string(version + 1);
+        {
+            std::scoped_lock lock(mtx_);
+            status_.targetIndex = target;
+        }
+
+        // A leftover from an interrupted run is never behind the alias
+        search_->deleteIndex(target);
+        if (!search_->createIndex(target, true))
+            throw std::runtime_error("Could not create index " + target);
+
+        // Live writes on every instance go to both indices from here until
+        // the swap. The snapshot is loaded with op_type create, so a document
+        // a live write already updated or deleted (a tombstone) is kept.
+        if (!search_->setShadowIndex(target))
+            throw std::runtime_error("Could not point " + std::string(OpenSearchClient::kShadowAlias)
+                                     + " at " + target);
+        // Other instances look the shadow alias up again within this
+        // interval; a write that missed it must be in the snapshot
+        std::this_thread::sleep_for(search_->shadowRefreshInterval());
+        std::cout << "[Reindex] Loading " << target << std::endl;
+
+        auto indexer = search_->createBulkIndexer(target, "create");
+        auto onRow = [&](const MediaSearchRow& row) {
+            indexer->add(toSearchDocument(row));
+            ++docsRead_;
+        };
+        long lastId = db_->streamSearchRows(0, onRow);
+
+        // Rows committed after the scan's snapshot have higher ids
+        for (int pass = 0; pass < kCatchUpPasses; ++pass) {
+            long next = db_->streamSearchRows(lastId, onRow);
+            if (next == lastId) break;
+            lastId = next;
+        }
+
+        auto stats = indexer->close();
+        {
+            std::scoped_lock lock(mtx_);
+            status_.docsIndexed = static_cast<long>(stats.indexed);
+            status_.docsFailed = static_cast<long>(stats.failed);
+        }
+        if (stats.failed > 0)
+            throw std::runtime_error(std::to_string(stats.failed) + " documents were rejected: " +
+                                     (stats.errors.empty() ? "" : stats.errors.front()));
+
+        if (!search_->finishBulkLoad(target))
+            throw std::runtime_error("Could not restore settings on " + target);
+        if (!search_->swapAlias(target, *previous))
+            throw std::runtime_error("Could not move alias to " + target);
+        // Tombstones match no query, so they only need to go eventually
+        if (!search_->purgeTombstones(target))
+            std::cerr << "[Reindex] Could not purge tombstones from " << target << std::endl;
+
+        // A pre-alias index was already removed by the swap
+        if (previous->isAlias)
+            for (const auto& old : previous->indices)
+                if (old != target) search_->deleteIndex(old);
+
+        std::scoped_lock lock(mtx_);
+        status_.state = "COMPLETED";
+        status_.finishedAt = nowToString();
+        status_.docsRead = docsRead_.load();
+        status_.elapsedSeconds = std::chrono::duration<double>(Clock::now() - started_).count();
+        status_.docsPerSecond = status_.elapsedSeconds > 0 ? status_.docsRead / status_.elapsedSeconds : 0.0;
+        std::cout << "[Reindex] " << target << " is live: " << status_.docsIndexed << " documents in "
+                  << status_.elapsedSeconds << "s (" << static_cast<long>(status_.docsPerSecond)
+                  << " docs/sec)" << std::endl;
+    } catch (const std::exception& e) {
+        // The alias was not touched; dropping the half-built index drops
+        // the shadow alias with it
+        if (!target.empty()) search_->deleteIndex(target);
+        fail(e.what());
+    }
+
+    std::scoped_lock lock(mtx_);
+    running_ = false;
+}
+
+void ReindexService::fail(const std::string& error) {
+    std::cerr << "[Reindex] Failed: " << error << std::endl;
+    std::scoped_lock lock(mtx_);
+    status_.state = "FAILED";
+    status_.finishedAt = nowToString();
+    status_.docsRead = docsRead_.load();
+    status_.elapsedSeconds = std::chrono::duration<double>(Clock::now() - started_).count();
+    status_.error = error;
+}
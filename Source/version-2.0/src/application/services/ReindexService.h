@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include "src/data/PostgresAdapter.h"
+#include "src/infrastructure/search/OpenSearchClient.h"
+
+struct ReindexStatus {
+    std::string state = "IDLE";   // IDLE, RUNNING, COMPLETED or FAILED
+    std::string targetIndex;
+    long docsRead = 0;
+    long docsIndexed = 0;
+    long docsFailed = 0;
+    double elapsedSeconds = 0;
+    double docsPerSecond = 0;
+    std::optional<std::string> startedAt;
+    std::optional<std::string> finishedAt;
+    std::optional<std::string> error;
+};
+
+// Rebuilds the search index from Postgres. The catalogue is streamed into
+// a new versioned index while the alias keeps serving the old one, then the
+// alias is swapped in a single call, so readers never see a partial index.
+// Meanwhile every instance's live writes reach the new index through the
+// shadow alias, and the snapshot never overwrites them. The snapshot starts
+// one shadow refresh interval after the shadow alias is set, once every
+// instance writes through it.
+class ReindexService {
+public:
+    ReindexService(std::shared_ptr<PostgresAdapter> db,
+                   std::shared_ptr<OpenSearchClient> search);
+    ~ReindexService();
+
+    // Starts a reindex in the background; false if one is already running
+    bool start();
+
+    // Runs a reindex on the calling thread and returns its final status
+    ReindexStatus run();
+
+    ReindexStatus status() const;
+
+private:
+    // Marks a run as started; false if one is in progress
+    bool claim();
+    void reindex();
+    void fail(const std::string& error);
+
+    std::shared_ptr<PostgresAdapter> db_;
+    std::shared_ptr<OpenSearchClient> search_;
+
+    mutable std::mutex mtx_;
+    ReindexStatus status_;
+    bool running_ = false;
+    std::chrono::steady_clock::time_point started_;
+    std::atomic<long> docsRead_{0};
+    std::thread worker_;
+};
@@ -0,0 +1,258 @@
+#include "SearchService.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
+#include "src/utils/Exceptions.h"
+#include "src/utils/StringUtils.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// How long OpenSearch is bypassed after a failed request
+constexpr std::chrono::seconds kUpstreamRetryAfter{5};
+
+// Unit separator keeps the free-text query from colliding with the other fields
+std::string searchKey(const SearchQuery& q) {
+    return "q\x1f" + q.fuzziness + '\x1f' + std::to_string(q.from) + '\x1f' +
+           std::to_string(q.size) + '\x1f' + (q.after ? SearchService::encodeCursor(*q.after) : "") +
+           '\x1f' + q.text;
+}
+
+SearchService::Results page(std::vector<nlohmann::json> hits) {
+    SearchService::Results results = {{"hits", nlohmann::json::array()}, {"next_cursor", nullptr}};
+    for (auto& hit : hits) results["hits"].push_back(std::move(hit));
+    return results;
+}
+
+std::string suggestKey(const std::string& prefix, int maxResults) {
+    return "s\x1f" + std::to_string(maxResults) + '\x1f' + prefix;
+}
+
+}
+
+SearchService::SearchService(std::shared_ptr<LibraryService> library,
+                             std::shared_ptr<OpenSearchClient> search,
+                             size_t workers, size_t maxQueued,
+                             std::shared_ptr<SearchCache> cache,
+                             std::shared_ptr<CatalogIndexService> catalog)
+    : library_(std::move(library)), search_(std::move(search)), cache_(std::move(cache)),
+      catalog_(std::move(catalog)),
+      maxQueued_(maxQueued),
+      requests_(MetricsRegistry::instance().counter(
+          "search_requests_total", "Search and suggest requests")),
+      coalesced_(MetricsRegistry::instance().counter(
+          "search_coalesced_total", "Search requests answered by an identical in-flight query")),
+      upstream_(MetricsRegistry::instance().counter(
+          "search_upstream_requests_total", "Queries sent to the search backend")),
+      rejected_(MetricsRegistry::instance().counter(
+          "search_rejected_total", "Search requests rejected because the queue was full")),
+      localSuggestions_(MetricsRegistry::instance().counter(
+          "search_suggest_local_total", "Suggest requests answered by the in-process autocomplete index")),
+      fallbacks_(MetricsRegistry::instance().counter(
+          "search_fallback_total", "Searches answered without OpenSearch because it failed")),
+      postgresSearches_(MetricsRegistry::instance().counter(
+          "search_postgres_total", "Searches answered by PostgreSQL full-text search")),
+      busyWorkers_(MetricsRegistry::instance().gauge(
+          "search_workers_busy", "Search workers running a query")),
+      queueDepth_(MetricsRegistry::instance().gauge(
+          "search_queue_depth", "Queries waiting for a search worker")),
+      latency_(MetricsRegistry::instance().histogram(
+          "search_request_seconds", "Search latency from request to response",
+          {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0})),
+      workers_(workers) {}
+
+void SearchService::setPostgres(std::shared_ptr<PostgresAdapter> db, PostgresSearchOptions options) {
+    db_ = std::move(db);
+    postgresOptions_ = options;
+}
+
+// "<rank>_<id>"; %.17g round-trips the rank exactly, which the keyset
+// comparison needs
+std::string SearchService::encodeCursor(const MediaSearchCursor& cursor) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%.17g_%ld", cursor.rank, cursor.id);
+    return buf;
+}
+
+MediaSearchCursor SearchService::decodeCursor(const std::string& text) {
+    auto sep = text.rfind('_');
+    if (sep != std::string::npos && sep > 0 && sep + 1 < text.size()) {
+        char* end = nullptr;
+        double rank = std::strtod(text.c_str(), &end);
+        if (end == text.c_str() + sep) {
+            const char* idStart = text.c_str() + sep + 1;
+            long id = std::strtol(idStart, &end, 10);
+            if (*end == '\0' && std::isdigit(static_cast<unsigned char>(*idStart))) return {rank, id};
+        }
+    }
+    throw ValidationException("Invalid cursor");
+}
+
+bool SearchService::overloaded() {
+    if (workers_.queued() < maxQueued_) return false;
+    rejected_.inc();
+    return true;
+}
+
+bool SearchService::upstreamAvailable() const {
+    return search_ && Clock::now().time_since_epoch().count() >= upstreamRetryAt_.load();
+}
+
+void SearchService::upstreamFailed() {
+    upstreamRetryAt_ = (Clock::now() + kUpstreamRetryAfter).time_since_epoch().count();
+}
+
+void SearchService::dispatch(std::function<void()> task) {
+    queueDepth_.inc();
+    workers_.submit([this, task = std::move(task)] {
+        queueDepth_.dec();
+        busyWorkers_.inc();
+        task();
+        busyWorkers_.dec();
+    });
+}
+
+bool SearchService::run(SingleFlight<nlohmann::json>& flights, const std::string& key,
+                        Fetch fetch, Callback done) {
+    requests_.inc();
+    auto start = Clock::now();
+    auto finish = [this, start, done = std::move(done)](const nlohmann::json& value,
+                                                        std::exception_ptr error) {
+        latency_.observe(std::chrono::duration<double>(Clock::now() - start).count());
+        done(value, error);
+    };
+
+    uint64_t generation = cache_ ? cache_->generation() : 0;
+    if (cache_) {
+        if (auto hit = cache_->getLocal(key, generation)) {
+            finish(*hit, nullptr);
+            return true;
+        }
+    }
+    if (overloaded()) return false;
+
+    // Queries from before and after an index write must not share a flight
+    std::string flightKey = std::to_string(generation) + '\x1f' + key;
+    if (!flights.join(flightKey, std::move(finish))) {
+        coalesced_.inc();
+        return true;
+    }
+
+    dispatch([this, &flights, key, flightKey, generation, fetch = std::move(fetch)] {
+        nlohmann::json value;
+        std::exception_ptr error;
+        try {
+            SearchCache::Value cached = cache_ ? cache_->getShared(key, generation) : nullptr;
+            if (cached) {
+                value = *cached;
+            } else {
+                upstream_.inc();
+                bool cacheable = true;
+                value = fetch(cacheable);
+                if (cache_ && cacheable) cache_->put(key, generation, value);
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        flights.complete(flightKey, value, error);
+    });
+    return true;
+}
+
+SearchService::Results SearchService::searchPostgres(const SearchQuery& q) {
+    postgresSearches_.inc();
+    // Without a cursor, the first from hits are fetched and skipped
+    int skip = q.after ? 0 : q.from;
+    auto hits = db_->searchMedia(q.text, skip + q.size, q.after, postgresOptions_.trigram);
+
+    Results results = page({});
+    for (size_t i = static_cast<size_t>(skip); i < hits.size(); ++i) {
+        const auto& h = hits[i];
+        results["hits"].push_back({{"id", h.id}, {"title", h.title}, {"author", h.author},
+                                   {"category", h.category}, {"_score", h.rank}});
+    }
+    if (hits.size() == static_cast<size_t>(skip + q.size))
+        results["next_cursor"] = encodeCursor({hits.back().rank, hits.back().id});
+    return results;
+}
+
+bool SearchService::search(const SearchQuery& query, ResultCallback done) {
+    SearchQuery q = query;
+    q.text = normalizeSearchText(q.text);
+
+    return run(searches_, searchKey(q), [this, q](bool& cacheable) {
+        // A cursor comes from a PostgreSQL answer and only means something there
+        if (db_ && (postgresOptions_.primary || q.after)) {
+            // PostgreSQL writes do not bump the cache generation
+            cacheable = false;
+            return searchPostgres(q);
+        }
+        if (upstreamAvailable()) {
+            try {
+                return page(search_->fuzzySearch(q.text, q.fuzziness, q.from, q.size));
+            } catch (const std::exception& e) {
+                if (!localReady() && !db_) throw;
+                upstreamFailed();
+                std::cerr << "[Search] OpenSearch failed, using "
+                          << (localReady() ? "the local index" : "PostgreSQL") << ": " << e.what() << std::endl;
+            }
+        }
+        if (localReady()) {
+            fallbacks_.inc();
+            // The local index is not tied to the cache generation
+            cacheable = false;
+            return page(catalog_->search(q.text, q.fuzziness, q.from, q.size));
+        }
+        if (db_) {
+            fallbacks_.inc();
+            cacheable = false;
+            return searchPostgres(q);
+        }
+        // Fallback to basic search via LibraryService
+        auto all = library_->searchMedia(q.text);
+        int end = std::min(static_cast<int>(all.size()), q.from + q.size);
+        std::vector<nlohmann::json> hits;
+        for (int i = q.from; i < end; ++i)
+            hits.push_back(std::move(all[i]));
+        return page(std::move(hits));
+    }, std::move(done));
+}
+
+bool SearchService::suggest(const std::string& prefix, int maxResults, SuggestCallback done) {
+    std::string p = normalizeSearchText(prefix);
+
+    if (localReady() && maxResults > 0) {
+        auto start = Clock::now();
+        auto local = catalog_->suggest(p, static_cast<size_t>(maxResults));
+        if (!local.empty()) {
+            requests_.inc();
+            localSuggestions_.inc();
+            latency_.observe(std::chrono::duration<double>(Clock::now() - start).count());
+            done(Suggestions(std::move(local)), nullptr);
+            return true;
+        }
+    }
+
+    return run(suggestions_, suggestKey(p, maxResults), [this, p, maxResults](bool& cacheable) {
+        Suggestions suggestions = Suggestions::array();
+        // Otherwise the local index has already found nothing for this prefix
+        if (!upstreamAvailable()) {
+            cacheable = false;
+            return suggestions;
+        }
+        try {
+            for (auto& s : search_->autoSuggest(p, maxResults))
+                suggestions.push_back(std::move(s));
+        } catch (const std::exception&) {
+            if (!localReady()) throw;
+            upstreamFailed();
+            cacheable = false;
+        }
+        return suggestions;
+    }, std::move(done));
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "src/application/services/CatalogIndexService.h"
+#include "src/application/services/LibraryService.h"
+#include "src/data/PostgresAdapter.h"
+#include "src/infrastructure/cache/SearchCache.h"
+#include "src/infrastructure/search/OpenSearchClient.h"
+#include "src/utils/SingleFlight.h"
+#include "src/utils/ThreadPool.h"
+
+class Counter;
+class Gauge;
+class Histogram;
+
+struct SearchQuery {
+    std::string text;
+    std::string fuzziness = "AUTO";
+    int from = 0;
+    int size = 10;
+    // Continues a PostgreSQL result list; from is ignored when set
+    std::optional<MediaSearchCursor> after;
+};
+
+struct PostgresSearchOptions {
+    bool primary = false;   // answer every search from PostgreSQL
+    bool trigram = false;   // also match similar titles (needs pg_trgm)
+};
+
+// Runs searches on a dedicated worker pool so REST threads are not held
+// while OpenSearch answers. Identical queries that arrive while one is in
+// flight share its upstream request. With a cache, a query found in the
+// local tier is answered on the calling thread; the Redis tier is checked
+// on a worker before going upstream. Suggestions come from the in-process
+// autocomplete index once it is loaded, falling back to OpenSearch when it
+// is not or has nothing for the prefix. When OpenSearch fails, searches are
+// answered from the in-process full-text index instead, or from PostgreSQL
+// while that index is not loaded; those results are not cached. PostgreSQL
+// can also be the primary search backend, paginated by cursor.
+class SearchService {
+public:
+    // {"hits": [...], "next_cursor": string or null}
+    using Results = nlohmann::json;
+    using Suggestions = nlohmann::json;   // array of strings
+    using ResultCallback = std::function<void(const Results&, std::exception_ptr)>;
+    using SuggestCallback = std::function<void(const Suggestions&, std::exception_ptr)>;
+
+    SearchService(std::shared_ptr<LibraryService> library,
+                  std::shared_ptr<OpenSearchClient> search,
+                  size_t workers, size_t maxQueued,
+                  std::shared_ptr<SearchCache> cache = nullptr,
+                  std::shared_ptr<CatalogIndexService> catalog = nullptr);
+
+    // done runs on a search worker, or on the caller for a local cache hit.
+    // False, without calling done, when the queue is full.
+    bool search(const SearchQuery& query, ResultCallback done);
+    bool suggest(const std::string& prefix, int maxResults, SuggestCallback done);
+
+    // Enables PostgreSQL search; call before the first search
+    void setPostgres(std::shared_ptr<PostgresAdapter> db, PostgresSearchOptions options);
+
+    // next_cursor values; decodeCursor throws ValidationException
+    static std::string encodeCursor(const MediaSearchCursor& cursor);
+    static MediaSearchCursor decodeCursor(const std::string& text);
+
+private:
+    using Callback = std::function<void(const nlohmann::json&, std::exception_ptr)>;
+    // Clears cacheable for an answer that must not be cached
+    using Fetch = std::function<nlohmann::json(bool& cacheable)>;
+
+    bool overloaded();
+    // Whether to try OpenSearch; after a failure it is skipped for a while
+    // so degraded searches do not each wait for a timeout
+    bool upstreamAvailable() const;
+    void upstreamFailed();
+    bool localReady() const { return catalog_ && catalog_->ready(); }
+    Results searchPostgres(const SearchQuery& q);
+    void dispatch(std::function<void()> task);
+    // Shared path for search and suggest: cache tiers, coalescing, upstream
+    bool run(SingleFlight<nlohmann::json>& flights, const std::string& key,
+             Fetch fetch, Callback done);
+
+    std::shared_ptr<LibraryService> library_;
+    std::shared_ptr<OpenSearchClient> search_;
+    std::shared_ptr<SearchCache> cache_;
+    std::shared_ptr<CatalogIndexService> catalog_;
+    std::shared_ptr<PostgresAdapter> db_;
+    PostgresSearchOptions postgresOptions_;
+    size_t maxQueued_;
+    std::atomic<int64_t> upstreamRetryAt_{0};
+
+    SingleFlight<nlohmann::json> searches_;
+    SingleFlight<nlohmann::json> suggestions_;
+
+    Counter& requests_;
+    Counter& coalesced_;
+    Counter& upstream_;
+    Counter& rejected_;
+    Counter& localSuggestions_;
+    Counter& fallbacks_;
+    Counter& postgresSearches_;
+    Gauge& busyWorkers_;
+    Gauge& queueDepth_;
+    Histogram& latency_;
+
+    // Last, so workers stop before the members they use are destroyed
+    ThreadPool workers_;
+};
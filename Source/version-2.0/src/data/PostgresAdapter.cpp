@@ -1,48 +1,43 @@
+#include <algorithm>
+#include <cctype>
 #include <stdexcept>
 #include "src/data/PostgresAdapter.h"
+#include "src/data/PreparedStatements.h"
+#include "src/utils/StringUtils.h"
 
-PostgresAdapter::PostgresAdapter(std::shared_ptr<pqxx::connection> conn)
-    : conn_(std::move(conn)) {}
+PostgresAdapter::PostgresAdapter(std::shared_ptr<PostgresPool> pool)
+    : pool_(std::move(pool)) {
+    pool_->addConnectionInitializer("prepared_statements", &PreparedStatements::prepareAll);
+}
 
 //  MEDIA 
 long PostgresAdapter::createMedia(int mediaTypeId, const std::string& title) {
-    pqxx::work txn(*conn_);
-    auto r = txn.exec(
-        "INSERT INTO media (title, media_type_id, is_available) VALUES ($1, $2, TRUE) RETURNING id;",
-        pqxx::params{title, mediaTypeId}
-    );
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    auto r = txn.exec(pqxx::prepped{Stmt::CreateMedia}, pqxx::params{title, mediaTypeId});
     txn.commit();
     return r[0]["id"].as<long>();
 };
 
 void PostgresAdapter::attachBook(long mediaId, const std::string& author, const std::string& isbn) {
-    pqxx::work txn(*conn_);
-    txn.exec(
-        "INSERT INTO book (media_id, author, isbn) VALUES ($1, $2, $3) "
-        "ON CONFLICT (media_id) DO NOTHING;",
-        pqxx::params{mediaId, author, isbn}
-    );
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    txn.exec(pqxx::prepped{Stmt::AttachBook}, pqxx::params{mediaId, author, isbn});
     txn.commit();
 };
 
 void PostgresAdapter::attachMagazine(long mediaId, int issueNumber, const std::string& publisher) {
-    pqxx::work txn(*conn_);
-    txn.exec(
-        "INSERT INTO magazine (media_id, issue_number, publisher) VALUES ($1, $2, $3) "
-        "ON CONFLICT (media_id) DO NOTHING;",
-        pqxx::params{mediaId, issueNumber, publisher}
-    );
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    txn.exec(pqxx::prepped{Stmt::AttachMagazine}, pqxx::params{mediaId, issueNumber, publisher});
     txn.commit();
 };
 
 MediaCopy PostgresAdapter::createMediaCopy(long mediaId, const std::string& condition) {
-    pqxx::work txn(*conn_);
-    txn.exec("CALL create_media_copy($1, $2);", pqxx::params{mediaId, condition});
-    auto r = txn.exec(
-        "SELECT copy_id, media_id, condition, is_available "
-        "FROM media_copy WHERE media_id = $1 ORDER BY copy_id DESC LIMIT 1;",
-        pqxx::params{mediaId}
-    );
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    txn.exec(pqxx::prepped{Stmt::CreateMediaCopy}, pqxx::params{mediaId, condition});
+    auto r = txn.exec(pqxx::prepped{Stmt::LatestCopyForMedia}, pqxx::params{mediaId});
     txn.commit();
 
     if (r.empty()) throw std::runtime_error("Failed to create media copy.");
@@ -56,12 +51,9 @@ MediaCopy PostgresAdapter::createMediaCopy(long mediaId, const std::string& cond
 };
 
 MediaCopy PostgresAdapter::getCopy(long copyId) {
-    pqxx::work txn(*conn_);
-    auto r = txn.exec(
-        "SELECT copy_id, media_id, condition, is_available "
-        "FROM media_copy WHERE copy_id = $1;",
-        pqxx::params{copyId}
-    );
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    auto r = txn.exec(pqxx::prepped{Stmt::GetCopy}, pqxx::params{copyId});
     txn.commit();
     if (r.empty()) throw std::runtime_error("Copy not found.");
 
@@ -74,12 +66,9 @@ MediaCopy PostgresAdapter::getCopy(long copyId) {
 };
 
 std::vector<MediaCopy> PostgresAdapter::listCopiesByMedia(long mediaId) {
-    pqxx::work txn(*conn_);
-    auto res = txn.exec(
-        "SELECT copy_id, media_id, condition, is_available "
-        "FROM media_copy WHERE media_id = $1 ORDER BY copy_id;",
-        pqxx::params{mediaId}
-    );
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    auto res = txn.exec(pqxx::prepped{Stmt::ListCopiesByMedia}, pqxx::params{mediaId});
     txn.commit();
 
     std::vector<MediaCopy> out;
@@ -96,29 +85,11 @@ std::vector<MediaCopy> PostgresAdapter::listCopiesByMedia(long mediaId) {
 };
 
 std::vector<std::shared_ptr<Media>> PostgresAdapter::getAllMedia() {
-    pqxx::work txn(*conn_);
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
 
     // Join with type-specific tables to get all details
-    auto res = txn.exec(
-        "SELECT "
-        "    m.id, "
-        "    m.title, "
-        "    m.is_available, "
-        "    mt.name AS type, "
-        "    b.author, "
-        "    b.isbn, "
-        "    mg.issue_number, "
-        "    mg.publisher, "
-        "    d.director, "
-        "    a.narrator "
-        "FROM media m "
-        "LEFT JOIN media_type mt ON m.media_type_id = mt.id "
-        "LEFT JOIN book b ON m.id = b.media_id "
-        "LEFT JOIN magazine mg ON m.id = mg.media_id "
-        "LEFT JOIN dvd d ON m.id = d.media_id "
-        "LEFT JOIN audiobook a ON m.id = a.media_id "
-        "ORDER BY m.id;"
-    );
+    auto res = txn.exec(pqxx::prepped{Stmt::GetAllMedia}, pqxx::params{});
 
     txn.commit();
 
@@ -167,26 +138,280 @@ std::vector<std::shared_ptr<Media>> PostgresAdapter::getAllMedia() {
     return out;
 };
 
+std::vector<long> PostgresAdapter::bulkInsertMedia(const std::vector<ImportRow>& rows,
+                                                   const std::function<void(pqxx::work&)>& inTransaction) {
+    std::vector<long> ids;
+    if (rows.empty()) return ids;
+
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+
+    // Ids are reserved up front so staged rows map back to their input position
+    auto reserved = txn.exec(pqxx::prepped{Stmt::ReserveMediaIds},
+                             pqxx::params{static_cast<long>(rows.size())});
+    ids.reserve(rows.size());
+    for (const auto& r : reserved) ids.push_back(r["id"].as<long>());
+
+    // Session-scoped staging table, reused across batches on this connection
+    txn.exec(
+        "CREATE TEMP TABLE IF NOT EXISTS import_staging ("
+        "    media_id BIGINT, media_type_id INT, title TEXT, "
+        "    author TEXT, isbn TEXT, issue_number INT, publisher TEXT"
+        ") ON COMMIT DELETE ROWS;");
+
+    auto stream = pqxx::stream_to::table(txn, {"import_staging"},
+        {"media_id", "media_type_id", "title", "author", "isbn", "issue_number", "publisher"});
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const auto& row = rows[i];
+        stream.write_values(ids[i], row.mediaTypeId, row.title,
+                            row.author, row.isbn, row.issueNumber, row.publisher);
+    }
+    stream.complete();
+
+    txn.exec(
+        "INSERT INTO media (id, title, media_type_id, is_available) "
+        "SELECT media_id, title, media_type_id, TRUE FROM import_staging;");
+    txn.exec(
+        "INSERT INTO book (media_id, author, isbn) "
+        "SELECT media_id, author, isbn FROM import_staging WHERE media_type_id = 1 "
+        "ON CONFLICT (media_id) DO NOTHING;");
+    txn.exec(
+        "INSERT INTO magazine (media_id, issue_number, publisher) "
+        "SELECT media_id, issue_number, publisher FROM import_staging WHERE media_type_id = 2 "
+        "ON CONFLICT (media_id) DO NOTHING;");
+
+    if (inTransaction) inTransaction(txn);
+    txn.commit();
+    return ids;
+}
+
+std::vector<long> PostgresAdapter::insertMediaRows(const std::vector<ImportRow>& rows,
+                                                   const std::function<void(size_t, const std::string&)>& onError,
+                                                   const std::function<void(pqxx::work&)>& inTransaction) {
+    std::vector<long> ids;
+    ids.reserve(rows.size());
+
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const auto& row = rows[i];
+        try {
+            pqxx::subtransaction sub(txn);
+            auto r = sub.exec(pqxx::prepped{Stmt::CreateMedia}, pqxx::params{row.title, row.mediaTypeId});
+            long mediaId = r[0]["id"].as<long>();
+            if (row.mediaTypeId == 1)
+                sub.exec(pqxx::prepped{Stmt::AttachBook}, pqxx::params{mediaId, row.author, row.isbn});
+            else if (row.mediaTypeId == 2)
+                sub.exec(pqxx::prepped{Stmt::AttachMagazine},
+                         pqxx::params{mediaId, row.issueNumber, row.publisher});
+            sub.commit();
+            ids.push_back(mediaId);
+        } catch (const pqxx::sql_error& e) {
+            // The savepoint is rolled back; the transaction goes on
+            ids.push_back(0);
+            onError(i, e.what());
+        }
+    }
+
+    if (inTransaction) inTransaction(txn);
+    txn.commit();
+    return ids;
+}
+
+size_t PostgresAdapter::streamMediaPage(long afterId, size_t limit,
+                                        const std::function<void(long, std::string_view)>& fn) {
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+
+    // stream() runs over COPY, which cannot bind parameters; both values are integers
+    std::string query =
+        "SELECT id, title FROM media WHERE id > " + std::to_string(afterId) +
+        " ORDER BY id LIMIT " + (limit ? std::to_string(limit) : std::string("ALL"));
+
+    size_t rows = 0;
+    for (auto [id, title] : txn.stream<long, std::string_view>(query)) {
+        fn(id, title);
+        ++rows;
+    }
+    txn.commit();
+    return rows;
+}
+
+long PostgresAdapter::streamSearchRows(long afterId,
+                                       const std::function<void(const MediaSearchRow&)>& fn) {
+    auto conn = pool_->acquire();
+    // One snapshot for the whole scan; the COPY streams rows as the server produces them
+    pqxx::read_transaction txn(*conn);
+
+    std::string query =
+        "SELECT m.id, m.title, "
+        "       COALESCE(b.author, mg.publisher, d.director, a.narrator, '') AS author, "
+        "       COALESCE(t.name, '') AS category "
+        "FROM media m "
+        "LEFT JOIN media_type t ON t.id = m.media_type_id "
+        "LEFT JOIN book b ON b.media_id = m.id "
+        "LEFT JOIN magazine mg ON mg.media_id = m.id "
+        "LEFT JOIN dvd d ON d.media_id = m.id "
+        "LEFT JOIN audiobook a ON a.media_id = m.id "
+        "WHERE m.id > " + std::to_string(afterId) + " ORDER BY m.id";
+
+    long lastId = afterId;
+    for (auto [id, title, author, category] :
+         txn.stream<long, std::string_view, std::string_view, std::string_view>(query)) {
+        fn(MediaSearchRow{id, title, author, category});
+        lastId = id;
+    }
+    txn.commit();
+    return lastId;
+}
+
+namespace {
+
+// "harry pott" -> "harry & pott:*". Only letters and digits are kept, so
+// user input cannot inject tsquery operators.
+std::string prefixTsQuery(const std::string& text) {
+    std::vector<std::string> words;
+    std::string word;
+    for (unsigned char c : text + ' ') {
+        if (std::isalnum(c) || c >= 0x80) {
+            word.push_back(static_cast<char>(std::tolower(c)));
+        } else if (!word.empty()) {
+            words.push_back(std::move(word));
+            word.clear();
+        }
+    }
+    std::string query;
+    for (size_t i = 0; i < words.size(); ++i) {
+        if (i) query += " & ";
+        query += words[i];
+    }
+    if (!query.empty()) query += ":*";
+    return query;
+}
+
+}
+
+std::vector<MediaSearchHit> PostgresAdapter::searchMedia(const std::string& query, int limit,
+                                                         const std::optional<MediaSearchCursor>& after,
+                                                         bool trigram) {
+    std::string tsquery = prefixTsQuery(query);
+    if (tsquery.empty() || limit <= 0) return {};
+
+    std::optional<double> afterRank;
+    std::optional<long> afterId;
+    if (after) {
+        afterRank = after->rank;
+        afterId = after->id;
+    }
+
+    auto conn = pool_->acquire();
+    pqxx::read_transaction txn(*conn);
+    pqxx::result r = trigram
+        ? txn.exec(PreparedStatements::mediaSearch(true),
+                   pqxx::params{tsquery, afterRank, afterId, limit, normalizeSearchText(query)})
+        : txn.exec(pqxx::prepped{Stmt::SearchMedia}, pqxx::params{tsquery, afterRank, afterId, limit});
+    txn.commit();
+
+    std::vector<MediaSearchHit> hits;
+    hits.reserve(r.size());
+    for (const auto& row : r) {
+        hits.push_back(MediaSearchHit{row["id"].as<long>(), row["title"].as<std::string>(),
+                                      row["author"].as<std::string>(), row["category"].as<std::string>(),
+                                      row["rank"].as<double>()});
+    }
+    return hits;
+}
+
+void PostgresAdapter::streamBorrowCounts(const std::function<void(long, long)>& fn) {
+    auto conn = pool_->acquire();
+    pqxx::read_transaction txn(*conn);
+    for (auto [mediaId, borrows] : txn.stream<long, long>(
+             "SELECT c.media_id, COUNT(*) "
+             "FROM (SELECT copy_id FROM active_borrow "
+             "      UNION ALL SELECT copy_id FROM borrow_history) b "
+             "JOIN media_copy c ON c.copy_id = b.copy_id "
+             "GROUP BY c.media_id")) {
+        fn(mediaId, borrows);
+    }
+    txn.commit();
+}
+
+std::string PostgresAdapter::databaseNow() {
+    auto conn = pool_->acquire();
+    pqxx::read_transaction txn(*conn);
+    auto now = txn.exec("SELECT now()::text AS now")[0]["now"].as<std::string>();
+    txn.commit();
+    return now;
+}
+
+std::string PostgresAdapter::streamCatalogChanges(
+        const std::string& since, std::chrono::seconds overlap,
+        const std::function<void(const MediaSearchRow&, long)>& onRow,
+        const std::function<void(long)>& onDeleted) {
+    auto conn = pool_->acquire();
+    // Repeatable read: the rows, the deletions and the returned time are one snapshot
+    pqxx::transaction<pqxx::isolation_level::repeatable_read, pqxx::write_policy::read_only> txn(*conn);
+    auto now = txn.exec("SELECT now()::text AS now")[0]["now"].as<std::string>();
+    std::string window = txn.quote(since) + "::timestamptz - INTERVAL '" +
+                         std::to_string(overlap.count()) + " seconds'";
+
+    std::string query =
+        "SELECT m.id, m.title, "
+        "       COALESCE(b.author, mg.publisher, d.director, a.narrator, '') AS author, "
+        "       COALESCE(t.name, '') AS category, "
+        "       (SELECT COUNT(*) FROM media_copy c "
+        "        JOIN (SELECT copy_id FROM active_borrow "
+        "              UNION ALL SELECT copy_id FROM borrow_history) h ON h.copy_id = c.copy_id "
+        "        WHERE c.media_id = m.id) AS borrows "
+        "FROM media m "
+        "LEFT JOIN media_type t ON t.id = m.media_type_id "
+        "LEFT JOIN book b ON b.media_id = m.id "
+        "LEFT JOIN magazine mg ON mg.media_id = m.id "
+        "LEFT JOIN dvd d ON d.media_id = m.id "
+        "LEFT JOIN audiobook a ON a.media_id = m.id "
+        "WHERE m.updated_at > " + window + " ORDER BY m.id";
+    for (auto [id, title, author, category, borrows] :
+         txn.stream<long, std::string_view, std::string_view, std::string_view, long>(query)) {
+        onRow(MediaSearchRow{id, title, author, category}, borrows);
+    }
+
+    for (auto [id] : txn.stream<long>(
+             "SELECT media_id FROM media_deleted WHERE deleted_at > " + window)) {
+        onDeleted(id);
+    }
+    txn.commit();
+    return now;
+}
+
 //  BORROW 
-void PostgresAdapter::addActiveBorrow(int userId, long copyId) {
-    pqxx::work txn(*conn_);
-    txn.exec("CALL add_active_borrow($1, $2);", pqxx::params{userId, copyId});
+BorrowOutcome PostgresAdapter::borrowCopy(int userId, long copyId) {
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    pqxx::result r;
+    try {
+        r = txn.exec(pqxx::prepped{Stmt::BorrowCopy}, pqxx::params{userId, copyId});
+    } catch (const pqxx::foreign_key_violation&) {
+        return BorrowOutcome::UserNotFound;
+    }
     txn.commit();
+
+    if (!r[0]["borrow_id"].is_null()) return BorrowOutcome::Borrowed;
+    if (!r[0]["copy_exists"].as<bool>()) return BorrowOutcome::CopyNotFound;
+    return BorrowOutcome::Unavailable;
 }
 
-void PostgresAdapter::markCopyReturned(long copyId) {
-    pqxx::work txn(*conn_);
-    txn.exec("CALL mark_copy_returned($1);", pqxx::params{copyId});
+ReturnOutcome PostgresAdapter::returnCopy(int userId, long copyId) {
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    auto r = txn.exec(pqxx::prepped{Stmt::ReturnCopy}, pqxx::params{userId, copyId});
     txn.commit();
+    return r[0]["returned"].as<long>() > 0 ? ReturnOutcome::Returned : ReturnOutcome::NotBorrowed;
 }
 
 std::optional<BorrowRecord> PostgresAdapter::findActiveBorrow(int userId, long copyId) {
-    pqxx::work txn(*conn_);
-    auto r = txn.exec(
-        "SELECT borrow_id, user_id, copy_id, borrow_date "
-        "FROM active_borrow WHERE user_id = $1 AND copy_id = $2;",
-        pqxx::params{userId, copyId}
-    );
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    auto r = txn.exec(pqxx::prepped{Stmt::FindActiveBorrow}, pqxx::params{userId, copyId});
     txn.commit();
     if (r.empty()) return std::nullopt;
 
@@ -204,50 +429,41 @@ int PostgresAdapter::insertUser(const std::string& name, const std::string& emai
                                 const std::string& hashedPassword, const std::string& role,
                                 const std::optional<std::string>& gradeLevel,
                                 const std::optional<std::string>& department) {
-    pqxx::work txn(*conn_);
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
 
     // Normalize role to uppercase for comparison
     std::string normalizedRole = role;
     std::transform(normalizedRole.begin(), normalizedRole.end(), normalizedRole.begin(), ::toupper);
 
     // Insert into users table (no user_type column)
-    auto r = txn.exec(
-        "INSERT INTO users (name, email, password_hash) "
-        "VALUES ($1, $2, $3) RETURNING id;",
-        pqxx::params{name, email, hashedPassword}
-    );
+    auto r = txn.exec(pqxx::prepped{Stmt::InsertUser}, pqxx::params{name, email, hashedPassword});
     int id = r[0]["id"].as<int>();
 
     // Insert into appropriate subtype table based on role
     if (normalizedRole == "ADMIN") {
-        txn.exec("INSERT INTO admins (id) VALUES ($1);", pqxx::params{id});
+        txn.exec(pqxx::prepped{Stmt::InsertAdmin}, pqxx::params{id});
     } 
     else if (normalizedRole == "LIBRARIAN") {
-        txn.exec("INSERT INTO librarians (id) VALUES ($1);", pqxx::params{id});
+        txn.exec(pqxx::prepped{Stmt::InsertLibrarian}, pqxx::params{id});
     } 
     else if (normalizedRole == "STUDENT" || normalizedRole == "TEACHER" || normalizedRole == "MEMBER") {
         // All students, teachers, and members go into members table first
-        txn.exec("INSERT INTO members (id) VALUES ($1);", pqxx::params{id});
+        txn.exec(pqxx::prepped{Stmt::InsertMember}, pqxx::params{id});
 
         // Then insert into appropriate subtype
         if (normalizedRole == "STUDENT") {
             std::string grade = gradeLevel.value_or("Unknown");
-            txn.exec("INSERT INTO students (id, grade_level) VALUES ($1, $2);",
-                     pqxx::params{id, grade});
+            txn.exec(pqxx::prepped{Stmt::InsertStudent}, pqxx::params{id, grade});
         } 
         else if (normalizedRole == "TEACHER") {
             std::string dept = department.value_or("Unknown");
-            txn.exec("INSERT INTO teachers (id, department) VALUES ($1, $2);",
-                     pqxx::params{id, dept});
+            txn.exec(pqxx::prepped{Stmt::InsertTeacher}, pqxx::params{id, dept});
         }
     }
 
     // Assign role in user_roles table
-    txn.exec(
-        "INSERT INTO user_roles (user_id, role_id) "
-        "SELECT $1, id FROM roles WHERE name = $2;",
-        pqxx::params{id, normalizedRole}
-    );
+    txn.exec(pqxx::prepped{Stmt::InsertUserRole}, pqxx::params{id, normalizedRole});
 
     txn.commit();
     return id;
@@ -255,37 +471,17 @@ int PostgresAdapter::insertUser(const std::string& name, const std::string& emai
 
 
 void PostgresAdapter::assignRole(int userId, const std::string& role) {
-    pqxx::work txn(*conn_);
-    txn.exec(
-        "INSERT INTO user_roles (user_id, role_id) "
-        "SELECT $1, id FROM roles WHERE name = $2 "
-        "ON CONFLICT (user_id, role_id) DO NOTHING;",
-        pqxx::params{userId, role}
-    );
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    txn.exec(pqxx::prepped{Stmt::AssignRole}, pqxx::params{userId, role});
     txn.commit();
 };
 
 std::vector<std::shared_ptr<User>> PostgresAdapter::getAllUsers() {
-    pqxx::work txn(*conn_);
-
-    auto res = txn.exec(
-        "SELECT u.id AS user_id, u.name, u.email, "
-        "       CASE "
-        "         WHEN a.id IS NOT NULL THEN 'ADMIN' "
-        "         WHEN l.id IS NOT NULL THEN 'LIBRARIAN' "
-        "         WHEN t.id IS NOT NULL THEN 'TEACHER' "
-        "         WHEN s.id IS NOT NULL THEN 'STUDENT' "
-        "         ELSE 'MEMBER' "
-        "       END AS user_type, "
-        "       s.grade_level, t.department "
-        "FROM users u "
-        "LEFT JOIN admins a ON u.id = a.id "
-        "LEFT JOIN librarians l ON u.id = l.id "
-        "LEFT JOIN members m ON u.id = m.id "
-        "LEFT JOIN students s ON m.id = s.id "
-        "LEFT JOIN teachers t ON m.id = t.id "
-        "ORDER BY u.id;"
-    );
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+
+    auto res = txn.exec(pqxx::prepped{Stmt::GetAllUsers}, pqxx::params{});
     txn.commit();
 
     auto col_user_id    = res.column_number("user_id");
@@ -328,26 +524,10 @@ std::vector<std::shared_ptr<User>> PostgresAdapter::getAllUsers() {
 
 
 std::optional<UserRow> PostgresAdapter::getUserByName(const std::string& username) {
-    pqxx::work txn(*conn_);
-
-    auto r = txn.exec(
-        "SELECT u.id, u.name, u.email, u.password_hash, "
-        "       CASE "
-        "         WHEN a.id IS NOT NULL THEN 'ADMIN' "
-        "         WHEN l.id IS NOT NULL THEN 'LIBRARIAN' "
-        "         WHEN t.id IS NOT NULL THEN 'TEACHER' "
-        "         WHEN s.id IS NOT NULL THEN 'STUDENT' "
-        "         ELSE 'MEMBER' "
-        "       END AS role "
-        "FROM users u "
-        "LEFT JOIN admins a ON u.id = a.id "
-        "LEFT JOIN librarians l ON u.id = l.id "
-        "LEFT JOIN members m ON u.id = m.id "
-        "LEFT JOIN teachers t ON m.id = t.id "
-        "LEFT JOIN students s ON m.id = s.id "
-        "WHERE u.name = $1 "
-        "LIMIT 1;",
-        pqxx::params{username});
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+
+    auto r = txn.exec(pqxx::prepped{Stmt::GetUserByName}, pqxx::params{username});
 
     txn.commit();
 
@@ -367,24 +547,9 @@ std::optional<UserRow> PostgresAdapter::getUserByName(const std::string& usernam
 };
 
 std::optional<UserRow> PostgresAdapter::getUserByEmail(const std::string& email) {
-    pqxx::work txn(*conn_);
-    auto res = txn.exec(
-        "SELECT u.id, u.name, u.email, u.password_hash, "
-        "       CASE "
-        "         WHEN a.id IS NOT NULL THEN 'ADMIN' "
-        "         WHEN l.id IS NOT NULL THEN 'LIBRARIAN' "
-        "         WHEN t.id IS NOT NULL THEN 'TEACHER' "
-        "         WHEN s.id IS NOT NULL THEN 'STUDENT' "
-        "         ELSE 'MEMBER' "
-        "       END AS role "
-        "FROM users u "
-        "LEFT JOIN admins a ON u.id = a.id "
-        "LEFT JOIN librarians l ON u.id = l.id "
-        "LEFT JOIN members m ON u.id = m.id "
-        "LEFT JOIN teachers t ON m.id = t.id "
-        "LEFT JOIN students s ON m.id = s.id "
-        "WHERE u.email = $1;",
-        pqxx::params{email});
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    auto res = txn.exec(pqxx::prepped{Stmt::GetUserByEmail}, pqxx::params{email});
 
     txn.commit();
 
@@ -404,24 +569,9 @@ std::optional<UserRow> PostgresAdapter::getUserByEmail(const std::string& email)
 };
 
 std::optional<UserRow> PostgresAdapter::getUserById(const int userId) {
-    pqxx::work txn(*conn_);
-    auto res = txn.exec(
-        "SELECT u.id, u.name, u.email, u.password_hash, "
-        "       CASE "
-        "         WHEN a.id IS NOT NULL THEN 'ADMIN' "
-        "         WHEN l.id IS NOT NULL THEN 'LIBRARIAN' "
-        "         WHEN t.id IS NOT NULL THEN 'TEACHER' "
-        "         WHEN s.id IS NOT NULL THEN 'STUDENT' "
-        "         ELSE 'MEMBER' "
-        "       END AS role "
-        "FROM users u "
-        "LEFT JOIN admins a ON u.id = a.id "
-        "LEFT JOIN librarians l ON u.id = l.id "
-        "LEFT JOIN members m ON u.id = m.id "
-        "LEFT JOIN teachers t ON m.id = t.id "
-        "LEFT JOIN students s ON m.id = s.id "
-        "WHERE u.id = $1;",
-        pqxx::params{userId});
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    auto res = txn.exec(pqxx::prepped{Stmt::GetUserById}, pqxx::params{userId});
 
     txn.commit();
 
@@ -442,15 +592,9 @@ std::optional<UserRow> PostgresAdapter::getUserById(const int userId) {
 
 std::vector<std::tuple<std::string, std::string, std::string>> PostgresAdapter::getAllRolePermissions() {
 
-    pqxx::work txn(*conn_);
-    auto res = txn.exec(
-        R"(
-            SELECT r.name AS role, p.table_name, p.action
-            FROM role_permissions rp
-            JOIN roles r ON rp.role_id = r.id
-            JOIN permissions p ON rp.permission_id = p.id;
-        )"
-    );
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    auto res = txn.exec(pqxx::prepped{Stmt::GetAllRolePermissions}, pqxx::params{});
     txn.commit();
 
     std::vector<std::tuple<std::string, std::string, std::string>> perms;
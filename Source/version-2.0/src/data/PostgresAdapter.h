@@ -1,13 +1,19 @@
 #pragma once
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <unordered_set>
 #include "pqxx/pqxx"
 
+#include "src/infrastructure/db/PostgresPool.h"
+
 #include "src/domain/media/MediaCopy.h"
 #include "src/domain/borrow/BorrowRecord.h"
+#include "src/domain/borrow/BorrowOutcome.h"
 #include "src/domain/user/User.h"
 #include "src/domain/media/MediaCopy.h"
 #include "src/utils/DateTimeUtils.h"
@@ -33,9 +39,46 @@ struct UserRow {
     std::string role;
 };
 
+// One validated record for bulkInsertMedia. author/isbn apply to books,
+// issueNumber/publisher to magazines.
+struct ImportRow {
+    int mediaTypeId;
+    std::string title;
+    std::string author;
+    std::string isbn;
+    int issueNumber = 0;
+    std::string publisher;
+};
+
+// One catalogue entry as the search index stores it. Views are only valid
+// during the callback that receives them.
+struct MediaSearchRow {
+    long id;
+    std::string_view title;
+    std::string_view author;    // author, publisher, director or narrator
+    std::string_view category;  // media type name
+};
+
+// One ranked result of PostgresAdapter::searchMedia
+struct MediaSearchHit {
+    long id;
+    std::string title;
+    std::string author;
+    std::string category;
+    double rank;
+};
+
+// Where the next page of searchMedia starts: hits are ordered by rank
+// descending, then id
+struct MediaSearchCursor {
+    double rank;
+    long id;
+};
+
 class PostgresAdapter {
 public:
-    explicit PostgresAdapter(std::shared_ptr<pqxx::connection> conn);
+    // Every call borrows a connection from the pool for the duration of its transaction
+    explicit PostgresAdapter(std::shared_ptr<PostgresPool> pool);
 
     // Media & Copies
     long createMedia(int mediaTypeId, const std::string& title);
@@ -45,10 +88,54 @@ public:
     MediaCopy getCopy(long copyId);
     std::vector<MediaCopy> listCopiesByMedia(long mediaId);
     std::vector<std::shared_ptr<class Media>> getAllMedia();
+    // Stages rows over COPY and inserts media/book/magazine set-wise in one
+    // transaction. Returns the new media ids in row order; all or nothing.
+    // inTransaction, if set, runs just before commit and can veto it by throwing.
+    std::vector<long> bulkInsertMedia(const std::vector<ImportRow>& rows,
+                                      const std::function<void(pqxx::work&)>& inTransaction = {});
+    // Inserts rows one by one in one transaction, each under its own
+    // savepoint, so a failing row rolls back alone. Returns the new media
+    // ids in row order, 0 for a row whose SQL error went to onError with its
+    // index. inTransaction as for bulkInsertMedia.
+    std::vector<long> insertMediaRows(const std::vector<ImportRow>& rows,
+                                      const std::function<void(size_t, const std::string&)>& onError,
+                                      const std::function<void(pqxx::work&)>& inTransaction = {});
+    // Keyset page of (id, title) with id > afterId, handed to fn row by row
+    // straight off a COPY stream; limit 0 reads to the end. Returns the
+    // number of rows visited.
+    size_t streamMediaPage(long afterId, size_t limit,
+                           const std::function<void(long, std::string_view)>& fn);
+    // Every media row with id > afterId in id order, joined with its subtype,
+    // from a single COPY in one snapshot. Returns the last id seen, or afterId.
+    long streamSearchRows(long afterId, const std::function<void(const MediaSearchRow&)>& fn);
+
+    // Borrow count (active and returned) of every media item borrowed at least once
+    void streamBorrowCounts(const std::function<void(long mediaId, long borrows)>& fn);
+
+    // Database clock, as text that casts back to timestamptz
+    std::string databaseNow();
+    // Catalogue changes for the in-process indices; needs migration 005.
+    // Every media row updated after since - overlap, with its borrow count,
+    // then every id deleted in that window, all from one snapshot. The
+    // overlap covers writers that commit well after their timestamp.
+    // Returns the time to pass as since next time.
+    std::string streamCatalogChanges(const std::string& since, std::chrono::seconds overlap,
+                                     const std::function<void(const MediaSearchRow&, long borrows)>& onRow,
+                                     const std::function<void(long)>& onDeleted);
+
+    // Title search through idx_media_title, ranked by ts_rank. Every word
+    // must match and the last one also matches as a prefix. With trigram,
+    // titles similar to the query match too (typos) and rank by the better
+    // of the two scores; it needs migration 003. Up to limit hits after the
+    // cursor.
+    std::vector<MediaSearchHit> searchMedia(const std::string& query, int limit,
+                                            const std::optional<MediaSearchCursor>& after = std::nullopt,
+                                            bool trigram = false);
 
     // Borrowing / Returning
-    void addActiveBorrow(int userId, long copyId);
-    void markCopyReturned(long copyId);
+    // Each is one round trip; conflicts come back as an outcome, not an exception
+    BorrowOutcome borrowCopy(int userId, long copyId);
+    ReturnOutcome returnCopy(int userId, long copyId);
     std::optional<BorrowRecord> findActiveBorrow(int userId, long copyId);
 
     // User Management
@@ -67,5 +154,5 @@ public:
     std::vector<std::tuple<std::string, std::string, std::string>> getAllRolePermissions();
     
 private:
-    std::shared_ptr<pqxx::connection> conn_;
+    std::shared_ptr<PostgresPool> pool_;
 };
@@ -0,0 +1,185 @@
+#include "src/data/PreparedStatements.h"
+
+namespace {
+
+// Shared by the three user lookups; only the WHERE clause differs
+const std::string kUserWithRole =
+    "SELECT u.id, u.name, u.email, u.password_hash, "
+    "       CASE "
+    "         WHEN a.id IS NOT NULL THEN 'ADMIN' "
+    "         WHEN l.id IS NOT NULL THEN 'LIBRARIAN' "
+    "         WHEN t.id IS NOT NULL THEN 'TEACHER' "
+    "         WHEN s.id IS NOT NULL THEN 'STUDENT' "
+    "         ELSE 'MEMBER' "
+    "       END AS role "
+    "FROM users u "
+    "LEFT JOIN admins a ON u.id = a.id "
+    "LEFT JOIN librarians l ON u.id = l.id "
+    "LEFT JOIN members m ON u.id = m.id "
+    "LEFT JOIN teachers t ON m.id = t.id "
+    "LEFT JOIN students s ON m.id = s.id ";
+
+}
+
+std::string PreparedStatements::mediaSearch(bool trigram) {
+    // The WHERE clause repeats idx_media_title's expression so the GIN index
+    // is used; idx_media_title_trgm covers the similarity arm
+    std::string rank = trigram
+        ? "GREATEST(ts_rank(to_tsvector('english', m.title), q), similarity(lower(m.title), $5))"
+        : "ts_rank(to_tsvector('english', m.title), q)";
+    std::string match = trigram
+        ? "to_tsvector('english', m.title) @@ q OR lower(m.title) % $5"
+        : "to_tsvector('english', m.title) @@ q";
+    return
+        "WITH hits AS ( "
+        "    SELECT m.id, m.title, m.media_type_id, " + rank + "::float8 AS rank "
+        "    FROM media m, to_tsquery('english', $1) q "
+        "    WHERE " + match + " "
+        ") "
+        "SELECT h.id, h.title, "
+        "       COALESCE(b.author, mg.publisher, d.director, a.narrator, '') AS author, "
+        "       COALESCE(t.name, '') AS category, h.rank "
+        "FROM hits h "
+        "LEFT JOIN media_type t ON t.id = h.media_type_id "
+        "LEFT JOIN book b ON b.media_id = h.id "
+        "LEFT JOIN magazine mg ON mg.media_id = h.id "
+        "LEFT JOIN dvd d ON d.media_id = h.id "
+        "LEFT JOIN audiobook a ON a.media_id = h.id "
+        "WHERE $2::float8 IS NULL OR h.rank < $2 OR (h.rank = $2 AND h.id > $3) "
+        "ORDER BY h.rank DESC, h.id "
+        "LIMIT $4;";
+}
+
+const std::vector<std::pair<std::string, std::string>>& PreparedStatements::all() {
+    static const std::vector<std::pair<std::string, std::string>> statements = {
+        //  MEDIA
+        {Stmt::CreateMedia,
+         "INSERT INTO media (title, media_type_id, is_available) VALUES ($1, $2, TRUE) RETURNING id;"},
+        {Stmt::AttachBook,
+         "INSERT INTO book (media_id, author, isbn) VALUES ($1, $2, $3) "
+         "ON CONFLICT (media_id) DO NOTHING;"},
+        {Stmt::AttachMagazine,
+         "INSERT INTO magazine (media_id, issue_number, publisher) VALUES ($1, $2, $3) "
+         "ON CONFLICT (media_id) DO NOTHING;"},
+        {Stmt::CreateMediaCopy,
+         "CALL create_media_copy($1, $2);"},
+        {Stmt::LatestCopyForMedia,
+         "SELECT copy_id, media_id, condition, is_available "
+         "FROM media_copy WHERE media_id = $1 ORDER BY copy_id DESC LIMIT 1;"},
+        {Stmt::GetCopy,
+         "SELECT copy_id, media_id, condition, is_available "
+         "FROM media_copy WHERE copy_id = $1;"},
+        {Stmt::ListCopiesByMedia,
+         "SELECT copy_id, media_id, condition, is_available "
+         "FROM media_copy WHERE media_id = $1 ORDER BY copy_id;"},
+        {Stmt::GetAllMedia,
+         "SELECT "
+         "    m.id, "
+         "    m.title, "
+         "    m.is_available, "
+         "    mt.name AS type, "
+         "    b.author, "
+         "    b.isbn, "
+         "    mg.issue_number, "
+         "    mg.publisher, "
+         "    d.director, "
+         "    a.narrator "
+         "FROM media m "
+         "LEFT JOIN media_type mt ON m.media_type_id = mt.id "
+         "LEFT JOIN book b ON m.id = b.media_id "
+         "LEFT JOIN magazine mg ON m.id = mg.media_id "
+         "LEFT JOIN dvd d ON m.id = d.media_id "
+         "LEFT JOIN audiobook a ON m.id = a.media_id "
+         "ORDER BY m.id;"},
+        {Stmt::ReserveMediaIds,
+         "SELECT nextval(pg_get_serial_sequence('media', 'id')) AS id "
+         "FROM generate_series(1, $1);"},
+        {Stmt::SearchMedia, PreparedStatements::mediaSearch(false)},
+
+        //  BORROW
+        // The partial unique index uq_active_copy_borrow is the guard: of two
+        // concurrent borrows of the same copy, the second waits on the index
+        // entry and then hits DO NOTHING. The copy is only flagged when the
+        // insert went through. copy_exists tells "unknown copy" from "taken".
+        {Stmt::BorrowCopy,
+         "WITH ins AS ( "
+         "    INSERT INTO active_borrow (user_id, copy_id) "
+         "    SELECT $1, copy_id FROM media_copy WHERE copy_id = $2 AND is_available "
+         "    ON CONFLICT (copy_id) WHERE due_date IS NULL DO NOTHING "
+         "    RETURNING borrow_id, copy_id "
+         "), upd AS ( "
+         "    UPDATE media_copy SET is_available = FALSE "
+         "    WHERE copy_id IN (SELECT copy_id FROM ins) "
+         ") "
+         "SELECT (SELECT borrow_id FROM ins) AS borrow_id, "
+         "       EXISTS (SELECT 1 FROM media_copy WHERE copy_id = $2) AS copy_exists;"},
+        // Moves the active borrow into borrow_history and frees the copy.
+        // A concurrent second return blocks on the row lock and deletes nothing.
+        {Stmt::ReturnCopy,
+         "WITH del AS ( "
+         "    DELETE FROM active_borrow WHERE user_id = $1 AND copy_id = $2 "
+         "    RETURNING user_id, copy_id, borrow_date "
+         "), hist AS ( "
+         "    INSERT INTO borrow_history (user_id, copy_id, borrow_date) "
+         "    SELECT user_id, copy_id, borrow_date FROM del "
+         "), upd AS ( "
+         "    UPDATE media_copy SET is_available = TRUE "
+         "    WHERE copy_id IN (SELECT copy_id FROM del) "
+         ") "
+         "SELECT COUNT(*) AS returned FROM del;"},
+        {Stmt::FindActiveBorrow,
+         "SELECT borrow_id, user_id, copy_id, borrow_date "
+         "FROM active_borrow WHERE user_id = $1 AND copy_id = $2;"},
+
+        //  USER
+        {Stmt::InsertUser,
+         "INSERT INTO users (name, email, password_hash) "
+         "VALUES ($1, $2, $3) RETURNING id;"},
+        {Stmt::InsertAdmin,      "INSERT INTO admins (id) VALUES ($1);"},
+        {Stmt::InsertLibrarian,  "INSERT INTO librarians (id) VALUES ($1);"},
+        {Stmt::InsertMember,     "INSERT INTO members (id) VALUES ($1);"},
+        {Stmt::InsertStudent,    "INSERT INTO students (id, grade_level) VALUES ($1, $2);"},
+        {Stmt::InsertTeacher,    "INSERT INTO teachers (id, department) VALUES ($1, $2);"},
+        {Stmt::InsertUserRole,
+         "INSERT INTO user_roles (user_id, role_id) "
+         "SELECT $1, id FROM roles WHERE name = $2;"},
+        {Stmt::AssignRole,
+         "INSERT INTO user_roles (user_id, role_id) "
+         "SELECT $1, id FROM roles WHERE name = $2 "
+         "ON CONFLICT (user_id, role_id) DO NOTHING;"},
+        {Stmt::GetAllUsers,
+         "SELECT u.id AS user_id, u.name, u.email, "
+         "       CASE "
+         "         WHEN a.id IS NOT NULL THEN 'ADMIN' "
+         "         WHEN l.id IS NOT NULL THEN 'LIBRARIAN' "
+         "         WHEN t.id IS NOT NULL THEN 'TEACHER' "
+         "         WHEN s.id IS NOT NULL THEN 'STUDENT' "
+         "         ELSE 'MEMBER' "
+         "       END AS user_type, "
+         "       s.grade_level, t.department "
+         "FROM users u "
+         "LEFT JOIN admins a ON u.id = a.id "
+         "LEFT JOIN librarians l ON u.id = l.id "
+         "LEFT JOIN members m ON u.id = m.id "
+         "LEFT JOIN students s ON m.id = s.id "
+         "LEFT JOIN teachers t ON m.id = t.id "
+         "ORDER BY u.id;"},
+        {Stmt::GetUserByName,  kUserWithRole + "WHERE u.name = $1 LIMIT 1;"},
+        {Stmt::GetUserByEmail, kUserWithRole + "WHERE u.email = $1;"},
+        {Stmt::GetUserById,    kUserWithRole + "WHERE u.id = $1;"},
+
+        //  PERMISSIONS
+        {Stmt::GetAllRolePermissions,
+         "SELECT r.name AS role, p.table_name, p.action "
+         "FROM role_permissions rp "
+         "JOIN roles r ON rp.role_id = r.id "
+         "JOIN permissions p ON rp.permission_id = p.id;"},
+    };
+    return statements;
+}
+
+void PreparedStatements::prepareAll(pqxx::connection& conn) {
+    for (const auto& [name, sql] : all()) {
+        conn.prepare(name, sql);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+#include <pqxx/pqxx>
+
+// Stable names for every statement PostgresAdapter runs.
+// The SQL lives in PreparedStatements.cpp; adapter code only refers to these names.
+namespace Stmt {
+    // Media & Copies
+    inline constexpr const char* CreateMedia        = "create_media";
+    inline constexpr const char* AttachBook         = "attach_book";
+    inline constexpr const char* AttachMagazine     = "attach_magazine";
+    inline constexpr const char* CreateMediaCopy    = "create_media_copy";
+    inline constexpr const char* LatestCopyForMedia = "latest_copy_for_media";
+    inline constexpr const char* GetCopy            = "get_copy";
+    inline constexpr const char* ListCopiesByMedia  = "list_copies_by_media";
+    inline constexpr const char* GetAllMedia        = "get_all_media";
+    inline constexpr const char* ReserveMediaIds    = "reserve_media_ids";
+    inline constexpr const char* SearchMedia        = "search_media";
+
+    // Borrowing / Returning
+    inline constexpr const char* BorrowCopy         = "borrow_copy";
+    inline constexpr const char* ReturnCopy         = "return_copy";
+    inline constexpr const char* FindActiveBorrow   = "find_active_borrow";
+
+    // Users
+    inline constexpr const char* InsertUser         = "insert_user";
+    inline constexpr const char* InsertAdmin        = "insert_admin";
+    inline constexpr const char* InsertLibrarian    = "insert_librarian";
+    inline constexpr const char* InsertMember       = "insert_member";
+    inline constexpr const char* InsertStudent      = "insert_student";
+    inline constexpr const char* InsertTeacher      = "insert_teacher";
+    inline constexpr const char* InsertUserRole     = "insert_user_role";
+    inline constexpr const char* AssignRole         = "assign_role";
+    inline constexpr const char* GetAllUsers        = "get_all_users";
+    inline constexpr const char* GetUserByName      = "get_user_by_name";
+    inline constexpr const char* GetUserByEmail     = "get_user_by_email";
+    inline constexpr const char* GetUserById        = "get_user_by_id";
+
+    // Permissions
+    inline constexpr const char* GetAllRolePermissions = "get_all_role_permissions";
+}
+
+// Registry of the adapter's SQL. Registered as a PostgresPool connection
+// initializer, so each pooled connection prepares the whole set once and a
+// reconnected connection prepares it again before it is handed out.
+class PreparedStatements {
+public:
+    static const std::vector<std::pair<std::string, std::string>>& all();
+
+    static void prepareAll(pqxx::connection& conn);
+
+    // Ranked title search: $1 tsquery text, $2/$3 keyset cursor (rank, id;
+    // NULL for the first page), $4 limit. With trigram, $5 is the lower-cased
+    // query and similar titles match too. The trigram form needs pg_trgm
+    // (migration 003), so it is not prepared on every connection.
+    static std::string mediaSearch(bool trigram);
+};
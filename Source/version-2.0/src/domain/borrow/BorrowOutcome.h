@@ -0,0 +1,16 @@
+#pragma once
+
+// Result of a single-statement borrow. Anything other than Borrowed means
+// nothing was written.
+enum class BorrowOutcome {
+    Borrowed,
+    CopyNotFound,
+    UserNotFound,
+    Unavailable     // copy is lost/unavailable or already has an active borrow
+};
+
+// Result of a single-statement return
+enum class ReturnOutcome {
+    Returned,
+    NotBorrowed     // no active borrow of this copy by this user
+};
@@ -0,0 +1,122 @@
+#include "NearCache.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
+#include <iostream>
+#include <mutex>
+#include <random>
+
+NearCache::NearCache(std::shared_ptr<RedisClient> redis, Options options)
+    : redis_(std::move(redis)), options_(std::move(options)),
+      local_(options_.maxEntries, options_.localTtl),
+      instanceId_(std::to_string(std::random_device{}()) + std::to_string(std::random_device{}())),
+      localHits_(MetricsRegistry::instance().counter(
+          "near_cache_local_hits_total", "Cache reads answered from process memory")),
+      redisHits_(MetricsRegistry::instance().counter(
+          "near_cache_redis_hits_total", "Cache reads answered from Redis")),
+      misses_(MetricsRegistry::instance().counter(
+          "near_cache_misses_total", "Cache reads found in neither tier")),
+      invalidations_(MetricsRegistry::instance().counter(
+          "near_cache_invalidations_total", "Invalidations received from other instances")),
+      entries_(MetricsRegistry::instance().gauge(
+          "near_cache_entries", "Entries in the in-process cache")) {}
+
+NearCache::~NearCache() {
+    if (subscription_) redis_->unsubscribe(*subscription_);
+}
+
+void NearCache::start() {
+    subscription_ = redis_->subscribe(options_.channel,
+                      [this](std::string_view message) { onMessage(message); },
+                      [this](bool subscribed) { onSubscription(subscribed); });
+}
+
+void NearCache::onSubscription(bool subscribed) {
+    if (subscribed) {
+        // Whatever changed while unsubscribed was not announced to us
+        {
+            std::scoped_lock lock(fillMtx_);
+            ++epoch_;
+            local_.clear();
+        }
+        entries_.set(0);
+        std::cout << "[NearCache] Subscribed to " << options_.channel << "." << std::endl;
+    } else if (subscribed_) {
+        std::cerr << "[NearCache] Lost " << options_.channel << "; reading through to Redis." << std::endl;
+    }
+    subscribed_ = subscribed;
+}
+
+// "<instance> <key>"
+void NearCache::onMessage(std::string_view message) {
+    auto sep = message.find(' ');
+    if (sep == std::string_view::npos) return;
+    if (message.substr(0, sep) == instanceId_) return;
+    invalidations_.inc();
+    {
+        std::scoped_lock lock(fillMtx_);
+        ++epoch_;
+        local_.erase(std::string(message.substr(sep + 1)));
+    }
+    entries_.set(static_cast<double>(local_.size()));
+}
+
+void NearCache::announce(const std::string& key) {
+    redis_->commandAsync({"PUBLISH", options_.channel, instanceId_ + " " + key}, nullptr);
+}
+
+NearCache::Value NearCache::get(const std::string& key) {
+    bool useLocal = subscribed_.load();
+    if (useLocal) {
+        if (auto hit = local_.get(key)) {
+            localHits_.inc();
+            return *hit;
+        }
+    }
+
+    uint64_t epoch = epoch_.load();
+    auto raw = redis_->get(key);
+    if (!raw) {
+        misses_.inc();
+        return nullptr;
+    }
+    auto parsed = nlohmann::json::parse(*raw, nullptr, false);
+    if (parsed.is_discarded()) {
+        misses_.inc();
+        return nullptr;
+    }
+    redisHits_.inc();
+    auto value = std::make_shared<const nlohmann::json>(std::move(parsed));
+    if (useLocal) {
+        // Checked and stored together, so a change applied after the check
+        // replaces this value rather than being overwritten by it
+        std::scoped_lock lock(fillMtx_);
+        if (epoch_.load() == epoch) local_.put(key, value);
+    }
+    entries_.set(static_cast<double>(local_.size()));
+    return value;
+}
+
+// A read of the old value that overlaps the write must not be kept. The
+// epoch moves before the Redis write, and again with the local change.
+void NearCache::put(const std::string& key, nlohmann::json value, int ttlSeconds) {
+    ++epoch_;
+    redis_->set(key, value.dump(), ttlSeconds);
+    announce(key);
+    {
+        std::scoped_lock lock(fillMtx_);
+        ++epoch_;
+        local_.put(key, std::make_shared<const nlohmann::json>(std::move(value)));
+    }
+    entries_.set(static_cast<double>(local_.size()));
+}
+
+void NearCache::invalidate(const std::string& key) {
+    ++epoch_;
+    redis_->del(key);
+    announce(key);
+    {
+        std::scoped_lock lock(fillMtx_);
+        ++epoch_;
+        local_.erase(key);
+    }
+    entries_.set(static_cast<double>(local_.size()));
+}
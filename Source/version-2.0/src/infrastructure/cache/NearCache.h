@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <nlohmann/json.hpp>
+#include "src/infrastructure/cache/RedisClient.h"
+#include "src/utils/LruCache.h"
+
+class Counter;
+class Gauge;
+
+// In-process cache of decoded JSON values in front of Redis. A hit costs
+// no round trip and no parse. Writes and deletes go to Redis, then are
+// announced on a pub/sub channel; every instance drops its local copy of
+// the key when the message arrives. While the subscription is down,
+// announcements may be missed, so the local tier is bypassed until it is
+// back and then cleared. Local entries also expire after localTtl, which
+// bounds staleness if a message is lost anyway.
+class NearCache {
+public:
+    struct Options {
+        size_t maxEntries = 10000;
+        std::chrono::milliseconds localTtl{60000};
+        std::string channel = "cache:invalidate";
+    };
+
+    using Value = std::shared_ptr<const nlohmann::json>;
+
+    NearCache(std::shared_ptr<RedisClient> redis, Options options);
+    ~NearCache();
+
+    // Subscribes to the invalidation channel
+    void start();
+
+    // Local tier, then Redis; null when neither has the key
+    Value get(const std::string& key);
+    void put(const std::string& key, nlohmann::json value, int ttlSeconds);
+    void invalidate(const std::string& key);
+
+    // True while the local tier is in use
+    bool subscribed() const { return subscribed_.load(); }
+
+private:
+    void announce(const std::string& key);
+    void onMessage(std::string_view message);
+    void onSubscription(bool subscribed);
+
+    std::shared_ptr<RedisClient> redis_;
+    Options options_;
+    LruCache<Value> local_;
+    // Tells this instance's announcements apart from other instances'
+    std::string instanceId_;
+    std::atomic<bool> subscribed_{false};
+    std::optional<uint64_t> subscription_;
+    // Bumped on every write, delete or invalidation received; a Redis read
+    // that overlaps one is not kept locally, since it may predate the write
+    std::atomic<uint64_t> epoch_{0};
+    // Held to change the local tier after a bump, and to check the epoch
+    // and store a value read from Redis
+    std::mutex fillMtx_;
+
+    Counter& localHits_;
+    Counter& redisHits_;
+    Counter& misses_;
+    Counter& invalidations_;
+    Gauge& entries_;
+};
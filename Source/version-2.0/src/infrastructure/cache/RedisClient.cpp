@@ -1,127 +1,800 @@
 #include "RedisClient.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fcntl.h>
 #include <iostream>
-#include <stdexcept>
+#include <poll.h>
+#include <random>
+#include <unordered_set>
+#include <unordered_map>
+#include <unistd.h>
+#include <hiredis/async.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::chrono::milliseconds kMinBackoff{100};
+constexpr std::chrono::milliseconds kMaxBackoff{5000};
+
+// Keys per SCAN/SSCAN page, and so per UNLINK
+constexpr const char* kScanCount = "1000";
+
+// Async commands held while no async connection is up
+constexpr size_t kMaxWaiting = 10000;
+
+// Commands that are safe to send again when their reply was lost
+bool readOnly(const std::vector<std::vector<std::string>>& commands) {
+    static const std::unordered_set<std::string> kReadOnly{
+        "GET", "MGET", "EXISTS", "TTL", "PING", "SCAN", "SSCAN"};
+    return std::all_of(commands.begin(), commands.end(), [](const auto& args) {
+        return !args.empty() && kReadOnly.count(args.front()) > 0;
+    });
+}
+
+// An idle connection has nothing to read; if its socket is readable the
+// server has closed it (idle timeout, restart)
+bool closedWhileIdle(const redisContext* c) {
+    pollfd pfd{c->fd, POLLIN, 0};
+    return poll(&pfd, 1, 0) != 0;
+}
+
+std::string tagKey(const std::string& tag) {
+    return "tag:" + tag;
+}
+
+// Escapes the glob characters of a SCAN MATCH pattern
+std::string globEscape(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        if (c == '*' || c == '?' || c == '[' || c == ']' || c == '\\') out.push_back('\\');
+        out.push_back(c);
+    }
+    return out;
+}
+
+std::string uniqueSuffix() {
+    static std::atomic<uint64_t> counter{0};
+    static const uint64_t process = std::random_device{}();
+    return std::to_string(process) + "-" + std::to_string(++counter);
+}
+
+timeval toTimeval(std::chrono::milliseconds ms) {
+    timeval tv;
+    tv.tv_sec = static_cast<decltype(tv.tv_sec)>(ms.count() / 1000);
+    tv.tv_usec = static_cast<decltype(tv.tv_usec)>((ms.count() % 1000) * 1000);
+    return tv;
+}
+
+// argv/argvlen views of a command for the hiredis *Argv calls
+struct Argv {
+    explicit Argv(const std::vector<std::string>& args) {
+        argv.reserve(args.size());
+        argvlen.reserve(args.size());
+        for (const auto& a : args) {
+            argv.push_back(a.c_str());
+            argvlen.push_back(a.size());
+        }
+    }
+    int argc() const { return static_cast<int>(argv.size()); }
+
+    std::vector<const char*> argv;
+    std::vector<size_t> argvlen;
+};
+
+}
+
+// hiredis async contexts driven by one thread with poll(). hiredis async
+// contexts are not thread-safe, so commands from other threads are queued
+// and issued on the loop thread. Dropped connections are reopened there
+// with backoff; connecting is non-blocking, so it never stalls commands
+// on the other connections. Each subscription has a connection of its
+// own, subscribed again whenever it reconnects.
+class RedisClient::AsyncLoop {
+public:
+    explicit AsyncLoop(RedisClient& owner) : owner_(owner) {
+        if (pipe(wake_) != 0) throw std::runtime_error("[Redis] Cannot create event-loop pipe");
+        fcntl(wake_[0], F_SETFL, O_NONBLOCK);
+        fcntl(wake_[1], F_SETFL, O_NONBLOCK);
+        for (size_t i = 0; i < std::max<size_t>(1, owner_.options_.asyncConnections); ++i) {
+            auto slot = std::make_unique<Slot>();
+            slot->loop = this;
+            slots_.push_back(std::move(slot));
+        }
+        thread_ = std::thread([this] { run(); });
+    }
+
+    ~AsyncLoop() {
+        {
+            std::scoped_lock lock(mtx_);
+            stopping_ = true;
+        }
+        wake();
+        if (thread_.joinable()) thread_.join();
+        close(wake_[0]);
+        close(wake_[1]);
+    }
+
+    void submit(Args args, AsyncCallback done) {
+        {
+            std::scoped_lock lock(mtx_);
+            if (!stopping_) {
+                queue_.push_back({std::move(args), std::move(done),
+                                  Clock::now() + owner_.options_.connectTimeout});
+                // The loop drains the whole queue, so one wake-up per batch
+                if (queue_.size() == 1) wake();
+                return;
+            }
+        }
+        if (done) done(nullptr);
+    }
+
+    uint64_t subscribe(std::string channel, MessageCallback onMessage, StateCallback onState) {
+        auto sub = std::make_shared<Subscription>();
+        sub->channel = std::move(channel);
+        sub->onMessage = std::move(onMessage);
+        sub->onState = std::move(onState);
+        uint64_t id;
+        {
+            std::scoped_lock lock(mtx_);
+            id = ++lastSubscriptionId_;
+            if (stopping_) return id;
+            active_[id] = sub;
+            newSubscriptions_.push_back(std::move(sub));
+        }
+        wake();
+        return id;
+    }
+
+    void unsubscribe(uint64_t id) {
+        std::shared_ptr<Subscription> sub;
+        {
+            std::scoped_lock lock(mtx_);
+            auto it = active_.find(id);
+            if (it == active_.end()) return;
+            sub = std::move(it->second);
+            active_.erase(it);
+        }
+        {
+            // Waits out a callback in progress
+            std::scoped_lock lock(sub->mtx);
+            sub->active = false;
+        }
+        // The loop closes the connection
+        wake();
+    }
+
+private:
+    struct Subscription {
+        std::string channel;
+        MessageCallback onMessage;
+        StateCallback onState;
+        // Held while a callback runs; no callback runs once active is false
+        std::mutex mtx;
+        std::atomic<bool> active{true};
+    };
+
+    struct Slot {
+        AsyncLoop* loop = nullptr;
+        redisAsyncContext* ac = nullptr;   // null while disconnected
+        bool connected = false;            // connected and authenticated
+        bool reading = false;
+        bool writing = false;
+        Clock::time_point timer = Clock::time_point::max();   // hiredis timeout
+        Clock::time_point retryAt{};
+        std::chrono::milliseconds backoff = kMinBackoff;
+        Subscription* subscription = nullptr;   // set for a subscriber connection
+    };
+
+    struct Pending {
+        Args args;
+        AsyncCallback done;
+        // Until when it may wait for a connection
+        Clock::time_point deadline;
+    };
+
+    void wake() {
+        char b = 1;
+        (void)!write(wake_[1], &b, 1);
+    }
+
+    void run() {
+        std::vector<pollfd> fds;
+        std::vector<Slot*> polled;
+        while (true) {
+            dropUnsubscribed();
+            auto now = Clock::now();
+            auto nextEvent = now + std::chrono::seconds(1);
+            while (!waiting_.empty() && now >= waiting_.front().deadline) {
+                fail(std::move(waiting_.front()));
+                waiting_.pop_front();
+            }
+            if (!waiting_.empty()) nextEvent = std::min(nextEvent, waiting_.front().deadline);
+            for (auto& s : slots_) {
+                if (!s->ac && now >= s->retryAt) connect(*s);
+                if (s->ac && now >= s->timer) {
+                    s->timer = Clock::time_point::max();
+                    redisAsyncHandleTimeout(s->ac);
+                }
+                nextEvent = std::min(nextEvent, s->ac ? s->timer : s->retryAt);
+            }
+
+            fds.clear();
+            polled.clear();
+            fds.push_back({wake_[0], POLLIN, 0});
+            for (auto& s : slots_) {
+                if (!s->ac || !(s->reading || s->writing)) continue;
+                short events = static_cast<short>((s->reading ? POLLIN : 0) | (s->writing ? POLLOUT : 0));
+                fds.push_back({s->ac->c.fd, events, 0});
+                polled.push_back(s.get());
+            }
+            auto wait = std::chrono::ceil<std::chrono::milliseconds>(nextEvent - Clock::now());
+            poll(fds.data(), fds.size(), static_cast<int>(std::max<int64_t>(0, wait.count())));
+
+            for (size_t i = 0; i < polled.size(); ++i) {
+                Slot* s = polled[i];
+                short revents = fds[i + 1].revents;
+                if (s->ac && s->reading && (revents & (POLLIN | POLLHUP | POLLERR)))
+                    redisAsyncHandleRead(s->ac);
+                if (s->ac && s->writing && (revents & (POLLOUT | POLLHUP | POLLERR)))
+                    redisAsyncHandleWrite(s->ac);
+            }
+
+            std::deque<Pending> pending;
+            std::vector<std::shared_ptr<Subscription>> added;
+            bool stopping;
+            {
+                std::scoped_lock lock(mtx_);
+                if (fds[0].revents & POLLIN) {
+                    char buf[64];
+                    while (read(wake_[0], buf, sizeof(buf)) > 0) {}
+                }
+                pending.swap(queue_);
+                added.swap(newSubscriptions_);
+                stopping = stopping_;
+            }
+            // Connected at the top of the next iteration
+            for (auto& sub : added) {
+                auto slot = std::make_unique<Slot>();
+                slot->loop = this;
+                slot->subscription = sub.get();
+                slots_.push_back(std::move(slot));
+                subscriptions_.push_back(std::move(sub));
+            }
+            // Commands held for a connection go first, in order
+            if (!waiting_.empty() && commandSlotUp()) {
+                std::deque<Pending> held;
+                held.swap(waiting_);
+                for (auto& p : held) dispatch(std::move(p));
+            }
+            for (auto& p : pending) dispatch(std::move(p));
+            if (stopping) break;
+        }
+
+        // Pending callbacks are called with a null reply
+        for (auto& s : slots_)
+            if (s->ac) redisAsyncFree(s->ac);
+        for (auto& p : waiting_) fail(std::move(p));
+        waiting_.clear();
+    }
+
+    void dropUnsubscribed() {
+        for (auto it = slots_.begin(); it != slots_.end();) {
+            Slot& s = **it;
+            if (!s.subscription || s.subscription->active) {
+                ++it;
+                continue;
+            }
+            if (s.ac) redisAsyncFree(s.ac);
+            Subscription* sub = s.subscription;
+            subscriptions_.erase(std::remove_if(subscriptions_.begin(), subscriptions_.end(),
+                                                [sub](const auto& p) { return p.get() == sub; }),
+                                 subscriptions_.end());
+            it = slots_.erase(it);
+        }
+    }
+
+    void connect(Slot& s) {
+        redisOptions options{};
+        REDIS_OPTIONS_SET_TCP(&options, owner_.host_.c_str(), owner_.port_);
+        timeval connectTimeout = toTimeval(owner_.options_.connectTimeout);
+        options.connect_timeout = &connectTimeout;
+
+        redisAsyncContext* ac = redisAsyncConnectWithOptions(&options);
+        if (!ac || ac->err) {
+            if (ac) redisAsyncFree(ac);
+            dropped(s);
+            return;
+        }
+        s.ac = ac;
+        s.reading = s.writing = false;
+        s.timer = Clock::time_point::max();
+        ac->data = &s;
+        ac->ev.data = &s;
+        ac->ev.addRead = [](void* p) { static_cast<Slot*>(p)->reading = true; };
+        ac->ev.delRead = [](void* p) { static_cast<Slot*>(p)->reading = false; };
+        ac->ev.addWrite = [](void* p) { static_cast<Slot*>(p)->writing = true; };
+        ac->ev.delWrite = [](void* p) { static_cast<Slot*>(p)->writing = false; };
+        ac->ev.scheduleTimer = [](void* p, timeval tv) {
+            static_cast<Slot*>(p)->timer =
+                Clock::now() + std::chrono::seconds(tv.tv_sec) + std::chrono::microseconds(tv.tv_usec);
+        };
+        // hiredis is freeing the context
+        ac->ev.cleanup = [](void* p) {
+            auto* slot = static_cast<Slot*>(p);
+            slot->ac = nullptr;
+            slot->connected = false;
+            slot->reading = slot->writing = false;
+        };
+        redisAsyncSetConnectCallback(ac, &AsyncLoop::onConnect);
+        redisAsyncSetDisconnectCallback(ac, &AsyncLoop::onDisconnect);
+        redisAsyncSetTimeout(ac, toTimeval(owner_.options_.commandTimeout));
+    }
+
+    // The context is gone or going; the loop reopens it after the backoff
+    void dropped(Slot& s) {
+        s.connected = false;
+        s.retryAt = Clock::now() + s.backoff;
+        s.backoff = std::min(s.backoff * 2, kMaxBackoff);
+        owner_.onFailure();
+    }
+
+    static void onConnect(const redisAsyncContext* ac, int status) {
+        auto* s = static_cast<Slot*>(ac->data);
+        if (status != REDIS_OK) {
+            s->loop->dropped(*s);
+            return;
+        }
+        const std::string& password = s->loop->owner_.password_;
+        if (password.empty()) {
+            s->loop->ready(*s);
+            return;
+        }
+        // Nothing else is sent until AUTH has succeeded
+        Args args{"AUTH", password};
+        Argv auth(args);
+        redisAsyncCommandArgv(const_cast<redisAsyncContext*>(ac), &AsyncLoop::onAuth, s,
+                              auth.argc(), auth.argv.data(), auth.argvlen.data());
+    }
+
+    static void onAuth(redisAsyncContext* ac, void* r, void* privdata) {
+        auto* s = static_cast<Slot*>(privdata);
+        auto* reply = static_cast<redisReply*>(r);
+        // The connection went away; onDisconnect has dealt with the slot
+        if (!reply) return;
+        if (reply->type == REDIS_REPLY_ERROR) {
+            std::cerr << "[Redis] AUTH failed on async connection" << std::endl;
+            // Retried after the backoff; onDisconnect sees a requested close
+            s->loop->dropped(*s);
+            redisAsyncDisconnect(ac);
+            return;
+        }
+        s->loop->ready(*s);
+    }
+
+    void ready(Slot& s) {
+        s.connected = true;
+        s.backoff = kMinBackoff;
+        owner_.onSuccess();
+        if (s.subscription) {
+            Args args{"SUBSCRIBE", s.subscription->channel};
+            Argv argv(args);
+            redisAsyncCommandArgv(s.ac, &AsyncLoop::onSubscription, s.subscription,
+                                  argv.argc(), argv.argv.data(), argv.argvlen.data());
+        }
+    }
+
+    // Called for the SUBSCRIBE confirmation, for every message, and with
+    // a null reply when the connection goes away
+    static void onSubscription(redisAsyncContext*, void* r, void* privdata) {
+        auto* sub = static_cast<Subscription*>(privdata);
+        auto* reply = static_cast<redisReply*>(r);
+        std::scoped_lock lock(sub->mtx);
+        if (!sub->active) return;
+        try {
+            if (!reply) {
+                if (sub->onState) sub->onState(false);
+                return;
+            }
+            if (reply->type != REDIS_REPLY_ARRAY || reply->elements < 3) return;
+            std::string_view kind(reply->element[0]->str, reply->element[0]->len);
+            if (kind == "subscribe") {
+                if (sub->onState) sub->onState(true);
+            } else if (kind == "message" && reply->element[2]->type == REDIS_REPLY_STRING) {
+                sub->onMessage(std::string_view(reply->element[2]->str, reply->element[2]->len));
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "[Redis] Subscription callback threw: " << e.what() << std::endl;
+        }
+    }
+
+    static void onDisconnect(const redisAsyncContext* ac, int status) {
+        auto* s = static_cast<Slot*>(ac->data);
+        // REDIS_OK is a disconnect we asked for (shutdown)
+        if (status == REDIS_OK) {
+            s->connected = false;
+            return;
+        }
+        s->loop->dropped(*s);
+    }
+
+    static void onReply(redisAsyncContext*, void* reply, void* privdata) {
+        std::unique_ptr<AsyncCallback> done(static_cast<AsyncCallback*>(privdata));
+        try {
+            (*done)(static_cast<const redisReply*>(reply));
+        } catch (const std::exception& e) {
+            std::cerr << "[Redis] Async callback threw: " << e.what() << std::endl;
+        }
+    }
+
+    bool commandSlotUp() const {
+        return std::any_of(slots_.begin(), slots_.end(), [](const auto& s) {
+            return s->ac && s->connected && !s->subscription;
+        });
+    }
+
+    void fail(Pending p) {
+        owner_.failures_.inc();
+        if (p.done) p.done(nullptr);
+    }
+
+    // Round-robin over connected contexts. With none up the command waits
+    // for one until its deadline, unless the breaker says Redis is down.
+    void dispatch(Pending p) {
+        if (!commandSlotUp()) {
+            if (owner_.breaker_.open()) {
+                owner_.rejected_.inc();
+                if (p.done) p.done(nullptr);
+            } else if (waiting_.size() < kMaxWaiting && Clock::now() < p.deadline) {
+                waiting_.push_back(std::move(p));
+            } else {
+                fail(std::move(p));
+            }
+            return;
+        }
+        Argv argv(p.args);
+        for (size_t n = 0; n < slots_.size(); ++n) {
+            Slot& s = *slots_[next_++ % slots_.size()];
+            if (!s.ac || !s.connected || s.subscription) continue;
+            if (!p.done) {
+                if (redisAsyncCommandArgv(s.ac, nullptr, nullptr, argv.argc(), argv.argv.data(),
+                                          argv.argvlen.data()) == REDIS_OK)
+                    return;
+                continue;
+            }
+            auto* done = new AsyncCallback(std::move(p.done));
+            if (redisAsyncCommandArgv(s.ac, &AsyncLoop::onReply, done, argv.argc(), argv.argv.data(),
+                                      argv.argvlen.data()) == REDIS_OK)
+                return;
+            p.done = std::move(*done);
+            delete done;
+        }
+        fail(std::move(p));
+    }
+
+    RedisClient& owner_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    size_t next_ = 0;
+    int wake_[2] = {-1, -1};
+
+    std::vector<std::shared_ptr<Subscription>> subscriptions_;
+    // Loop thread only: commands issued while no connection was up
+    std::deque<Pending> waiting_;
+
+    std::mutex mtx_;
+    std::deque<Pending> queue_;
+    std::vector<std::shared_ptr<Subscription>> newSubscriptions_;
+    std::unordered_map<uint64_t, std::shared_ptr<Subscription>> active_;
+    uint64_t lastSubscriptionId_ = 0;
+    bool stopping_ = false;
+    std::thread thread_;
+};
 
 RedisClient::RedisClient(const std::string& host, int port, const std::string& password)
-    : host_(host), port_(port), password_(password), ctx_(nullptr) {
-    ctx_ = connect();
+    : RedisClient(host, port, password, Options{}) {}
+
+RedisClient::RedisClient(const std::string& host, int port, const std::string& password, Options options)
+    : host_(host), port_(port), password_(password), options_(options),
+      breaker_(options.breakerThreshold, options.breakerCooldown),
+      openGauge_(MetricsRegistry::instance().gauge(
+          "redis_pool_connections_open", "Blocking Redis connections currently open")),
+      inUseGauge_(MetricsRegistry::instance().gauge(
+          "redis_pool_connections_in_use", "Blocking Redis connections currently leased")),
+      breakerGauge_(MetricsRegistry::instance().gauge(
+          "redis_breaker_open", "1 while Redis calls fail fast after repeated failures")),
+      failures_(MetricsRegistry::instance().counter(
+          "redis_command_failures_total", "Redis commands that failed on a broken or missing connection")),
+      rejected_(MetricsRegistry::instance().counter(
+          "redis_breaker_rejected_total", "Redis calls failed fast by the circuit breaker")),
+      reconnects_(MetricsRegistry::instance().counter(
+          "redis_reconnects_total", "Broken Redis connections replaced in the background")) {
+    options_.poolSize = std::max<size_t>(1, options_.poolSize);
+
+    // The first connection opens inline so startup knows whether Redis is
+    // up; the rest of the pool opens in the background
+    if (auto conn = connect()) {
+        idle_.push_back(std::move(conn));
+        open_ = 1;
+    } else {
+        onFailure();
+    }
+    publishLocked();
+    async_ = std::make_unique<AsyncLoop>(*this);
+    reconnector_ = std::thread([this] { reconnectLoop(); });
 }
 
 RedisClient::~RedisClient() {
-    if (ctx_) redisFree(ctx_);
+    async_.reset();
+    {
+        std::scoped_lock lock(mtx_);
+        stopping_ = true;
+    }
+    reconnect_.notify_all();
+    available_.notify_all();
+    if (reconnector_.joinable()) reconnector_.join();
 }
 
-redisContext* RedisClient::connect() {
-    struct timeval timeout = {2, 0};
-    redisContext* c = redisConnectWithTimeout(host_.c_str(), port_, timeout);
-    if (!c || c->err) {
-        std::string err = c ? c->errstr : "allocation failed";
-        if (c) redisFree(c);
-        std::cerr << "[Redis] Connection failed: " << err << std::endl;
-        return nullptr;
-    }
+RedisClient::Context RedisClient::connect() {
+    Context c(redisConnectWithTimeout(host_.c_str(), port_, toTimeval(options_.connectTimeout)));
+    if (!c || c->err) return nullptr;
+    redisSetTimeout(c.get(), toTimeval(options_.commandTimeout));
 
     if (!password_.empty()) {
-        auto* reply = static_cast<redisReply*>(
-            redisCommand(c, "AUTH %s", password_.c_str()));
+        Reply reply(static_cast<redisReply*>(redisCommand(c.get(), "AUTH %s", password_.c_str())));
         if (!reply || reply->type == REDIS_REPLY_ERROR) {
             std::cerr << "[Redis] AUTH failed" << std::endl;
-            if (reply) freeReplyObject(reply);
-            redisFree(c);
             return nullptr;
         }
-        freeReplyObject(reply);
     }
-
     return c;
 }
 
-redisReply* RedisClient::execute(const std::string& cmd) {
-    if (!ctx_) {
-        ctx_ = connect();
-        if (!ctx_) return nullptr;
+void RedisClient::onSuccess() {
+    if (breaker_.open()) {
+        std::cout << "[Redis] Connection restored." << std::endl;
+        breakerGauge_.set(0);
     }
-    auto* reply = static_cast<redisReply*>(redisCommand(ctx_, cmd.c_str()));
-    if (!reply && ctx_->err) {
-        redisFree(ctx_);
-        ctx_ = connect();
-        if (ctx_)
-            reply = static_cast<redisReply*>(redisCommand(ctx_, cmd.c_str()));
+    breaker_.recordSuccess();
+}
+
+void RedisClient::onFailure() {
+    if (breaker_.recordFailure()) {
+        std::cerr << "[Redis] Unavailable after " << options_.breakerThreshold
+                  << " failures; failing calls fast while reconnecting." << std::endl;
+        breakerGauge_.set(1);
     }
-    return reply;
 }
 
-redisReply* RedisClient::execute(const std::vector<std::string>& args) {
-    if (!ctx_) {
-        ctx_ = connect();
-        if (!ctx_) return nullptr;
+void RedisClient::publishLocked() {
+    openGauge_.set(static_cast<double>(open_));
+    inUseGauge_.set(static_cast<double>(leased_));
+}
+
+void RedisClient::reconnectLoop() {
+    auto backoff = kMinBackoff;
+    std::unique_lock lock(mtx_);
+    while (!stopping_) {
+        if (open_ >= options_.poolSize) {
+            reconnect_.wait(lock, [this] { return stopping_ || open_ < options_.poolSize; });
+            continue;
+        }
+        // Reserve the slot so the pool never opens more than poolSize
+        ++open_;
+        lock.unlock();
+        Context conn = connect();
+        lock.lock();
+        if (conn) {
+            idle_.push_back(std::move(conn));
+            available_.notify_one();
+            backoff = kMinBackoff;
+            lock.unlock();
+            onSuccess();
+            lock.lock();
+        } else {
+            --open_;
+            lock.unlock();
+            onFailure();
+            lock.lock();
+            reconnect_.wait_for(lock, backoff, [this] { return stopping_; });
+            backoff = std::min(backoff * 2, kMaxBackoff);
+        }
+        publishLocked();
     }
-    std::vector<const char*> argv;
-    std::vector<size_t> argvlen;
-    argv.reserve(args.size());
-    argvlen.reserve(args.size());
-    for (auto& a : args) {
-        argv.push_back(a.c_str());
-        argvlen.push_back(a.size());
+}
+
+RedisClient::Context RedisClient::acquire() {
+    if (!breaker_.allow()) {
+        rejected_.inc();
+        return nullptr;
     }
-    auto* reply = static_cast<redisReply*>(
-        redisCommandArgv(ctx_, static_cast<int>(args.size()), argv.data(), argvlen.data()));
-    if (!reply && ctx_->err) {
-        redisFree(ctx_);
-        ctx_ = connect();
-        if (ctx_)
-            reply = static_cast<redisReply*>(
-                redisCommandArgv(ctx_, static_cast<int>(args.size()), argv.data(), argvlen.data()));
+    std::unique_lock lock(mtx_);
+    auto deadline = Clock::now() + options_.acquireTimeout;
+    while (available_.wait_until(lock, deadline, [this] { return stopping_ || !idle_.empty(); })
+           && !idle_.empty()) {
+        // Most recently used first: it is the least likely to have gone stale
+        Context conn = std::move(idle_.back());
+        idle_.pop_back();
+        if (closedWhileIdle(conn.get())) {
+            // Nothing was sent on it, so the caller can have another
+            conn.reset();
+            --open_;
+            reconnects_.inc();
+            reconnect_.notify_one();
+            publishLocked();
+            continue;
+        }
+        ++leased_;
+        publishLocked();
+        return conn;
     }
-    return reply;
+    failures_.inc();
+    return nullptr;
 }
 
-bool RedisClient::set(const std::string& key, const std::string& value, int ttlSeconds) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    redisReply* reply;
-    if (ttlSeconds > 0) {
-        reply = execute({"SET", key, value, "EX", std::to_string(ttlSeconds)});
+void RedisClient::release(Context conn, bool broken) {
+    std::scoped_lock lock(mtx_);
+    --leased_;
+    if (broken) {
+        conn.reset();
+        --open_;
+        reconnects_.inc();
+        reconnect_.notify_one();
     } else {
-        reply = execute({"SET", key, value});
+        idle_.push_back(std::move(conn));
+        available_.notify_one();
+    }
+    publishLocked();
+}
+
+std::vector<RedisClient::Reply> RedisClient::pipeline(const std::vector<Args>& commands) {
+    // acquire() skips connections the server closed while idle. A failure
+    // after sending may still have run the commands (an INCR counted
+    // twice), so only reads get a second attempt.
+    const int attempts = readOnly(commands) ? 2 : 1;
+    for (int attempt = 0; attempt < attempts; ++attempt) {
+        Context conn = acquire();
+        if (!conn) return {};
+
+        for (const auto& args : commands) {
+            Argv argv(args);
+            redisAppendCommandArgv(conn.get(), argv.argc(), argv.argv.data(), argv.argvlen.data());
+        }
+        std::vector<Reply> replies;
+        replies.reserve(commands.size());
+        while (replies.size() < commands.size()) {
+            void* reply = nullptr;
+            if (redisGetReply(conn.get(), &reply) != REDIS_OK) break;
+            replies.emplace_back(static_cast<redisReply*>(reply));
+        }
+
+        bool broken = replies.size() < commands.size();
+        release(std::move(conn), broken);
+        if (!broken) {
+            onSuccess();
+            return replies;
+        }
+        failures_.inc();
+        onFailure();
     }
-    bool ok = reply && reply->type == REDIS_REPLY_STATUS;
-    if (reply) freeReplyObject(reply);
-    return ok;
+    return {};
+}
+
+RedisClient::Reply RedisClient::execute(const Args& args) {
+    auto replies = pipeline({args});
+    return replies.empty() ? nullptr : std::move(replies.front());
+}
+
+bool RedisClient::set(const std::string& key, const std::string& value, int ttlSeconds) {
+    Reply reply = ttlSeconds > 0
+        ? execute({"SET", key, value, "EX", std::to_string(ttlSeconds)})
+        : execute({"SET", key, value});
+    return reply && reply->type == REDIS_REPLY_STATUS;
 }
 
 std::optional<std::string> RedisClient::get(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    auto* reply = execute({"GET", key});
-    if (!reply) return std::nullopt;
-    std::optional<std::string> result;
-    if (reply->type == REDIS_REPLY_STRING)
-        result = std::string(reply->str, reply->len);
-    freeReplyObject(reply);
-    return result;
+    auto reply = execute({"GET", key});
+    if (!reply || reply->type != REDIS_REPLY_STRING) return std::nullopt;
+    return std::string(reply->str, reply->len);
 }
 
 bool RedisClient::del(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    auto* reply = execute({"DEL", key});
-    bool ok = reply && reply->type == REDIS_REPLY_INTEGER && reply->integer > 0;
-    if (reply) freeReplyObject(reply);
-    return ok;
+    auto reply = execute({"DEL", key});
+    return reply && reply->type == REDIS_REPLY_INTEGER && reply->integer > 0;
 }
 
 bool RedisClient::exists(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    auto* reply = execute({"EXISTS", key});
-    bool ok = reply && reply->type == REDIS_REPLY_INTEGER && reply->integer > 0;
-    if (reply) freeReplyObject(reply);
-    return ok;
+    auto reply = execute({"EXISTS", key});
+    return reply && reply->type == REDIS_REPLY_INTEGER && reply->integer > 0;
 }
 
 bool RedisClient::expire(const std::string& key, int seconds) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    auto* reply = execute({"EXPIRE", key, std::to_string(seconds)});
-    bool ok = reply && reply->type == REDIS_REPLY_INTEGER && reply->integer == 1;
-    if (reply) freeReplyObject(reply);
-    return ok;
+    auto reply = execute({"EXPIRE", key, std::to_string(seconds)});
+    return reply && reply->type == REDIS_REPLY_INTEGER && reply->integer == 1;
+}
+
+std::optional<long long> RedisClient::incr(const std::string& key) {
+    auto reply = execute({"INCR", key});
+    if (!reply || reply->type != REDIS_REPLY_INTEGER) return std::nullopt;
+    return reply->integer;
+}
+
+std::vector<std::optional<std::string>> RedisClient::mget(const std::vector<std::string>& keys) {
+    std::vector<std::optional<std::string>> values(keys.size());
+    if (keys.empty()) return values;
+
+    Args args;
+    args.reserve(keys.size() + 1);
+    args.push_back("MGET");
+    args.insert(args.end(), keys.begin(), keys.end());
+    auto reply = execute(args);
+    if (!reply || reply->type != REDIS_REPLY_ARRAY || reply->elements != keys.size()) return values;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const redisReply* e = reply->element[i];
+        if (e->type == REDIS_REPLY_STRING) values[i] = std::string(e->str, e->len);
+    }
+    return values;
+}
+
+bool RedisClient::mset(const std::vector<std::pair<std::string, std::string>>& entries, int ttlSeconds) {
+    if (entries.empty()) return true;
+
+    std::vector<Args> commands;
+    if (ttlSeconds > 0) {
+        std::string ttl = std::to_string(ttlSeconds);
+        commands.reserve(entries.size());
+        for (const auto& [key, value] : entries)
+            commands.push_back({"SET", key, value, "EX", ttl});
+    } else {
+        Args args;
+        args.reserve(entries.size() * 2 + 1);
+        args.push_back("MSET");
+        for (const auto& [key, value] : entries) {
+            args.push_back(key);
+            args.push_back(value);
+        }
+        commands.push_back(std::move(args));
+    }
+    auto replies = pipeline(commands);
+    return !replies.empty() && std::all_of(replies.begin(), replies.end(), [](const Reply& r) {
+        return r && r->type == REDIS_REPLY_STATUS;
+    });
+}
+
+void RedisClient::commandAsync(std::vector<std::string> args, AsyncCallback done) {
+    async_->submit(std::move(args), std::move(done));
+}
+
+uint64_t RedisClient::subscribe(const std::string& channel, MessageCallback onMessage, StateCallback onState) {
+    return async_->subscribe(channel, std::move(onMessage), std::move(onState));
+}
+
+void RedisClient::unsubscribe(uint64_t id) {
+    async_->unsubscribe(id);
+}
+
+void RedisClient::getAsync(const std::string& key, std::function<void(std::optional<std::string>)> done) {
+    commandAsync({"GET", key}, [done = std::move(done)](const redisReply* reply) {
+        if (reply && reply->type == REDIS_REPLY_STRING)
+            done(std::string(reply->str, reply->len));
+        else
+            done(std::nullopt);
+    });
+}
+
+void RedisClient::setAsync(const std::string& key, const std::string& value, int ttlSeconds,
+                           std::function<void(bool)> done) {
+    Args args = ttlSeconds > 0 ? Args{"SET", key, value, "EX", std::to_string(ttlSeconds)}
+                               : Args{"SET", key, value};
+    if (!done) {
+        commandAsync(std::move(args), nullptr);
+        return;
+    }
+    commandAsync(std::move(args), [done = std::move(done)](const redisReply* reply) {
+        done(reply && reply->type == REDIS_REPLY_STATUS);
+    });
 }
 
 bool RedisClient::setJson(const std::string& key, const nlohmann::json& value, int ttlSeconds) {
@@ -148,26 +821,95 @@ bool RedisClient::destroySession(const std::string& sessionId) {
     return del("session:" + sessionId);
 }
 
-bool RedisClient::invalidateByPrefix(const std::string& prefix) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    auto* reply = execute({"KEYS", prefix + "*"});
-    if (!reply || reply->type != REDIS_REPLY_ARRAY) {
-        if (reply) freeReplyObject(reply);
-        return false;
+std::optional<size_t> RedisClient::unlinkScanned(
+        const std::function<Args(const std::string& cursor)>& scan) {
+    std::string cursor = "0";
+    Args unlink;
+    size_t removed = 0;
+    while (true) {
+        // The previous batch is unlinked in the round trip of the next scan
+        std::vector<Args> commands;
+        if (!unlink.empty()) commands.push_back(std::move(unlink));
+        unlink.clear();
+        commands.push_back(scan(cursor));
+        auto replies = pipeline(commands);
+        if (replies.empty()) return std::nullopt;
+        if (commands.size() == 2 && replies.front()->type == REDIS_REPLY_INTEGER)
+            removed += static_cast<size_t>(replies.front()->integer);
+
+        const redisReply* page = replies.back().get();
+        if (page->type != REDIS_REPLY_ARRAY || page->elements != 2) return std::nullopt;
+        cursor.assign(page->element[0]->str, page->element[0]->len);
+        const redisReply* keys = page->element[1];
+        if (keys->elements > 0) {
+            unlink.reserve(keys->elements + 1);
+            unlink.push_back("UNLINK");
+            for (size_t i = 0; i < keys->elements; ++i)
+                unlink.emplace_back(keys->element[i]->str, keys->element[i]->len);
+        }
+        if (cursor == "0") break;
+    }
+    if (!unlink.empty()) {
+        auto reply = execute(unlink);
+        if (!reply) return std::nullopt;
+        if (reply->type == REDIS_REPLY_INTEGER) removed += static_cast<size_t>(reply->integer);
     }
-    for (size_t i = 0; i < reply->elements; ++i) {
-        auto* delReply = execute({"DEL", std::string(reply->element[i]->str, reply->element[i]->len)});
-        if (delReply) freeReplyObject(delReply);
+    return removed;
+}
+
+std::optional<size_t> RedisClient::invalidateByPrefix(const std::string& prefix) {
+    std::string pattern = globEscape(prefix) + "*";
+    return unlinkScanned([&](const std::string& cursor) {
+        return Args{"SCAN", cursor, "MATCH", pattern, "COUNT", kScanCount};
+    });
+}
+
+bool RedisClient::setTagged(const std::string& key, const std::string& value, int ttlSeconds,
+                            const std::vector<std::string>& tags) {
+    std::string ttl = std::to_string(ttlSeconds);
+    std::vector<Args> commands;
+    commands.push_back(ttlSeconds > 0 ? Args{"SET", key, value, "EX", ttl} : Args{"SET", key, value});
+    for (const auto& tag : tags) {
+        std::string set = tagKey(tag);
+        commands.push_back({"SADD", set, key});
+        if (ttlSeconds > 0) {
+            // NX sets a TTL on a new set, GT only ever extends it
+            commands.push_back({"EXPIRE", set, ttl, "NX"});
+            commands.push_back({"EXPIRE", set, ttl, "GT"});
+        } else {
+            commands.push_back({"PERSIST", set});
+        }
     }
-    freeReplyObject(reply);
-    return true;
+    // SET answers a status, the rest an integer. An error (EXPIRE NX/GT
+    // before Redis 7) means a tag set may be missing the key or its TTL.
+    auto replies = pipeline(commands);
+    if (replies.empty() || replies.front()->type != REDIS_REPLY_STATUS) return false;
+    bool tagged = std::all_of(replies.begin() + 1, replies.end(), [](const Reply& r) {
+        return r->type == REDIS_REPLY_INTEGER;
+    });
+    if (!tagged) std::cerr << "[Redis] setTagged: a tag command failed for " << key << std::endl;
+    return tagged;
+}
+
+std::optional<size_t> RedisClient::invalidateTag(const std::string& tag) {
+    // Moved aside first, so keys tagged while the group is being dropped
+    // land in a fresh set instead of being missed
+    std::string set = tagKey(tag);
+    std::string dropping = set + ":dropping:" + uniqueSuffix();
+    auto replies = pipeline({{"RENAME", set, dropping}, {"EXPIRE", dropping, "3600"}});
+    if (replies.empty()) return std::nullopt;
+    // No such tag
+    if (replies.front()->type == REDIS_REPLY_ERROR) return 0;
+
+    auto removed = unlinkScanned([&](const std::string& cursor) {
+        return Args{"SSCAN", dropping, cursor, "COUNT", kScanCount};
+    });
+    if (removed) execute({"UNLINK", dropping});
+    return removed;
 }
 
 bool RedisClient::ping() {
-    std::lock_guard<std::mutex> lock(mtx_);
-    auto* reply = execute({"PING"});
-    bool ok = reply && reply->type == REDIS_REPLY_STATUS
-              && std::string(reply->str) == "PONG";
-    if (reply) freeReplyObject(reply);
-    return ok;
+    auto reply = execute({"PING"});
+    return reply && reply->type == REDIS_REPLY_STATUS
+           && std::string(reply->str, reply->len) == "PONG";
 }
@@ -1,23 +1,90 @@
 #pragma once
-#include <string>
-#include <optional>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
-#include <functional>
 #include <hiredis/hiredis.h>
 #include <nlohmann/json.hpp>
+#include "src/utils/CircuitBreaker.h"
 
+class Counter;
+class Gauge;
+
+// Thread-safe Redis client. Blocking calls run on a pool of connections,
+// so concurrent callers do not queue behind one socket; a caller waits for
+// a free connection at most acquireTimeout. The async calls share a few
+// connections multiplexed by one event-loop thread.
+//
+// Callers never connect inline: broken connections are replaced by a
+// background thread with backoff. After breakerThreshold consecutive
+// failures the circuit breaker fails every call immediately (reads miss,
+// writes return false) until a trial after breakerCooldown succeeds.
 class RedisClient {
 public:
+    struct Options {
+        size_t poolSize = 8;
+        size_t asyncConnections = 2;
+        std::chrono::milliseconds connectTimeout{2000};
+        std::chrono::milliseconds commandTimeout{500};
+        std::chrono::milliseconds acquireTimeout{100};
+        int breakerThreshold = 5;
+        std::chrono::milliseconds breakerCooldown{5000};
+    };
+
+    // Null when the command failed or Redis was unavailable; the reply is
+    // freed when the callback returns
+    using AsyncCallback = std::function<void(const redisReply* reply)>;
+    using MessageCallback = std::function<void(std::string_view message)>;
+    // True once subscribed, false when the subscription is lost
+    using StateCallback = std::function<void(bool subscribed)>;
+
     RedisClient(const std::string& host, int port, const std::string& password = "");
+    RedisClient(const std::string& host, int port, const std::string& password, Options options);
     ~RedisClient();
 
+    RedisClient(const RedisClient&) = delete;
+    RedisClient& operator=(const RedisClient&) = delete;
+
     // Basic key-value operations
     bool set(const std::string& key, const std::string& value, int ttlSeconds = 0);
     std::optional<std::string> get(const std::string& key);
     bool del(const std::string& key);
     bool exists(const std::string& key);
     bool expire(const std::string& key, int seconds);
+    std::optional<long long> incr(const std::string& key);
+
+    // Batches: one round trip each. mget has an entry per key (nullopt
+    // for a missing key, or every key when Redis is unavailable); mset
+    // pipelines SET ... EX when a TTL is given, since MSET takes none.
+    std::vector<std::optional<std::string>> mget(const std::vector<std::string>& keys);
+    bool mset(const std::vector<std::pair<std::string, std::string>>& entries, int ttlSeconds = 0);
+
+    // Non-blocking variants. done runs on the event-loop thread and must
+    // not block; it may be empty for fire-and-forget writes. With no async
+    // connection up (at startup, or while one reconnects) a command waits
+    // up to connectTimeout for one; while the breaker is open it fails at
+    // once.
+    void commandAsync(std::vector<std::string> args, AsyncCallback done);
+    void getAsync(const std::string& key, std::function<void(std::optional<std::string>)> done);
+    void setAsync(const std::string& key, const std::string& value, int ttlSeconds = 0,
+                  std::function<void(bool)> done = nullptr);
+
+    // Pub/sub on a dedicated connection, resubscribed after every
+    // reconnect. Messages published while it was down are lost, so
+    // onState(false) should stop trusting anything they would invalidate.
+    // Callbacks run on the event-loop thread; none runs once unsubscribe()
+    // has returned.
+    uint64_t subscribe(const std::string& channel, MessageCallback onMessage, StateCallback onState = nullptr);
+    void unsubscribe(uint64_t id);
 
     // JSON convenience methods
     bool setJson(const std::string& key, const nlohmann::json& value, int ttlSeconds = 0);
@@ -28,20 +95,81 @@ public:
     std::optional<nlohmann::json> getSession(const std::string& sessionId);
     bool destroySession(const std::string& sessionId);
 
-    // Cache invalidation patterns
-    bool invalidateByPrefix(const std::string& prefix);
+    // Cache invalidation. Both walk their keys with SCAN/SSCAN in batches
+    // and UNLINK each batch in the same round trip as the next scan, so
+    // Redis never blocks on a whole keyspace or group. They return the
+    // number of keys removed, or nullopt when Redis failed part way.
+    //
+    // invalidateByPrefix visits the whole keyspace; for groups that are
+    // dropped often, write with setTagged and drop with invalidateTag,
+    // which visits only the group. A tag's set lives as long as its
+    // longest-lived key; that uses EXPIRE NX/GT, so tags need Redis 7.
+    // setTagged is false unless the value and every tag were written.
+    std::optional<size_t> invalidateByPrefix(const std::string& prefix);
+    bool setTagged(const std::string& key, const std::string& value, int ttlSeconds,
+                   const std::vector<std::string>& tags);
+    std::optional<size_t> invalidateTag(const std::string& tag);
 
     // Health check
     bool ping();
 
 private:
-    redisContext* connect();
-    redisReply* execute(const std::string& cmd);
-    redisReply* execute(const std::vector<std::string>& args);
+    struct ReplyDeleter {
+        void operator()(redisReply* r) const { freeReplyObject(r); }
+    };
+    using Reply = std::unique_ptr<redisReply, ReplyDeleter>;
+    using Args = std::vector<std::string>;
+
+    struct ContextDeleter {
+        void operator()(redisContext* c) const { redisFree(c); }
+    };
+    using Context = std::unique_ptr<redisContext, ContextDeleter>;
+
+    // Owns the hiredis async contexts; defined in the .cpp
+    class AsyncLoop;
+
+    Context connect();
+    // One reply per command, in order; empty when no connection was
+    // available or the connection broke (it is then replaced). Only
+    // read-only batches are retried on another connection.
+    std::vector<Reply> pipeline(const std::vector<Args>& commands);
+    Reply execute(const Args& args);
+    // Scans with the command scan(cursor) builds, unlinking what it returns
+    std::optional<size_t> unlinkScanned(const std::function<Args(const std::string& cursor)>& scan);
+
+    // Blocking connection pool; acquire() returns null when the breaker is
+    // open or no connection frees up in time
+    Context acquire();
+    void release(Context conn, bool broken);
+    void reconnectLoop();
+    void publishLocked();
+
+    // Feed the breaker; log when it opens and closes
+    void onSuccess();
+    void onFailure();
 
     std::string host_;
     int port_;
     std::string password_;
-    redisContext* ctx_;
+    Options options_;
+    CircuitBreaker breaker_;
+
     std::mutex mtx_;
+    std::condition_variable available_;
+    std::condition_variable reconnect_;
+    std::deque<Context> idle_;
+    size_t open_ = 0;
+    size_t leased_ = 0;
+    bool stopping_ = false;
+    std::thread reconnector_;
+
+    Gauge& openGauge_;
+    Gauge& inUseGauge_;
+    Gauge& breakerGauge_;
+    Counter& failures_;
+    Counter& rejected_;
+    Counter& reconnects_;
+
+    // Last, so the loop stops before the members its callbacks use
+    std::unique_ptr<AsyncLoop> async_;
 };
@@ -0,0 +1,152 @@
+#include "SearchCache.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr const char* kGenerationKey = "search:generation";
+
+}
+
+SearchCache::SearchCache(std::shared_ptr<RedisClient> redis, Options options)
+    : redis_(std::move(redis)), options_(options),
+      local_(options.maxEntries, options.localTtl),
+      localHits_(MetricsRegistry::instance().counter(
+          "search_cache_local_hits_total", "Search results served from the in-process cache")),
+      redisHits_(MetricsRegistry::instance().counter(
+          "search_cache_redis_hits_total", "Search results served from Redis")),
+      misses_(MetricsRegistry::instance().counter(
+          "search_cache_misses_total", "Search lookups that reached the search backend")),
+      invalidations_(MetricsRegistry::instance().counter(
+          "search_cache_invalidations_total", "Index generation changes")),
+      hitRatio_(MetricsRegistry::instance().gauge(
+          "search_cache_hit_ratio", "Fraction of search lookups served from either cache tier")),
+      entries_(MetricsRegistry::instance().gauge(
+          "search_cache_entries", "Entries in the in-process search cache")),
+      generationGauge_(MetricsRegistry::instance().gauge(
+          "search_cache_generation", "Current search index generation")) {}
+
+std::string SearchCache::tierKey(const std::string& key, uint64_t generation) {
+    return "search:" + std::to_string(generation) + ":" + key;
+}
+
+void SearchCache::adopt(uint64_t generation, bool forwardOnly) {
+    std::scoped_lock lock(adoptMtx_);
+    uint64_t current = generation_.load();
+    if (current == generation || (forwardOnly && generation < current)) return;
+    generation_ = generation;
+    local_.clear();
+    invalidations_.inc();
+    generationGauge_.set(static_cast<double>(generation));
+    entries_.set(0);
+}
+
+SearchCache::~SearchCache() {
+    if (subscription_) redis_->unsubscribe(*subscription_);
+}
+
+void SearchCache::start() {
+    if (!redis_) return;
+    subscription_ = redis_->subscribe(options_.channel,
+                      [this](std::string_view message) { onBump(message); },
+                      [this](bool subscribed) { onSubscription(subscribed); });
+}
+
+void SearchCache::onSubscription(bool subscribed) {
+    subscribed_ = subscribed;
+    // Bumps made while unsubscribed were not announced to us
+    if (subscribed) resync();
+}
+
+void SearchCache::onBump(std::string_view message) {
+    uint64_t announced = 0;
+    try {
+        announced = std::stoull(std::string(message));
+    } catch (const std::exception&) {
+        return;
+    }
+    // Bumps from different instances can be announced out of order
+    adopt(announced, true);
+}
+
+void SearchCache::resync() {
+    lastSync_ = Clock::now().time_since_epoch().count();
+    redis_->getAsync(kGenerationKey, [this](std::optional<std::string> remote) {
+        if (!remote) return;
+        try {
+            adopt(std::stoull(*remote), false);
+        } catch (const std::exception&) {}
+    });
+}
+
+uint64_t SearchCache::generation() {
+    if (redis_ && !subscribed_.load()) {
+        int64_t now = Clock::now().time_since_epoch().count();
+        int64_t last = lastSync_.load();
+        auto interval = std::chrono::duration_cast<Clock::duration>(options_.generationSync).count();
+        // One caller per interval starts a refresh; everyone uses the local value
+        if (now - last >= interval && lastSync_.compare_exchange_strong(last, now)) resync();
+    }
+    return generation_.load();
+}
+
+void SearchCache::bumpGeneration() {
+    std::optional<long long> next;
+    if (redis_) next = redis_->incr(kGenerationKey);
+    if (next) {
+        // Another instance may have bumped past us already
+        adopt(static_cast<uint64_t>(*next), true);
+        redis_->commandAsync({"PUBLISH", options_.channel, std::to_string(*next)}, nullptr);
+    } else {
+        // Redis is unavailable: invalidate this instance only
+        adopt(generation_.load() + 1, true);
+    }
+}
+
+void SearchCache::recordLookup(bool hit) {
+    uint64_t lookups = ++lookups_;
+    uint64_t hits = hit ? ++hits_ : hits_.load();
+    hitRatio_.set(static_cast<double>(hits) / static_cast<double>(lookups));
+}
+
+SearchCache::Value SearchCache::getLocal(const std::string& key, uint64_t generation) {
+    auto hit = local_.get(tierKey(key, generation));
+    if (!hit) return nullptr;
+    localHits_.inc();
+    recordLookup(true);
+    return *hit;
+}
+
+SearchCache::Value SearchCache::getShared(const std::string& key, uint64_t generation) {
+    std::string k = tierKey(key, generation);
+    if (redis_) {
+        if (auto raw = redis_->get(k)) {
+            auto parsed = nlohmann::json::parse(*raw, nullptr, false);
+            if (!parsed.is_discarded()) {
+                auto value = std::make_shared<const nlohmann::json>(std::move(parsed));
+                if (generation == generation_.load()) {
+                    local_.put(k, value);
+                    entries_.set(static_cast<double>(local_.size()));
+                }
+                redisHits_.inc();
+                recordLookup(true);
+                return value;
+            }
+        }
+    }
+    misses_.inc();
+    recordLookup(false);
+    return nullptr;
+}
+
+void SearchCache::put(const std::string& key, uint64_t generation, nlohmann::json value) {
+    // Computed before a write landed; the next lookup recomputes it
+    if (generation != generation_.load()) return;
+
+    std::string k = tierKey(key, generation);
+    // Nothing waits for the shared copy
+    if (redis_) redis_->setAsync(k, value.dump(), options_.redisTtlSeconds);
+    local_.put(k, std::make_shared<const nlohmann::json>(std::move(value)));
+    entries_.set(static_cast<double>(local_.size()));
+}
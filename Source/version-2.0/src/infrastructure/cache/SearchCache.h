@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <nlohmann/json.hpp>
+#include "src/infrastructure/cache/RedisClient.h"
+#include "src/utils/LruCache.h"
+
+class Counter;
+class Gauge;
+
+// Two-tier cache for search results: an in-process LRU in front of Redis.
+// Keys carry the index generation, a counter shared through Redis and
+// bumped on every index write, so a write invalidates every cached result
+// at once on all instances. A bump is published on a channel, and each
+// instance keeps the generation in memory, so reading it costs no round
+// trip. While the subscription is down the value is re-read from Redis
+// in the background, at most once per generationSync.
+class SearchCache {
+public:
+    struct Options {
+        size_t maxEntries = 10000;
+        std::chrono::milliseconds localTtl{30000};
+        int redisTtlSeconds = 300;
+        std::chrono::milliseconds generationSync{1000};
+        std::string channel = "search:generation";
+    };
+
+    using Value = std::shared_ptr<const nlohmann::json>;
+
+    // redis may be null for a local-only cache
+    SearchCache(std::shared_ptr<RedisClient> redis, Options options);
+    ~SearchCache();
+
+    // Subscribes to generation bumps from other instances
+    void start();
+    // True while bumps from other instances arrive
+    bool subscribed() const { return subscribed_.load(); }
+
+    // Current generation; pass it back to the lookups and put so a result
+    // computed before a write is never stored under the newer generation.
+    // Never waits on Redis.
+    uint64_t generation();
+    // Call once the write is visible to searches, or a search running in
+    // between caches the old result under the new generation. A write that
+    // is not visible yet bumps again once it is.
+    void bumpGeneration();
+
+    Value getLocal(const std::string& key, uint64_t generation);
+    // Redis tier; a hit is copied into the local tier. Counts the miss
+    // when neither tier has the key.
+    Value getShared(const std::string& key, uint64_t generation);
+    void put(const std::string& key, uint64_t generation, nlohmann::json value);
+
+private:
+    static std::string tierKey(const std::string& key, uint64_t generation);
+    // Clears the local tier on a change. Redis's stored value is taken as
+    // is; bumps only move the generation forward.
+    void adopt(uint64_t generation, bool forwardOnly);
+    void onBump(std::string_view message);
+    void onSubscription(bool subscribed);
+    // Reads the generation from Redis without blocking the caller
+    void resync();
+    void recordLookup(bool hit);
+
+    std::shared_ptr<RedisClient> redis_;
+    Options options_;
+    LruCache<Value> local_;
+    std::atomic<uint64_t> generation_{0};
+    std::atomic<int64_t> lastSync_{0};
+    std::mutex adoptMtx_;
+    std::atomic<bool> subscribed_{false};
+    std::optional<uint64_t> subscription_;
+    std::atomic<uint64_t> lookups_{0};
+    std::atomic<uint64_t> hits_{0};
+
+    Counter& localHits_;
+    Counter& redisHits_;
+    Counter& misses_;
+    Counter& invalidations_;
+    Gauge& hitRatio_;
+    Gauge& entries_;
+    Gauge& generationGauge_;
+};
@@ -3,6 +3,8 @@
 
 struct Config {
     std::string postgresUri;
+    int postgresPoolSize;
+    int postgresPoolTimeoutMs;
     std::string mongoUri;
     std::string mongoDb;
     std::string mongoCollection;
@@ -10,18 +12,36 @@ struct Config {
 
     std::string restHost;
     int restPort;
+    int restThreads;
+    int importWorkers;
     std::string grpcHost;
     int grpcPort;
 
     std::string jwtSecret;
     int jwtExpirationMinutes;
 
+    // Outbound HTTP (OpenSearch, S3)
+    int httpMaxPerHost;
+
     std::string opensearchUrl;
+    int opensearchBulkConcurrency;
+    int opensearchBulkMaxBytes;
+    int searchWorkers;
+    int searchMaxQueued;
+    int searchCacheEntries;      // 0 disables the search result cache
+    int searchCacheTtlSeconds;
+    int catalogIndexRefreshSeconds;
+    std::string searchBackend;   // "opensearch" or "postgres"
+    bool searchTrigram;
 
     // Redis
     std::string redisHost;
     int redisPort;
     std::string redisPassword;
+    int redisPoolSize;
+    int redisTimeoutMs;          // connect and command timeout
+    int nearCacheEntries;
+    int nearCacheTtlSeconds;
 
     // S3 / MinIO
     std::string s3Endpoint;
@@ -29,6 +49,16 @@ struct Config {
     std::string s3SecretKey;
     std::string s3Bucket;
     std::string s3Region;
+    int s3UrlCacheSeconds;       // 0 signs every presigned URL on request
+    int s3PartSizeMb;
+    int s3UploadParallelism;     // parts in flight per upload
+    int downloadMaxChunkMb;      // largest body /content sends in one response
+    std::string diskCacheDir;    // empty disables the disk cache
+    int diskCacheMaxMb;
+    std::string diskCacheAdmission;  // "tinylfu" or "always"
+    bool contentDedup;           // store versions by content hash; needs migration 004
+    int blobGcGraceSeconds;      // how long an unreferenced blob is kept
+    int blobGcIntervalSeconds;
 
     // Kafka
     std::string kafkaBrokers;
@@ -1,48 +1,231 @@
 #include "src/infrastructure/db/PostgresPool.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
+#include "src/utils/Exceptions.h"
 #include <iostream>
 #include <stdexcept>
 
-std::queue<std::shared_ptr<pqxx::connection>> PostgresPool::pool_;
-std::mutex PostgresPool::mtx_;
-std::string PostgresPool::uri_;
-int PostgresPool::maxConnections_ = 5;
-bool PostgresPool::initialized_ = false;
+namespace {
+// Connections idle for longer than this are pinged before being handed out
+constexpr auto kValidateAfterIdle = std::chrono::seconds(30);
+}
 
-void PostgresPool::initialize(const std::string& uri, int maxConnections) {
-    std::scoped_lock lock(mtx_);
+// --- Lease ---
+
+PostgresPool::Lease::Lease(PostgresPool* pool, std::unique_ptr<pqxx::connection> conn,
+                           size_t initializersRun)
+    : pool_(pool), conn_(std::move(conn)), initializersRun_(initializersRun) {}
+
+PostgresPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), conn_(std::move(other.conn_)),
+      initializersRun_(other.initializersRun_), broken_(other.broken_) {
+    other.pool_ = nullptr;
+}
+
+PostgresPool::Lease& PostgresPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        reset();
+        pool_ = other.pool_;
+        conn_ = std::move(other.conn_);
+        initializersRun_ = other.initializersRun_;
+        broken_ = other.broken_;
+        other.pool_ = nullptr;
+    }
+    return *this;
+}
+
+PostgresPool::Lease::~Lease() {
+    reset();
+}
+
+void PostgresPool::Lease::reset() {
+    if (pool_ && conn_) pool_->release(std::move(conn_), initializersRun_, broken_);
+    pool_ = nullptr;
+}
+
+// --- Pool ---
+
+PostgresPool::PostgresPool()
+    : waitSeconds_(MetricsRegistry::instance().histogram(
+          "pg_pool_wait_seconds", "Time spent waiting for a pooled PostgreSQL connection",
+          {0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 5.0})),
+      inUseGauge_(MetricsRegistry::instance().gauge(
+          "pg_pool_connections_in_use", "PostgreSQL connections currently leased")),
+      openGauge_(MetricsRegistry::instance().gauge(
+          "pg_pool_connections_open", "PostgreSQL connections currently open")),
+      utilizationGauge_(MetricsRegistry::instance().gauge(
+          "pg_pool_utilization", "Leased connections as a fraction of the pool size")),
+      timeouts_(MetricsRegistry::instance().counter(
+          "pg_pool_acquire_timeouts_total", "Pool checkouts that timed out")),
+      reconnects_(MetricsRegistry::instance().counter(
+          "pg_pool_reconnects_total", "Broken PostgreSQL connections replaced by the pool")) {}
+
+PostgresPool::~PostgresPool() = default;
+
+void PostgresPool::initialize(const std::string& uri, int maxConnections,
+                              std::chrono::milliseconds acquireTimeout) {
+    std::unique_lock<std::mutex> lock(mtx_);
     if (initialized_) return;
+    if (maxConnections <= 0)
+        throw std::invalid_argument("PostgresPool size must be positive");
+
     uri_ = uri;
     maxConnections_ = maxConnections;
+    acquireTimeout_ = acquireTimeout;
 
     try {
         for (int i = 0; i < maxConnections_; ++i) {
-            auto conn = std::make_shared<pqxx::connection>(uri_);
-            if (!conn->is_open())
-                throw std::runtime_error("Failed to open PostgreSQL connection");
-            pool_.push(conn);
+            idle_.push_back({open(), 0, Clock::now()});
+            ++open_;
         }
         initialized_ = true;
+        publishMetricsLocked();
         std::cout << "[PostgresPool] Initialized with " << maxConnections_ << " connections.\n";
     } catch (const std::exception& e) {
+        idle_.clear();
+        open_ = 0;
         std::cerr << "[PostgresPool] Initialization failed: " << e.what() << std::endl;
         throw;
     }
 }
 
-std::shared_ptr<pqxx::connection> PostgresPool::acquire() {
+void PostgresPool::addConnectionInitializer(const std::string& name,
+                                            ConnectionInitializer initializer) {
+    std::scoped_lock lock(mtx_);
+    if (!initializerNames_.insert(name).second) return;
+    initializers_.push_back(std::move(initializer));
+}
+
+std::unique_ptr<pqxx::connection> PostgresPool::open() {
+    auto conn = std::make_unique<pqxx::connection>(uri_);
+    if (!conn->is_open())
+        throw std::runtime_error("Failed to open PostgreSQL connection");
+    return conn;
+}
+
+// Called without the lock held. Brings a connection up to date with the
+// initializers registered since it was last checked out.
+bool PostgresPool::runInitializers(pqxx::connection& conn, size_t& initializersRun) {
+    std::vector<ConnectionInitializer> pending;
+    {
+        std::scoped_lock lock(mtx_);
+        if (initializersRun >= initializers_.size()) return true;
+        pending.assign(initializers_.begin() + static_cast<std::ptrdiff_t>(initializersRun),
+                       initializers_.end());
+    }
+    try {
+        for (auto& init : pending) {
+            init(conn);
+            ++initializersRun;
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "[PostgresPool] Connection initializer failed: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool PostgresPool::isHealthy(pqxx::connection& conn, Clock::time_point idleSince) {
+    if (!conn.is_open()) return false;
+    if (Clock::now() - idleSince < kValidateAfterIdle) return true;
+    try {
+        pqxx::nontransaction txn(conn);
+        txn.exec("SELECT 1;");
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+PostgresPool::Lease PostgresPool::acquire() {
+    auto start = Clock::now();
     std::unique_lock<std::mutex> lock(mtx_);
-    if (pool_.empty()) {
-        // Fallback: create new connection temporarily
-        std::cerr << "[PostgresPool] Pool exhausted, creating temporary connection.\n";
-        return std::make_shared<pqxx::connection>(uri_);
+    if (!initialized_)
+        throw DatabaseException("PostgresPool used before initialize()");
+
+    while (true) {
+        bool ready = available_.wait_until(lock, start + acquireTimeout_, [this] {
+            return !idle_.empty() || open_ < maxConnections_;
+        });
+        if (!ready) {
+            timeouts_.inc();
+            throw DatabaseException("Timed out waiting for a PostgreSQL connection ("
+                                    + std::to_string(maxConnections_) + " in use)");
+        }
+
+        if (!idle_.empty()) {
+            auto idle = std::move(idle_.front());
+            idle_.pop_front();
+            ++leased_;
+            publishMetricsLocked();
+
+            // Ping outside the lock; a dead connection frees its slot for a reconnect
+            lock.unlock();
+            bool healthy = isHealthy(*idle.conn, idle.idleSince)
+                           && runInitializers(*idle.conn, idle.initializersRun);
+            lock.lock();
+            if (!healthy) {
+                --leased_;
+                --open_;
+                publishMetricsLocked();
+                continue;
+            }
+
+            waitSeconds_.observe(std::chrono::duration<double>(Clock::now() - start).count());
+            return Lease(this, std::move(idle.conn), idle.initializersRun);
+        }
+
+        // A slot is free because an earlier connection was dropped: reconnect
+        ++open_;
+        ++leased_;
+        publishMetricsLocked();
+        lock.unlock();
+        try {
+            auto conn = open();
+            size_t initializersRun = 0;
+            if (!runInitializers(*conn, initializersRun))
+                throw std::runtime_error("connection initializer failed");
+            reconnects_.inc();
+            waitSeconds_.observe(std::chrono::duration<double>(Clock::now() - start).count());
+            return Lease(this, std::move(conn), initializersRun);
+        } catch (const std::exception& e) {
+            lock.lock();
+            --open_;
+            --leased_;
+            publishMetricsLocked();
+            available_.notify_one();
+            throw DatabaseException(std::string("Failed to reconnect to PostgreSQL: ") + e.what());
+        }
     }
-    auto conn = pool_.front();
-    pool_.pop();
-    return conn;
 }
 
-void PostgresPool::release(std::shared_ptr<pqxx::connection> conn) {
+void PostgresPool::release(std::unique_ptr<pqxx::connection> conn, size_t initializersRun,
+                           bool broken) {
+    {
+        std::scoped_lock lock(mtx_);
+        --leased_;
+        if (broken || !conn || !conn->is_open()) {
+            std::cerr << "[PostgresPool] Dropping broken connection.\n";
+            --open_;
+        } else {
+            idle_.push_back({std::move(conn), initializersRun, Clock::now()});
+        }
+        publishMetricsLocked();
+    }
+    available_.notify_one();
+}
+
+int PostgresPool::size() const {
+    std::scoped_lock lock(mtx_);
+    return maxConnections_;
+}
+
+int PostgresPool::inUse() const {
     std::scoped_lock lock(mtx_);
-    if (!conn || !conn->is_open()) return;
-    pool_.push(std::move(conn));
+    return leased_;
+}
+
+void PostgresPool::publishMetricsLocked() {
+    inUseGauge_.set(leased_);
+    openGauge_.set(open_);
+    utilizationGauge_.set(maxConnections_ > 0 ? static_cast<double>(leased_) / maxConnections_ : 0.0);
 }
@@ -1,23 +1,102 @@
 #pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
+#include <unordered_set>
+#include <vector>
 #include <pqxx/pqxx>
 
+class Histogram;
+class Gauge;
+class Counter;
+
+// Bounded pool of PostgreSQL connections.
+// acquire() hands out a Lease that returns the connection when it goes out of scope.
+// When every connection is leased, callers wait up to the acquire timeout and then
+// get a DatabaseException instead of an unbounded number of extra connections.
 class PostgresPool {
 public:
+    using Clock = std::chrono::steady_clock;
+    using ConnectionInitializer = std::function<void(pqxx::connection&)>;
+
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        pqxx::connection& operator*() const { return *conn_; }
+        pqxx::connection* operator->() const { return conn_.get(); }
+
+        // Close the connection on release instead of returning it to the pool
+        void invalidate() { broken_ = true; }
+
+    private:
+        friend class PostgresPool;
+        Lease(PostgresPool* pool, std::unique_ptr<pqxx::connection> conn, size_t initializersRun);
+        void reset();
+
+        PostgresPool* pool_;
+        std::unique_ptr<pqxx::connection> conn_;
+        size_t initializersRun_ = 0;
+        bool broken_ = false;
+    };
 
-    static void initialize(const std::string& uri, int maxConnections = 5);
+    PostgresPool();
+    ~PostgresPool();
 
-    static std::shared_ptr<pqxx::connection> acquire();
+    PostgresPool(const PostgresPool&) = delete;
+    PostgresPool& operator=(const PostgresPool&) = delete;
 
-    static void release(std::shared_ptr<pqxx::connection> conn);
+    void initialize(const std::string& uri, int maxConnections = 5,
+                    std::chrono::milliseconds acquireTimeout = std::chrono::milliseconds(5000));
+
+    // Runs once on every pooled connection, including connections opened
+    // after a reconnect. Connections that are already open pick it up at
+    // their next checkout. Registering a name a second time is a no-op, so
+    // every component sharing the pool can register what it needs.
+    void addConnectionInitializer(const std::string& name, ConnectionInitializer initializer);
+
+    Lease acquire();
+
+    int size() const;
+    int inUse() const;
 
 private:
-    static std::queue<std::shared_ptr<pqxx::connection>> pool_;
-    static std::mutex mtx_;
-    static std::string uri_;
-    static int maxConnections_;
-    static bool initialized_;
+    struct IdleConnection {
+        std::unique_ptr<pqxx::connection> conn;
+        size_t initializersRun;
+        Clock::time_point idleSince;
+    };
+
+    std::unique_ptr<pqxx::connection> open();
+    bool isHealthy(pqxx::connection& conn, Clock::time_point idleSince);
+    bool runInitializers(pqxx::connection& conn, size_t& initializersRun);
+    void release(std::unique_ptr<pqxx::connection> conn, size_t initializersRun, bool broken);
+    void publishMetricsLocked();
+
+    mutable std::mutex mtx_;
+    std::condition_variable available_;
+    std::deque<IdleConnection> idle_;
+    std::string uri_;
+    int maxConnections_ = 5;
+    int open_ = 0;
+    int leased_ = 0;
+    std::chrono::milliseconds acquireTimeout_{5000};
+    std::vector<ConnectionInitializer> initializers_;
+    std::unordered_set<std::string> initializerNames_;
+    bool initialized_ = false;
+
+    Histogram& waitSeconds_;
+    Gauge& inUseGauge_;
+    Gauge& openGauge_;
+    Gauge& utilizationGauge_;
+    Counter& timeouts_;
+    Counter& reconnects_;
 };
@@ -0,0 +1,216 @@
+#include "HttpTransport.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void initCurlOnce() {
+    static std::once_flag once;
+    std::call_once(once, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+    return s;
+}
+
+}
+
+std::optional<std::string> HttpResponse::header(std::string_view name) const {
+    for (const auto& [key, value] : headers) {
+        if (key.size() == name.size() &&
+            std::equal(key.begin(), key.end(), name.begin(), [](char a, char b) {
+                return a == std::tolower(static_cast<unsigned char>(b));
+            }))
+            return value;
+    }
+    return std::nullopt;
+}
+
+HttpTransport::HttpTransport() : HttpTransport(Options{}) {}
+
+HttpTransport::HttpTransport(Options options)
+    : options_(options),
+      requests_(MetricsRegistry::instance().counter(
+          "http_client_requests_total", "Outbound HTTP requests")),
+      errors_(MetricsRegistry::instance().counter(
+          "http_client_errors_total", "Outbound HTTP requests that failed below HTTP")),
+      inFlight_(MetricsRegistry::instance().gauge(
+          "http_client_requests_in_flight", "Outbound HTTP requests in flight")),
+      latency_(MetricsRegistry::instance().histogram(
+          "http_client_request_seconds", "Outbound HTTP request latency")),
+      slotWait_(MetricsRegistry::instance().histogram(
+          "http_client_host_wait_seconds", "Time spent waiting for a per-host request slot",
+          {0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 5.0})) {
+    initCurlOnce();
+    options_.maxPerHost = std::max<size_t>(1, options_.maxPerHost);
+
+    share_ = curl_share_init();
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, lockShare);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, unlockShare);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    // Connections are not shared: a shared connection cache is not safe
+    // across threads. Each pooled handle keeps its own live connections.
+}
+
+HttpTransport::~HttpTransport() {
+    for (CURL* easy : idleHandles_) curl_easy_cleanup(easy);
+    if (share_) curl_share_cleanup(share_);
+}
+
+void HttpTransport::lockShare(CURL*, curl_lock_data data, curl_lock_access, void* userp) {
+    static_cast<HttpTransport*>(userp)->shareLocks_[data].lock();
+}
+
+void HttpTransport::unlockShare(CURL*, curl_lock_data data, void* userp) {
+    static_cast<HttpTransport*>(userp)->shareLocks_[data].unlock();
+}
+
+size_t HttpTransport::writeCallback(char* data, size_t size, size_t nmemb, void* userp) {
+    size_t realSize = size * nmemb;
+    auto* target = static_cast<BodyTarget*>(userp);
+    if (*target->sink) {
+        long status = 0;
+        curl_easy_getinfo(target->easy, CURLINFO_RESPONSE_CODE, &status);
+        // Error bodies are small; keep them for the caller to read
+        if (status >= 200 && status < 300)
+            return (*target->sink)(std::string_view(data, realSize)) ? realSize : 0;
+    }
+    target->response->body.append(data, realSize);
+    return realSize;
+}
+
+size_t HttpTransport::headerCallback(char* data, size_t size, size_t nmemb, void* userp) {
+    size_t realSize = size * nmemb;
+    std::string_view line(data, realSize);
+    auto colon = line.find(':');
+    if (colon != std::string_view::npos) {
+        std::string name(trim(line.substr(0, colon)));
+        std::transform(name.begin(), name.end(), name.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        static_cast<HttpResponse*>(userp)->headers.emplace_back(
+            std::move(name), std::string(trim(line.substr(colon + 1))));
+    }
+    return realSize;
+}
+
+std::string HttpTransport::hostKey(const std::string& url) {
+    size_t start = url.find("://");
+    start = start == std::string::npos ? 0 : start + 3;
+    size_t end = url.find_first_of("/?#", start);
+    return url.substr(0, end);
+}
+
+CURL* HttpTransport::acquireHandle() {
+    {
+        std::scoped_lock lock(handlesMtx_);
+        if (!idleHandles_.empty()) {
+            CURL* easy = idleHandles_.back();
+            idleHandles_.pop_back();
+            return easy;
+        }
+    }
+    return curl_easy_init();
+}
+
+void HttpTransport::releaseHandle(CURL* easy) {
+    // Options are cleared; the handle keeps its open connections, so the
+    // next request taking it reuses them
+    curl_easy_reset(easy);
+    std::scoped_lock lock(handlesMtx_);
+    idleHandles_.push_back(easy);
+}
+
+bool HttpTransport::acquireSlot(const std::string& host) {
+    auto start = Clock::now();
+    std::unique_lock lock(hostsMtx_);
+    auto& slots = hosts_[host];
+    if (!slots) slots = std::make_unique<HostSlots>();
+    bool acquired = slots->cv.wait_for(lock, options_.acquireTimeout,
+                                       [&] { return slots->active < options_.maxPerHost; });
+    if (acquired) slots->active++;
+    slotWait_.observe(std::chrono::duration<double>(Clock::now() - start).count());
+    return acquired;
+}
+
+void HttpTransport::releaseSlot(const std::string& host) {
+    std::scoped_lock lock(hostsMtx_);
+    auto& slots = hosts_[host];
+    slots->active--;
+    slots->cv.notify_one();
+}
+
+HttpResponse HttpTransport::perform(const HttpRequest& request) {
+    HttpResponse response;
+    requests_.inc();
+
+    std::string host = hostKey(request.url);
+    if (!acquireSlot(host)) {
+        errors_.inc();
+        response.curlCode = CURLE_OPERATION_TIMEDOUT;
+        response.error = "Timed out waiting for a connection slot to " + host;
+        return response;
+    }
+
+    CURL* easy = acquireHandle();
+    if (!easy) {
+        releaseSlot(host);
+        errors_.inc();
+        response.curlCode = CURLE_FAILED_INIT;
+        response.error = "curl_easy_init failed";
+        return response;
+    }
+
+    curl_easy_setopt(easy, CURLOPT_SHARE, share_);
+    curl_easy_setopt(easy, CURLOPT_URL, request.url.c_str());
+    curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, request.connectTimeoutMs);
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, request.timeoutMs);
+
+    if (request.headOnly) {
+        curl_easy_setopt(easy, CURLOPT_NOBODY, 1L);
+    } else if (request.method != "GET") {
+        curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+    }
+    if (!request.body.empty() || request.method == "POST" || request.method == "PUT") {
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDS, request.body.data());
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE,
+                         static_cast<curl_off_t>(request.body.size()));
+    }
+
+    curl_slist* headers = nullptr;
+    for (const auto& h : request.headers) headers = curl_slist_append(headers, h.c_str());
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers);
+
+    BodyTarget target{easy, &response, &request.onBody};
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &target);
+    curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, headerCallback);
+    curl_easy_setopt(easy, CURLOPT_HEADERDATA, &response);
+
+    inFlight_.inc();
+    auto start = Clock::now();
+    response.curlCode = curl_easy_perform(easy);
+    latency_.observe(std::chrono::duration<double>(Clock::now() - start).count());
+    inFlight_.dec();
+
+    if (response.curlCode == CURLE_OK) {
+        curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response.status);
+    } else {
+        errors_.inc();
+        response.error = curl_easy_strerror(response.curlCode);
+    }
+
+    curl_slist_free_all(headers);
+    releaseHandle(easy);
+    releaseSlot(host);
+    return response;
+}
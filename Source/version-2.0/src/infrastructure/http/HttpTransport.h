@@ -0,0 +1,108 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <curl/curl.h>
+
+class Counter;
+class Gauge;
+class Histogram;
+
+// Receives a response body as it arrives; returning false aborts the transfer
+using HttpBodySink = std::function<bool(std::string_view chunk)>;
+
+struct HttpRequest {
+    std::string method = "GET";
+    std::string url;
+    std::vector<std::string> headers;   // "Name: value"
+    std::string_view body;              // must outlive perform()
+    bool headOnly = false;
+    long connectTimeoutMs = 3000;
+    long timeoutMs = 5000;
+    // When set, a 2xx body goes here instead of into HttpResponse::body
+    HttpBodySink onBody;
+};
+
+struct HttpResponse {
+    CURLcode curlCode = CURLE_OK;
+    long status = 0;
+    std::string body;
+    // Header names are lower-cased
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string error;
+
+    bool ok() const { return curlCode == CURLE_OK && status >= 200 && status < 300; }
+    std::optional<std::string> header(std::string_view name) const;
+};
+
+// Thread-safe HTTP client shared by the outbound service clients. Requests
+// run concurrently on pooled easy handles. Each handle keeps its own
+// keep-alive connections and the most recently released one is reused
+// first; DNS results and TLS sessions live in one curl share, so a new
+// connection skips both lookups. HTTP/2 is negotiated over TLS where the server
+// offers it. Each host has a cap on requests in flight; callers over the
+// cap wait up to acquireTimeout.
+class HttpTransport {
+public:
+    struct Options {
+        size_t maxPerHost = 32;
+        std::chrono::milliseconds acquireTimeout{5000};
+    };
+
+    HttpTransport();
+    explicit HttpTransport(Options options);
+    ~HttpTransport();
+
+    HttpTransport(const HttpTransport&) = delete;
+    HttpTransport& operator=(const HttpTransport&) = delete;
+
+    HttpResponse perform(const HttpRequest& request);
+
+private:
+    struct HostSlots {
+        size_t active = 0;
+        std::condition_variable cv;
+    };
+
+    CURL* acquireHandle();
+    void releaseHandle(CURL* easy);
+    bool acquireSlot(const std::string& host);
+    void releaseSlot(const std::string& host);
+
+    static std::string hostKey(const std::string& url);
+    struct BodyTarget {
+        CURL* easy;
+        HttpResponse* response;
+        const HttpBodySink* sink;
+    };
+
+    static size_t writeCallback(char* data, size_t size, size_t nmemb, void* userp);
+    static size_t headerCallback(char* data, size_t size, size_t nmemb, void* userp);
+    static void lockShare(CURL*, curl_lock_data data, curl_lock_access, void* userp);
+    static void unlockShare(CURL*, curl_lock_data data, void* userp);
+
+    Options options_;
+    CURLSH* share_ = nullptr;
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> shareLocks_;
+
+    std::mutex handlesMtx_;
+    std::vector<CURL*> idleHandles_;
+
+    std::mutex hostsMtx_;
+    std::unordered_map<std::string, std::unique_ptr<HostSlots>> hosts_;
+
+    Counter& requests_;
+    Counter& errors_;
+    Gauge& inFlight_;
+    Histogram& latency_;
+    Histogram& slotWait_;
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <memory>
 #include <unordered_map>
 #include <mutex>
 #include <atomic>
@@ -51,12 +52,9 @@ public:
         std::lock_guard<std::mutex> lock(mtx_);
         sum_ += value;
         count_++;
-        for (size_t i = 0; i < buckets_.size(); ++i) {
-            if (value <= buckets_[i]) {
-                bucketCounts_[i]++;
-            }
-        }
-        bucketCounts_[buckets_.size()]++; // +Inf bucket
+        size_t i = 0;
+        while (i < buckets_.size() && value > buckets_[i]) ++i;
+        bucketCounts_[i]++; // serialize() accumulates, so count each value once
     }
 
     std::string serialize() const {
@@ -128,11 +126,13 @@ public:
         return ref;
     }
 
-    Histogram& histogram(const std::string& name, const std::string& help = "") {
+    Histogram& histogram(const std::string& name, const std::string& help = "",
+                         std::vector<double> buckets = {}) {
         std::lock_guard<std::mutex> lock(mtx_);
         auto it = histograms_.find(name);
         if (it != histograms_.end()) return *it->second;
-        auto h = std::make_unique<Histogram>(name, help);
+        auto h = buckets.empty() ? std::make_unique<Histogram>(name, help)
+                                 : std::make_unique<Histogram>(name, help, std::move(buckets));
         auto& ref = *h;
         histograms_[name] = std::move(h);
         return ref;
@@ -1,13 +1,13 @@
 #include "src/infrastructure/queue/PersistentQueue.h"
 #include <iostream>
 
-PersistentQueue::PersistentQueue(std::shared_ptr<pqxx::connection> conn)
-    : conn_(std::move(conn)) {}
+PersistentQueue::PersistentQueue(std::shared_ptr<PostgresPool> pool)
+    : pool_(std::move(pool)) {}
 
 void PersistentQueue::enqueue(const std::string& type, const nlohmann::json& payload) {
-    std::scoped_lock lock(mtx_);
     try {
-        pqxx::work txn(*conn_);
+        auto conn = pool_->acquire();
+        pqxx::work txn(*conn);
         txn.exec(
             "INSERT INTO task_queue (task_type, payload, status) VALUES ($1, $2, 'PENDING');",
             pqxx::params{type, payload.dump()}
@@ -19,8 +19,8 @@ void PersistentQueue::enqueue(const std::string& type, const nlohmann::json& pay
 }
 
 std::optional<Task> PersistentQueue::dequeueOne() {
-    std::scoped_lock lock(mtx_);
-    pqxx::work txn(*conn_);
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
     auto r = txn.exec(
         "UPDATE task_queue "
         "SET status = 'PROCESSING' "
@@ -39,8 +39,8 @@ std::optional<Task> PersistentQueue::dequeueOne() {
 }
 
 std::vector<Task> PersistentQueue::dequeueBatch(int limit) {
-    std::scoped_lock lock(mtx_);
-    pqxx::work txn(*conn_);
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
     auto r = txn.exec(
         "UPDATE task_queue "
         "SET status = 'PROCESSING' "
@@ -63,7 +63,8 @@ std::vector<Task> PersistentQueue::dequeueBatch(int limit) {
 }
 
 void PersistentQueue::markProcessed(long taskId) {
-    pqxx::work txn(*conn_);
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
     txn.exec("UPDATE task_queue SET status = 'DONE' WHERE id = $1;", pqxx::params{taskId});
     txn.commit();
 }
@@ -2,10 +2,10 @@
 #include <memory>
 #include <string>
 #include <vector>
-#include <mutex>
 #include <optional>
 #include <nlohmann/json.hpp>
 #include "pqxx/pqxx"
+#include "src/infrastructure/db/PostgresPool.h"
 
 struct Task {
     long id;
@@ -16,7 +16,7 @@ struct Task {
 
 class PersistentQueue {
 public:
-    explicit PersistentQueue(std::shared_ptr<pqxx::connection> conn);
+    explicit PersistentQueue(std::shared_ptr<PostgresPool> pool);
 
     void enqueue(const std::string& type, const nlohmann::json& payload);
     std::optional<Task> dequeueOne();
@@ -24,6 +24,5 @@ public:
     void markProcessed(long taskId);
 
 private:
-    std::shared_ptr<pqxx::connection> conn_;
-    std::mutex mtx_;
+    std::shared_ptr<PostgresPool> pool_;
 };
@@ -0,0 +1,287 @@
+#include "AutocompleteIndex.h"
+#include "src/utils/StringUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <unordered_set>
+
+namespace {
+
+// Prefixes matching more entries than this have their answer cached
+constexpr size_t kCacheThreshold = 1024;
+// Delta size, or stale entries in the main array, that triggers a merge
+constexpr size_t kCompactThreshold = 4096;
+// Entries looked at per fuzzy variant
+constexpr size_t kFuzzyScanLimit = 64;
+// Like OpenSearch's AUTO fuzziness, short prefixes are matched exactly
+constexpr size_t kFuzzyMinLength = 3;
+constexpr std::string_view kAlphabet = "abcdefghijklmnopqrstuvwxyz0123456789";
+
+std::vector<std::string> fuzzyVariants(const std::string& p) {
+    std::vector<std::string> out;
+    size_t m = p.size();
+    out.reserve(m * (2 * kAlphabet.size() + 2));
+    // A change at the very end only widens or narrows the exact range
+    for (size_t i = 0; i + 1 < m; ++i) {
+        out.push_back(p.substr(0, i) + p.substr(i + 1));
+        std::string t = p;
+        std::swap(t[i], t[i + 1]);
+        if (t != p) out.push_back(std::move(t));
+    }
+    for (size_t i = 0; i < m; ++i) {
+        for (char c : kAlphabet) {
+            if (c != p[i]) {
+                std::string s = p;
+                s[i] = c;
+                out.push_back(std::move(s));
+            }
+            out.push_back(p.substr(0, i) + c + p.substr(i));
+        }
+    }
+    return out;
+}
+
+}
+
+AutocompleteIndex::AutocompleteIndex()
+    : topCache_(4096, std::chrono::hours(1)) {}
+
+AutocompleteIndex::Doc AutocompleteIndex::makeDoc(Document doc, uint32_t version) {
+    auto titleKey = std::make_unique<const std::string>(normalizeSearchText(doc.title));
+    auto authorKey = std::make_unique<const std::string>(normalizeSearchText(doc.author));
+    return Doc{std::move(doc.title), std::move(doc.author), std::move(titleKey), std::move(authorKey),
+               doc.popularity, version};
+}
+
+void AutocompleteIndex::appendEntries(long id, const Doc& doc, std::vector<Entry>& out) {
+    auto add = [&](const std::string& key, Field field) {
+        // The full text and every later word start, so "potter" finds "Harry Potter"
+        for (size_t i = 0; i < key.size(); ++i) {
+            if (i == 0 || key[i - 1] == ' ')
+                out.push_back(Entry{&key, static_cast<uint32_t>(i), doc.version, id,
+                                    static_cast<float>(doc.popularity), field});
+        }
+    };
+    add(*doc.titleKey, Field::Title);
+    add(*doc.authorKey, Field::Author);
+}
+
+size_t AutocompleteIndex::entryCount(const Doc& doc) {
+    auto count = [](const std::string& key) {
+        size_t n = 0;
+        for (size_t i = 0; i < key.size(); ++i)
+            if (i == 0 || key[i - 1] == ' ') ++n;
+        return n;
+    };
+    return count(*doc.titleKey) + count(*doc.authorKey);
+}
+
+bool AutocompleteIndex::entryLess(const Entry& a, const Entry& b) {
+    if (int c = a.key().compare(b.key()); c != 0) return c < 0;
+    return a.id < b.id;
+}
+
+void AutocompleteIndex::sortEntries(std::vector<Entry>& entries) {
+    std::sort(entries.begin(), entries.end(), entryLess);
+}
+
+void AutocompleteIndex::retireLocked(Doc& doc) {
+    retiredKeys_.push_back(std::move(doc.titleKey));
+    retiredKeys_.push_back(std::move(doc.authorKey));
+}
+
+void AutocompleteIndex::beginRebuild() {
+    std::unique_lock lock(mtx_);
+    rebuilding_ = true;
+    journal_.clear();
+}
+
+void AutocompleteIndex::rebuild(std::vector<Document> docs) {
+    // Built outside the lock; readers keep using the old contents meanwhile
+    std::vector<Entry> entries;
+    std::unordered_map<long, Doc> byId;
+    entries.reserve(docs.size() * 4);
+    byId.reserve(docs.size());
+    for (auto& d : docs) {
+        long id = d.id;
+        Doc doc = makeDoc(std::move(d), 0);
+        appendEntries(id, doc, entries);
+        byId[id] = std::move(doc);
+    }
+    sortEntries(entries);
+
+    std::unique_lock lock(mtx_);
+    entries_ = std::move(entries);
+    delta_.clear();
+    staleEntries_ = 0;
+    nextVersion_ = 0;
+    docs_ = std::move(byId);
+    retiredKeys_.clear();
+    rebuilding_ = false;
+    for (auto& change : journal_) {
+        if (change.removed) removeLocked(change.doc.id);
+        else upsertLocked({std::move(change.doc)});
+    }
+    journal_.clear();
+    topCache_.clear();
+}
+
+void AutocompleteIndex::abortRebuild() {
+    std::unique_lock lock(mtx_);
+    rebuilding_ = false;
+    journal_.clear();
+}
+
+void AutocompleteIndex::upsert(std::vector<Document> docs) {
+    if (docs.empty()) return;
+    std::unique_lock lock(mtx_);
+    upsertLocked(std::move(docs));
+    topCache_.clear();
+}
+
+void AutocompleteIndex::remove(long id) {
+    std::unique_lock lock(mtx_);
+    removeLocked(id);
+    topCache_.clear();
+}
+
+void AutocompleteIndex::upsertLocked(std::vector<Document> docs) {
+    if (rebuilding_)
+        for (const auto& d : docs) journal_.push_back(Change{false, d});
+
+    std::vector<Entry> added;
+    for (auto& d : docs) {
+        auto it = docs_.find(d.id);
+        if (it != docs_.end()) {
+            // Index events carry no popularity; keep what the last load found
+            if (d.popularity == 0) d.popularity = it->second.popularity;
+            staleEntries_ += entryCount(it->second);
+            retireLocked(it->second);
+        }
+        long id = d.id;
+        Doc doc = makeDoc(std::move(d), ++nextVersion_);
+        appendEntries(id, doc, added);
+        docs_[id] = std::move(doc);
+    }
+
+    sortEntries(added);
+    size_t mid = delta_.size();
+    delta_.insert(delta_.end(), added.begin(), added.end());
+    std::inplace_merge(delta_.begin(), delta_.begin() + static_cast<std::ptrdiff_t>(mid), delta_.end(),
+                       entryLess);
+    if (delta_.size() > kCompactThreshold || staleEntries_ > kCompactThreshold) compactLocked();
+}
+
+void AutocompleteIndex::removeLocked(long id) {
+    if (rebuilding_) journal_.push_back(Change{true, Document{id, {}, {}, 0}});
+    auto it = docs_.find(id);
+    if (it == docs_.end()) return;
+    staleEntries_ += entryCount(it->second);
+    retireLocked(it->second);
+    docs_.erase(it);
+    if (staleEntries_ > kCompactThreshold) compactLocked();
+}
+
+void AutocompleteIndex::compactLocked() {
+    auto live = [this](const Entry& e) {
+        auto doc = docs_.find(e.id);
+        return doc != docs_.end() && doc->second.version == e.version;
+    };
+    std::vector<Entry> merged;
+    merged.reserve(entries_.size() + delta_.size());
+    auto a = entries_.begin(), b = delta_.begin();
+    while (a != entries_.end() || b != delta_.end()) {
+        bool takeA = b == delta_.end() || (a != entries_.end() && entryLess(*a, *b));
+        const Entry& e = takeA ? *a++ : *b++;
+        if (live(e)) merged.push_back(e);
+    }
+    entries_ = std::move(merged);
+    delta_.clear();
+    staleEntries_ = 0;
+    // Only the stale entries just dropped pointed into these
+    retiredKeys_.clear();
+}
+
+size_t AutocompleteIndex::documents() const {
+    std::shared_lock lock(mtx_);
+    return docs_.size();
+}
+
+size_t AutocompleteIndex::scan(const std::vector<Entry>& entries, const std::string& prefix,
+                               bool exact, size_t scanLimit, std::vector<Candidate>& candidates) {
+    std::string_view p = prefix;
+    auto lo = std::lower_bound(entries.begin(), entries.end(), p,
+                               [](const Entry& e, std::string_view q) { return e.key() < q; });
+    auto hi = std::partition_point(lo, entries.end(), [&](const Entry& e) {
+        return e.key().starts_with(p);
+    });
+    size_t range = static_cast<size_t>(hi - lo);
+    auto end = lo + static_cast<std::ptrdiff_t>(std::min(range, scanLimit));
+    for (auto it = lo; it != end; ++it)
+        candidates.push_back(Candidate{exact, it->popularity, static_cast<uint32_t>(it->key().size()),
+                                       it->version, it->id, it->field});
+    return range;
+}
+
+size_t AutocompleteIndex::collect(const std::string& prefix, bool exact, size_t scanLimit,
+                                  std::vector<Candidate>& candidates) const {
+    return scan(entries_, prefix, exact, scanLimit, candidates) +
+           scan(delta_, prefix, exact, scanLimit, candidates);
+}
+
+std::vector<std::string> AutocompleteIndex::top(std::vector<Candidate>& candidates, size_t limit) const {
+    // Exact matches first, then by popularity, then shorter keys
+    auto better = [](const Candidate& a, const Candidate& b) {
+        if (a.exact != b.exact) return a.exact;
+        if (a.popularity != b.popularity) return a.popularity > b.popularity;
+        if (a.keyLength != b.keyLength) return a.keyLength < b.keyLength;
+        return a.id < b.id;
+    };
+
+    std::vector<std::string> out;
+    std::unordered_set<std::string> seen;
+    // Duplicates (editions sharing a title, several word starts of one
+    // title) are rare enough that a few times the limit usually suffices
+    size_t sorted = 0;
+    size_t want = std::min(candidates.size(), limit * 4);
+    while (out.size() < limit && sorted < candidates.size()) {
+        std::partial_sort(candidates.begin() + static_cast<std::ptrdiff_t>(sorted),
+                          candidates.begin() + static_cast<std::ptrdiff_t>(want),
+                          candidates.end(), better);
+        for (; sorted < want && out.size() < limit; ++sorted) {
+            const auto& c = candidates[sorted];
+            auto doc = docs_.find(c.id);
+            if (doc == docs_.end() || doc->second.version != c.version) continue;
+            bool title = c.field == Field::Title;
+            const std::string& key = title ? *doc->second.titleKey : *doc->second.authorKey;
+            if (seen.insert(key).second) out.push_back(title ? doc->second.title : doc->second.author);
+        }
+        want = candidates.size();
+    }
+    return out;
+}
+
+std::vector<std::string> AutocompleteIndex::suggest(std::string_view prefix, size_t limit) const {
+    std::string p = normalizeSearchText(prefix);
+    if (p.empty() || limit == 0) return {};
+
+    std::string cacheKey = std::to_string(limit) + '\x1f' + p;
+    if (auto cached = topCache_.get(cacheKey)) return *cached;
+
+    std::shared_lock lock(mtx_);
+    std::vector<Candidate> candidates;
+    size_t range = collect(p, true, std::numeric_limits<size_t>::max(), candidates);
+    auto result = top(candidates, limit);
+
+    if (result.size() < limit && p.size() >= kFuzzyMinLength) {
+        for (const auto& variant : fuzzyVariants(p))
+            collect(variant, false, kFuzzyScanLimit, candidates);
+        result = top(candidates, limit);
+    }
+
+    // Cached under the shared lock, so a concurrent write cannot clear the
+    // cache between computing and storing
+    if (range > kCacheThreshold) topCache_.put(cacheKey, result);
+    return result;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "src/utils/LruCache.h"
+
+// In-memory prefix index over media titles and authors for autocomplete.
+// Keys (the normalized full text and every word start in it) live in a
+// sorted array, so a prefix is a binary-searched range. Writes go to a
+// small sorted delta that is merged in once it grows; replaced and removed
+// documents leave stale entries behind that are skipped by version until
+// then. Suggestions are ranked by popularity; when the exact prefix has too
+// few, edit-distance-1 variants of it are tried. Top suggestions for wide
+// ranges (short prefixes) are cached until the next write.
+class AutocompleteIndex {
+public:
+    struct Document {
+        long id = 0;
+        std::string title;
+        std::string author;
+        double popularity = 0;
+    };
+
+    AutocompleteIndex();
+
+    // Replaces the whole index. Writes made between beginRebuild() and
+    // rebuild() are replayed onto the new contents, so a slow load does not
+    // lose them.
+    void beginRebuild();
+    void rebuild(std::vector<Document> docs);
+    // Keeps the current contents after a failed load
+    void abortRebuild();
+
+    // Adds or replaces documents by id
+    void upsert(std::vector<Document> docs);
+    void remove(long id);
+
+    std::vector<std::string> suggest(std::string_view prefix, size_t limit) const;
+
+    size_t documents() const;
+
+private:
+    enum class Field : uint8_t { Title, Author };
+
+    // A key is the tail of a document's normalized title or author from
+    // one word start on; every entry of a field shares that one string
+    struct Entry {
+        const std::string* text;
+        uint32_t offset;
+        uint32_t version;
+        long id;
+        float popularity;
+        Field field;
+
+        std::string_view key() const { return std::string_view(*text).substr(offset); }
+    };
+
+    struct Doc {
+        std::string title;
+        std::string author;
+        // Normalized title and author the entries point into; heap-held so
+        // they stay put while docs_ rehashes
+        std::unique_ptr<const std::string> titleKey;
+        std::unique_ptr<const std::string> authorKey;
+        double popularity;
+        uint32_t version;
+    };
+
+    struct Candidate {
+        bool exact;
+        float popularity;
+        uint32_t keyLength;
+        uint32_t version;
+        long id;
+        Field field;
+    };
+
+    struct Change {
+        bool removed;
+        Document doc;
+    };
+
+    static Doc makeDoc(Document doc, uint32_t version);
+    static void appendEntries(long id, const Doc& doc, std::vector<Entry>& out);
+    static size_t entryCount(const Doc& doc);
+    static bool entryLess(const Entry& a, const Entry& b);
+    static void sortEntries(std::vector<Entry>& entries);
+    // Keeps a replaced or removed document's keys alive for its stale
+    // entries until the next compaction
+    void retireLocked(Doc& doc);
+    void upsertLocked(std::vector<Document> docs);
+    void removeLocked(long id);
+    // Merges the delta into the main array and drops stale entries
+    void compactLocked();
+    static size_t scan(const std::vector<Entry>& entries, const std::string& prefix, bool exact,
+                       size_t scanLimit, std::vector<Candidate>& candidates);
+
+    // Adds up to scanLimit entries of prefix's range to candidates; returns
+    // the size of the range
+    size_t collect(const std::string& prefix, bool exact, size_t scanLimit,
+                   std::vector<Candidate>& candidates) const;
+    std::vector<std::string> top(std::vector<Candidate>& candidates, size_t limit) const;
+
+    mutable std::shared_mutex mtx_;
+    std::vector<Entry> entries_;
+    std::vector<Entry> delta_;
+    size_t staleEntries_ = 0;
+    std::vector<std::unique_ptr<const std::string>> retiredKeys_;
+    uint32_t nextVersion_ = 0;
+    std::unordered_map<long, Doc> docs_;
+
+    bool rebuilding_ = false;
+    std::vector<Change> journal_;
+
+    mutable LruCache<std::vector<std::string>> topCache_;
+};
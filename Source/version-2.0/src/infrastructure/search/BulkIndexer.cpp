@@ -0,0 +1,355 @@
+#include "BulkIndexer.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
+#include <algorithm>
+#include <iostream>
+
+using json = nlohmann::json;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Permanent failures kept in BulkIndexStats::errors
+constexpr size_t kMaxReportedErrors = 20;
+// Upper bound on how long the sender sleeps waiting for sockets or work
+constexpr int kPollTimeoutMs = 100;
+
+// 429 and 5xx mean the cluster was busy; anything else will fail again
+bool isRetryable(long status) {
+    return status == 429 || status >= 500;
+}
+
+}
+
+BulkIndexer::BulkIndexer(const std::string& baseUrl,
+                         const std::optional<std::string>& apiKey,
+                         BulkIndexerOptions options)
+    : options_(std::move(options)),
+      // Only per-item status and error are read back, which keeps responses small
+      url_(baseUrl + "/_bulk?" + (options_.requireAlias ? "require_alias=true&" : "")
+           + "filter_path=errors,items.*.status,items.*.error"),
+      actionPrefix_("{" + json(options_.opType).dump() + R"(:{"_index":)" + json(options_.index).dump()
+                    + R"(,"_id":)"),
+      docsIndexed_(MetricsRegistry::instance().counter(
+          "opensearch_bulk_docs_indexed_total", "Documents accepted by OpenSearch _bulk")),
+      docsFailed_(MetricsRegistry::instance().counter(
+          "opensearch_bulk_docs_failed_total", "Documents OpenSearch _bulk rejected for good")),
+      docsRetried_(MetricsRegistry::instance().counter(
+          "opensearch_bulk_docs_retried_total", "Documents resent after a retryable _bulk rejection")),
+      inFlight_(MetricsRegistry::instance().gauge(
+          "opensearch_bulk_requests_in_flight", "OpenSearch _bulk requests in flight")),
+      requestSeconds_(MetricsRegistry::instance().histogram(
+          "opensearch_bulk_request_seconds", "OpenSearch _bulk request latency")) {
+    options_.concurrency = std::max<size_t>(1, options_.concurrency);
+    options_.maxQueuedBatches = std::max<size_t>(1, options_.maxQueuedBatches);
+
+    headers_ = curl_slist_append(headers_, "Content-Type: application/x-ndjson");
+    if (apiKey.has_value()) {
+        std::string authHeader = "Authorization: ApiKey " + apiKey.value();
+        headers_ = curl_slist_append(headers_, authHeader.c_str());
+    }
+
+    multi_ = curl_multi_init();
+    curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(options_.concurrency));
+
+    sender_ = std::thread([this] { run(); });
+}
+
+BulkIndexer::~BulkIndexer() {
+    close();
+    for (CURL* easy : idleHandles_) curl_easy_cleanup(easy);
+    if (multi_) curl_multi_cleanup(multi_);
+    curl_slist_free_all(headers_);
+}
+
+size_t BulkIndexer::writeCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    size_t realSize = size * nmemb;
+    reinterpret_cast<std::string*>(userp)->append(static_cast<char*>(contents), realSize);
+    return realSize;
+}
+
+//  PRODUCER SIDE
+void BulkIndexer::pack(Batch& current, std::string& scratch, const json& doc,
+                       const std::function<void(Batch&&)>& emit) const {
+    const auto& id = doc.at("id");
+    scratch.assign(actionPrefix_);
+    scratch.append(id.is_string() ? id.dump() : json(id.dump()).dump());
+    scratch.append("}}\n");
+    scratch.append(doc.dump());
+    scratch.push_back('\n');
+
+    auto cut = [&] {
+        Batch next;
+        next.tracker = current.tracker;
+        emit(std::exchange(current, std::move(next)));
+    };
+
+    if (!current.items.empty() && current.body.size() + scratch.size() > options_.maxBatchBytes)
+        cut();
+
+    current.items.emplace_back(current.body.size(), scratch.size());
+    current.body.append(scratch);
+
+    if (current.items.size() >= options_.maxBatchDocs || current.body.size() >= options_.maxBatchBytes)
+        cut();
+}
+
+void BulkIndexer::add(const json& doc) {
+    pack(current_, scratch_, doc, [this](Batch&& full) { enqueue(std::move(full)); });
+}
+
+BulkIndexStats BulkIndexer::index(const std::vector<json>& docs) {
+    auto tracker = std::make_shared<Tracker>();
+    std::vector<Batch> batches;
+    Batch current;
+    current.tracker = tracker;
+    std::string scratch;
+    for (const auto& doc : docs)
+        pack(current, scratch, doc, [&batches](Batch&& full) { batches.push_back(std::move(full)); });
+    if (!current.items.empty()) batches.push_back(std::move(current));
+
+    {
+        std::scoped_lock lock(mtx_);
+        if (closed_) {
+            tracker->stats.failed = docs.size();
+            tracker->stats.errors.push_back("indexer is closed");
+            return tracker->stats;
+        }
+        tracker->pending = docs.size();
+    }
+    for (auto& batch : batches) enqueue(std::move(batch));
+
+    std::unique_lock lock(mtx_);
+    doneCv_.wait(lock, [&tracker] { return tracker->pending == 0; });
+    return tracker->stats;
+}
+
+void BulkIndexer::enqueue(Batch&& batch) {
+    {
+        std::unique_lock lock(mtx_);
+        // Backpressure: wait for the sender to pick up a batch
+        spaceCv_.wait(lock, [this] { return queue_.size() < options_.maxQueuedBatches; });
+        queue_.push_back(std::move(batch));
+    }
+    curl_multi_wakeup(multi_);
+}
+
+BulkIndexStats BulkIndexer::close() {
+    {
+        std::scoped_lock lock(mtx_);
+        if (closed_) return stats_;
+    }
+    if (!current_.items.empty()) enqueue(std::exchange(current_, Batch{}));
+    {
+        std::scoped_lock lock(mtx_);
+        closing_ = true;
+        closed_ = true;
+    }
+    curl_multi_wakeup(multi_);
+    if (sender_.joinable()) sender_.join();
+    return stats_;
+}
+
+//  SENDER THREAD
+bool BulkIndexer::nextBatch(Batch& out) {
+    // Retries that have waited out their backoff go first
+    auto now = Clock::now();
+    for (auto it = retries_.begin(); it != retries_.end(); ++it) {
+        if (it->notBefore <= now) {
+            out = std::move(*it);
+            retries_.erase(it);
+            return true;
+        }
+    }
+
+    std::scoped_lock lock(mtx_);
+    if (queue_.empty()) return false;
+    out = std::move(queue_.front());
+    queue_.pop_front();
+    spaceCv_.notify_one();
+    return true;
+}
+
+void BulkIndexer::run() {
+    while (true) {
+        while (active_.size() < options_.concurrency) {
+            Batch batch;
+            if (!nextBatch(batch)) break;
+            auto transfer = std::make_unique<Transfer>();
+            transfer->batch = std::move(batch);
+            start(std::move(transfer));
+        }
+
+        if (active_.empty() && retries_.empty()) {
+            std::scoped_lock lock(mtx_);
+            if (closing_ && queue_.empty()) break;
+        }
+
+        int running = 0;
+        curl_multi_perform(multi_, &running);
+
+        int pending = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi_, &pending)) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            CURL* easy = msg->easy_handle;
+            CURLcode code = msg->data.result;
+
+            auto it = std::find_if(active_.begin(), active_.end(),
+                                   [easy](const auto& t) { return t->easy == easy; });
+            std::unique_ptr<Transfer> transfer = std::move(*it);
+            active_.erase(it);
+
+            curl_multi_remove_handle(multi_, easy);
+            finish(*transfer, code);
+            idleHandles_.push_back(easy);
+        }
+
+        curl_multi_poll(multi_, nullptr, 0, kPollTimeoutMs, nullptr);
+    }
+}
+
+void BulkIndexer::start(std::unique_ptr<Transfer> transfer) {
+    CURL* easy;
+    if (!idleHandles_.empty()) {
+        easy = idleHandles_.back();
+        idleHandles_.pop_back();
+        curl_easy_reset(easy);
+    } else {
+        easy = curl_easy_init();
+    }
+    transfer->easy = easy;
+    transfer->started = Clock::now();
+
+    const auto& body = transfer->batch.body;
+    curl_easy_setopt(easy, CURLOPT_URL, url_.c_str());
+    curl_easy_setopt(easy, CURLOPT_POST, 1L);
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDS, body.data());
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(body.size()));
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers_);
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, 3000L);
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, 60000L);
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfer->response);
+
+    curl_multi_add_handle(multi_, easy);
+    {
+        std::scoped_lock lock(mtx_);
+        auto& tracker = transfer->batch.tracker;
+        (tracker ? tracker->stats : stats_).requests++;
+    }
+    active_.push_back(std::move(transfer));
+    inFlight_.inc();
+}
+
+void BulkIndexer::finish(Transfer& transfer, CURLcode code) {
+    inFlight_.dec();
+    requestSeconds_.observe(std::chrono::duration<double>(Clock::now() - transfer.started).count());
+    auto& batch = transfer.batch;
+
+    if (code != CURLE_OK) {
+        retryOrFail(std::move(batch), curl_easy_strerror(code));
+        return;
+    }
+
+    long status = 0;
+    curl_easy_getinfo(transfer.easy, CURLINFO_RESPONSE_CODE, &status);
+    if (isRetryable(status)) {
+        retryOrFail(std::move(batch), "HTTP " + std::to_string(status));
+        return;
+    }
+    if (status < 200 || status >= 300) {
+        recordFailure(batch, batch.items.size(),
+                      "HTTP " + std::to_string(status) + ": " + transfer.response);
+        return;
+    }
+
+    json parsed = json::parse(transfer.response, nullptr, false);
+    if (parsed.is_discarded() || !parsed.is_object()) {
+        retryOrFail(std::move(batch), "unreadable _bulk response");
+        return;
+    }
+    // Anything but an explicit "errors": false is checked item by item
+    const auto errors = parsed.find("errors");
+    if (errors != parsed.end() && errors->is_boolean() && !errors->get<bool>()) {
+        recordIndexed(batch, batch.items.size());
+        return;
+    }
+
+    // Items come back in request order; collect the retryable ones into a new
+    // batch. Items missing from the response count as retryable.
+    auto itemsIt = parsed.find("items");
+    const json items = itemsIt != parsed.end() && itemsIt->is_array() ? *itemsIt : json::array();
+    Batch retry;
+    retry.attempt = batch.attempt;
+    retry.tracker = batch.tracker;
+    size_t indexed = 0;
+    for (size_t i = 0; i < batch.items.size(); ++i) {
+        long itemStatus = 0;
+        std::string reason;
+        if (i < items.size() && items[i].is_object() && !items[i].empty()) {
+            const auto& result = items[i].begin().value();
+            itemStatus = result.value("status", 0L);
+            if (result.contains("error"))
+                reason = result["error"].is_object()
+                    ? result["error"].value("type", "") + ": " + result["error"].value("reason", "")
+                    : result["error"].dump();
+        }
+
+        if ((itemStatus >= 200 && itemStatus < 300) || (itemStatus == 409 && options_.opType == "create")) {
+            ++indexed;
+        } else if (isRetryable(itemStatus) || i >= items.size()) {
+            auto [offset, length] = batch.items[i];
+            retry.items.emplace_back(retry.body.size(), length);
+            retry.body.append(batch.body, offset, length);
+        } else {
+            recordFailure(batch, 1, reason.empty() ? "status " + std::to_string(itemStatus) : reason);
+        }
+    }
+    if (indexed) recordIndexed(batch, indexed);
+    if (!retry.items.empty())
+        retryOrFail(std::move(retry), "items rejected with 429/5xx");
+}
+
+void BulkIndexer::retryOrFail(Batch&& batch, const std::string& reason) {
+    if (batch.attempt >= options_.maxRetries) {
+        recordFailure(batch, batch.items.size(), reason + " (gave up after " +
+                      std::to_string(batch.attempt) + " retries)");
+        return;
+    }
+    batch.notBefore = Clock::now() + options_.retryBackoff * (1 << batch.attempt);
+    batch.attempt++;
+    docsRetried_.inc(static_cast<double>(batch.items.size()));
+    {
+        std::scoped_lock lock(mtx_);
+        auto& stats = batch.tracker ? batch.tracker->stats : stats_;
+        stats.retried += batch.items.size();
+    }
+    retries_.push_back(std::move(batch));
+}
+
+void BulkIndexer::recordIndexed(const Batch& batch, size_t count) {
+    docsIndexed_.inc(static_cast<double>(count));
+    std::scoped_lock lock(mtx_);
+    auto& stats = batch.tracker ? batch.tracker->stats : stats_;
+    stats.indexed += count;
+    resolve(batch, count);
+}
+
+void BulkIndexer::recordFailure(const Batch& batch, size_t count, const std::string& reason) {
+    docsFailed_.inc(static_cast<double>(count));
+    std::scoped_lock lock(mtx_);
+    auto& stats = batch.tracker ? batch.tracker->stats : stats_;
+    stats.failed += count;
+    if (stats.errors.size() < kMaxReportedErrors) {
+        stats.errors.push_back(reason);
+        std::cerr << "[OpenSearch] Bulk indexing failed for " << count << " docs: " << reason << "\n";
+    }
+    resolve(batch, count);
+}
+
+// Called with mtx_ held
+void BulkIndexer::resolve(const Batch& batch, size_t count) {
+    if (!batch.tracker) return;
+    batch.tracker->pending -= count;
+    if (batch.tracker->pending == 0) doneCv_.notify_all();
+}
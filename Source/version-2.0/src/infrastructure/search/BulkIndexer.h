@@ -0,0 +1,148 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <curl/curl.h>
+
+class Counter;
+class Gauge;
+class Histogram;
+
+struct BulkIndexerOptions {
+    std::string index = "media";
+    // "index" overwrites; with "create" an existing document wins, and its
+    // 409 counts as indexed
+    std::string opType = "index";
+    // Fail items instead of creating an index when "index" is not an alias
+    bool requireAlias = false;
+    // A batch is sent once it reaches either limit
+    size_t maxBatchBytes = 5 * 1024 * 1024;
+    size_t maxBatchDocs = 1000;
+    // _bulk requests in flight at once
+    size_t concurrency = 4;
+    // Full batches waiting to be sent before add() blocks
+    size_t maxQueuedBatches = 8;
+    // Resends of items rejected with 429/5xx, with exponential backoff
+    int maxRetries = 3;
+    std::chrono::milliseconds retryBackoff{250};
+};
+
+struct BulkIndexStats {
+    size_t indexed = 0;
+    size_t failed = 0;
+    size_t retried = 0;
+    size_t requests = 0;
+    // First few permanent failures
+    std::vector<std::string> errors;
+};
+
+// Streams documents into OpenSearch _bulk requests. Documents are packed into
+// size-bounded NDJSON batches that a sender thread keeps in flight over a
+// curl multi handle, reusing its keep-alive connections. Items the _bulk
+// response rejects as retryable are resent on their own; add() and index()
+// block while the send queue is full, so producers cannot outrun the cluster.
+//
+// An indexer is meant to live as long as its index: add()/close() stream one
+// large load from a single producer, and index() lets any number of threads
+// share the sender for small batches.
+class BulkIndexer {
+public:
+    BulkIndexer(const std::string& baseUrl,
+                const std::optional<std::string>& apiKey,
+                BulkIndexerOptions options = {});
+    ~BulkIndexer();
+
+    BulkIndexer(const BulkIndexer&) = delete;
+    BulkIndexer& operator=(const BulkIndexer&) = delete;
+
+    // Queues one document; its "id" field becomes the document _id.
+    // Not thread-safe; for a single producer
+    void add(const nlohmann::json& doc);
+
+    // Sends docs and waits until every one of them is indexed or has
+    // failed for good; the stats cover only these documents. Thread-safe,
+    // and batches of concurrent callers are in flight together.
+    BulkIndexStats index(const std::vector<nlohmann::json>& docs);
+
+    // Sends the remaining documents and waits for every request, retries
+    // included. The indexer cannot be used afterwards.
+    BulkIndexStats close();
+
+private:
+    // Documents of one index() call that are still unresolved, and their
+    // outcome; guarded by mtx_
+    struct Tracker {
+        size_t pending = 0;
+        BulkIndexStats stats;
+    };
+
+    struct Batch {
+        std::string body;
+        // [offset, length) of each document's action and source lines in body
+        std::vector<std::pair<size_t, size_t>> items;
+        int attempt = 0;
+        std::chrono::steady_clock::time_point notBefore{};
+        std::shared_ptr<Tracker> tracker;
+    };
+
+    struct Transfer {
+        CURL* easy;
+        Batch batch;
+        std::string response;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    // Appends doc to current, handing every batch that fills up to emit
+    void pack(Batch& current, std::string& scratch, const nlohmann::json& doc,
+              const std::function<void(Batch&&)>& emit) const;
+    void enqueue(Batch&& batch);
+    bool nextBatch(Batch& out);
+    void run();
+    void start(std::unique_ptr<Transfer> transfer);
+    void finish(Transfer& transfer, CURLcode code);
+    void retryOrFail(Batch&& batch, const std::string& reason);
+    void recordIndexed(const Batch& batch, size_t count);
+    void recordFailure(const Batch& batch, size_t count, const std::string& reason);
+    void resolve(const Batch& batch, size_t count);
+
+    static size_t writeCallback(void* contents, size_t size, size_t nmemb, void* userp);
+
+    BulkIndexerOptions options_;
+    std::string url_;
+    std::string actionPrefix_;
+    curl_slist* headers_ = nullptr;
+    CURLM* multi_ = nullptr;
+
+    std::mutex mtx_;
+    std::condition_variable spaceCv_;
+    std::condition_variable doneCv_;
+    std::deque<Batch> queue_;
+    bool closing_ = false;
+    bool closed_ = false;
+    Batch current_;
+    std::string scratch_;
+
+    // Owned by the sender thread until close() joins it
+    std::deque<Batch> retries_;
+    std::vector<std::unique_ptr<Transfer>> active_;
+    std::vector<CURL*> idleHandles_;
+    // Totals for add(); read by close() once the sender has stopped
+    BulkIndexStats stats_;
+
+    Counter& docsIndexed_;
+    Counter& docsFailed_;
+    Counter& docsRetried_;
+    Gauge& inFlight_;
+    Histogram& requestSeconds_;
+
+    std::thread sender_;
+};
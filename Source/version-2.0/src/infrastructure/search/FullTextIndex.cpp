@@ -0,0 +1,366 @@
+#include "FullTextIndex.h"
+#include "src/utils/StringUtils.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr size_t kCategory = 2;
+constexpr std::array<float, 3> kBoost = {3.0f, 2.0f, 1.0f};   // title^3, author^2, category
+constexpr float kK1 = 1.2f;
+constexpr float kB = 0.75f;
+// OpenSearch's default max_expansions for fuzzy and phrase_prefix queries
+constexpr size_t kMaxExpansions = 50;
+// A term completing the last query word counts a little less than the word itself
+constexpr float kPrefixWeight = 0.8f;
+// Longest term edit distances are computed for
+constexpr size_t kMaxFuzzyLength = 64;
+// Dead slots that trigger rebuilding the postings, at least
+constexpr size_t kCompactThreshold = 4096;
+
+uint16_t saturate(size_t v) {
+    return static_cast<uint16_t>(std::min<size_t>(v, std::numeric_limits<uint16_t>::max()));
+}
+
+// Edit budget for a term of the given length, as OpenSearch reads fuzziness
+int maxEdits(std::string_view fuzziness, size_t length) {
+    std::string f = toLower(std::string(fuzziness));
+    if (f.rfind("auto", 0) == 0) {
+        size_t low = 3, high = 6;
+        auto colon = f.find(':'), comma = f.find(',');
+        if (colon != std::string::npos && comma != std::string::npos && comma > colon) {
+            std::from_chars(f.data() + colon + 1, f.data() + comma, low);
+            std::from_chars(f.data() + comma + 1, f.data() + f.size(), high);
+        }
+        return length < low ? 0 : length < high ? 1 : 2;
+    }
+    int edits = 0;
+    std::from_chars(f.data(), f.data() + f.size(), edits);
+    return std::clamp(edits, 0, 2);
+}
+
+// Optimal string alignment distance (edits plus adjacent transpositions,
+// like OpenSearch's fuzzy_transpositions); max + 1 once it exceeds max.
+// Only the diagonal band of width 2 * max + 1 can stay within max, so only
+// it is computed. Terms longer than kMaxFuzzyLength only match exactly.
+int editDistance(std::string_view a, std::string_view b, int max) {
+    if (std::abs(static_cast<int>(a.size()) - static_cast<int>(b.size())) > max) return max + 1;
+    int m = static_cast<int>(a.size()), n = static_cast<int>(b.size());
+    if (n > static_cast<int>(kMaxFuzzyLength)) return max + 1;
+    const int inf = max + 1;
+    std::array<std::array<int, kMaxFuzzyLength + 2>, 3> rows;
+    int* prev2 = rows[0].data();
+    int* prev = rows[1].data();
+    int* cur = rows[2].data();
+    for (int j = 0; j <= n; ++j) prev[j] = std::min(j, inf);
+    prev[n + 1] = inf;
+    for (int i = 1; i <= m; ++i) {
+        int lo = std::max(1, i - max), hi = std::min(n, i + max);
+        cur[lo - 1] = lo == 1 ? std::min(i, inf) : inf;
+        int rowMin = cur[lo - 1];
+        for (int j = lo; j <= hi; ++j) {
+            int cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            int d = std::min({prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + cost});
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1])
+                d = std::min(d, prev2[j - 2] + 1);
+            cur[j] = std::min(d, inf);
+            rowMin = std::min(rowMin, cur[j]);
+        }
+        if (rowMin >= inf) return inf;
+        cur[hi + 1] = inf;
+        std::swap(prev2, prev);
+        std::swap(prev, cur);
+    }
+    return prev[n];
+}
+
+}
+
+std::vector<std::string> FullTextIndex::tokenize(std::string_view text) {
+    std::vector<std::string> tokens;
+    std::string current;
+    for (unsigned char c : text) {
+        if (std::isalnum(c) || c >= 0x80) {
+            current.push_back(static_cast<char>(std::tolower(c)));
+        } else if (!current.empty()) {
+            tokens.push_back(std::move(current));
+            current.clear();
+        }
+    }
+    if (!current.empty()) tokens.push_back(std::move(current));
+    return tokens;
+}
+
+std::array<std::vector<std::string>, FullTextIndex::kFields> FullTextIndex::fieldTerms(const Doc& doc) {
+    std::array<std::vector<std::string>, kFields> terms{tokenize(doc.title), tokenize(doc.author), {}};
+    std::string category = normalizeSearchText(doc.category);
+    if (!category.empty()) terms[kCategory].push_back(std::move(category));
+    return terms;
+}
+
+void FullTextIndex::add(Data& data, long id, Doc doc) {
+    auto slot = static_cast<uint32_t>(data.slots.size());
+    Slot s{id, {}, true};
+    auto fields = fieldTerms(doc);
+    for (size_t f = 0; f < kFields; ++f) {
+        auto& tokens = fields[f];
+        s.length[f] = static_cast<uint32_t>(tokens.size());
+        data.totalLength[f] += tokens.size();
+        std::sort(tokens.begin(), tokens.end());
+        for (size_t i = 0; i < tokens.size();) {
+            size_t j = i;
+            while (j < tokens.size() && tokens[j] == tokens[i]) ++j;
+            Term& term = data.terms[tokens[i]];
+            term.postings[f].push_back(Posting{slot, saturate(j - i), saturate(tokens.size())});
+            ++term.df[f];
+            i = j;
+        }
+    }
+    data.slots.push_back(s);
+    doc.slot = slot;
+    data.docs[id] = std::move(doc);
+}
+
+void FullTextIndex::kill(Data& data, std::unordered_map<long, Doc>::iterator it) {
+    Slot& slot = data.slots[it->second.slot];
+    auto fields = fieldTerms(it->second);
+    for (size_t f = 0; f < kFields; ++f) {
+        auto& tokens = fields[f];
+        std::sort(tokens.begin(), tokens.end());
+        tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+        for (const auto& t : tokens) {
+            auto term = data.terms.find(t);
+            if (term != data.terms.end()) --term->second.df[f];
+        }
+        data.totalLength[f] -= slot.length[f];
+    }
+    slot.live = false;
+    ++data.deadSlots;
+    data.docs.erase(it);
+}
+
+void FullTextIndex::compact(Data& data) {
+    std::vector<std::pair<long, Doc>> docs(std::make_move_iterator(data.docs.begin()),
+                                           std::make_move_iterator(data.docs.end()));
+    std::sort(docs.begin(), docs.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    data = Data{};
+    data.slots.reserve(docs.size());
+    data.docs.reserve(docs.size());
+    for (auto& [id, doc] : docs) add(data, id, std::move(doc));
+}
+
+void FullTextIndex::beginRebuild() {
+    std::unique_lock lock(mtx_);
+    rebuilding_ = true;
+    journal_.clear();
+}
+
+void FullTextIndex::rebuild(std::vector<Document> docs) {
+    // Built outside the lock; searches keep using the old contents meanwhile
+    std::sort(docs.begin(), docs.end(), [](const Document& a, const Document& b) { return a.id < b.id; });
+    Data data;
+    data.slots.reserve(docs.size());
+    data.docs.reserve(docs.size());
+    for (auto& d : docs) {
+        if (data.docs.count(d.id)) continue;
+        add(data, d.id, Doc{std::move(d.title), std::move(d.author), std::move(d.category), 0});
+    }
+
+    std::unique_lock lock(mtx_);
+    data_ = std::move(data);
+    rebuilding_ = false;
+    for (auto& change : journal_) {
+        if (change.removed) removeLocked(change.doc.id);
+        else upsertLocked({std::move(change.doc)});
+    }
+    journal_.clear();
+}
+
+void FullTextIndex::abortRebuild() {
+    std::unique_lock lock(mtx_);
+    rebuilding_ = false;
+    journal_.clear();
+}
+
+void FullTextIndex::upsert(std::vector<Document> docs) {
+    if (docs.empty()) return;
+    std::unique_lock lock(mtx_);
+    upsertLocked(std::move(docs));
+}
+
+void FullTextIndex::remove(long id) {
+    std::unique_lock lock(mtx_);
+    removeLocked(id);
+}
+
+void FullTextIndex::upsertLocked(std::vector<Document> docs) {
+    if (rebuilding_)
+        for (const auto& d : docs) journal_.push_back(Change{false, d});
+
+    for (auto& d : docs) {
+        auto it = data_.docs.find(d.id);
+        if (it != data_.docs.end()) kill(data_, it);
+        add(data_, d.id, Doc{std::move(d.title), std::move(d.author), std::move(d.category), 0});
+    }
+    if (data_.deadSlots > std::max(kCompactThreshold, data_.docs.size())) compact(data_);
+}
+
+void FullTextIndex::removeLocked(long id) {
+    if (rebuilding_) journal_.push_back(Change{true, Document{id, {}, {}, {}}});
+    auto it = data_.docs.find(id);
+    if (it == data_.docs.end()) return;
+    kill(data_, it);
+    if (data_.deadSlots > std::max(kCompactThreshold, data_.docs.size())) compact(data_);
+}
+
+size_t FullTextIndex::documents() const {
+    std::shared_lock lock(mtx_);
+    return data_.docs.size();
+}
+
+bool FullTextIndex::inUse(const Term& term) {
+    for (uint32_t df : term.df)
+        if (df > 0) return true;
+    return false;
+}
+
+std::vector<FullTextIndex::Expansion> FullTextIndex::expand(const std::string& term, int edits,
+                                                           bool prefix) const {
+    std::vector<Expansion> out;
+    const auto& terms = data_.terms;
+    if (auto it = terms.find(term); it != terms.end() && inUse(it->second))
+        out.push_back(Expansion{&it->second, 1.0f});
+    if (term.empty()) return out;
+
+    if (edits > 0) {
+        // prefix_length 1: only terms sharing the first character
+        std::vector<std::pair<int, const Term*>> fuzzy;
+        for (auto it = terms.lower_bound(term.substr(0, 1));
+             it != terms.end() && it->first[0] == term[0]; ++it) {
+            if (!inUse(it->second) || it->first == term) continue;
+            int d = editDistance(it->first, term, edits);
+            if (d <= edits) fuzzy.emplace_back(d, &it->second);
+        }
+        std::stable_sort(fuzzy.begin(), fuzzy.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        if (fuzzy.size() > kMaxExpansions) fuzzy.resize(kMaxExpansions);
+        // An edit count as large as the term would match at no weight
+        for (const auto& [d, t] : fuzzy) {
+            float weight = 1.0f - static_cast<float>(d) / static_cast<float>(term.size());
+            if (weight > 0) out.push_back(Expansion{t, weight});
+        }
+    }
+
+    if (prefix) {
+        size_t taken = 0;
+        for (auto it = terms.upper_bound(term);
+             it != terms.end() && taken < kMaxExpansions && it->first.compare(0, term.size(), term) == 0;
+             ++it) {
+            if (!inUse(it->second)) continue;
+            out.push_back(Expansion{&it->second, kPrefixWeight});
+            ++taken;
+        }
+    }
+    return out;
+}
+
+std::vector<json> FullTextIndex::search(std::string_view query, std::string_view fuzziness,
+                                        int from, int size) const {
+    if (from < 0 || size <= 0) return {};
+    auto tokens = tokenize(query);
+    std::string whole = normalizeSearchText(query);
+    if (tokens.empty() && whole.empty()) return {};
+
+    std::shared_lock lock(mtx_);
+    const auto& data = data_;
+    double n = static_cast<double>(data.docs.size());
+    if (n == 0) return {};
+
+    // Per-field BM25 sums, indexed by slot. The buffers are kept per thread
+    // and only the touched entries are reset, so a query costs its postings
+    // rather than the size of the index.
+    thread_local Scratch scratch;
+    if (scratch.best.size() < data.slots.size()) {
+        scratch.best.resize(data.slots.size(), 0.0f);
+        scratch.scores.resize(data.slots.size(), std::array<float, kFields>{});
+        scratch.touched.resize(data.slots.size(), 0);
+    }
+    std::vector<uint32_t> touched;
+    std::array<float, kFields> avgLength;
+    for (size_t f = 0; f < kFields; ++f)
+        avgLength[f] = static_cast<float>(std::max(1.0, static_cast<double>(data.totalLength[f]) / n));
+
+    // Adds one query term's BM25 score in field f; a document counts the
+    // term once, through its best expansion
+    auto score = [&](const std::vector<Expansion>& expansions, size_t f) {
+        scratch.matched.clear();
+        for (const auto& e : expansions) {
+            double df = e.term->df[f];
+            if (df == 0) continue;
+            float idf = static_cast<float>(std::log(1.0 + (n - df + 0.5) / (df + 0.5)));
+            // Dead slots are scored too and dropped when ranking
+            for (const auto& p : e.term->postings[f]) {
+                float tf = static_cast<float>(p.tf);
+                float norm = kK1 * (1 - kB + kB * static_cast<float>(p.length) / avgLength[f]);
+                float s = e.weight * idf * tf * (kK1 + 1) / (tf + norm);
+                float& b = scratch.best[p.slot];
+                if (b == 0) scratch.matched.push_back(p.slot);
+                b = std::max(b, s);
+            }
+        }
+        for (uint32_t slot : scratch.matched) {
+            auto& fields = scratch.scores[slot];
+            if (!scratch.touched[slot]) {
+                scratch.touched[slot] = 1;
+                touched.push_back(slot);
+            }
+            fields[f] += scratch.best[slot];
+            scratch.best[slot] = 0;
+        }
+    };
+
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        auto expansions = expand(tokens[i], maxEdits(fuzziness, tokens[i].size()), i + 1 == tokens.size());
+        for (size_t f = 0; f < kCategory; ++f) score(expansions, f);
+    }
+    if (!whole.empty()) score(expand(whole, maxEdits(fuzziness, whole.size()), false), kCategory);
+
+    std::vector<std::pair<float, uint32_t>> ranked;
+    ranked.reserve(touched.size());
+    for (uint32_t slot : touched) {
+        auto& fields = scratch.scores[slot];
+        scratch.touched[slot] = 0;
+        if (!data.slots[slot].live) {
+            fields = {};
+            continue;
+        }
+        float score = 0;
+        for (size_t f = 0; f < kFields; ++f) score = std::max(score, kBoost[f] * fields[f]);
+        ranked.emplace_back(score, slot);
+        fields = {};
+    }
+
+    size_t end = std::min(ranked.size(), static_cast<size_t>(from) + static_cast<size_t>(size));
+    if (static_cast<size_t>(from) >= end) return {};
+    auto better = [&](const auto& a, const auto& b) {
+        if (a.first != b.first) return a.first > b.first;
+        return data.slots[a.second].id < data.slots[b.second].id;
+    };
+    std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(end), ranked.end(), better);
+
+    std::vector<json> hits;
+    hits.reserve(end - static_cast<size_t>(from));
+    for (size_t i = static_cast<size_t>(from); i < end; ++i) {
+        long id = data.slots[ranked[i].second].id;
+        const Doc& doc = data.docs.at(id);
+        hits.push_back({{"id", id}, {"title", doc.title}, {"author", doc.author},
+                        {"category", doc.category}, {"_score", ranked[i].first}});
+    }
+    return hits;
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Embedded inverted index over media titles, authors and categories, used
+// to answer /api/search without OpenSearch. It mirrors the query
+// OpenSearchClient::fuzzySearch sends: BM25 per field with title^3 and
+// author^2 boosts, the best field winning; query terms match vocabulary
+// terms within the requested fuzziness (first character fixed), and the
+// last term also matches as a prefix. Category is matched as a whole, like
+// the keyword field it stands in for.
+//
+// Replaced and removed documents leave dead postings behind that are
+// skipped until enough of them pile up to rebuild the postings.
+class FullTextIndex {
+public:
+    struct Document {
+        long id = 0;
+        std::string title;
+        std::string author;
+        std::string category;
+    };
+
+    // Writes made between beginRebuild() and rebuild() are replayed onto
+    // the new contents, as in AutocompleteIndex
+    void beginRebuild();
+    void rebuild(std::vector<Document> docs);
+    void abortRebuild();
+
+    // Adds or replaces documents by id
+    void upsert(std::vector<Document> docs);
+    void remove(long id);
+
+    // Hits shaped like OpenSearchClient::fuzzySearch results:
+    // {id, title, author, category, _score}. fuzziness is "AUTO",
+    // "AUTO:<low>,<high>" or an edit count.
+    std::vector<nlohmann::json> search(std::string_view query, std::string_view fuzziness,
+                                       int from, int size) const;
+
+    size_t documents() const;
+
+    // Lower-cased runs of letters and digits; bytes of multi-byte UTF-8
+    // characters count as letters
+    static std::vector<std::string> tokenize(std::string_view text);
+
+private:
+    static constexpr size_t kFields = 3;   // title, author, category
+
+    // Carries the field length so scoring does not look up the slot
+    struct Posting {
+        uint32_t slot;
+        uint16_t tf;
+        uint16_t length;
+    };
+
+    struct Term {
+        std::array<std::vector<Posting>, kFields> postings;
+        std::array<uint32_t, kFields> df{};
+    };
+
+    struct Slot {
+        long id;
+        std::array<uint32_t, kFields> length;
+        bool live;
+    };
+
+    struct Doc {
+        std::string title;
+        std::string author;
+        std::string category;
+        uint32_t slot;
+    };
+
+    struct Data {
+        std::map<std::string, Term, std::less<>> terms;
+        std::vector<Slot> slots;
+        std::unordered_map<long, Doc> docs;
+        std::array<uint64_t, kFields> totalLength{};
+        size_t deadSlots = 0;
+    };
+
+    struct Change {
+        bool removed;
+        Document doc;
+    };
+
+    // Per-thread score buffers for search()
+    struct Scratch {
+        std::vector<float> best;
+        std::vector<std::array<float, kFields>> scores;
+        std::vector<uint32_t> matched;
+        std::vector<uint8_t> touched;   // slots already listed for ranking
+    };
+
+    // A vocabulary term a query term matched, and how much it counts
+    struct Expansion {
+        const Term* term;
+        float weight;
+    };
+
+    static std::array<std::vector<std::string>, kFields> fieldTerms(const Doc& doc);
+    static void add(Data& data, long id, Doc doc);
+    static void kill(Data& data, std::unordered_map<long, Doc>::iterator it);
+    static void compact(Data& data);
+    void upsertLocked(std::vector<Document> docs);
+    void removeLocked(long id);
+
+    static bool inUse(const Term& term);
+    // Vocabulary terms matching term exactly, within edits, and, with
+    // prefix, starting with it
+    std::vector<Expansion> expand(const std::string& term, int edits, bool prefix) const;
+
+    mutable std::shared_mutex mtx_;
+    Data data_;
+
+    bool rebuilding_ = false;
+    std::vector<Change> journal_;
+};
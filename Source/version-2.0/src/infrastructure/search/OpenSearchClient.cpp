@@ -1,81 +1,67 @@
 #include "OpenSearchClient.h"
 #include <iostream>
+#include <stdexcept>
+#include <utility>
 
 using json = nlohmann::json;
 
-OpenSearchClient::OpenSearchClient(const std::string& baseUrl,
-                                   const std::optional<std::string>& apiKey)
-    : baseUrl_(baseUrl), apiKey_(apiKey) {
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-    curl_ = curl_easy_init();
+namespace {
+
+// The index's refresh_interval; a write is searchable once a refresh has
+// run after it. The margin covers the refresh itself.
+constexpr std::chrono::milliseconds kRefreshInterval{1000};
+constexpr std::chrono::milliseconds kRefreshMargin{250};
+
 }
 
-OpenSearchClient::~OpenSearchClient() {
-    if (curl_) curl_easy_cleanup(curl_);
-    curl_global_cleanup();
+OpenSearchClient::OpenSearchClient(const std::string& baseUrl,
+                                   const std::optional<std::string>& apiKey,
+                                   std::shared_ptr<HttpTransport> transport)
+    : baseUrl_(baseUrl), apiKey_(apiKey),
+      transport_(transport ? std::move(transport) : std::make_shared<HttpTransport>()) {
+    refreshNotifier_ = std::thread([this] { refreshNotifyLoop(); });
 }
 
-size_t OpenSearchClient::writeCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    size_t realSize = size * nmemb;
-    reinterpret_cast<std::string*>(userp)->append((char*)contents, realSize);
-    return realSize;
+OpenSearchClient::~OpenSearchClient() {
+    {
+        std::scoped_lock lock(refreshMutex_);
+        stopping_ = true;
+    }
+    refreshCv_.notify_all();
+    refreshNotifier_.join();
 }
 
 bool OpenSearchClient::sendRequest(const std::string& endpoint,
                                    const std::string& method,
                                    const std::string& body,
-                                   std::string& response) {
-    std::lock_guard<std::mutex> lock(curlMutex_);
-
-    if (!curl_) return false;
-    curl_easy_reset(curl_);
-
-    std::string url = baseUrl_ + endpoint;
-
-    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl_, CURLOPT_CUSTOMREQUEST, method.c_str());
-
-    // Timeouts
-    curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT_MS, 3000);
-    curl_easy_setopt(curl_, CURLOPT_TIMEOUT_MS, 5000);
-
-    // Response handler
-    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, writeCallback);
-    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response);
-
-    // Body
-    if (method == "POST" || method == "PUT") {
-        curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, body.c_str());
-        curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE, body.size());
-    }
-
-    // Headers
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-
-    if (apiKey_.has_value()) {
-        std::string authHeader = "Authorization: ApiKey " + apiKey_.value();
-        headers = curl_slist_append(headers, authHeader.c_str());
-    }
-
-    curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers);
-
-    // Perform
-    CURLcode res = curl_easy_perform(curl_);
-    curl_slist_free_all(headers);
-
-    if (res != CURLE_OK) {
-        std::cerr << "[OpenSearch] CURL error: " << curl_easy_strerror(res) << "\n";
+                                   std::string& response,
+                                   long* status) {
+    HttpRequest request;
+    request.method = method;
+    request.url = baseUrl_ + endpoint;
+    request.connectTimeoutMs = 3000;
+    request.timeoutMs = 5000;
+    if (method == "POST" || method == "PUT") request.body = body;
+
+    request.headers.push_back("Content-Type: application/json");
+    if (apiKey_.has_value())
+        request.headers.push_back("Authorization: ApiKey " + apiKey_.value());
+
+    HttpResponse result = transport_->perform(request);
+    response = std::move(result.body);
+
+    if (result.curlCode != CURLE_OK) {
+        std::cerr << "[OpenSearch] CURL error: " << result.error << "\n";
+        if (status) *status = 0;
         return false;
     }
 
-    // Check status
-    long status = 0;
-    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &status);
+    if (status) *status = result.status;
 
-    if (status < 200 || status >= 300) {
-        std::cerr << "[OpenSearch] HTTP error: " << status << "\n"
-                  << "Response: " << response << "\n";
+    if (result.status < 200 || result.status >= 300) {
+        if (!status)
+            std::cerr << "[OpenSearch] HTTP error: " << result.status << "\n"
+                      << "Response: " << response << "\n";
         return false;
     }
 
@@ -94,18 +80,26 @@ bool OpenSearchClient::indexMedia(int id,
     };
 
     std::string resp;
-    return sendRequest("/media/_doc/" + std::to_string(id),
-                       "PUT",
-                       body.dump(),
-                       resp);
+    writeShadow(std::to_string(id), body);
+    bool ok = sendRequest("/media/_doc/" + std::to_string(id),
+                          "PUT",
+                          body.dump(),
+                          resp);
+    notifyIndexed({body});
+    notifyUnrefreshedWrite();
+    return ok;
 }
 
 bool OpenSearchClient::deleteMedia(int id) {
     std::string resp;
-    return sendRequest("/media/_doc/" + std::to_string(id),
-                       "DELETE",
-                       "",
-                       resp);
+    writeShadow(std::to_string(id), {{"id", id}, {"deleted", true}});
+    bool ok = sendRequest("/media/_doc/" + std::to_string(id),
+                          "DELETE",
+                          "",
+                          resp);
+    notifyDeleted(id);
+    notifyUnrefreshedWrite();
+    return ok;
 }
 
 std::vector<json> OpenSearchClient::searchMedia(const std::string& query) {
@@ -138,10 +132,9 @@ std::vector<json> OpenSearchClient::searchMedia(const std::string& query) {
     return results;
 }
 
-std::vector<json> OpenSearchClient::fuzzySearch(const std::string& query,
-                                                const std::string& fuzziness,
-                                                int from, int size) {
-    json q = {
+json OpenSearchClient::fuzzyQuery(const std::string& query, const std::string& fuzziness,
+                                  int from, int size) {
+    return {
         {"from", from},
         {"size", size},
         {"query", {
@@ -170,14 +163,18 @@ std::vector<json> OpenSearchClient::fuzzySearch(const std::string& query,
             }}
         }}
     };
+}
 
+std::vector<json> OpenSearchClient::fuzzySearch(const std::string& query,
+                                                const std::string& fuzziness,
+                                                int from, int size) {
     std::string resp;
-    if (!sendRequest("/media/_search", "POST", q.dump(), resp))
-        return {};
+    if (!sendRequest("/media/_search", "POST", fuzzyQuery(query, fuzziness, from, size).dump(), resp))
+        throw std::runtime_error("Search request failed");
 
     json parsed = json::parse(resp, nullptr, false);
     if (parsed.is_discarded())
-        return {};
+        throw std::runtime_error("Search returned an unreadable response");
 
     std::vector<json> results;
     if (parsed.contains("hits") && parsed["hits"].contains("hits")) {
@@ -213,11 +210,11 @@ std::vector<std::string> OpenSearchClient::autoSuggest(const std::string& prefix
 
     std::string resp;
     if (!sendRequest("/media/_search", "POST", q.dump(), resp))
-        return {};
+        throw std::runtime_error("Suggest request failed");
 
     json parsed = json::parse(resp, nullptr, false);
     if (parsed.is_discarded())
-        return {};
+        throw std::runtime_error("Suggest returned an unreadable response");
 
     std::vector<std::string> suggestions;
     if (parsed.contains("suggest") && parsed["suggest"].contains("media-suggest")) {
@@ -233,11 +230,13 @@ std::vector<std::string> OpenSearchClient::autoSuggest(const std::string& prefix
     return suggestions;
 }
 
-bool OpenSearchClient::createIndexWithMapping() {
-    json mapping = {
+json OpenSearchClient::indexDefinition(bool bulkLoad) {
+    return {
         {"settings", {
             {"number_of_shards", 1},
-            {"number_of_replicas", 1},
+            // Bulk loads skip replicas and refreshes; finishBulkLoad restores them
+            {"number_of_replicas", bulkLoad ? 0 : 1},
+            {"refresh_interval", bulkLoad ? "-1" : "1s"},
             {"analysis", {
                 {"analyzer", {
                     {"autocomplete_analyzer", {
@@ -271,6 +270,8 @@ bool OpenSearchClient::createIndexWithMapping() {
                 }},
                 {"author", {{"type", "text"}}},
                 {"category", {{"type", "keyword"}}},
+                // Tombstones of documents deleted during a reindex
+                {"deleted", {{"type", "boolean"}}},
                 {"suggest", {
                     {"type", "completion"},
                     {"analyzer", "simple"}
@@ -279,19 +280,289 @@ bool OpenSearchClient::createIndexWithMapping() {
         }}
     };
 
+}
+
+bool OpenSearchClient::createIndexWithMapping() {
+    auto targets = aliasTargets();
+    if (!targets) return false;
+    // Already set up, either behind the alias or as a pre-alias index
+    if (!targets->indices.empty()) return true;
+
+    std::string first = std::string(kAlias) + "_v1";
+    return createIndex(first) && swapAlias(first, *targets);
+}
+
+std::optional<OpenSearchClient::AliasTargets> OpenSearchClient::aliasTargets() {
     std::string resp;
-    return sendRequest("/media", "PUT", mapping.dump(), resp);
+    long status = 0;
+    if (!sendRequest("/" + std::string(kAlias) + "/_alias", "GET", "", resp, &status)) {
+        if (status == 404) return AliasTargets{};
+        std::cerr << "[OpenSearch] Could not resolve alias " << kAlias << ": HTTP " << status << "\n";
+        return std::nullopt;
+    }
+
+    json parsed = json::parse(resp, nullptr, false);
+    if (parsed.is_discarded() || !parsed.is_object()) return std::nullopt;
+
+    // Keyed by concrete index name; a concrete "media" index means no alias yet
+    AliasTargets targets;
+    targets.isAlias = true;
+    for (auto& [name, _] : parsed.items()) {
+        targets.indices.push_back(name);
+        if (name == kAlias) targets.isAlias = false;
+    }
+    return targets;
 }
 
-bool OpenSearchClient::bulkIndex(const std::vector<json>& docs) {
-    std::string body;
+bool OpenSearchClient::createIndex(const std::string& name, bool bulkLoad) {
+    std::string resp;
+    return sendRequest("/" + name, "PUT", indexDefinition(bulkLoad).dump(), resp);
+}
+
+bool OpenSearchClient::finishBulkLoad(const std::string& name) {
+    json settings = {{"index", {{"number_of_replicas", 1}, {"refresh_interval", "1s"}}}};
+    std::string resp;
+    return sendRequest("/" + name + "/_settings", "PUT", settings.dump(), resp)
+        && sendRequest("/" + name + "/_refresh", "POST", "", resp);
+}
 
-    for (const auto& d : docs) {
-        body += R"({"index":{"_index":"media","_id":")" 
-             + std::to_string(d["id"].get<int>()) + R"("}})" "\n";
-        body += d.dump() + "\n";
+bool OpenSearchClient::deleteIndex(const std::string& name) {
+    std::string resp;
+    long status = 0;
+    bool ok = sendRequest("/" + name, "DELETE", "", resp, &status) || status == 404;
+    // Its aliases went with it
+    if (ok) {
+        std::scoped_lock lock(shadowMutex_);
+        if (shadow_ == name) shadow_.reset();
+    }
+    return ok;
+}
+
+bool OpenSearchClient::swapAlias(const std::string& newIndex, const AliasTargets& previous) {
+    json actions = json::array();
+    actions.push_back({{"add", {{"index", newIndex}, {"alias", kAlias}}}});
+    // Live writes stop going through the shadow alias exactly when they
+    // start reaching newIndex through the main one
+    bool dropsShadow = shadowIndex() == newIndex;
+    if (dropsShadow)
+        actions.push_back({{"remove", {{"index", newIndex}, {"alias", kShadowAlias}}}});
+    for (const auto& old : previous.indices) {
+        if (old == newIndex) continue;
+        // A concrete index named like the alias has to go in the same call
+        if (previous.isAlias)
+            actions.push_back({{"remove", {{"index", old}, {"alias", kAlias}}}});
+        else
+            actions.push_back({{"remove_index", {{"index", old}}}});
     }
 
     std::string resp;
-    return sendRequest("/_bulk", "POST", body, resp);
+    bool ok = sendRequest("/_aliases", "POST", json{{"actions", actions}}.dump(), resp);
+    if (ok && dropsShadow) rememberShadow(std::nullopt);
+    // Shadow writes since finishBulkLoad are not searchable yet
+    if (ok) sendRequest("/" + newIndex + "/_refresh", "POST", "", resp);
+    notifyWrite();
+    return ok;
+}
+
+void OpenSearchClient::setWriteListener(std::function<void()> listener) {
+    std::lock_guard<std::mutex> lock(listenerMutex_);
+    writeListener_ = std::move(listener);
+}
+
+void OpenSearchClient::notifyWrite() {
+    std::function<void()> listener;
+    {
+        std::lock_guard<std::mutex> lock(listenerMutex_);
+        listener = writeListener_;
+    }
+    if (listener) listener();
+}
+
+void OpenSearchClient::notifyUnrefreshedWrite() {
+    // A search between now and the refresh can still cache the old result;
+    // the second call drops it
+    notifyWrite();
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::scoped_lock lock(refreshMutex_);
+        lastUnrefreshedWrite_ = now;
+        if (refreshNotifyAt_) return;
+        refreshNotifyAt_ = now + kRefreshInterval + kRefreshMargin;
+    }
+    refreshCv_.notify_one();
+}
+
+void OpenSearchClient::refreshNotifyLoop() {
+    std::unique_lock lock(refreshMutex_);
+    while (!stopping_) {
+        if (!refreshNotifyAt_) {
+            refreshCv_.wait(lock);
+            continue;
+        }
+        auto due = *refreshNotifyAt_;
+        if (std::chrono::steady_clock::now() < due) {
+            refreshCv_.wait_until(lock, due);
+            continue;
+        }
+        // Writes after the one this call was scheduled for get one more
+        auto covered = due - kRefreshInterval - kRefreshMargin;
+        if (lastUnrefreshedWrite_ > covered)
+            refreshNotifyAt_ = lastUnrefreshedWrite_ + kRefreshInterval + kRefreshMargin;
+        else
+            refreshNotifyAt_.reset();
+        lock.unlock();
+        notifyWrite();
+        lock.lock();
+    }
+}
+
+void OpenSearchClient::setDocumentListener(std::function<void(const std::vector<json>&)> onIndexed,
+                                           std::function<void(long)> onDeleted) {
+    std::lock_guard<std::mutex> lock(listenerMutex_);
+    onIndexed_ = std::move(onIndexed);
+    onDeleted_ = std::move(onDeleted);
+}
+
+void OpenSearchClient::notifyIndexed(const std::vector<json>& docs) {
+    std::function<void(const std::vector<json>&)> listener;
+    {
+        std::lock_guard<std::mutex> lock(listenerMutex_);
+        listener = onIndexed_;
+    }
+    if (listener) listener(docs);
+}
+
+void OpenSearchClient::notifyDeleted(long id) {
+    std::function<void(long)> listener;
+    {
+        std::lock_guard<std::mutex> lock(listenerMutex_);
+        listener = onDeleted_;
+    }
+    if (listener) listener(id);
+}
+
+bool OpenSearchClient::setShadowIndex(const std::string& index) {
+    json actions = json::array();
+    actions.push_back({{"add", {{"index", index}, {"alias", kShadowAlias}}}});
+    // One reindex at a time: a stale alias from an interrupted run is moved
+    if (auto previous = shadowIndex(); previous && *previous != index)
+        actions.push_back({{"remove", {{"index", *previous}, {"alias", kShadowAlias}}}});
+    std::string resp;
+    bool ok = sendRequest("/_aliases", "POST", json{{"actions", actions}}.dump(), resp);
+    if (ok) rememberShadow(index);
+    return ok;
+}
+
+std::optional<std::string> OpenSearchClient::shadowIndex(bool* ok) {
+    std::string resp;
+    long status = 0;
+    bool found = sendRequest("/_alias/" + std::string(kShadowAlias), "GET", "", resp, &status);
+    if (ok) *ok = found || status == 404;
+    if (!found) return std::nullopt;
+    json parsed = json::parse(resp, nullptr, false);
+    if (parsed.is_discarded() || !parsed.is_object() || parsed.empty()) {
+        if (ok) *ok = false;
+        return std::nullopt;
+    }
+    return parsed.begin().key();
+}
+
+std::optional<std::string> OpenSearchClient::knownShadow() {
+    // Stamped before the lookup, so a shadow set while it is in flight is
+    // seen by the next one within the interval
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::milliseconds refresh;
+    {
+        std::scoped_lock lock(shadowMutex_);
+        if (now < shadowExpires_) return shadow_;
+        refresh = shadowRefresh_;
+    }
+
+    bool ok = false;
+    auto index = shadowIndex(&ok);
+    std::scoped_lock lock(shadowMutex_);
+    // A failed lookup keeps what was known and is retried after the
+    // interval; state stored after this lookup started is newer
+    if (shadowExpires_ > now + refresh) return shadow_;
+    if (ok) shadow_ = std::move(index);
+    shadowExpires_ = now + refresh;
+    return shadow_;
+}
+
+void OpenSearchClient::rememberShadow(std::optional<std::string> index) {
+    std::scoped_lock lock(shadowMutex_);
+    shadow_ = std::move(index);
+    shadowExpires_ = std::chrono::steady_clock::now() + shadowRefresh_;
+}
+
+void OpenSearchClient::setShadowRefreshInterval(std::chrono::milliseconds interval) {
+    std::scoped_lock lock(shadowMutex_);
+    shadowRefresh_ = interval;
+    shadowExpires_ = {};
+}
+
+std::chrono::milliseconds OpenSearchClient::shadowRefreshInterval() const {
+    std::scoped_lock lock(shadowMutex_);
+    return shadowRefresh_;
+}
+
+void OpenSearchClient::writeShadow(const std::string& id, const json& doc) {
+    if (!knownShadow()) return;
+    // require_alias keeps a write from creating a "media_shadow" index
+    // when the reindex has finished since the last lookup
+    std::string resp;
+    long status = 0;
+    sendRequest("/" + std::string(kShadowAlias) + "/_doc/" + id + "?require_alias=true",
+                "PUT", doc.dump(), resp, &status);
+    if (status != 0 && status != 404 && (status < 200 || status >= 300))
+        std::cerr << "[OpenSearch] Shadow write of " << id << " failed: HTTP " << status << "\n";
+}
+
+bool OpenSearchClient::purgeTombstones(const std::string& index) {
+    json query = {{"query", {{"term", {{"deleted", true}}}}}};
+    std::string resp;
+    return sendRequest("/" + index + "/_delete_by_query?refresh=true&conflicts=proceed", "POST",
+                       query.dump(), resp);
+}
+
+std::unique_ptr<BulkIndexer> OpenSearchClient::createBulkIndexer(const std::string& index,
+                                                                const std::string& opType) const {
+    BulkIndexerOptions options = bulkOptions_;
+    options.index = index;
+    options.opType = opType;
+    return std::make_unique<BulkIndexer>(baseUrl_, apiKey_, options);
+}
+
+std::shared_ptr<BulkIndexer> OpenSearchClient::sharedBulkIndexer(const std::string& index) {
+    std::lock_guard<std::mutex> lock(bulkMutex_);
+    auto& indexer = bulkIndexers_[index];
+    if (!indexer) {
+        BulkIndexerOptions options = bulkOptions_;
+        options.index = index;
+        options.requireAlias = index == kShadowAlias;
+        indexer = std::make_shared<BulkIndexer>(baseUrl_, apiKey_, options);
+    }
+    return indexer;
+}
+
+bool OpenSearchClient::bulkIndex(const std::vector<json>& docs) {
+    if (docs.empty()) return true;
+
+    // Through the alias, so a reindex finishing meanwhile cannot make this
+    // recreate a dropped index
+    if (knownShadow()) sharedBulkIndexer(kShadowAlias)->index(docs);
+    bool ok = sharedBulkIndexer(kAlias)->index(docs).failed == 0;
+    // One refresh for the whole call rather than refresh=wait_for on each
+    // batch, which would hold every request up to a refresh interval
+    std::string resp;
+    sendRequest("/" + std::string(kAlias) + "/_refresh", "POST", "", resp);
+    notifyIndexed(docs);
+    notifyWrite();
+    return ok;
+}
+
+void OpenSearchClient::setBulkOptions(const BulkIndexerOptions& options) {
+    std::lock_guard<std::mutex> lock(bulkMutex_);
+    bulkOptions_ = options;
+    bulkIndexers_.clear();
 }
@@ -1,16 +1,24 @@
 #pragma once
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <mutex>
 #include <optional>
+#include <thread>
 #include <nlohmann/json.hpp>
-#include <curl/curl.h>
+#include "src/infrastructure/http/HttpTransport.h"
+#include "src/infrastructure/search/BulkIndexer.h"
 
 class OpenSearchClient {
 public:
+    // Without a transport the client gets its own connection pool
     OpenSearchClient(const std::string& baseUrl,
-                     const std::optional<std::string>& apiKey = std::nullopt);
-
+                     const std::optional<std::string>& apiKey = std::nullopt,
+                     std::shared_ptr<HttpTransport> transport = nullptr);
     ~OpenSearchClient();
 
     bool indexMedia(int id,
@@ -22,31 +30,138 @@ public:
 
     std::vector<nlohmann::json> searchMedia(const std::string& query);
 
-    // Fuzzy full-text search with configurable fuzziness
+    // Fuzzy full-text search with configurable fuzziness; throws if
+    // OpenSearch cannot be reached or answers with an error
     std::vector<nlohmann::json> fuzzySearch(const std::string& query,
                                             const std::string& fuzziness = "AUTO",
                                             int from = 0, int size = 10);
 
-    // Auto-suggest / completion
+    // The _search body fuzzySearch sends
+    static nlohmann::json fuzzyQuery(const std::string& query, const std::string& fuzziness,
+                                     int from, int size);
+
+    // Auto-suggest / completion; throws like fuzzySearch
     std::vector<std::string> autoSuggest(const std::string& prefix, int maxResults = 5);
 
-    // Setup index with completion mapping (call once on startup)
+    // Setup index with completion mapping (call once on startup).
+    // "media" is an alias over a versioned index (media_v1, media_v2, ...)
+    // so a reindex can replace the index without downtime.
     bool createIndexWithMapping();
 
-    // Bulk indexing
+    // --- Reindexing ---
+    static constexpr const char* kAlias = "media";
+    // Points at the index a reindex is loading. Every instance writes
+    // through it, so documents changed during the run reach the new index.
+    static constexpr const char* kShadowAlias = "media_shadow";
+
+    // Indices currently behind the alias; a pre-alias deployment reports
+    // its concrete "media" index with isAlias = false
+    struct AliasTargets {
+        std::vector<std::string> indices;
+        bool isAlias = false;
+    };
+    std::optional<AliasTargets> aliasTargets();
+
+    // Creates an index with the media mapping. bulkLoad turns off refresh
+    // and replicas until finishBulkLoad.
+    bool createIndex(const std::string& name, bool bulkLoad = false);
+    bool finishBulkLoad(const std::string& name);
+    bool deleteIndex(const std::string& name);
+
+    // Points the alias at newIndex and detaches or deletes the old indices
+    // in one _aliases call. The shadow alias is removed in the same call.
+    bool swapAlias(const std::string& newIndex, const AliasTargets& previous);
+
+    // Points the shadow alias at index. From then on live writes on every
+    // instance also go there: documents are overwritten, and deletes leave
+    // a {"deleted": true} tombstone so an older copy loaded with op_type
+    // create cannot bring the document back. Other instances notice within
+    // shadowRefreshInterval().
+    bool setShadowIndex(const std::string& index);
+    // Drops the tombstones left in index while it was the shadow
+    bool purgeTombstones(const std::string& index);
+
+    // Indexer for one index, with the client's bulk options. "create" loads
+    // a snapshot under live writes: a 409 means a newer copy is there.
+    std::unique_ptr<BulkIndexer> createBulkIndexer(const std::string& index,
+                                                   const std::string& opType = "index") const;
+
+    // Bulk indexing through the client's long-lived indexer for the alias
+    // (and the shadow index); false if any document was rejected
     bool bulkIndex(const std::vector<nlohmann::json>& docs);
 
+    // Batch size and parallelism used by bulkIndex; set before the first use
+    void setBulkOptions(const BulkIndexerOptions& options);
+
+    // Writes go through the shadow alias only while the client knows of
+    // one. What it knows is looked up again once this much time has passed
+    // (default 5s), so a reindex waits this long after setShadowIndex
+    // before it takes its snapshot.
+    void setShadowRefreshInterval(std::chrono::milliseconds interval);
+    std::chrono::milliseconds shadowRefreshInterval() const;
+
+    // Called after every write to the alias (single documents, bulkIndex and
+    // alias swaps), whether or not it succeeded, so caches can invalidate.
+    // bulkIndex and swapAlias refresh the index and call it once the write
+    // is visible to searches. A single document is not refreshed: the
+    // listener runs when the write is acknowledged and again once the
+    // refresh interval has made it visible, so a result cached in between
+    // does not outlive it. At most one such later call is pending.
+    void setWriteListener(std::function<void()> listener);
+
+    // Receives every document written to the alias and the id of every
+    // deleted one, so in-process indices can follow the catalogue
+    void setDocumentListener(std::function<void(const std::vector<nlohmann::json>&)> onIndexed,
+                             std::function<void(long)> onDeleted);
+
 private:
+    // status, when given, receives the HTTP status and suppresses error logging
     bool sendRequest(const std::string& endpoint,
                      const std::string& method,
                      const std::string& body,
-                     std::string& response);
+                     std::string& response,
+                     long* status = nullptr);
 
-    static size_t writeCallback(void* contents, size_t size, size_t nmemb, void* userp);
+    static nlohmann::json indexDefinition(bool bulkLoad);
+    // Index behind the shadow alias, read from OpenSearch. ok, when given,
+    // is false if OpenSearch could not say.
+    std::optional<std::string> shadowIndex(bool* ok = nullptr);
+    // The shadow index as last looked up, refreshed once the interval is up
+    std::optional<std::string> knownShadow();
+    void rememberShadow(std::optional<std::string> index);
+    // Writes to the shadow alias while one is known
+    void writeShadow(const std::string& id, const nlohmann::json& doc);
+    std::shared_ptr<BulkIndexer> sharedBulkIndexer(const std::string& index);
+    void notifyWrite();
+    // notifyWrite now and again after the refresh interval
+    void notifyUnrefreshedWrite();
+    void refreshNotifyLoop();
+    void notifyIndexed(const std::vector<nlohmann::json>& docs);
+    void notifyDeleted(long id);
 
 private:
     std::string baseUrl_;
     std::optional<std::string> apiKey_;
-    CURL* curl_;
-    std::mutex curlMutex_;
+    BulkIndexerOptions bulkOptions_;
+    std::function<void()> writeListener_;
+    std::function<void(const std::vector<nlohmann::json>&)> onIndexed_;
+    std::function<void(long)> onDeleted_;
+    std::mutex listenerMutex_;
+    std::shared_ptr<HttpTransport> transport_;
+    // bulkIndex's indexers for the alias and the shadow alias; each keeps
+    // its sender thread and connections for the life of the client
+    std::unordered_map<std::string, std::shared_ptr<BulkIndexer>> bulkIndexers_;
+    std::mutex bulkMutex_;
+    // Shadow alias state; stale after shadowExpires_
+    std::optional<std::string> shadow_;
+    std::chrono::steady_clock::time_point shadowExpires_{};
+    std::chrono::milliseconds shadowRefresh_{5000};
+    mutable std::mutex shadowMutex_;
+    // Pending notifyWrite for single-document writes not yet refreshed
+    std::optional<std::chrono::steady_clock::time_point> refreshNotifyAt_;
+    std::chrono::steady_clock::time_point lastUnrefreshedWrite_{};
+    bool stopping_ = false;
+    std::mutex refreshMutex_;
+    std::condition_variable refreshCv_;
+    std::thread refreshNotifier_;
 };
@@ -0,0 +1,321 @@
+#include "DiskCache.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
+#include "src/infrastructure/storage/SigV4Signer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t kSliceBytes = 1024 * 1024;
+
+}
+
+DiskCache::DiskCache(std::shared_ptr<S3StorageClient> storage, Options options)
+    : storage_(std::move(storage)), options_(std::move(options)),
+      objectsDir_(options_.directory + "/objects"), tmpDir_(options_.directory + "/tmp"),
+      hits_(MetricsRegistry::instance().counter(
+          "disk_cache_hits_total", "Object reads served from the local disk cache")),
+      misses_(MetricsRegistry::instance().counter(
+          "disk_cache_misses_total", "Object reads not in the local disk cache")),
+      rejected_(MetricsRegistry::instance().counter(
+          "disk_cache_rejected_total", "Misses the admission policy kept out of the disk cache")),
+      evictions_(MetricsRegistry::instance().counter(
+          "disk_cache_evictions_total", "Objects evicted from the disk cache")),
+      revalidations_(MetricsRegistry::instance().counter(
+          "disk_cache_revalidations_total", "Cached objects confirmed current with a HEAD")),
+      bytesGauge_(MetricsRegistry::instance().gauge(
+          "disk_cache_bytes", "Bytes held in the disk cache")),
+      fillPool_(options_.fillThreads) {
+    options_.maxObjectBytes = std::min(options_.maxObjectBytes, options_.maxBytes);
+    load();
+    purger_ = std::thread([this] { purgeLoop(); });
+}
+
+DiskCache::~DiskCache() {
+    {
+        std::scoped_lock lock(mtx_);
+        stopping_ = true;
+    }
+    purgeCv_.notify_all();
+    purger_.join();
+    // Files still retired are orphans now; load() removes them next time
+}
+
+void DiskCache::load() {
+    fs::create_directories(objectsDir_);
+    fs::remove_all(tmpDir_);
+    fs::create_directories(tmpDir_);
+
+    struct Found {
+        fs::file_time_type mtime;
+        std::string key;
+        Entry entry;
+    };
+    std::vector<Found> found;
+    std::vector<fs::path> orphans;
+    for (const auto& file : fs::recursive_directory_iterator(objectsDir_)) {
+        if (!file.is_regular_file()) continue;
+        if (file.path().extension() != ".meta") {
+            // Evicted, or written by a fill that never finished
+            if (!fs::exists(file.path().string() + ".meta")) orphans.push_back(file.path());
+            continue;
+        }
+        std::string metaPath = file.path().string();
+        std::string dataPath = metaPath.substr(0, metaPath.size() - 5);
+        std::ifstream in(metaPath);
+        auto meta = nlohmann::json::parse(in, nullptr, false);
+        std::error_code ec;
+        auto size = fs::file_size(dataPath, ec);
+        if (meta.is_discarded() || ec || meta.value("size", uint64_t{0}) != size || meta.value("key", "").empty()) {
+            fs::remove(metaPath, ec);
+            fs::remove(dataPath, ec);
+            continue;
+        }
+        Entry entry{dataPath, meta.value("etag", ""), meta.value("content_type", ""), size};
+        found.push_back({fs::last_write_time(dataPath, ec), meta.value("key", ""), std::move(entry)});
+    }
+
+    for (const auto& orphan : orphans) {
+        std::error_code ec;
+        fs::remove(orphan, ec);
+    }
+
+    // Oldest first, so they end up at the back of the LRU. Loaded entries
+    // are revalidated on first use.
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.mtime < b.mtime; });
+    for (const auto& f : found) insert(f.key, f.entry, Clock::time_point{});
+    if (!found.empty()) {
+        std::cout << "[DiskCache] Loaded " << slots_.size() << " objects (" << bytes_ / (1024 * 1024)
+                  << " MiB) from " << options_.directory << "." << std::endl;
+    }
+}
+
+DiskCache::Lookup DiskCache::get(const std::string& key) {
+    if (options_.admission) options_.admission->recordAccess(key);
+
+    Lookup result;
+    std::optional<Entry> stale;
+    {
+        std::scoped_lock lock(mtx_);
+        auto it = slots_.find(key);
+        if (it != slots_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second.lru);
+            if (Clock::now() - it->second.validated < options_.revalidateAfter) {
+                hits_.inc();
+                result.local = it->second.entry;
+                return result;
+            }
+            stale = it->second.entry;
+        }
+    }
+
+    result.head = storage_->headObject(key);
+    const auto& object = result.head.object;
+    if (stale) {
+        // S3 unreachable or erroring: the local copy is the best answer there is
+        bool unanswered = !object && result.head.status != 404;
+        if (unanswered || (object && object->etag == stale->etag)) {
+            if (object) {
+                std::scoped_lock lock(mtx_);
+                if (auto it = slots_.find(key); it != slots_.end()) it->second.validated = Clock::now();
+                revalidations_.inc();
+            }
+            hits_.inc();
+            result.local = std::move(stale);
+            return result;
+        }
+        // Replaced, or deleted from S3
+        erase(key);
+    }
+    misses_.inc();
+    if (object && object->size > 0 && object->size <= options_.maxObjectBytes) fill(key, *object);
+    return result;
+}
+
+void DiskCache::fill(const std::string& key, const S3Object& object) {
+    {
+        std::scoped_lock lock(mtx_);
+        // Being downloaded, or cached by a fill that finished during the HEAD
+        if (slots_.count(key) || !filling_.insert(key).second) return;
+    }
+    if (!reserve(key, object.size)) {
+        rejected_.inc();
+        std::scoped_lock lock(mtx_);
+        filling_.erase(key);
+        return;
+    }
+    fillPool_.submit([this, key, object] {
+        try {
+            if (auto entry = fetch(key, object)) insert(key, *entry, Clock::now());
+        } catch (const std::exception& e) {
+            std::cerr << "[DiskCache] Fill of " << key << " failed: " << e.what() << std::endl;
+        }
+        std::scoped_lock lock(mtx_);
+        filling_.erase(key);
+    });
+}
+
+std::optional<DiskCache::Entry> DiskCache::fetch(const std::string& key, const S3Object& object) {
+    std::string tmp = tmpDir_ + "/fill-" + std::to_string(tmpSeq_++);
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "[DiskCache] Cannot create " << tmp << ": " << std::strerror(errno) << std::endl;
+        return std::nullopt;
+    }
+
+    uint64_t written = 0;
+    auto res = storage_->downloadStream(key, std::nullopt, object.etag, [&](std::string_view chunk) {
+        if (stopping_) return false;
+        while (!chunk.empty()) {
+            ssize_t n = ::write(fd, chunk.data(), chunk.size());
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            chunk.remove_prefix(static_cast<size_t>(n));
+            written += static_cast<uint64_t>(n);
+        }
+        return true;
+    });
+    ::close(fd);
+
+    std::error_code ec;
+    if (!res.ok() || written != object.size) {
+        fs::remove(tmp, ec);
+        return std::nullopt;
+    }
+
+    // Named by key and ETag; the first two hex digits fan out directories
+    std::string name = SigV4Signer::sha256Hex(key + '\n' + object.etag);
+    std::string dir = objectsDir_ + "/" + name.substr(0, 2);
+    std::string path = dir + "/" + name;
+    fs::create_directories(dir, ec);
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        std::cerr << "[DiskCache] Cannot store " << key << ": " << ec.message() << std::endl;
+        fs::remove(tmp, ec);
+        return std::nullopt;
+    }
+    std::ofstream(path + ".meta") << nlohmann::json{
+        {"key", key}, {"etag", object.etag}, {"content_type", object.contentType}, {"size", object.size}}.dump();
+
+    return Entry{path, object.etag, object.contentType, object.size};
+}
+
+bool DiskCache::reserve(const std::string& key, uint64_t bytes) {
+    std::scoped_lock lock(mtx_);
+    while (bytes_ + bytes > options_.maxBytes && !lru_.empty()) {
+        const std::string& victim = lru_.back();
+        if (options_.admission && !options_.admission->admit(key, victim)) return false;
+        evictions_.inc();
+        removeLocked(slots_.find(victim));
+    }
+    return true;
+}
+
+void DiskCache::insert(const std::string& key, const Entry& entry, Clock::time_point validated) {
+    std::scoped_lock lock(mtx_);
+    if (auto it = slots_.find(key); it != slots_.end()) {
+        if (it->second.entry.path == entry.path) {
+            it->second.validated = validated;
+            return;
+        }
+        removeLocked(it);
+    }
+    // Fills that raced past reserve() evict without asking admission
+    while (bytes_ + entry.size > options_.maxBytes && !lru_.empty()) {
+        evictions_.inc();
+        removeLocked(slots_.find(lru_.back()));
+    }
+    lru_.push_front(key);
+    slots_.emplace(key, Slot{entry, validated, lru_.begin()});
+    bytes_ += entry.size;
+    bytesGauge_.set(static_cast<double>(bytes_));
+}
+
+void DiskCache::erase(const std::string& key) {
+    std::scoped_lock lock(mtx_);
+    if (auto it = slots_.find(key); it != slots_.end()) removeLocked(it);
+}
+
+void DiskCache::removeLocked(std::unordered_map<std::string, Slot>::iterator it) {
+    std::error_code ec;
+    fs::remove(it->second.entry.path + ".meta", ec);
+    retireLocked(it->first, it->second.entry.path);
+    bytes_ -= it->second.entry.size;
+    lru_.erase(it->second.lru);
+    slots_.erase(it);
+    bytesGauge_.set(static_cast<double>(bytes_));
+}
+
+void DiskCache::retireLocked(const std::string& key, const std::string& path) {
+    // Deleted later, so a response that was handed the path can still open it
+    retired_.push_back({Clock::now(), key, path});
+    if (retired_.size() == 1) purgeCv_.notify_one();
+}
+
+void DiskCache::purgeLoop() {
+    std::unique_lock lock(mtx_);
+    while (!stopping_) {
+        if (retired_.empty()) {
+            purgeCv_.wait(lock);
+            continue;
+        }
+        auto due = retired_.front().at + options_.retireGrace;
+        if (Clock::now() < due) {
+            purgeCv_.wait_until(lock, due);
+            continue;
+        }
+        const Retired& r = retired_.front();
+        // Unless the same key and ETag has been cached again since
+        auto it = slots_.find(r.key);
+        std::error_code ec;
+        if (it == slots_.end() || it->second.entry.path != r.path) fs::remove(r.path, ec);
+        retired_.pop_front();
+    }
+}
+
+bool DiskCache::readRange(const std::string& path, uint64_t offset, uint64_t length, const HttpBodySink& sink) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || offset + length > static_cast<uint64_t>(st.st_size)) {
+        ::close(fd);
+        return false;
+    }
+    if (length == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    // mmap offsets must be page-aligned
+    static const uint64_t pageSize = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+    uint64_t aligned = offset - offset % pageSize;
+    size_t mapped = static_cast<size_t>(length + (offset - aligned));
+    void* base = ::mmap(nullptr, mapped, PROT_READ, MAP_PRIVATE, fd, static_cast<off_t>(aligned));
+    ::close(fd);
+    if (base == MAP_FAILED) return false;
+    ::madvise(base, mapped, MADV_SEQUENTIAL);
+
+    const char* data = static_cast<const char*>(base) + (offset - aligned);
+    bool ok = true;
+    for (uint64_t sent = 0; ok && sent < length;) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(kSliceBytes, length - sent));
+        ok = sink(std::string_view(data + sent, n));
+        sent += n;
+    }
+    ::munmap(base, mapped);
+    return ok;
+}
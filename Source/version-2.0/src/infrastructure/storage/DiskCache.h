@@ -0,0 +1,162 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include "src/infrastructure/storage/S3StorageClient.h"
+#include "src/utils/ThreadPool.h"
+#include "src/utils/TinyLfu.h"
+
+class Counter;
+class Gauge;
+
+// Decides whether a new object may take a cached object's place when the
+// disk cache is full
+class CacheAdmission {
+public:
+    virtual ~CacheAdmission() = default;
+    virtual void recordAccess(const std::string& key) = 0;
+    virtual bool admit(const std::string& candidate, const std::string& victim) = 0;
+};
+
+class AdmitAll : public CacheAdmission {
+public:
+    void recordAccess(const std::string&) override {}
+    bool admit(const std::string&, const std::string&) override { return true; }
+};
+
+// Admits a candidate only if it has been requested more often than the
+// object it would evict, so a scan of one-off downloads cannot flush the
+// popular ones
+class TinyLfuAdmission : public CacheAdmission {
+public:
+    explicit TinyLfuAdmission(size_t sampleSize) : sketch_(sampleSize) {}
+
+    void recordAccess(const std::string& key) override {
+        std::scoped_lock lock(mtx_);
+        sketch_.increment(std::hash<std::string>{}(key));
+    }
+
+    bool admit(const std::string& candidate, const std::string& victim) override {
+        std::scoped_lock lock(mtx_);
+        return sketch_.admit(std::hash<std::string>{}(candidate), std::hash<std::string>{}(victim));
+    }
+
+private:
+    std::mutex mtx_;
+    TinyLfu sketch_;
+};
+
+// Size-bounded LRU of S3 objects on local disk. Files are named by a hash
+// of the key and ETag, so a replaced object never reuses a stale file.
+// A hit within revalidateAfter of the last check does not touch S3. An
+// older one is checked with a HEAD and kept if the ETag still matches; if
+// S3 cannot be reached, the local copy is served, and if S3 no longer has
+// the object, it is evicted. A miss is served from S3 by the caller; if
+// admission lets the object in, it is downloaded in the background, once
+// however many misses there are. Evicted files are deleted after a grace
+// period. The index is rebuilt from the directory on startup.
+class DiskCache {
+public:
+    struct Options {
+        std::string directory;
+        uint64_t maxBytes = 10ULL * 1024 * 1024 * 1024;
+        uint64_t maxObjectBytes = 512ULL * 1024 * 1024;
+        std::chrono::seconds revalidateAfter{60};
+        // How long an evicted file stays readable by responses streaming it
+        std::chrono::milliseconds retireGrace{std::chrono::seconds(60)};
+        size_t fillThreads = 2;
+        // Null admits everything
+        std::shared_ptr<CacheAdmission> admission;
+    };
+
+    struct Entry {
+        std::string path;
+        std::string etag;
+        std::string contentType;
+        uint64_t size = 0;
+    };
+
+    // A validated local copy, or else the HEAD the lookup made, so the
+    // caller can read S3 without asking again. A fresh hit makes no HEAD.
+    struct Lookup {
+        std::optional<Entry> local;
+        S3HeadResult head;
+    };
+
+    DiskCache(std::shared_ptr<S3StorageClient> storage, Options options);
+    ~DiskCache();
+
+    DiskCache(const DiskCache&) = delete;
+    DiskCache& operator=(const DiskCache&) = delete;
+
+    Lookup get(const std::string& key);
+
+    void erase(const std::string& key);
+
+    // Sends [offset, offset + length) of a cached file to sink from a
+    // read-only mapping
+    static bool readRange(const std::string& path, uint64_t offset, uint64_t length, const HttpBodySink& sink);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Slot {
+        Entry entry;
+        Clock::time_point validated;
+        std::list<std::string>::iterator lru;
+    };
+
+    // Queues a background download of an admitted miss
+    void fill(const std::string& key, const S3Object& object);
+    std::optional<Entry> fetch(const std::string& key, const S3Object& object);
+    // Makes room for bytes; false if admission keeps the current objects
+    bool reserve(const std::string& key, uint64_t bytes);
+    void insert(const std::string& key, const Entry& entry, Clock::time_point validated);
+    void removeLocked(std::unordered_map<std::string, Slot>::iterator it);
+    void retireLocked(const std::string& key, const std::string& path);
+    void purgeLoop();
+    void load();
+
+    std::shared_ptr<S3StorageClient> storage_;
+    Options options_;
+    std::string objectsDir_;
+    std::string tmpDir_;
+
+    std::mutex mtx_;
+    std::unordered_map<std::string, Slot> slots_;
+    std::list<std::string> lru_;   // front is most recent
+    uint64_t bytes_ = 0;
+    // Evicted files stay on disk for a while, for responses still streaming
+    // them; the purge thread deletes them once their grace period is over
+    struct Retired {
+        Clock::time_point at;
+        std::string key;
+        std::string path;
+    };
+    std::deque<Retired> retired_;
+    std::unordered_set<std::string> filling_;
+    std::atomic<uint64_t> tmpSeq_{0};
+    std::atomic<bool> stopping_{false};
+    std::condition_variable purgeCv_;
+    std::thread purger_;
+
+    Counter& hits_;
+    Counter& misses_;
+    Counter& rejected_;
+    Counter& evictions_;
+    Counter& revalidations_;
+    Gauge& bytesGauge_;
+
+    // Last, so it is stopped before the state its fills use is destroyed
+    ThreadPool fillPool_;
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <charconv>
+#include <string>
+#include <string_view>
+#include "src/infrastructure/storage/S3StorageClient.h"
+#include "src/utils/XmlStream.h"
+
+// One page of a ListObjectsV2 or ListObjectVersions reply. Entries go to
+// the visitors as their closing tag is parsed. The visitors are held by
+// reference and must outlive the page.
+class ListingPage {
+public:
+    ListingPage(const S3StorageClient::VersionVisitor& onEntry, const S3StorageClient::PrefixVisitor& onPrefix)
+        : onEntry_(onEntry), onPrefix_(onPrefix),
+          xml_([this](std::string_view name) { start(name); },
+               [this](std::string_view name, std::string_view text) { end(name, text); }) {}
+
+    ListingPage(const ListingPage&) = delete;
+    ListingPage& operator=(const ListingPage&) = delete;
+
+    // False to abort the transfer
+    bool feed(std::string_view chunk) { return xml_.feed(chunk) && !stopped_; }
+
+    bool stopped() const { return stopped_; }
+    bool complete() const { return xml_.complete(); }
+
+    bool truncated = false;
+    std::string continuationToken;
+    std::string keyMarker;
+    std::string versionIdMarker;
+
+private:
+    void start(std::string_view name) {
+        if (xml_.depth() == 2 && (name == "Contents" || name == "Version" || name == "DeleteMarker")) {
+            entry_ = S3ObjectVersion{};
+            entry_.object.size = 0;
+            entry_.deleteMarker = name == "DeleteMarker";
+            inEntry_ = true;
+        }
+    }
+
+    void end(std::string_view name, std::string_view text) {
+        if (stopped_) return;
+        if (xml_.depth() == 3 && inEntry_) {
+            S3Object& o = entry_.object;
+            if (name == "Key") o.key = text;
+            else if (name == "Size") std::from_chars(text.data(), text.data() + text.size(), o.size);
+            else if (name == "ETag") o.etag = text;
+            else if (name == "LastModified") o.lastModified = text;
+            else if (name == "VersionId") entry_.versionId = text;
+            else if (name == "IsLatest") entry_.isLatest = text == "true";
+        } else if (xml_.depth() == 3 && name == "Prefix") {
+            // Only CommonPrefixes has a Prefix child
+            if (onPrefix_ && !onPrefix_(std::string(text))) stopped_ = true;
+        } else if (xml_.depth() == 2) {
+            if (inEntry_) {
+                inEntry_ = false;
+                if (!onEntry_(entry_)) stopped_ = true;
+            }
+            else if (name == "IsTruncated") truncated = text == "true";
+            else if (name == "NextContinuationToken") continuationToken = text;
+            else if (name == "NextKeyMarker") keyMarker = text;
+            else if (name == "NextVersionIdMarker") versionIdMarker = text;
+        }
+    }
+
+    const S3StorageClient::VersionVisitor& onEntry_;
+    const S3StorageClient::PrefixVisitor& onPrefix_;
+    XmlStream xml_;
+    S3ObjectVersion entry_;
+    bool inEntry_ = false;
+    bool stopped_ = false;
+};
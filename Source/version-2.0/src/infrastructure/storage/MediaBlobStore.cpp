@@ -0,0 +1,407 @@
+#include "MediaBlobStore.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
+#include "src/infrastructure/storage/SigV4Signer.h"
+#include "src/utils/Exceptions.h"
+#include "src/utils/Hex.h"
+#include <algorithm>
+#include <ctime>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <locale>
+#include <sstream>
+#include <openssl/rand.h>
+#include "pqxx/pqxx"
+
+namespace {
+
+constexpr int kGcBatch = 100;
+constexpr size_t kSweepBatch = 1000;
+// Keys the sweep's listing may run ahead of their lookups
+constexpr size_t kSweepQueue = 2 * kSweepBatch;
+const std::string kBlobPrefix = "blobs/";
+
+std::string blobKey(const std::string& sha256) {
+    return kBlobPrefix + sha256.substr(0, 2) + "/" + sha256;
+}
+
+// Streams are uploaded before their hash is known
+std::string stagingKey() {
+    unsigned char nonce[16];
+    RAND_bytes(nonce, sizeof(nonce));
+    return kBlobPrefix + "staging/" + toHex(nonce, sizeof(nonce));
+}
+
+// S3's LastModified, e.g. 2024-05-01T12:00:00.000Z
+std::optional<std::time_t> parseS3Time(const std::string& value) {
+    std::tm tm{};
+    std::istringstream in(value);
+    in >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
+    if (in.fail()) return std::nullopt;
+    return timegm(&tm);
+}
+
+// A HEAD's Last-Modified, e.g. Wed, 01 May 2024 12:00:00 GMT
+std::optional<std::time_t> parseHttpTime(const std::string& value) {
+    std::tm tm{};
+    std::istringstream in(value);
+    in.imbue(std::locale::classic());
+    in >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S");
+    if (in.fail()) return std::nullopt;
+    return timegm(&tm);
+}
+
+}
+
+MediaBlobStore::MediaBlobStore(std::shared_ptr<PostgresPool> pool,
+                               std::shared_ptr<S3StorageClient> storage,
+                               std::shared_ptr<MultipartUploader> uploader,
+                               std::shared_ptr<ParallelLister> lister)
+    : MediaBlobStore(std::move(pool), std::move(storage), std::move(uploader), std::move(lister), Options{}) {}
+
+MediaBlobStore::MediaBlobStore(std::shared_ptr<PostgresPool> pool,
+                               std::shared_ptr<S3StorageClient> storage,
+                               std::shared_ptr<MultipartUploader> uploader,
+                               std::shared_ptr<ParallelLister> lister,
+                               Options options)
+    : pool_(std::move(pool)), storage_(std::move(storage)), uploader_(std::move(uploader)),
+      lister_(std::move(lister)), options_(options),
+      dedupHits_(MetricsRegistry::instance().counter(
+          "media_blob_dedup_hits_total", "Uploads that matched a stored blob")),
+      bytesSaved_(MetricsRegistry::instance().counter(
+          "media_blob_bytes_saved_total", "Bytes not stored again because a blob matched")),
+      blobsStored_(MetricsRegistry::instance().counter(
+          "media_blob_stored_total", "New blobs stored")),
+      blobsCollected_(MetricsRegistry::instance().counter(
+          "media_blob_collected_total", "Unreferenced blobs deleted by the collector")),
+      untrackedDeleted_(MetricsRegistry::instance().counter(
+          "media_blob_untracked_deleted_total", "Objects under blobs/ with no row, deleted by the sweep")) {}
+
+MediaBlobStore::~MediaBlobStore() {
+    stop();
+}
+
+bool MediaBlobStore::owns(const std::string& s3Key) {
+    return s3Key.compare(0, kBlobPrefix.size(), kBlobPrefix) == 0;
+}
+
+//  PUT
+
+MediaBlobStore::Blob MediaBlobStore::put(std::string_view data, const std::string& contentType) {
+    if (data.empty())
+        throw ValidationException("File data cannot be empty");
+    std::string sha256 = SigV4Signer::sha256Hex(data);
+    if (auto blob = revive(sha256)) return *blob;
+
+    // Same content, same key: a concurrent upload of it writes the same bytes
+    std::string key = blobKey(sha256);
+    auto stored = uploader_->upload(key, contentType, MultipartUploader::fromBuffer(data));
+    return adopt(sha256, key, stored.size);
+}
+
+MediaBlobStore::Blob MediaBlobStore::put(const MultipartUploader::Source& source, const std::string& contentType) {
+    std::string key = stagingKey();
+    auto stored = uploader_->upload(key, contentType, source);
+
+    auto blob = revive(stored.sha256);
+    if (!blob) blob = adopt(stored.sha256, key, stored.size);
+    if (blob->s3Key != key && !storage_->deleteFile(key))
+        std::cerr << "[MediaBlobStore] Could not delete duplicate upload " << key << std::endl;
+    return *blob;
+}
+
+// Finds a stored blob and, if it is unreferenced, restarts its grace
+// period. The update waits for a collector holding the row, and finds
+// nothing if the collector deleted it.
+std::optional<MediaBlobStore::Blob> MediaBlobStore::revive(const std::string& sha256) {
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    auto r = txn.exec(
+        "UPDATE content_blob SET orphaned_at = CASE WHEN ref_count = 0 THEN now() END "
+        "WHERE sha256 = $1 RETURNING s3_key, size;",
+        pqxx::params{sha256});
+    txn.commit();
+    if (r.empty()) return std::nullopt;
+
+    Blob blob{sha256, r[0]["s3_key"].as<std::string>(), r[0]["size"].as<uint64_t>(), true};
+    dedupHits_.inc();
+    bytesSaved_.inc(static_cast<double>(blob.size));
+    return blob;
+}
+
+// Records an uploaded object as the blob for sha256. If another upload
+// of the same content got there first, that one is returned.
+MediaBlobStore::Blob MediaBlobStore::adopt(const std::string& sha256, const std::string& s3Key, uint64_t size) {
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    auto r = txn.exec(
+        "INSERT INTO content_blob (sha256, s3_key, size, orphaned_at) VALUES ($1, $2, $3, now()) "
+        "ON CONFLICT (sha256) DO UPDATE "
+        "    SET orphaned_at = CASE WHEN content_blob.ref_count = 0 THEN now() END "
+        "RETURNING s3_key;",
+        pqxx::params{sha256, s3Key, static_cast<long long>(size)});
+    txn.commit();
+
+    Blob blob{sha256, r[0]["s3_key"].as<std::string>(), size, false};
+    if (blob.s3Key == s3Key) {
+        blobsStored_.inc();
+    } else {
+        blob.reused = true;
+        dedupHits_.inc();
+        bytesSaved_.inc(static_cast<double>(size));
+    }
+    return blob;
+}
+
+//  VERSIONS
+
+void MediaBlobStore::recordVersion(long mediaId, int version, const std::string& mimeType, bool drmProtected,
+                                   const Blob& blob) {
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+
+    // Item row first, then blob rows, as releaseMedia takes them, so a
+    // release cannot count the versions while this one is being added
+    auto r = txn.exec("SELECT id FROM digital_media WHERE media_id = $1 FOR UPDATE;", pqxx::params{mediaId});
+
+    auto ref = txn.exec(
+        "UPDATE content_blob SET ref_count = ref_count + 1, orphaned_at = NULL WHERE sha256 = $1;",
+        pqxx::params{blob.sha256});
+    if (ref.affected_rows() == 0)
+        throw DatabaseException("Stored file was collected before its version was recorded");
+
+    auto size = static_cast<long long>(blob.size);
+    if (r.empty()) {
+        r = txn.exec(
+            "INSERT INTO digital_media (media_id, mime_type, s3_key, file_size, drm_protected, current_version) "
+            "VALUES ($1, $2, $3, $4, $5, $6) RETURNING id;",
+            pqxx::params{mediaId, mimeType, blob.s3Key, size, drmProtected, version});
+    } else {
+        txn.exec(
+            "UPDATE digital_media SET s3_key = $2, file_size = $3, current_version = $4, "
+            "    updated_at = CURRENT_TIMESTAMP "
+            "WHERE id = $1;",
+            pqxx::params{r[0]["id"].as<long>(), blob.s3Key, size, version});
+    }
+    txn.exec(
+        "INSERT INTO digital_media_version (digital_media_id, version_number, s3_key, file_size, checksum) "
+        "VALUES ($1, $2, $3, $4, $5);",
+        pqxx::params{r[0]["id"].as<long>(), version, blob.s3Key, size, blob.sha256});
+    txn.commit();
+}
+
+std::vector<nlohmann::json> MediaBlobStore::listVersions(long mediaId) {
+    auto conn = pool_->acquire();
+    pqxx::read_transaction txn(*conn);
+    auto r = txn.exec(
+        "SELECT v.version_number, v.s3_key, v.file_size, v.checksum, "
+        "       to_char(v.uploaded_at AT TIME ZONE 'UTC', 'YYYY-MM-DD\"T\"HH24:MI:SS\"Z\"') AS uploaded_at "
+        "FROM digital_media_version v JOIN digital_media d ON d.id = v.digital_media_id "
+        "WHERE d.media_id = $1 ORDER BY v.version_number;",
+        pqxx::params{mediaId});
+    txn.commit();
+
+    std::vector<nlohmann::json> versions;
+    versions.reserve(r.size());
+    for (const auto& row : r) {
+        versions.push_back({
+            {"version", row["version_number"].as<int>()},
+            {"s3_key", row["s3_key"].as<std::string>()},
+            {"file_size", row["file_size"].as<long long>()},
+            {"sha256", row["checksum"].is_null() ? "" : row["checksum"].as<std::string>()},
+            {"uploaded_at", row["uploaded_at"].is_null() ? "" : row["uploaded_at"].as<std::string>()}
+        });
+    }
+    return versions;
+}
+
+void MediaBlobStore::releaseMedia(long mediaId) {
+    auto conn = pool_->acquire();
+    pqxx::work txn(*conn);
+    // Held until commit, so no version is recorded between the count and the delete
+    auto media = txn.exec("SELECT id FROM digital_media WHERE media_id = $1 FOR UPDATE;", pqxx::params{mediaId});
+    if (media.empty()) {
+        txn.commit();
+        return;
+    }
+    txn.exec(
+        "UPDATE content_blob b "
+        "SET ref_count = b.ref_count - c.n, "
+        "    orphaned_at = CASE WHEN b.ref_count - c.n = 0 THEN now() END "
+        "FROM (SELECT v.checksum, count(*)::int AS n "
+        "      FROM digital_media_version v JOIN digital_media d ON d.id = v.digital_media_id "
+        "      WHERE d.media_id = $1 AND v.checksum IS NOT NULL GROUP BY v.checksum) c "
+        "WHERE b.sha256 = c.checksum;",
+        pqxx::params{mediaId});
+    // Versions go with it (ON DELETE CASCADE)
+    txn.exec("DELETE FROM digital_media WHERE media_id = $1;", pqxx::params{mediaId});
+    txn.commit();
+}
+
+//  GARBAGE COLLECTION
+
+size_t MediaBlobStore::collectGarbage() {
+    size_t collected = 0;
+    while (!stopFlag_) {
+        auto conn = pool_->acquire();
+        pqxx::work txn(*conn);
+        // Locked until commit, so put cannot revive a blob being deleted
+        auto r = txn.exec(
+            "SELECT sha256, s3_key FROM content_blob "
+            "WHERE ref_count = 0 AND orphaned_at < now() - make_interval(secs => $1) "
+            "ORDER BY orphaned_at LIMIT $2 FOR UPDATE SKIP LOCKED;",
+            pqxx::params{static_cast<double>(options_.gcGrace.count()), kGcBatch});
+        size_t deleted = 0;
+        for (const auto& row : r) {
+            if (!storage_->deleteFile(row["s3_key"].as<std::string>())) continue;
+            txn.exec("DELETE FROM content_blob WHERE sha256 = $1;", pqxx::params{row["sha256"].as<std::string>()});
+            ++deleted;
+        }
+        txn.commit();
+        collected += deleted;
+        blobsCollected_.inc(static_cast<double>(deleted));
+        // A short batch is the last one; failed S3 deletes wait for the next pass
+        if (r.size() < kGcBatch || deleted < static_cast<size_t>(r.size())) break;
+    }
+    return collected;
+}
+
+size_t MediaBlobStore::sweepUntracked() {
+    std::time_t cutoff = std::time(nullptr) - static_cast<std::time_t>(options_.gcGrace.count());
+
+    // The lister runs visitors one at a time, holding up the transfers
+    // behind them, so the visitor only queues keys. The database check and
+    // the HEAD/DELETE requests run on this thread, up to kSweepQueue keys
+    // behind the listing.
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::string> queue;
+    bool listed = false, abandoned = false, ok = false;
+    std::exception_ptr listError;
+
+    std::thread listing([&]() {
+        bool result = false;
+        try {
+            result = lister_->forEachObject(kBlobPrefix, [&](const S3Object& object) {
+                auto modified = parseS3Time(object.lastModified);
+                if (!modified || *modified >= cutoff) return !stopFlag_;
+                std::unique_lock lock(mtx);
+                cv.wait(lock, [&] { return queue.size() < kSweepQueue || abandoned; });
+                if (abandoned) return false;
+                queue.push_back(object.key);
+                cv.notify_all();
+                return !stopFlag_;
+            });
+        } catch (...) {
+            listError = std::current_exception();
+        }
+        std::scoped_lock lock(mtx);
+        ok = result;
+        listed = true;
+        cv.notify_all();
+    });
+
+    size_t deleted = 0;
+    std::exception_ptr error;
+    std::vector<std::string> batch;
+    for (;;) {
+        {
+            // A full batch, or what is left once the listing is over
+            std::unique_lock lock(mtx);
+            cv.wait(lock, [&] { return queue.size() >= kSweepBatch || listed; });
+            size_t n = std::min(queue.size(), kSweepBatch);
+            batch.assign(std::make_move_iterator(queue.begin()),
+                         std::make_move_iterator(queue.begin() + static_cast<std::ptrdiff_t>(n)));
+            queue.erase(queue.begin(), queue.begin() + static_cast<std::ptrdiff_t>(n));
+            cv.notify_all();
+        }
+        if (batch.empty()) break;
+        try {
+            deleted += deleteUntracked(batch, cutoff);
+        } catch (...) {
+            error = std::current_exception();
+            break;
+        }
+    }
+
+    {
+        std::scoped_lock lock(mtx);
+        abandoned = true;
+        cv.notify_all();
+    }
+    listing.join();
+    if (error) std::rethrow_exception(error);
+    if (listError) std::rethrow_exception(listError);
+    if (!ok) std::cerr << "[MediaBlobStore] Sweep of blobs/ stopped on a listing error" << std::endl;
+    return deleted;
+}
+
+size_t MediaBlobStore::deleteUntracked(std::vector<std::string>& keys, std::time_t cutoff) {
+    if (keys.empty()) return 0;
+    std::string joined;
+    for (const auto& key : keys) joined.append(key).append("\n");
+    joined.pop_back();
+    keys.clear();
+
+    pqxx::result r;
+    {
+        auto conn = pool_->acquire();
+        pqxx::read_transaction txn(*conn);
+        r = txn.exec(
+            "SELECT k FROM unnest(string_to_array($1, E'\\n')) AS k "
+            "WHERE NOT EXISTS (SELECT 1 FROM content_blob b WHERE b.s3_key = k);",
+            pqxx::params{joined});
+        txn.commit();
+    }
+
+    size_t deleted = 0;
+    for (const auto& row : r) {
+        auto key = row["k"].as<std::string>();
+        // put(string_view) uploads to the final key before inserting its
+        // row; a re-upload since the listing shows as a new LastModified
+        auto head = storage_->headObject(key);
+        if (!head.object) continue;
+        auto modified = parseHttpTime(head.object->lastModified);
+        if (!modified || *modified >= cutoff) continue;
+        if (storage_->deleteFile(key)) {
+            ++deleted;
+            std::cout << "[MediaBlobStore] Deleted untracked object " << key << std::endl;
+        }
+    }
+    untrackedDeleted_.inc(static_cast<double>(deleted));
+    return deleted;
+}
+
+void MediaBlobStore::start() {
+    collector_ = std::thread([this]() {
+        std::cout << "[MediaBlobStore] Collector started." << std::endl;
+        auto nextSweep = std::chrono::steady_clock::now() + options_.gcInterval;
+        std::unique_lock lock(gcMtx_);
+        while (!stopFlag_) {
+            lock.unlock();
+            try {
+                if (size_t n = collectGarbage())
+                    std::cout << "[MediaBlobStore] Collected " << n << " unreferenced blobs." << std::endl;
+                if (std::chrono::steady_clock::now() >= nextSweep) {
+                    sweepUntracked();
+                    nextSweep = std::chrono::steady_clock::now() + options_.untrackedSweepInterval;
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "[MediaBlobStore] Collector pass failed: " << e.what() << std::endl;
+            }
+            lock.lock();
+            gcCv_.wait_for(lock, options_.gcInterval, [this] { return stopFlag_.load(); });
+        }
+    });
+}
+
+void MediaBlobStore::stop() {
+    {
+        std::scoped_lock lock(gcMtx_);
+        if (stopFlag_) return;
+        stopFlag_ = true;
+    }
+    gcCv_.notify_all();
+    if (collector_.joinable()) collector_.join();
+    std::cout << "[MediaBlobStore] Stopped." << std::endl;
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "src/infrastructure/db/PostgresPool.h"
+#include "src/infrastructure/storage/MultipartUploader.h"
+#include "src/infrastructure/storage/ParallelLister.h"
+#include "src/infrastructure/storage/S3StorageClient.h"
+
+class Counter;
+
+// Content-addressed storage for digital media versions (migration 004).
+// Every distinct file is stored in S3 once and recorded in content_blob
+// under its SHA-256; versions reference it through
+// digital_media_version.checksum, and content_blob.ref_count counts them.
+// Content already in memory is hashed before upload, so a duplicate is
+// never sent to S3. A stream is hashed as it uploads and dropped
+// afterwards if it turns out to be a duplicate.
+//
+// A blob that loses its last reference is kept for gcGrace, so a put
+// whose version has not been recorded yet cannot lose it. The collector
+// takes the row lock before deleting from S3, and put revives a blob
+// under the same lock, so the two cannot interleave. A periodic sweep of
+// blobs/ deletes objects no row knows about, left by interrupted uploads;
+// each is checked with a HEAD first, so one rewritten by a put since the
+// listing is kept. recordVersion and releaseMedia lock the digital_media
+// row before touching blob counts.
+class MediaBlobStore {
+public:
+    struct Options {
+        std::chrono::seconds gcGrace{3600};
+        std::chrono::seconds gcInterval{600};
+        std::chrono::seconds untrackedSweepInterval{24 * 3600};
+    };
+
+    struct Blob {
+        std::string sha256;
+        std::string s3Key;
+        uint64_t size = 0;
+        bool reused = false;   // already stored; nothing was uploaded
+    };
+
+    MediaBlobStore(std::shared_ptr<PostgresPool> pool,
+                   std::shared_ptr<S3StorageClient> storage,
+                   std::shared_ptr<MultipartUploader> uploader,
+                   std::shared_ptr<ParallelLister> lister);
+    MediaBlobStore(std::shared_ptr<PostgresPool> pool,
+                   std::shared_ptr<S3StorageClient> storage,
+                   std::shared_ptr<MultipartUploader> uploader,
+                   std::shared_ptr<ParallelLister> lister,
+                   Options options);
+    ~MediaBlobStore();
+
+    // Whether s3Key is a blob key; items stored before content addressing
+    // have keys of their own
+    static bool owns(const std::string& s3Key);
+
+    // Stores content unless a blob with the same hash exists. The blob is
+    // unreferenced until recordVersion; throws like MultipartUploader
+    Blob put(std::string_view data, const std::string& contentType);
+    Blob put(const MultipartUploader::Source& source, const std::string& contentType);
+
+    // Writes the digital_media and digital_media_version rows for a new
+    // version and references its blob, in one transaction
+    void recordVersion(long mediaId, int version, const std::string& mimeType, bool drmProtected,
+                       const Blob& blob);
+
+    // Versions of a media item, oldest first
+    std::vector<nlohmann::json> listVersions(long mediaId);
+
+    // Deletes a media item's rows and drops their blob references
+    void releaseMedia(long mediaId);
+
+    // One collector pass; returns the blobs deleted
+    size_t collectGarbage();
+    // Deletes objects under blobs/ that no row refers to and that are
+    // older than gcGrace; returns how many. The listing runs on a thread
+    // of its own while this one looks the keys up and deletes, a batch at
+    // a time.
+    size_t sweepUntracked();
+
+    // Starts the background collector
+    void start();
+    void stop();
+
+private:
+    std::optional<Blob> revive(const std::string& sha256);
+    Blob adopt(const std::string& sha256, const std::string& s3Key, uint64_t size);
+    size_t deleteUntracked(std::vector<std::string>& keys, std::time_t cutoff);
+
+    std::shared_ptr<PostgresPool> pool_;
+    std::shared_ptr<S3StorageClient> storage_;
+    std::shared_ptr<MultipartUploader> uploader_;
+    std::shared_ptr<ParallelLister> lister_;
+    Options options_;
+
+    Counter& dedupHits_;
+    Counter& bytesSaved_;
+    Counter& blobsStored_;
+    Counter& blobsCollected_;
+    Counter& untrackedDeleted_;
+
+    std::atomic<bool> stopFlag_{false};
+    std::mutex gcMtx_;
+    std::condition_variable gcCv_;
+    std::thread collector_;
+};
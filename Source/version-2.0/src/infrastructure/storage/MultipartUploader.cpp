@@ -0,0 +1,230 @@
+#include "MultipartUploader.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
+#include "src/utils/Exceptions.h"
+#include "src/utils/Hex.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <openssl/evp.h>
+
+namespace {
+
+constexpr size_t kMinPartSize = 5 * 1024 * 1024;
+constexpr int kMaxParts = 10000;
+
+class Sha256 {
+public:
+    Sha256() : ctx_(EVP_MD_CTX_new(), EVP_MD_CTX_free) {
+        EVP_DigestInit_ex(ctx_.get(), EVP_sha256(), nullptr);
+    }
+
+    void update(std::string_view data) { EVP_DigestUpdate(ctx_.get(), data.data(), data.size()); }
+
+    std::string hex() {
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int len = 0;
+        EVP_DigestFinal_ex(ctx_.get(), digest, &len);
+        return toHex(digest, len);
+    }
+
+private:
+    std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx_;
+};
+
+class S3MultipartStorage : public MultipartStorage {
+public:
+    explicit S3MultipartStorage(std::shared_ptr<S3StorageClient> s3) : s3_(std::move(s3)) {}
+
+    bool uploadFile(const std::string& key, const std::string& data, const std::string& contentType) override {
+        return s3_->uploadFile(key, data, contentType);
+    }
+    std::optional<std::string> createMultipartUpload(const std::string& key,
+                                                     const std::string& contentType) override {
+        return s3_->createMultipartUpload(key, contentType);
+    }
+    std::optional<std::string> uploadPart(const std::string& key, const std::string& uploadId,
+                                          int partNumber, std::string_view data) override {
+        return s3_->uploadPart(key, uploadId, partNumber, data);
+    }
+    bool completeMultipartUpload(const std::string& key, const std::string& uploadId,
+                                 const std::vector<std::string>& etags) override {
+        return s3_->completeMultipartUpload(key, uploadId, etags);
+    }
+    bool abortMultipartUpload(const std::string& key, const std::string& uploadId) override {
+        return s3_->abortMultipartUpload(key, uploadId);
+    }
+
+private:
+    std::shared_ptr<S3StorageClient> s3_;
+};
+
+}
+
+MultipartUploader::MultipartUploader(std::shared_ptr<S3StorageClient> storage)
+    : MultipartUploader(std::move(storage), Options{}) {}
+
+MultipartUploader::MultipartUploader(std::shared_ptr<S3StorageClient> storage, Options options)
+    : MultipartUploader(std::make_shared<S3MultipartStorage>(std::move(storage)), options) {}
+
+MultipartUploader::MultipartUploader(std::shared_ptr<MultipartStorage> storage, Options options)
+    : storage_(std::move(storage)), options_(options), pool_(options.threads),
+      partsUploaded_(MetricsRegistry::instance().counter(
+          "s3_multipart_parts_uploaded_total", "Multipart upload parts stored")),
+      partsRetried_(MetricsRegistry::instance().counter(
+          "s3_multipart_parts_retried_total", "Multipart upload part attempts that failed and were retried")),
+      uploadsAborted_(MetricsRegistry::instance().counter(
+          "s3_multipart_uploads_aborted_total", "Multipart uploads given up and aborted")) {
+    options_.partSize = std::max(options_.partSize, kMinPartSize);
+    options_.partsInFlight = std::max<size_t>(options_.partsInFlight, 1);
+    timer_ = std::thread([this] { timerLoop(); });
+}
+
+MultipartUploader::~MultipartUploader() {
+    {
+        std::scoped_lock lock(timerMtx_);
+        stopping_ = true;
+    }
+    timerCv_.notify_all();
+    timer_.join();
+}
+
+void MultipartUploader::schedule(std::chrono::milliseconds delay, std::function<void()> task) {
+    {
+        std::scoped_lock lock(timerMtx_);
+        timers_.emplace(Clock::now() + delay, std::move(task));
+    }
+    timerCv_.notify_one();
+}
+
+void MultipartUploader::timerLoop() {
+    std::unique_lock lock(timerMtx_);
+    while (!stopping_) {
+        if (timers_.empty()) {
+            timerCv_.wait(lock);
+            continue;
+        }
+        auto due = timers_.begin()->first;
+        if (Clock::now() < due) {
+            timerCv_.wait_until(lock, due);
+            continue;
+        }
+        auto task = std::move(timers_.begin()->second);
+        timers_.erase(timers_.begin());
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+MultipartUploader::Source MultipartUploader::fromBuffer(std::string_view data) {
+    return [data, offset = size_t{0}](char* buffer, size_t capacity) mutable {
+        size_t n = std::min(capacity, data.size() - offset);
+        std::memcpy(buffer, data.data() + offset, n);
+        offset += n;
+        return n;
+    };
+}
+
+std::string MultipartUploader::readPart(const Source& source) {
+    std::string part(options_.partSize, '\0');
+    size_t filled = 0;
+    while (filled < part.size()) {
+        size_t n = source(part.data() + filled, part.size() - filled);
+        if (n == 0) break;
+        filled += n;
+    }
+    part.resize(filled);
+    return part;
+}
+
+void MultipartUploader::uploadPart(std::shared_ptr<Part> part, int attempt) {
+    pool_.submit([this, part = std::move(part), attempt] {
+        try {
+            if (auto etag = storage_->uploadPart(part->key, part->uploadId, part->number, part->data)) {
+                partsUploaded_.inc();
+                part->etag.set_value(std::move(etag));
+                return;
+            }
+            if (attempt >= options_.partRetries) {
+                part->etag.set_value(std::nullopt);
+                return;
+            }
+            partsRetried_.inc();
+            // The pool thread moves on to other parts meanwhile
+            schedule(options_.retryBackoff * (1 << attempt),
+                     [this, part, attempt] { uploadPart(part, attempt + 1); });
+        } catch (...) {
+            part->etag.set_exception(std::current_exception());
+        }
+    });
+}
+
+MultipartUploader::Result MultipartUploader::upload(const std::string& key, const std::string& contentType,
+                                                    const Source& source) {
+    Result result;
+    Sha256 hash;
+
+    std::string part = readPart(source);
+    if (part.empty())
+        throw ValidationException("File data cannot be empty");
+    hash.update(part);
+    result.size = part.size();
+
+    if (part.size() < options_.partSize) {
+        if (!storage_->uploadFile(key, part, contentType))
+            throw DatabaseException("Failed to upload file to storage");
+        result.sha256 = hash.hex();
+        result.parts = 1;
+        return result;
+    }
+
+    auto uploadId = storage_->createMultipartUpload(key, contentType);
+    if (!uploadId)
+        throw DatabaseException("Failed to start multipart upload");
+
+    std::deque<std::future<std::optional<std::string>>> inFlight;
+    std::vector<std::string> etags;
+    auto collectOldest = [&] {
+        auto etag = inFlight.front().get();
+        inFlight.pop_front();
+        if (!etag)
+            throw DatabaseException("Failed to upload part " + std::to_string(etags.size() + 1) + " to storage");
+        etags.push_back(std::move(*etag));
+    };
+
+    try {
+        int partNumber = 0;
+        while (!part.empty()) {
+            if (++partNumber > kMaxParts)
+                throw ValidationException("File exceeds the multipart upload size limit");
+            if (inFlight.size() >= options_.partsInFlight) collectOldest();
+            auto next = std::make_shared<Part>();
+            next->key = key;
+            next->uploadId = *uploadId;
+            next->number = partNumber;
+            next->data = std::move(part);
+            inFlight.push_back(next->etag.get_future());
+            uploadPart(std::move(next), 0);
+            part = readPart(source);
+            hash.update(part);
+            result.size += part.size();
+        }
+        while (!inFlight.empty()) collectOldest();
+
+        if (!storage_->completeMultipartUpload(key, *uploadId, etags))
+            throw DatabaseException("Failed to complete multipart upload");
+    } catch (...) {
+        // A part still uploading would be stored after the abort
+        for (auto& f : inFlight) f.wait();
+        uploadsAborted_.inc();
+        if (!storage_->abortMultipartUpload(key, *uploadId))
+            std::cerr << "[S3] Failed to abort multipart upload " << *uploadId << " for " << key << std::endl;
+        throw;
+    }
+
+    result.sha256 = hash.hex();
+    result.parts = etags.size();
+    return result;
+}
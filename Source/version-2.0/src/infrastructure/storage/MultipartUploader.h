@@ -0,0 +1,110 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "src/infrastructure/storage/S3StorageClient.h"
+#include "src/utils/ThreadPool.h"
+
+class Counter;
+
+// The S3 calls an upload makes; S3StorageClient in production, a fake in
+// tests
+class MultipartStorage {
+public:
+    virtual ~MultipartStorage() = default;
+    virtual bool uploadFile(const std::string& key, const std::string& data, const std::string& contentType) = 0;
+    virtual std::optional<std::string> createMultipartUpload(const std::string& key,
+                                                             const std::string& contentType) = 0;
+    virtual std::optional<std::string> uploadPart(const std::string& key, const std::string& uploadId,
+                                                  int partNumber, std::string_view data) = 0;
+    virtual bool completeMultipartUpload(const std::string& key, const std::string& uploadId,
+                                         const std::vector<std::string>& etags) = 0;
+    virtual bool abortMultipartUpload(const std::string& key, const std::string& uploadId) = 0;
+};
+
+// Streams an object into S3 in parts without holding all of it. The caller's
+// thread reads the source one part at a time and hashes it as it goes.
+// Parts are uploaded on a shared pool, with at most partsInFlight of one
+// upload outstanding, so an upload holds at most partsInFlight + 1 part
+// buffers. A failed part is retried on its own, without restarting the
+// upload; the backoff is waited out on a timer, not on a pool thread. If a
+// part still fails, the upload is aborted so S3 does not keep the parts
+// already stored. A source smaller than one part is sent as a single PUT.
+class MultipartUploader {
+public:
+    struct Options {
+        size_t partSize = 8 * 1024 * 1024;   // S3 minimum is 5 MiB
+        size_t partsInFlight = 4;
+        size_t threads = 8;
+        int partRetries = 3;
+        // Doubled after each failed attempt of a part
+        std::chrono::milliseconds retryBackoff{200};
+    };
+
+    // Fills up to capacity bytes of buffer and returns the count; 0 at the end
+    using Source = std::function<size_t(char* buffer, size_t capacity)>;
+
+    struct Result {
+        size_t size = 0;
+        std::string sha256;   // hex digest of the whole object
+        size_t parts = 0;
+    };
+
+    explicit MultipartUploader(std::shared_ptr<S3StorageClient> storage);
+    MultipartUploader(std::shared_ptr<S3StorageClient> storage, Options options);
+    MultipartUploader(std::shared_ptr<MultipartStorage> storage, Options options);
+    ~MultipartUploader();
+
+    MultipartUploader(const MultipartUploader&) = delete;
+    MultipartUploader& operator=(const MultipartUploader&) = delete;
+
+    // Throws ValidationException for an empty or oversized source and
+    // DatabaseException when S3 does not take it
+    Result upload(const std::string& key, const std::string& contentType, const Source& source);
+
+    // Source over memory owned by the caller, which must outlive the upload
+    static Source fromBuffer(std::string_view data);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // One part and where its ETag goes; shared by its attempts
+    struct Part {
+        std::string key;
+        std::string uploadId;
+        int number = 0;
+        std::string data;
+        std::promise<std::optional<std::string>> etag;
+    };
+
+    std::string readPart(const Source& source);
+    // Runs one attempt on the pool; a failure schedules the next
+    void uploadPart(std::shared_ptr<Part> part, int attempt);
+    void schedule(std::chrono::milliseconds delay, std::function<void()> task);
+    void timerLoop();
+
+    std::shared_ptr<MultipartStorage> storage_;
+    Options options_;
+    ThreadPool pool_;
+
+    // Retries waiting out their backoff, by due time
+    std::mutex timerMtx_;
+    std::condition_variable timerCv_;
+    std::multimap<Clock::time_point, std::function<void()>> timers_;
+    bool stopping_ = false;
+    std::thread timer_;
+
+    Counter& partsUploaded_;
+    Counter& partsRetried_;
+    Counter& uploadsAborted_;
+};
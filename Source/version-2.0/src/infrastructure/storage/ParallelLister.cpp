@@ -0,0 +1,79 @@
+#include "ParallelLister.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+
+struct ParallelLister::Run {
+    const S3StorageClient::ObjectVisitor& onObject;
+    std::mutex visitMtx;
+    std::atomic<bool> stop{false};
+    std::atomic<bool> failed{false};
+
+    std::mutex pendingMtx;
+    std::condition_variable idle;
+    size_t pending = 0;
+
+    explicit Run(const S3StorageClient::ObjectVisitor& visitor) : onObject(visitor) {}
+
+    bool visit(const S3Object& object) {
+        std::scoped_lock lock(visitMtx);
+        if (stop) return false;
+        if (!onObject(object)) stop = true;
+        return !stop;
+    }
+};
+
+ParallelLister::ParallelLister(std::shared_ptr<S3StorageClient> storage)
+    : ParallelLister(std::move(storage), Options{}) {}
+
+ParallelLister::ParallelLister(std::shared_ptr<S3StorageClient> storage, Options options)
+    : storage_(std::move(storage)), options_(std::move(options)), pool_(options_.threads),
+      prefixesListed_(MetricsRegistry::instance().counter(
+          "s3_list_prefixes_total", "Prefixes listed by parallel S3 listings")) {}
+
+bool ParallelLister::forEachObject(const std::string& prefix, const S3StorageClient::ObjectVisitor& onObject) {
+    auto run = std::make_shared<Run>(onObject);
+    spawn(run, prefix, 0);
+    std::unique_lock lock(run->pendingMtx);
+    run->idle.wait(lock, [&run] { return run->pending == 0; });
+    return !run->failed;
+}
+
+void ParallelLister::spawn(const std::shared_ptr<Run>& run, std::string prefix, int depth) {
+    {
+        std::scoped_lock lock(run->pendingMtx);
+        ++run->pending;
+    }
+    pool_.submit([this, run, prefix = std::move(prefix), depth] {
+        try {
+            if (!run->stop) list(run, prefix, depth);
+        } catch (const std::exception& e) {
+            std::cerr << "[ParallelLister] Listing " << prefix << " failed: " << e.what() << std::endl;
+            run->failed = true;
+            run->stop = true;
+        }
+        std::scoped_lock lock(run->pendingMtx);
+        if (--run->pending == 0) run->idle.notify_all();
+    });
+}
+
+void ParallelLister::list(const std::shared_ptr<Run>& run, const std::string& prefix, int depth) {
+    prefixesListed_.inc();
+    auto visit = [&run](const S3Object& object) { return run->visit(object); };
+    bool ok;
+    if (depth < options_.splitDepth && !options_.delimiter.empty()) {
+        ok = storage_->forEachObject(prefix, visit, options_.delimiter, [this, &run, depth](const std::string& sub) {
+            spawn(run, sub, depth + 1);
+            return !run->stop;
+        }, options_.pageSize);
+    } else {
+        ok = storage_->forEachObject(prefix, visit, "", nullptr, options_.pageSize);
+    }
+    if (!ok) {
+        // A listing with a hole must not drive a cleanup
+        run->failed = true;
+        run->stop = true;
+    }
+}
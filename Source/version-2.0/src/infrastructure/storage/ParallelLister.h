@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include "src/infrastructure/storage/S3StorageClient.h"
+#include "src/utils/ThreadPool.h"
+
+class Counter;
+
+// Lists every object under a prefix with several S3 requests at once.
+// The prefix is listed with a delimiter to find its sub-prefixes, down to
+// splitDepth levels, and each sub-prefix found at the last level is listed
+// in full as its own task. Under "digital-media/" that is one listing per
+// media item, threads at a time. Sub-prefixes are handed to the pool as
+// they are parsed, so the fan-out starts with the first page. The visitor
+// is called from pool threads, one call at a time, in no particular key
+// order.
+class ParallelLister {
+public:
+    struct Options {
+        size_t threads = 8;
+        int splitDepth = 1;
+        std::string delimiter = "/";
+        int pageSize = 1000;
+    };
+
+    explicit ParallelLister(std::shared_ptr<S3StorageClient> storage);
+    ParallelLister(std::shared_ptr<S3StorageClient> storage, Options options);
+
+    // False if any page could not be read, in which case the objects
+    // visited are not the whole listing. A visitor returning false stops
+    // the listing; that is not a failure.
+    bool forEachObject(const std::string& prefix, const S3StorageClient::ObjectVisitor& onObject);
+
+private:
+    struct Run;
+    void spawn(const std::shared_ptr<Run>& run, std::string prefix, int depth);
+    void list(const std::shared_ptr<Run>& run, const std::string& prefix, int depth);
+
+    std::shared_ptr<S3StorageClient> storage_;
+    Options options_;
+    ThreadPool pool_;
+
+    Counter& prefixesListed_;
+};
@@ -1,417 +1,271 @@
 #include "S3StorageClient.h"
+#include "src/infrastructure/storage/ListingPage.h"
+#include <algorithm>
 #include <iostream>
-#include <openssl/hmac.h>
-#include <openssl/sha.h>
-#include <iomanip>
-#include <sstream>
 #include <ctime>
-#include <algorithm>
-
-S3StorageClient::S3StorageClient(const std::string& endpoint,
-                                 const std::string& accessKey,
-                                 const std::string& secretKey,
-                                 const std::string& bucket,
-                                 const std::string& region)
-    : endpoint_(endpoint), accessKey_(accessKey), secretKey_(secretKey),
-      bucket_(bucket), region_(region), curl_(nullptr) {
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-    curl_ = curl_easy_init();
-}
-
-S3StorageClient::~S3StorageClient() {
-    if (curl_) curl_easy_cleanup(curl_);
-    curl_global_cleanup();
-}
 
-size_t S3StorageClient::writeCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    size_t realSize = size * nmemb;
-    reinterpret_cast<std::string*>(userp)->append(static_cast<char*>(contents), realSize);
-    return realSize;
-}
+namespace {
 
-std::string S3StorageClient::sha256(const std::string& data) {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256(reinterpret_cast<const unsigned char*>(data.c_str()), data.size(), hash);
-    std::ostringstream os;
-    for (unsigned char c : hash)
-        os << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(c);
-    return os.str();
+// Text of the first <tag> element; enough for S3's flat replies
+std::optional<std::string> xmlValue(const std::string& xml, const std::string& tag) {
+    auto start = xml.find("<" + tag + ">");
+    if (start == std::string::npos) return std::nullopt;
+    start += tag.size() + 2;
+    auto end = xml.find("</" + tag + ">", start);
+    if (end == std::string::npos) return std::nullopt;
+    return xml.substr(start, end - start);
 }
 
-std::string S3StorageClient::hmacSha256(const std::string& key, const std::string& data) {
-    unsigned char result[EVP_MAX_MD_SIZE];
-    unsigned int len = 0;
-    HMAC(EVP_sha256(),
-         key.c_str(), static_cast<int>(key.size()),
-         reinterpret_cast<const unsigned char*>(data.c_str()), data.size(),
-         result, &len);
-    return std::string(reinterpret_cast<char*>(result), len);
+std::string uploadQuery(const std::string& uploadId) {
+    return "uploadId=" + SigV4Signer::uriEncode(uploadId, false);
 }
 
-std::string S3StorageClient::getTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    std::time_t t = std::chrono::system_clock::to_time_t(now);
-    std::tm tm{};
-    gmtime_r(&t, &tm);
-    char buf[32];
-    std::strftime(buf, sizeof(buf), "%Y%m%dT%H%M%SZ", &tm);
-    return std::string(buf);
+// Appends name=value, encoded, when value is set. SigV4 signs the query
+// as sent, so callers add parameters in sorted order.
+void addParam(std::string& query, std::string_view name, const std::string& value) {
+    if (value.empty()) return;
+    if (!query.empty()) query += '&';
+    query.append(name).append("=").append(SigV4Signer::uriEncode(value, false));
 }
 
-std::string S3StorageClient::getDateStamp() {
-    auto now = std::chrono::system_clock::now();
-    std::time_t t = std::chrono::system_clock::to_time_t(now);
-    std::tm tm{};
-    gmtime_r(&t, &tm);
-    char buf[16];
-    std::strftime(buf, sizeof(buf), "%Y%m%d", &tm);
-    return std::string(buf);
 }
 
-std::string S3StorageClient::signV4(const std::string& method, const std::string& path,
-                                     const std::string& queryString, const std::string& payloadHash,
-                                     const std::string& contentType, const std::string& timestamp) {
-    std::string dateStamp = timestamp.substr(0, 8);
-    std::string host = endpoint_;
-    // Strip protocol
-    if (host.find("://") != std::string::npos)
-        host = host.substr(host.find("://") + 3);
-    // Strip trailing slash
-    if (!host.empty() && host.back() == '/') host.pop_back();
-
-    std::string canonicalHeaders = "content-type:" + contentType + "\n"
-                                  + "host:" + host + "\n"
-                                  + "x-amz-content-sha256:" + payloadHash + "\n"
-                                  + "x-amz-date:" + timestamp + "\n";
-    std::string signedHeaders = "content-type;host;x-amz-content-sha256;x-amz-date";
-
-    std::string canonicalRequest = method + "\n"
-                                  + path + "\n"
-                                  + queryString + "\n"
-                                  + canonicalHeaders + "\n"
-                                  + signedHeaders + "\n"
-                                  + payloadHash;
-
-    std::string scope = dateStamp + "/" + region_ + "/s3/aws4_request";
-    std::string stringToSign = "AWS4-HMAC-SHA256\n" + timestamp + "\n" + scope + "\n" + sha256(canonicalRequest);
-
-    std::string kDate = hmacSha256("AWS4" + secretKey_, dateStamp);
-    std::string kRegion = hmacSha256(kDate, region_);
-    std::string kService = hmacSha256(kRegion, "s3");
-    std::string kSigning = hmacSha256(kService, "aws4_request");
-    std::string signature = hmacSha256(kSigning, stringToSign);
-
-    // Hex-encode signature
-    std::ostringstream sigHex;
-    for (unsigned char c : signature)
-        sigHex << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(c);
-
-    return "AWS4-HMAC-SHA256 Credential=" + accessKey_ + "/" + scope
-         + ", SignedHeaders=" + signedHeaders
-         + ", Signature=" + sigHex.str();
+S3StorageClient::S3StorageClient(const std::string& endpoint,
+                                 const std::string& accessKey,
+                                 const std::string& secretKey,
+                                 const std::string& bucket,
+                                 const std::string& region,
+                                 std::shared_ptr<HttpTransport> transport,
+                                 SigV4Signer::Options signerOptions)
+    : endpoint_(endpoint), bucket_(bucket),
+      transport_(transport ? std::move(transport) : std::make_shared<HttpTransport>()),
+      signer_(endpoint, accessKey, secretKey, region, signerOptions) {}
+
+HttpResponse S3StorageClient::send(const std::string& method, const std::string& path,
+                                   const std::string& query, std::string_view body,
+                                   const std::optional<std::string>& contentType,
+                                   long timeoutMs,
+                                   const std::vector<std::string>& extraHeaders,
+                                   HttpBodySink onBody) {
+    std::string timestamp = SigV4Signer::timestamp(std::time(nullptr));
+    std::string payloadHash = SigV4Signer::sha256Hex(body);
+    std::string auth = signer_.authorization(method, path, query, payloadHash,
+                                             contentType.value_or("application/octet-stream"), timestamp);
+
+    HttpRequest request;
+    request.method = method;
+    request.url = endpoint_ + path + (query.empty() ? "" : "?" + query);
+    request.body = body;
+    request.headOnly = method == "HEAD";
+    request.connectTimeoutMs = 10000;
+    request.timeoutMs = timeoutMs;
+    request.headers = {
+        "Authorization: " + auth,
+        "x-amz-date: " + timestamp,
+        "x-amz-content-sha256: " + payloadHash
+    };
+    if (contentType) request.headers.push_back("Content-Type: " + *contentType);
+    request.headers.insert(request.headers.end(), extraHeaders.begin(), extraHeaders.end());
+    request.onBody = std::move(onBody);
+    return transport_->perform(request);
 }
 
 bool S3StorageClient::uploadFile(const std::string& key,
                                   const std::string& data,
                                   const std::string& contentType) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (!curl_) return false;
-    curl_easy_reset(curl_);
-
-    std::string path = "/" + bucket_ + "/" + key;
-    std::string url = endpoint_ + path;
-    std::string timestamp = getTimestamp();
-    std::string payloadHash = sha256(data);
-    std::string auth = signV4("PUT", path, "", payloadHash, contentType, timestamp);
-
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, ("Authorization: " + auth).c_str());
-    headers = curl_slist_append(headers, ("x-amz-date: " + timestamp).c_str());
-    headers = curl_slist_append(headers, ("x-amz-content-sha256: " + payloadHash).c_str());
-    headers = curl_slist_append(headers, ("Content-Type: " + contentType).c_str());
-
-    std::string response;
-    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl_, CURLOPT_UPLOAD, 1L);
-    curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, data.c_str());
-    curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE, data.size());
-    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, writeCallback);
-    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT, 10L);
-    curl_easy_setopt(curl_, CURLOPT_TIMEOUT, 30L);
-
-    CURLcode res = curl_easy_perform(curl_);
-    curl_slist_free_all(headers);
-
-    if (res != CURLE_OK) {
-        std::cerr << "[S3] Upload failed: " << curl_easy_strerror(res) << std::endl;
+    auto res = send("PUT", "/" + bucket_ + "/" + key, "", data, contentType, 30000);
+    if (res.curlCode != CURLE_OK) {
+        std::cerr << "[S3] Upload failed: " << res.error << std::endl;
         return false;
     }
-
-    long httpCode = 0;
-    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &httpCode);
-    return httpCode >= 200 && httpCode < 300;
+    return res.ok();
 }
 
 std::optional<std::string> S3StorageClient::downloadFile(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (!curl_) return std::nullopt;
-    curl_easy_reset(curl_);
-
-    std::string path = "/" + bucket_ + "/" + key;
-    std::string url = endpoint_ + path;
-    std::string timestamp = getTimestamp();
-    std::string payloadHash = sha256("");
-    std::string auth = signV4("GET", path, "", payloadHash, "application/octet-stream", timestamp);
-
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, ("Authorization: " + auth).c_str());
-    headers = curl_slist_append(headers, ("x-amz-date: " + timestamp).c_str());
-    headers = curl_slist_append(headers, ("x-amz-content-sha256: " + payloadHash).c_str());
-
-    std::string response;
-    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, writeCallback);
-    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT, 10L);
-    curl_easy_setopt(curl_, CURLOPT_TIMEOUT, 60L);
-
-    CURLcode res = curl_easy_perform(curl_);
-    curl_slist_free_all(headers);
-
-    if (res != CURLE_OK) {
-        std::cerr << "[S3] Download failed: " << curl_easy_strerror(res) << std::endl;
+    auto res = send("GET", "/" + bucket_ + "/" + key, "", "", std::nullopt, 60000);
+    if (res.curlCode != CURLE_OK) {
+        std::cerr << "[S3] Download failed: " << res.error << std::endl;
         return std::nullopt;
     }
+    if (res.status != 200) return std::nullopt;
+    return std::move(res.body);
+}
 
-    long httpCode = 0;
-    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &httpCode);
-    if (httpCode != 200) return std::nullopt;
-    return response;
+HttpResponse S3StorageClient::downloadStream(const std::string& key, const std::optional<ByteRange>& range,
+                                             const std::string& ifMatch, HttpBodySink onBody) {
+    std::vector<std::string> headers;
+    if (range) headers.push_back("Range: " + range->header());
+    if (!ifMatch.empty()) headers.push_back("If-Match: " + ifMatch);
+    auto res = send("GET", "/" + bucket_ + "/" + key, "", "", std::nullopt, 300000, headers, std::move(onBody));
+    if (res.curlCode != CURLE_OK)
+        std::cerr << "[S3] Streaming download of " << key << " failed: " << res.error << std::endl;
+    return res;
 }
 
 bool S3StorageClient::deleteFile(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (!curl_) return false;
-    curl_easy_reset(curl_);
-
-    std::string path = "/" + bucket_ + "/" + key;
-    std::string url = endpoint_ + path;
-    std::string timestamp = getTimestamp();
-    std::string payloadHash = sha256("");
-    std::string auth = signV4("DELETE", path, "", payloadHash, "application/octet-stream", timestamp);
-
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, ("Authorization: " + auth).c_str());
-    headers = curl_slist_append(headers, ("x-amz-date: " + timestamp).c_str());
-    headers = curl_slist_append(headers, ("x-amz-content-sha256: " + payloadHash).c_str());
+    return send("DELETE", "/" + bucket_ + "/" + key, "", "", std::nullopt, 30000).ok();
+}
 
-    std::string response;
-    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl_, CURLOPT_CUSTOMREQUEST, "DELETE");
-    curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, writeCallback);
-    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response);
+std::optional<std::string> S3StorageClient::createMultipartUpload(const std::string& key,
+                                                                  const std::string& contentType) {
+    auto res = send("POST", "/" + bucket_ + "/" + key, "uploads=", "", contentType, 30000);
+    if (!res.ok()) {
+        std::cerr << "[S3] CreateMultipartUpload failed for " << key << ": "
+                  << (res.curlCode != CURLE_OK ? res.error : "HTTP " + std::to_string(res.status)) << std::endl;
+        return std::nullopt;
+    }
+    return xmlValue(res.body, "UploadId");
+}
 
-    CURLcode res = curl_easy_perform(curl_);
-    curl_slist_free_all(headers);
+std::optional<std::string> S3StorageClient::uploadPart(const std::string& key, const std::string& uploadId,
+                                                       int partNumber, std::string_view data) {
+    // The signed x-amz-content-sha256 lets S3 reject a part corrupted in transit
+    auto res = send("PUT", "/" + bucket_ + "/" + key,
+                    "partNumber=" + std::to_string(partNumber) + "&" + uploadQuery(uploadId),
+                    data, std::nullopt, 120000);
+    if (!res.ok()) return std::nullopt;
+    return res.header("etag");
+}
 
-    if (res != CURLE_OK) return false;
+bool S3StorageClient::completeMultipartUpload(const std::string& key, const std::string& uploadId,
+                                              const std::vector<std::string>& etags) {
+    std::string body = "<CompleteMultipartUpload>";
+    for (size_t i = 0; i < etags.size(); ++i) {
+        body += "<Part><PartNumber>" + std::to_string(i + 1) + "</PartNumber><ETag>"
+              + etags[i] + "</ETag></Part>";
+    }
+    body += "</CompleteMultipartUpload>";
+    auto res = send("POST", "/" + bucket_ + "/" + key, uploadQuery(uploadId), body, "application/xml", 120000);
+    // S3 can report a failed completion inside a 200 reply
+    return res.ok() && res.body.find("<Error>") == std::string::npos;
+}
 
-    long httpCode = 0;
-    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &httpCode);
-    return httpCode >= 200 && httpCode < 300;
+bool S3StorageClient::abortMultipartUpload(const std::string& key, const std::string& uploadId) {
+    return send("DELETE", "/" + bucket_ + "/" + key, uploadQuery(uploadId), "", std::nullopt, 30000).ok();
 }
 
 std::string S3StorageClient::generatePresignedDownloadUrl(const std::string& key, int expirySeconds) {
-    std::string timestamp = getTimestamp();
-    std::string dateStamp = timestamp.substr(0, 8);
-    std::string path = "/" + bucket_ + "/" + key;
-    std::string scope = dateStamp + "/" + region_ + "/s3/aws4_request";
-
-    std::string queryString =
-        "X-Amz-Algorithm=AWS4-HMAC-SHA256"
-        "&X-Amz-Credential=" + accessKey_ + "/" + scope +
-        "&X-Amz-Date=" + timestamp +
-        "&X-Amz-Expires=" + std::to_string(expirySeconds) +
-        "&X-Amz-SignedHeaders=host";
-
-    std::string host = endpoint_;
-    if (host.find("://") != std::string::npos)
-        host = host.substr(host.find("://") + 3);
-    if (!host.empty() && host.back() == '/') host.pop_back();
-
-    std::string canonicalRequest = "GET\n" + path + "\n" + queryString + "\n"
-                                  + "host:" + host + "\n\nhost\nUNSIGNED-PAYLOAD";
-    std::string stringToSign = "AWS4-HMAC-SHA256\n" + timestamp + "\n" + scope + "\n" + sha256(canonicalRequest);
-
-    std::string kDate = hmacSha256("AWS4" + secretKey_, dateStamp);
-    std::string kRegion = hmacSha256(kDate, region_);
-    std::string kService = hmacSha256(kRegion, "s3");
-    std::string kSigning = hmacSha256(kService, "aws4_request");
-    std::string signature = hmacSha256(kSigning, stringToSign);
-
-    std::ostringstream sigHex;
-    for (unsigned char c : signature)
-        sigHex << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(c);
-
-    return endpoint_ + path + "?" + queryString + "&X-Amz-Signature=" + sigHex.str();
+    return signer_.presign("GET", "/" + bucket_ + "/" + key, expirySeconds);
 }
 
 std::string S3StorageClient::generatePresignedUploadUrl(const std::string& key, int expirySeconds) {
-    std::string timestamp = getTimestamp();
-    std::string dateStamp = timestamp.substr(0, 8);
-    std::string path = "/" + bucket_ + "/" + key;
-    std::string scope = dateStamp + "/" + region_ + "/s3/aws4_request";
-
-    std::string queryString =
-        "X-Amz-Algorithm=AWS4-HMAC-SHA256"
-        "&X-Amz-Credential=" + accessKey_ + "/" + scope +
-        "&X-Amz-Date=" + timestamp +
-        "&X-Amz-Expires=" + std::to_string(expirySeconds) +
-        "&X-Amz-SignedHeaders=host";
-
-    std::string host = endpoint_;
-    if (host.find("://") != std::string::npos)
-        host = host.substr(host.find("://") + 3);
-    if (!host.empty() && host.back() == '/') host.pop_back();
-
-    std::string canonicalRequest = "PUT\n" + path + "\n" + queryString + "\n"
-                                  + "host:" + host + "\n\nhost\nUNSIGNED-PAYLOAD";
-    std::string stringToSign = "AWS4-HMAC-SHA256\n" + timestamp + "\n" + scope + "\n" + sha256(canonicalRequest);
-
-    std::string kDate = hmacSha256("AWS4" + secretKey_, dateStamp);
-    std::string kRegion = hmacSha256(kDate, region_);
-    std::string kService = hmacSha256(kRegion, "s3");
-    std::string kSigning = hmacSha256(kService, "aws4_request");
-    std::string signature = hmacSha256(kSigning, stringToSign);
-
-    std::ostringstream sigHex;
-    for (unsigned char c : signature)
-        sigHex << std::hex << std::setfill('0') << std::setw(2) << static_cast<int>(c);
-
-    return endpoint_ + path + "?" + queryString + "&X-Amz-Signature=" + sigHex.str();
+    return signer_.presign("PUT", "/" + bucket_ + "/" + key, expirySeconds);
 }
 
-std::optional<S3Object> S3StorageClient::headObject(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (!curl_) return std::nullopt;
-    curl_easy_reset(curl_);
-
-    std::string path = "/" + bucket_ + "/" + key;
-    std::string url = endpoint_ + path;
-    std::string timestamp = getTimestamp();
-    std::string payloadHash = sha256("");
-    std::string auth = signV4("HEAD", path, "", payloadHash, "application/octet-stream", timestamp);
-
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, ("Authorization: " + auth).c_str());
-    headers = curl_slist_append(headers, ("x-amz-date: " + timestamp).c_str());
-    headers = curl_slist_append(headers, ("x-amz-content-sha256: " + payloadHash).c_str());
-
-    std::string headerData;
-    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl_, CURLOPT_NOBODY, 1L);
-    curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl_, CURLOPT_HEADERFUNCTION, writeCallback);
-    curl_easy_setopt(curl_, CURLOPT_HEADERDATA, &headerData);
-
-    CURLcode res = curl_easy_perform(curl_);
-    curl_slist_free_all(headers);
-
-    if (res != CURLE_OK) return std::nullopt;
-
-    long httpCode = 0;
-    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &httpCode);
-    if (httpCode != 200) return std::nullopt;
-
-    double cl = 0;
-    curl_easy_getinfo(curl_, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &cl);
+S3HeadResult S3StorageClient::headObject(const std::string& key) {
+    auto res = send("HEAD", "/" + bucket_ + "/" + key, "", "", std::nullopt, 30000);
+    S3HeadResult result;
+    if (res.curlCode != CURLE_OK) {
+        std::cerr << "[S3] HEAD of " << key << " failed: " << res.error << std::endl;
+        return result;
+    }
+    result.status = res.status;
+    if (res.status != 200) return result;
 
     S3Object obj;
     obj.key = key;
-    obj.size = static_cast<size_t>(cl);
-    return obj;
+    obj.size = 0;
+    if (auto length = res.header("content-length")) {
+        try {
+            obj.size = static_cast<size_t>(std::stoull(*length));
+        } catch (const std::exception&) {}
+    }
+    obj.contentType = res.header("content-type").value_or("");
+    obj.lastModified = res.header("last-modified").value_or("");
+    obj.etag = res.header("etag").value_or("");
+    result.object = std::move(obj);
+    return result;
+}
+
+bool S3StorageClient::forEachObject(const std::string& prefix, const ObjectVisitor& onObject,
+                                    const std::string& delimiter, const PrefixVisitor& onPrefix,
+                                    int pageSize) {
+    VersionVisitor onEntry = [&onObject](const S3ObjectVersion& entry) { return onObject(entry.object); };
+    std::string token;
+    do {
+        std::string query;
+        addParam(query, "continuation-token", token);
+        addParam(query, "delimiter", delimiter);
+        addParam(query, "list-type", "2");
+        addParam(query, "max-keys", std::to_string(std::clamp(pageSize, 1, 1000)));
+        addParam(query, "prefix", prefix);
+
+        ListingPage page(onEntry, onPrefix);
+        auto res = send("GET", "/" + bucket_ + "/", query, "", std::nullopt, 60000, {},
+                        [&page](std::string_view chunk) { return page.feed(chunk); });
+        if (page.stopped()) return true;
+        if (!res.ok() || !page.complete() || (page.truncated && page.continuationToken.empty())) {
+            std::cerr << "[S3] Listing " << prefix << " failed: "
+                      << (res.curlCode != CURLE_OK ? res.error : "HTTP " + std::to_string(res.status)) << std::endl;
+            return false;
+        }
+        token = page.truncated ? page.continuationToken : "";
+    } while (!token.empty());
+    return true;
 }
 
-std::vector<S3Object> S3StorageClient::listObjects(const std::string& prefix, int maxKeys) {
-    // Simplified - in production use ListObjectsV2 XML parsing
-    (void)prefix;
-    (void)maxKeys;
-    return {};
+bool S3StorageClient::forEachVersion(const std::string& prefix, const VersionVisitor& onVersion, int pageSize) {
+    PrefixVisitor noPrefixes;
+    std::string keyMarker, versionIdMarker;
+    do {
+        std::string query;
+        addParam(query, "key-marker", keyMarker);
+        addParam(query, "max-keys", std::to_string(std::clamp(pageSize, 1, 1000)));
+        addParam(query, "prefix", prefix);
+        addParam(query, "version-id-marker", versionIdMarker);
+        query += query.empty() ? "versions=" : "&versions=";
+
+        ListingPage page(onVersion, noPrefixes);
+        auto res = send("GET", "/" + bucket_ + "/", query, "", std::nullopt, 60000, {},
+                        [&page](std::string_view chunk) { return page.feed(chunk); });
+        if (page.stopped()) return true;
+        if (!res.ok() || !page.complete() || (page.truncated && page.keyMarker.empty())) {
+            std::cerr << "[S3] Listing versions of " << prefix << " failed: "
+                      << (res.curlCode != CURLE_OK ? res.error : "HTTP " + std::to_string(res.status)) << std::endl;
+            return false;
+        }
+        keyMarker = page.truncated ? page.keyMarker : "";
+        versionIdMarker = page.truncated ? page.versionIdMarker : "";
+    } while (!keyMarker.empty());
+    return true;
+}
+
+std::optional<std::vector<S3Object>> S3StorageClient::listObjects(const std::string& prefix, size_t maxKeys) {
+    std::vector<S3Object> objects;
+    if (maxKeys == 0) return objects;
+    bool ok = forEachObject(prefix, [&objects, maxKeys](const S3Object& object) {
+        objects.push_back(object);
+        return objects.size() < maxKeys;
+    }, "", nullptr, static_cast<int>(std::min<size_t>(maxKeys, 1000)));
+    if (!ok) return std::nullopt;
+    return objects;
 }
 
 bool S3StorageClient::enableVersioning() {
     // PUT /{bucket}?versioning with XML body
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (!curl_) return false;
-    curl_easy_reset(curl_);
-
-    std::string path = "/" + bucket_ + "/";
-    std::string url = endpoint_ + path + "?versioning";
     std::string body = "<VersioningConfiguration><Status>Enabled</Status></VersioningConfiguration>";
-    std::string timestamp = getTimestamp();
-    std::string payloadHash = sha256(body);
-    std::string auth = signV4("PUT", path, "versioning", payloadHash, "application/xml", timestamp);
-
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, ("Authorization: " + auth).c_str());
-    headers = curl_slist_append(headers, ("x-amz-date: " + timestamp).c_str());
-    headers = curl_slist_append(headers, ("x-amz-content-sha256: " + payloadHash).c_str());
-    headers = curl_slist_append(headers, "Content-Type: application/xml");
-
-    std::string response;
-    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl_, CURLOPT_CUSTOMREQUEST, "PUT");
-    curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, body.c_str());
-    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, writeCallback);
-    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response);
-
-    CURLcode res = curl_easy_perform(curl_);
-    curl_slist_free_all(headers);
-
-    if (res != CURLE_OK) return false;
-
-    long httpCode = 0;
-    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &httpCode);
-    return httpCode >= 200 && httpCode < 300;
+    return send("PUT", "/" + bucket_ + "/", "versioning", body, "application/xml", 30000).ok();
 }
 
-std::vector<nlohmann::json> S3StorageClient::listVersions(const std::string& key) {
-    (void)key;
-    // In production: GET /{bucket}?versions&prefix={key} and parse XML
-    return {};
+std::optional<std::vector<nlohmann::json>> S3StorageClient::listVersions(const std::string& prefix) {
+    std::vector<nlohmann::json> versions;
+    bool ok = forEachVersion(prefix, [&versions](const S3ObjectVersion& v) {
+        versions.push_back({
+            {"key", v.object.key},
+            {"version_id", v.versionId},
+            {"is_latest", v.isLatest},
+            {"last_modified", v.object.lastModified},
+            {"size", v.object.size},
+            {"etag", v.object.etag},
+            {"delete_marker", v.deleteMarker}
+        });
+        return true;
+    });
+    if (!ok) return std::nullopt;
+    return versions;
 }
 
 bool S3StorageClient::bucketExists() {
-    std::lock_guard<std::mutex> lock(mtx_);
-    if (!curl_) return false;
-    curl_easy_reset(curl_);
-
-    std::string path = "/" + bucket_ + "/";
-    std::string url = endpoint_ + path;
-    std::string timestamp = getTimestamp();
-    std::string payloadHash = sha256("");
-    std::string auth = signV4("HEAD", path, "", payloadHash, "application/octet-stream", timestamp);
-
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, ("Authorization: " + auth).c_str());
-    headers = curl_slist_append(headers, ("x-amz-date: " + timestamp).c_str());
-    headers = curl_slist_append(headers, ("x-amz-content-sha256: " + payloadHash).c_str());
-
-    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl_, CURLOPT_NOBODY, 1L);
-    curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers);
-
-    CURLcode res = curl_easy_perform(curl_);
-    curl_slist_free_all(headers);
-
-    if (res != CURLE_OK) return false;
-
-    long httpCode = 0;
-    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &httpCode);
-    return httpCode == 200;
+    auto res = send("HEAD", "/" + bucket_ + "/", "", "", std::nullopt, 30000);
+    return res.curlCode == CURLE_OK && res.status == 200;
 }
@@ -1,10 +1,14 @@
 #pragma once
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <optional>
 #include <vector>
-#include <mutex>
 #include <nlohmann/json.hpp>
-#include <curl/curl.h>
+#include "src/infrastructure/http/HttpTransport.h"
+#include "src/infrastructure/storage/SigV4Signer.h"
+#include "src/utils/HttpRange.h"
 
 struct S3Object {
     std::string key;
@@ -14,53 +18,94 @@ struct S3Object {
     std::string etag;
 };
 
+// A HEAD reply. status is 0 when S3 could not be reached; object is set
+// only on a 200.
+struct S3HeadResult {
+    long status = 0;
+    std::optional<S3Object> object;
+};
+
+struct S3ObjectVersion {
+    S3Object object;
+    std::string versionId;
+    bool isLatest = false;
+    bool deleteMarker = false;   // object has no size or ETag
+};
+
 class S3StorageClient {
 public:
+    // Listing visitors return false to stop the listing
+    using ObjectVisitor = std::function<bool(const S3Object&)>;
+    using VersionVisitor = std::function<bool(const S3ObjectVersion&)>;
+    using PrefixVisitor = std::function<bool(const std::string& prefix)>;
+
     S3StorageClient(const std::string& endpoint,
                     const std::string& accessKey,
                     const std::string& secretKey,
                     const std::string& bucket,
-                    const std::string& region = "us-east-1");
-    ~S3StorageClient();
+                    const std::string& region = "us-east-1",
+                    std::shared_ptr<HttpTransport> transport = nullptr,
+                    SigV4Signer::Options signerOptions = {});
 
     // Upload/Download
     bool uploadFile(const std::string& key,
                     const std::string& data,
                     const std::string& contentType = "application/octet-stream");
     std::optional<std::string> downloadFile(const std::string& key);
+    // Streams the object, or one range of it, into onBody without buffering
+    // it. With ifMatch set, S3 answers 412 if the object has been replaced
+    // since that ETag was read.
+    HttpResponse downloadStream(const std::string& key, const std::optional<ByteRange>& range,
+                                const std::string& ifMatch, HttpBodySink onBody);
     bool deleteFile(const std::string& key);
 
+    // Multipart upload. Parts other than the last must be at least 5 MiB.
+    // uploadPart returns the part's ETag, which completeMultipartUpload
+    // needs in part order.
+    std::optional<std::string> createMultipartUpload(const std::string& key, const std::string& contentType);
+    std::optional<std::string> uploadPart(const std::string& key, const std::string& uploadId,
+                                          int partNumber, std::string_view data);
+    bool completeMultipartUpload(const std::string& key, const std::string& uploadId,
+                                 const std::vector<std::string>& etags);
+    bool abortMultipartUpload(const std::string& key, const std::string& uploadId);
+
     // Presigned URLs
     std::string generatePresignedUploadUrl(const std::string& key, int expirySeconds = 3600);
     std::string generatePresignedDownloadUrl(const std::string& key, int expirySeconds = 3600);
 
-    // Listing and metadata
-    std::vector<S3Object> listObjects(const std::string& prefix = "", int maxKeys = 1000);
-    std::optional<S3Object> headObject(const std::string& key);
+    // Listing and metadata. The forEach calls follow continuation markers
+    // to the end of the listing and parse each page as it arrives, so no
+    // page is held in memory. With a delimiter, keys that continue past it
+    // are reported once per common prefix to onPrefix instead. Visitors run
+    // inside the transfer, so they must be quick and must not throw. The
+    // calls return false if a page could not be read; stopping early is not
+    // a failure.
+    bool forEachObject(const std::string& prefix, const ObjectVisitor& onObject,
+                       const std::string& delimiter = "", const PrefixVisitor& onPrefix = nullptr,
+                       int pageSize = 1000);
+    bool forEachVersion(const std::string& prefix, const VersionVisitor& onVersion, int pageSize = 1000);
+    // Up to maxKeys objects; nullopt if S3 could not be read
+    std::optional<std::vector<S3Object>> listObjects(const std::string& prefix = "", size_t maxKeys = 1000);
+    S3HeadResult headObject(const std::string& key);
 
     // Versioning
     bool enableVersioning();
-    std::vector<nlohmann::json> listVersions(const std::string& key);
+    // Every version and delete marker under prefix
+    std::optional<std::vector<nlohmann::json>> listVersions(const std::string& prefix);
 
     // Health
     bool bucketExists();
 
 private:
-    std::string signV4(const std::string& method, const std::string& path,
-                       const std::string& queryString, const std::string& payloadHash,
-                       const std::string& contentType, const std::string& timestamp);
-    std::string hmacSha256(const std::string& key, const std::string& data);
-    std::string sha256(const std::string& data);
-    std::string getTimestamp();
-    std::string getDateStamp();
-
-    static size_t writeCallback(void* contents, size_t size, size_t nmemb, void* userp);
+    // Signs and sends one request; contentType, when given, is also sent as a header
+    HttpResponse send(const std::string& method, const std::string& path,
+                      const std::string& query, std::string_view body,
+                      const std::optional<std::string>& contentType, long timeoutMs,
+                      const std::vector<std::string>& extraHeaders = {},
+                      HttpBodySink onBody = nullptr);
 
     std::string endpoint_;
-    std::string accessKey_;
-    std::string secretKey_;
     std::string bucket_;
-    std::string region_;
-    CURL* curl_;
-    std::mutex mtx_;
+    std::shared_ptr<HttpTransport> transport_;
+    SigV4Signer signer_;
 };
@@ -0,0 +1,172 @@
+#include "SigV4Signer.h"
+#include "src/infrastructure/metrics/MetricsRegistry.h"
+#include "src/utils/Hex.h"
+#include <openssl/hmac.h>
+#include <openssl/sha.h>
+
+namespace {
+
+// Longest X-Amz-Expires S3 accepts
+constexpr int kMaxExpirySeconds = 7 * 24 * 3600;
+
+void hmac(const void* key, size_t keySize, std::string_view data, unsigned char out[32]) {
+    unsigned int len = 0;
+    HMAC(EVP_sha256(), key, static_cast<int>(keySize),
+         reinterpret_cast<const unsigned char*>(data.data()), data.size(), out, &len);
+}
+
+std::string hostOf(const std::string& endpoint) {
+    std::string host = endpoint;
+    if (auto scheme = host.find("://"); scheme != std::string::npos)
+        host = host.substr(scheme + 3);
+    if (!host.empty() && host.back() == '/') host.pop_back();
+    return host;
+}
+
+}
+
+SigV4Signer::SigV4Signer(const std::string& endpoint, const std::string& accessKey,
+                         const std::string& secretKey, const std::string& region)
+    : SigV4Signer(endpoint, accessKey, secretKey, region, Options{}) {}
+
+SigV4Signer::SigV4Signer(const std::string& endpoint, const std::string& accessKey,
+                         const std::string& secretKey, const std::string& region, Options options)
+    : endpoint_(endpoint), host_(hostOf(endpoint)), accessKey_(accessKey),
+      secretKey_(secretKey), region_(region), options_(options),
+      urls_(options_.urlCacheEntries,
+            std::chrono::duration_cast<std::chrono::milliseconds>(options_.urlCacheSeconds)),
+      urlCacheHits_(MetricsRegistry::instance().counter(
+          "s3_presign_cache_hits_total", "Presigned URLs served from the URL cache")),
+      urlCacheMisses_(MetricsRegistry::instance().counter(
+          "s3_presign_cache_misses_total", "Presigned URLs signed on request")) {
+    if (!endpoint_.empty() && endpoint_.back() == '/') endpoint_.pop_back();
+}
+
+std::string SigV4Signer::sha256Hex(std::string_view data) {
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(data.data()), data.size(), hash);
+    return toHex(hash, sizeof(hash));
+}
+
+std::string SigV4Signer::timestamp(std::time_t t) {
+    std::tm tm{};
+    gmtime_r(&t, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y%m%dT%H%M%SZ", &tm);
+    return std::string(buf);
+}
+
+std::string SigV4Signer::uriEncode(std::string_view s, bool keepSlash) {
+    static constexpr char kDigits[] = "0123456789ABCDEF";
+    std::string out;
+    out.reserve(s.size());
+    for (unsigned char c : s) {
+        bool unreserved = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+                          (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '~';
+        if (unreserved || (keepSlash && c == '/')) {
+            out += static_cast<char>(c);
+        } else {
+            out += '%';
+            out += kDigits[c >> 4];
+            out += kDigits[c & 0x0f];
+        }
+    }
+    return out;
+}
+
+std::string SigV4Signer::credentialScope(std::string_view dateStamp) const {
+    std::string scope(dateStamp);
+    scope += '/';
+    scope += region_;
+    scope += "/s3/aws4_request";
+    return scope;
+}
+
+std::string SigV4Signer::sign(std::string_view dateStamp, std::string_view stringToSign) {
+    unsigned char key[32];
+    {
+        std::scoped_lock lock(keyMtx_);
+        if (keyDate_ != dateStamp) {
+            std::string secret = "AWS4" + secretKey_;
+            hmac(secret.data(), secret.size(), dateStamp, key_);
+            hmac(key_, sizeof(key_), region_, key_);
+            hmac(key_, sizeof(key_), "s3", key_);
+            hmac(key_, sizeof(key_), "aws4_request", key_);
+            keyDate_ = dateStamp;
+        }
+        std::copy(std::begin(key_), std::end(key_), key);
+    }
+    unsigned char signature[32];
+    hmac(key, sizeof(key), stringToSign, signature);
+    return toHex(signature, sizeof(signature));
+}
+
+std::string SigV4Signer::authorization(const std::string& method, const std::string& path,
+                                       const std::string& query, const std::string& payloadHash,
+                                       const std::string& contentType, const std::string& timestamp) {
+    std::string_view dateStamp = std::string_view(timestamp).substr(0, 8);
+    static const std::string signedHeaders = "content-type;host;x-amz-content-sha256;x-amz-date";
+
+    std::string canonicalRequest;
+    canonicalRequest.reserve(256 + path.size() + query.size());
+    canonicalRequest.append(method).append("\n")
+                    .append(path).append("\n")
+                    .append(query).append("\n")
+                    .append("content-type:").append(contentType).append("\n")
+                    .append("host:").append(host_).append("\n")
+                    .append("x-amz-content-sha256:").append(payloadHash).append("\n")
+                    .append("x-amz-date:").append(timestamp).append("\n\n")
+                    .append(signedHeaders).append("\n")
+                    .append(payloadHash);
+
+    std::string scope = credentialScope(dateStamp);
+    std::string stringToSign = "AWS4-HMAC-SHA256\n" + timestamp + "\n" + scope + "\n" + sha256Hex(canonicalRequest);
+
+    return "AWS4-HMAC-SHA256 Credential=" + accessKey_ + "/" + scope
+         + ", SignedHeaders=" + signedHeaders
+         + ", Signature=" + sign(dateStamp, stringToSign);
+}
+
+std::string SigV4Signer::presign(const std::string& method, const std::string& path,
+                                 int expirySeconds, std::time_t signedAt) {
+    std::string amzDate = timestamp(signedAt);
+    std::string_view dateStamp = std::string_view(amzDate).substr(0, 8);
+    std::string scope = credentialScope(dateStamp);
+    std::string canonicalPath = uriEncode(path, true);
+
+    std::string query;
+    query.reserve(256);
+    query.append("X-Amz-Algorithm=AWS4-HMAC-SHA256&X-Amz-Credential=")
+         .append(uriEncode(accessKey_ + "/" + scope, false))
+         .append("&X-Amz-Date=").append(amzDate)
+         .append("&X-Amz-Expires=").append(std::to_string(expirySeconds))
+         .append("&X-Amz-SignedHeaders=host");
+
+    std::string canonicalRequest;
+    canonicalRequest.reserve(128 + canonicalPath.size() + query.size());
+    canonicalRequest.append(method).append("\n")
+                    .append(canonicalPath).append("\n")
+                    .append(query).append("\n")
+                    .append("host:").append(host_).append("\n\nhost\nUNSIGNED-PAYLOAD");
+
+    std::string stringToSign = "AWS4-HMAC-SHA256\n" + amzDate + "\n" + scope + "\n" + sha256Hex(canonicalRequest);
+    return endpoint_ + canonicalPath + "?" + query + "&X-Amz-Signature=" + sign(dateStamp, stringToSign);
+}
+
+std::string SigV4Signer::presign(const std::string& method, const std::string& path, int expirySeconds) {
+    std::time_t now = std::time(nullptr);
+    auto window = static_cast<std::time_t>(options_.urlCacheSeconds.count());
+    if (window <= 0 || expirySeconds + window > kMaxExpirySeconds)
+        return presign(method, path, expirySeconds, now);
+
+    std::time_t windowStart = now - now % window;
+    std::string cacheKey = method + " " + std::to_string(expirySeconds) + " " + path;
+    if (auto hit = urls_.get(cacheKey); hit && hit->window == windowStart) {
+        urlCacheHits_.inc();
+        return std::move(hit->url);
+    }
+    urlCacheMisses_.inc();
+    std::string url = presign(method, path, static_cast<int>(expirySeconds + window), windowStart);
+    urls_.put(cacheKey, CachedUrl{windowStart, url});
+    return url;
+}
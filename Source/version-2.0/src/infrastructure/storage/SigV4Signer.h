@@ -0,0 +1,75 @@
+#pragma once
+#include <chrono>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "src/utils/LruCache.h"
+
+class Counter;
+
+// AWS Signature Version 4 for S3 requests and presigned URLs. The derived
+// signing key only changes with the date, so it is computed once a day
+// instead of four HMACs per signature.
+//
+// With urlCacheSeconds > 0, presign() signs as of the start of the current
+// urlCacheSeconds window and reuses the URL for the rest of the window.
+// X-Amz-Expires is stretched by the window length, so a cached URL is
+// still valid for at least the requested time.
+class SigV4Signer {
+public:
+    struct Options {
+        std::chrono::seconds urlCacheSeconds{0};
+        size_t urlCacheEntries = 10000;
+    };
+
+    // endpoint is "scheme://host[:port]", as URLs are built on it
+    SigV4Signer(const std::string& endpoint, const std::string& accessKey,
+                const std::string& secretKey, const std::string& region);
+    SigV4Signer(const std::string& endpoint, const std::string& accessKey,
+                const std::string& secretKey, const std::string& region, Options options);
+
+    // Authorization header value; signs content-type, host,
+    // x-amz-content-sha256 and x-amz-date
+    std::string authorization(const std::string& method, const std::string& path,
+                              const std::string& query, const std::string& payloadHash,
+                              const std::string& contentType, const std::string& timestamp);
+
+    // Query-string signed URL for an unsigned payload
+    std::string presign(const std::string& method, const std::string& path, int expirySeconds);
+    // Same, signed at a fixed time and never cached
+    std::string presign(const std::string& method, const std::string& path,
+                        int expirySeconds, std::time_t signedAt);
+
+    static std::string sha256Hex(std::string_view data);
+    // "YYYYMMDDTHHMMSSZ"
+    static std::string timestamp(std::time_t t);
+    // RFC 3986 percent-encoding as SigV4 specifies it; '/' is kept when
+    // encoding a path
+    static std::string uriEncode(std::string_view s, bool keepSlash);
+
+private:
+    // HMAC-SHA256 of data with the signing key for dateStamp, hex-encoded
+    std::string sign(std::string_view dateStamp, std::string_view stringToSign);
+    std::string credentialScope(std::string_view dateStamp) const;
+
+    std::string endpoint_;
+    std::string host_;
+    std::string accessKey_;
+    std::string secretKey_;
+    std::string region_;
+    Options options_;
+
+    std::mutex keyMtx_;
+    std::string keyDate_;
+    unsigned char key_[32] = {};
+
+    struct CachedUrl {
+        std::time_t window;
+        std::string url;
+    };
+    LruCache<CachedUrl> urls_;
+
+    Counter& urlCacheHits_;
+    Counter& urlCacheMisses_;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Fails calls fast while a dependency is down. After threshold consecutive
+// failures the breaker opens and allow() is false for the cooldown. Then
+// one caller is let through as a trial: success closes the breaker,
+// failure opens it for another cooldown.
+class CircuitBreaker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CircuitBreaker(int threshold, Clock::duration cooldown)
+        : threshold_(threshold < 1 ? 1 : threshold), cooldown_(cooldown) {}
+
+    bool allow() {
+        if (failures_.load() < threshold_) return true;
+        int64_t until = openUntil_.load();
+        int64_t now = Clock::now().time_since_epoch().count();
+        if (now < until) return false;
+        // Only the caller that moves the deadline gets the trial
+        return openUntil_.compare_exchange_strong(until, now + cooldown_.count());
+    }
+
+    void recordSuccess() {
+        // Called on every success; skip the stores while closed
+        if (failures_.load() == 0) return;
+        failures_ = 0;
+        openUntil_ = 0;
+    }
+
+    // True when this failure opened the breaker
+    bool recordFailure() {
+        // Stops counting at the threshold
+        int failures = failures_.load();
+        while (failures < threshold_ && !failures_.compare_exchange_weak(failures, failures + 1)) {}
+        if (failures + 1 < threshold_) return false;
+        openUntil_ = (Clock::now() + cooldown_).time_since_epoch().count();
+        return failures + 1 == threshold_;
+    }
+
+    bool open() const {
+        return failures_.load() >= threshold_;
+    }
+
+private:
+    const int threshold_;
+    const Clock::duration cooldown_;
+    std::atomic<int> failures_{0};
+    std::atomic<int64_t> openUntil_{0};
+};
@@ -0,0 +1,161 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "src/utils/Exceptions.h"
+
+// Streaming RFC 4180 tokenizer.
+// Input is fed in arbitrary chunks; every complete record is passed to the
+// callback as string_views that are only valid during the call. Quoted fields
+// may contain delimiters, doubled quotes and line breaks; CRLF and LF line
+// endings are both accepted and blank lines are skipped. Only a record that
+// straddles two chunks is copied.
+class CsvTokenizer {
+public:
+    using Fields = std::vector<std::string_view>;
+
+    explicit CsvTokenizer(char delimiter = ',') : delim_(delimiter) {}
+
+    template <class OnRow>
+    void feed(std::string_view chunk, OnRow&& onRow) {
+        if (!pending_.empty() || pendingQuoted_) {
+            size_t end = findRecordEnd(chunk, 0, pendingQuoted_);
+            if (end == npos) {
+                pending_.append(chunk);
+                return;
+            }
+            pending_.append(chunk.substr(0, end + 1));
+            emit(pending_, onRow);
+            pending_.clear();
+            chunk.remove_prefix(end + 1);
+        }
+
+        size_t pos = 0;
+        while (pos < chunk.size()) {
+            bool quoted = false;
+            size_t end = findRecordEnd(chunk, pos, quoted);
+            if (end == npos) {
+                pending_.assign(chunk.substr(pos));
+                pendingQuoted_ = quoted;
+                return;
+            }
+            emit(chunk.substr(pos, end + 1 - pos), onRow);
+            pos = end + 1;
+        }
+    }
+
+    // Flushes a final record that has no trailing line break
+    template <class OnRow>
+    void finish(OnRow&& onRow) {
+        if (pendingQuoted_)
+            throw ValidationException("CSV ends inside a quoted field");
+        if (!pending_.empty()) emit(pending_, onRow);
+        pending_.clear();
+    }
+
+    static constexpr size_t npos = std::string_view::npos;
+
+    // Position of the line feed ending the record that starts at `from`, or
+    // npos. Exposed so callers can split raw input on record boundaries.
+    // `inQuotes` carries the quote state across calls; a doubled quote
+    // toggles it twice, so parity is enough.
+    static size_t findRecordEnd(std::string_view s, size_t from, bool& inQuotes) {
+        while (true) {
+            size_t p = findEither(s, from, '"', '\n');
+            if (p == npos) return npos;
+            if (s[p] == '"') inQuotes = !inQuotes;
+            else if (!inQuotes) return p;
+            from = p + 1;
+        }
+    }
+
+private:
+    // Index of the first byte at or after `from` equal to a or b, or npos
+    static size_t findEither(std::string_view s, size_t from, char a, char b) {
+#if defined(__SSE2__)
+        const __m128i va = _mm_set1_epi8(a);
+        const __m128i vb = _mm_set1_epi8(b);
+        while (from + 16 <= s.size()) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s.data() + from));
+            int mask = _mm_movemask_epi8(
+                _mm_or_si128(_mm_cmpeq_epi8(block, va), _mm_cmpeq_epi8(block, vb)));
+            if (mask) return from + static_cast<size_t>(__builtin_ctz(mask));
+            from += 16;
+        }
+#endif
+        for (; from < s.size(); ++from)
+            if (s[from] == a || s[from] == b) return from;
+        return npos;
+    }
+
+    template <class OnRow>
+    void emit(std::string_view record, OnRow& onRow) {
+        if (!record.empty() && record.back() == '\n') record.remove_suffix(1);
+        if (!record.empty() && record.back() == '\r') record.remove_suffix(1);
+        if (record.empty()) return;
+
+        fields_.clear();
+        scratch_.clear();
+        // Unescaped fields never outgrow their record, so views into scratch_ stay valid
+        scratch_.reserve(record.size());
+
+        size_t pos = 0;
+        while (true) {
+            if (pos < record.size() && record[pos] == '"') {
+                pos = parseQuoted(record, pos);
+            } else {
+                size_t end = findEither(record, pos, delim_, delim_);
+                if (end == npos) end = record.size();
+                fields_.push_back(record.substr(pos, end - pos));
+                pos = end;
+            }
+            if (pos >= record.size()) break;
+            ++pos; // skip delimiter
+            if (pos == record.size()) {
+                fields_.emplace_back();
+                break;
+            }
+        }
+        onRow(static_cast<const Fields&>(fields_));
+    }
+
+    // Parses the quoted field starting at `pos` and returns the index just past it
+    size_t parseQuoted(std::string_view record, size_t pos) {
+        size_t start = pos + 1;
+        size_t scratchStart = npos;
+        size_t cur = start;
+        while (true) {
+            size_t q = findEither(record, cur, '"', '"');
+            if (q == npos)
+                throw ValidationException("CSV quoted field is not terminated");
+            if (q + 1 < record.size() && record[q + 1] == '"') {
+                // Escaped quote: switch to the scratch buffer for this field
+                if (scratchStart == npos) scratchStart = scratch_.size();
+                scratch_.append(record.substr(cur, q + 1 - cur));
+                cur = q + 2;
+                continue;
+            }
+
+            if (scratchStart == npos) {
+                fields_.push_back(record.substr(start, q - start));
+            } else {
+                scratch_.append(record.substr(cur, q - cur));
+                fields_.push_back(std::string_view(scratch_).substr(scratchStart));
+            }
+            size_t next = q + 1;
+            if (next < record.size() && record[next] != delim_)
+                throw ValidationException("CSV has text after a closing quote");
+            return next;
+        }
+    }
+
+    char delim_;
+    std::string pending_;
+    bool pendingQuoted_ = false;
+    Fields fields_;
+    std::string scratch_;
+};
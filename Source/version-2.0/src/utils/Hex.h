@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Lower-case hex; out must have room for 2 * size characters
+inline void hexEncode(const unsigned char* data, size_t size, char* out) {
+    static constexpr char kDigits[] = "0123456789abcdef";
+    for (size_t i = 0; i < size; ++i) {
+        out[2 * i] = kDigits[data[i] >> 4];
+        out[2 * i + 1] = kDigits[data[i] & 0x0f];
+    }
+}
+
+inline std::string toHex(const unsigned char* data, size_t size) {
+    std::string out(2 * size, '\0');
+    hexEncode(data, size, out.data());
+    return out;
+}
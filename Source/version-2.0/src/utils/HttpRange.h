@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Inclusive byte range, as in Range and Content-Range
+struct ByteRange {
+    uint64_t first = 0;
+    uint64_t last = 0;
+
+    uint64_t length() const { return last - first + 1; }
+    std::string header() const { return "bytes=" + std::to_string(first) + "-" + std::to_string(last); }
+    std::string contentRange(uint64_t size) const {
+        return "bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(size);
+    }
+};
+
+struct RangeRequest {
+    enum class Kind { Whole, Partial, Unsatisfiable };
+    Kind kind = Kind::Whole;
+    ByteRange range;
+};
+
+namespace http_range_detail {
+
+inline bool parseUint(std::string_view s, uint64_t& out) {
+    if (s.empty() || s.size() > 19) return false;
+    out = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+        out = out * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return true;
+}
+
+inline std::string_view trimView(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+}
+
+// Resolves a Range header against an object of size bytes. Only a single
+// "bytes=" range is served partially; a missing, malformed or multi-range
+// header means the whole object, which RFC 9110 allows.
+inline RangeRequest parseRange(std::string_view header, uint64_t size) {
+    using namespace http_range_detail;
+    RangeRequest out;
+    header = trimView(header);
+    if (header.substr(0, 6) != "bytes=") return out;
+    std::string_view spec = trimView(header.substr(6));
+    if (spec.find(',') != std::string_view::npos) return out;
+    auto dash = spec.find('-');
+    if (dash == std::string_view::npos) return out;
+    std::string_view from = trimView(spec.substr(0, dash));
+    std::string_view to = trimView(spec.substr(dash + 1));
+
+    uint64_t a = 0, b = 0;
+    if (from.empty()) {
+        // Suffix range: the last b bytes
+        if (!parseUint(to, b)) return out;
+        if (b == 0 || size == 0) {
+            out.kind = RangeRequest::Kind::Unsatisfiable;
+            return out;
+        }
+        out.kind = RangeRequest::Kind::Partial;
+        out.range = {b >= size ? 0 : size - b, size - 1};
+        return out;
+    }
+    if (!parseUint(from, a)) return out;
+    if (to.empty()) {
+        b = UINT64_MAX;
+    } else if (!parseUint(to, b) || b < a) {
+        return out;
+    }
+    if (a >= size) {
+        out.kind = RangeRequest::Kind::Unsatisfiable;
+        return out;
+    }
+    out.kind = RangeRequest::Kind::Partial;
+    out.range = {a, b >= size ? size - 1 : b};
+    return out;
+}
+
+// Weak comparison of an If-None-Match list against an entity tag
+inline bool etagMatches(std::string_view ifNoneMatch, std::string_view etag) {
+    using namespace http_range_detail;
+    auto opaque = [](std::string_view tag) {
+        tag = trimView(tag);
+        if (tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+        return tag;
+    };
+    std::string_view target = opaque(etag);
+    if (target.empty()) return false;
+    while (!ifNoneMatch.empty()) {
+        auto comma = ifNoneMatch.find(',');
+        std::string_view tag = opaque(ifNoneMatch.substr(0, comma));
+        if (tag == "*" || tag == target) return true;
+        if (comma == std::string_view::npos) break;
+        ifNoneMatch.remove_prefix(comma + 1);
+    }
+    return false;
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "src/utils/Exceptions.h"
+
+// SAX handler that hands each element of the records array to onRecord as
+// its own json value, so only one record is materialized at a time.
+// Anything outside the records array is skipped.
+class JsonRecordReader : public nlohmann::json_sax<nlohmann::json> {
+public:
+    using json = nlohmann::json;
+
+    explicit JsonRecordReader(std::function<void(json&&)> onRecord)
+        : onRecord_(std::move(onRecord)) {}
+
+    bool sawRecords() const { return recordsDepth_ > 0; }
+
+    bool null() override { return value(nullptr); }
+    bool boolean(bool v) override { return value(v); }
+    bool number_integer(number_integer_t v) override { return value(v); }
+    bool number_unsigned(number_unsigned_t v) override { return value(v); }
+    bool number_float(number_float_t v, const string_t&) override { return value(v); }
+    bool string(string_t& v) override { return value(std::move(v)); }
+    bool binary(binary_t& v) override { return value(json::binary(std::move(v))); }
+
+    bool start_object(std::size_t) override {
+        open(json::object());
+        return true;
+    }
+
+    bool end_object() override {
+        close();
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        // Top-level array, or the array under a top-level "records" key
+        if (stack_.empty() && !inRecords_ && (depth_ == 0 || (depth_ == 1 && topKey_ == "records"))) {
+            inRecords_ = true;
+            recordsDepth_ = ++depth_;
+            return true;
+        }
+        open(json::array());
+        return true;
+    }
+
+    bool end_array() override {
+        if (inRecords_ && stack_.empty() && depth_ == recordsDepth_) {
+            inRecords_ = false;
+            --depth_;
+            return true;
+        }
+        close();
+        return true;
+    }
+
+    bool key(string_t& k) override {
+        if (stack_.empty()) topKey_ = k;
+        else key_ = k;
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string&,
+                     const nlohmann::detail::exception& ex) override {
+        throw ValidationException("Invalid JSON at byte " + std::to_string(position) + ": " + ex.what());
+    }
+
+private:
+    bool atRecordLevel() const { return inRecords_ && stack_.empty() && depth_ == recordsDepth_; }
+
+    json* insert(json&& v) {
+        json& top = *stack_.back();
+        if (top.is_array()) {
+            top.push_back(std::move(v));
+            return &top.back();
+        }
+        json& slot = top[key_];
+        slot = std::move(v);
+        return &slot;
+    }
+
+    bool value(json&& v) {
+        if (atRecordLevel()) onRecord_(std::move(v));
+        else if (!stack_.empty()) insert(std::move(v));
+        return true;
+    }
+
+    void open(json&& container) {
+        if (atRecordLevel()) {
+            current_ = std::move(container);
+            stack_.push_back(&current_);
+        } else if (!stack_.empty()) {
+            stack_.push_back(insert(std::move(container)));
+        }
+        ++depth_;
+    }
+
+    void close() {
+        --depth_;
+        if (stack_.empty()) return;
+        stack_.pop_back();
+        if (stack_.empty()) onRecord_(std::move(current_));
+    }
+
+    std::function<void(json&&)> onRecord_;
+    json current_;
+    std::vector<json*> stack_;  // open containers of the current record
+    std::string key_;           // pending key inside the current record
+    std::string topKey_;        // last key seen outside any record
+    int depth_ = 0;
+    int recordsDepth_ = 0;
+    bool inRecords_ = false;
+};
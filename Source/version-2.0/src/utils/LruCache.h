@@ -0,0 +1,84 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+// Thread-safe string-keyed LRU with a per-entry time to live. get() moves
+// a hit to the front; put() evicts from the back once capacity is reached.
+template <typename V>
+class LruCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    LruCache(size_t capacity, std::chrono::milliseconds ttl)
+        : capacity_(capacity == 0 ? 1 : capacity), ttl_(ttl) {}
+
+    std::optional<V> get(const std::string& key) {
+        std::scoped_lock lock(mtx_);
+        auto it = index_.find(key);
+        if (it == index_.end()) return std::nullopt;
+        if (Clock::now() >= it->second->expires) {
+            entries_.erase(it->second);
+            index_.erase(it);
+            return std::nullopt;
+        }
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->value;
+    }
+
+    void put(const std::string& key, V value) {
+        std::scoped_lock lock(mtx_);
+        auto expires = Clock::now() + ttl_;
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            it->second->value = std::move(value);
+            it->second->expires = expires;
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return;
+        }
+        if (entries_.size() >= capacity_) {
+            index_.erase(entries_.back().key);
+            entries_.pop_back();
+        }
+        entries_.push_front(Entry{key, std::move(value), expires});
+        index_.emplace(key, entries_.begin());
+    }
+
+    bool erase(const std::string& key) {
+        std::scoped_lock lock(mtx_);
+        auto it = index_.find(key);
+        if (it == index_.end()) return false;
+        entries_.erase(it->second);
+        index_.erase(it);
+        return true;
+    }
+
+    void clear() {
+        std::scoped_lock lock(mtx_);
+        entries_.clear();
+        index_.clear();
+    }
+
+    size_t size() const {
+        std::scoped_lock lock(mtx_);
+        return entries_.size();
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        V value;
+        Clock::time_point expires;
+    };
+
+    size_t capacity_;
+    std::chrono::milliseconds ttl_;
+    mutable std::mutex mtx_;
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, typename std::list<Entry>::iterator> index_;
+};
@@ -0,0 +1,111 @@
+#pragma once
+#include <cctype>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One part of a multipart/form-data body. body views the request body,
+// which must outlive it.
+struct MultipartPart {
+    std::string name;
+    std::string filename;
+    std::string contentType;
+    std::string_view body;
+};
+
+namespace multipart_detail {
+
+inline bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+            return false;
+    }
+    return true;
+}
+
+inline std::string_view trimView(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+// Value of param in a header such as `form-data; name="file"`, quotes removed
+inline std::optional<std::string> headerParam(std::string_view header, std::string_view param) {
+    size_t pos = 0;
+    while ((pos = header.find(';', pos)) != std::string_view::npos) {
+        std::string_view rest = trimView(header.substr(pos + 1));
+        auto eq = rest.find('=');
+        if (eq != std::string_view::npos && iequals(trimView(rest.substr(0, eq)), param)) {
+            std::string_view value = rest.substr(eq + 1);
+            if (!value.empty() && value.front() == '"') {
+                auto close = value.find('"', 1);
+                if (close == std::string_view::npos) return std::nullopt;
+                return std::string(value.substr(1, close - 1));
+            }
+            return std::string(trimView(value.substr(0, value.find(';'))));
+        }
+        ++pos;
+    }
+    return std::nullopt;
+}
+
+}
+
+// The boundary of a multipart/form-data Content-Type, if it is one
+inline std::optional<std::string> multipartBoundary(std::string_view contentType) {
+    using namespace multipart_detail;
+    auto semi = contentType.find(';');
+    if (!iequals(trimView(contentType.substr(0, semi)), "multipart/form-data")) return std::nullopt;
+    auto boundary = headerParam(contentType, "boundary");
+    if (!boundary || boundary->empty()) return std::nullopt;
+    return boundary;
+}
+
+// Splits a multipart body into parts without copying their contents.
+// Returns nullopt when the body is not well-formed.
+inline std::optional<std::vector<MultipartPart>> parseMultipart(std::string_view body, std::string_view boundary) {
+    using namespace multipart_detail;
+    const std::string delimiter = "--" + std::string(boundary);
+    const std::string nextDelimiter = "\r\n" + delimiter;
+
+    auto pos = body.find(delimiter);
+    if (pos == std::string_view::npos) return std::nullopt;
+    pos += delimiter.size();
+
+    std::vector<MultipartPart> parts;
+    while (true) {
+        if (body.substr(pos, 2) == "--") return parts;
+        if (body.substr(pos, 2) != "\r\n") return std::nullopt;
+        pos += 2;
+
+        auto headersEnd = body.find("\r\n\r\n", pos);
+        if (headersEnd == std::string_view::npos) return std::nullopt;
+        MultipartPart part;
+        std::string_view headers = body.substr(pos, headersEnd - pos + 2);
+        size_t line = 0;
+        while (line < headers.size()) {
+            auto eol = headers.find("\r\n", line);
+            std::string_view header = headers.substr(line, eol - line);
+            line = eol + 2;
+            auto colon = header.find(':');
+            if (colon == std::string_view::npos) continue;
+            std::string_view name = trimView(header.substr(0, colon));
+            std::string_view value = trimView(header.substr(colon + 1));
+            if (iequals(name, "Content-Disposition")) {
+                part.name = headerParam(value, "name").value_or("");
+                part.filename = headerParam(value, "filename").value_or("");
+            } else if (iequals(name, "Content-Type")) {
+                part.contentType = std::string(value);
+            }
+        }
+
+        auto bodyStart = headersEnd + 4;
+        auto bodyEnd = body.find(nextDelimiter, bodyStart);
+        if (bodyEnd == std::string_view::npos) return std::nullopt;
+        part.body = body.substr(bodyStart, bodyEnd - bodyStart);
+        parts.push_back(std::move(part));
+        pos = bodyEnd + nextDelimiter.size();
+    }
+}
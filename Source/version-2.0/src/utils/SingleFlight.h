@@ -0,0 +1,51 @@
+#pragma once
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Coalesces concurrent calls for the same key. The first caller for a key
+// becomes the leader and does the work; callers that join while it is in
+// flight are queued and receive the leader's result. Results are not kept
+// once delivered, so a later call starts a new flight.
+template <typename T>
+class SingleFlight {
+public:
+    using Callback = std::function<void(const T&, std::exception_ptr)>;
+
+    // Registers cb for key; true if the caller is the leader and must
+    // eventually call complete(key, ...)
+    bool join(const std::string& key, Callback cb) {
+        std::scoped_lock lock(mtx_);
+        auto [it, leader] = flights_.try_emplace(key);
+        it->second.push_back(std::move(cb));
+        return leader;
+    }
+
+    // Delivers the result to every caller waiting on key; returns how many
+    // callers shared it
+    size_t complete(const std::string& key, const T& value, std::exception_ptr error = nullptr) {
+        std::vector<Callback> waiters;
+        {
+            std::scoped_lock lock(mtx_);
+            auto it = flights_.find(key);
+            if (it == flights_.end()) return 0;
+            waiters = std::move(it->second);
+            flights_.erase(it);
+        }
+        for (auto& cb : waiters) cb(value, error);
+        return waiters.size();
+    }
+
+    size_t inFlight() const {
+        std::scoped_lock lock(mtx_);
+        return flights_.size();
+    }
+
+private:
+    mutable std::mutex mtx_;
+    std::unordered_map<std::string, std::vector<Callback>> flights_;
+};
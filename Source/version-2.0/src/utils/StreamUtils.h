@@ -0,0 +1,21 @@
+#pragma once
+#include <istream>
+#include <streambuf>
+#include <string_view>
+
+// Read-only streambuf over memory owned elsewhere (e.g. a request body)
+class MemoryStreamBuf : public std::streambuf {
+public:
+    explicit MemoryStreamBuf(std::string_view data) {
+        char* begin = const_cast<char*>(data.data());
+        setg(begin, begin, begin + data.size());
+    }
+};
+
+// Lets stream-based parsers read a buffer without copying it into a stringstream.
+// The viewed memory must outlive the stream.
+class MemoryIStream : private MemoryStreamBuf, public std::istream {
+public:
+    explicit MemoryIStream(std::string_view data)
+        : MemoryStreamBuf(data), std::istream(static_cast<std::streambuf*>(this)) {}
+};
@@ -1,5 +1,7 @@
 #pragma once
+#include <cctype>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
 #include <sstream>
@@ -34,3 +36,21 @@ inline bool endsWith(const std::string& s, const std::string& suffix) {
     return s.size() >= suffix.size() &&
            s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
 }
+
+// Lower-cased, trimmed, with runs of whitespace collapsed to one space;
+// the form search keys are compared in
+inline std::string normalizeSearchText(std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+    bool space = false;
+    for (unsigned char c : text) {
+        if (std::isspace(c)) {
+            space = !out.empty();
+            continue;
+        }
+        if (space) out.push_back(' ');
+        space = false;
+        out.push_back(static_cast<char>(std::tolower(c)));
+    }
+    return out;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Approximate access frequency over a sliding window, as TinyLFU uses it
+// to decide whether a new item deserves a victim's place. A count-min
+// sketch of 4-bit counters, four rows. After sampleSize increments every
+// counter is halved, so old popularity fades. Not thread-safe.
+class TinyLfu {
+public:
+    explicit TinyLfu(size_t sampleSize) : sampleSize_(sampleSize == 0 ? 1 : sampleSize) {
+        size_t width = 64;
+        while (width < sampleSize_) width <<= 1;
+        mask_ = width - 1;
+        // Two counters per byte
+        table_.assign(kRows * width / 2, 0);
+    }
+
+    void increment(uint64_t hash) {
+        bool added = false;
+        for (size_t row = 0; row < kRows; ++row) {
+            size_t i = index(hash, row);
+            uint8_t& cell = table_[i / 2];
+            unsigned shift = (i % 2) * 4;
+            if (((cell >> shift) & 0x0f) < 15) {
+                cell = static_cast<uint8_t>(cell + (1u << shift));
+                added = true;
+            }
+        }
+        if (added && ++additions_ >= sampleSize_) halve();
+    }
+
+    unsigned estimate(uint64_t hash) const {
+        unsigned min = 15;
+        for (size_t row = 0; row < kRows; ++row) {
+            size_t i = index(hash, row);
+            unsigned count = (table_[i / 2] >> ((i % 2) * 4)) & 0x0f;
+            if (count < min) min = count;
+        }
+        return min;
+    }
+
+    // True when candidate has been seen more often than victim
+    bool admit(uint64_t candidate, uint64_t victim) const {
+        return estimate(candidate) > estimate(victim);
+    }
+
+private:
+    static constexpr size_t kRows = 4;
+    static constexpr std::array<uint64_t, kRows> kSeeds = {
+        0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL, 0x165667b19e3779f9ULL, 0xd6e8feb86659fd93ULL};
+
+    size_t index(uint64_t hash, size_t row) const {
+        uint64_t h = (hash + kSeeds[row]) * kSeeds[(row + 1) % kRows];
+        h ^= h >> 32;
+        return row * (mask_ + 1) + static_cast<size_t>(h & mask_);
+    }
+
+    void halve() {
+        // Halves both nibbles of each byte at once
+        for (auto& cell : table_) cell = static_cast<uint8_t>((cell >> 1) & 0x77);
+        additions_ /= 2;
+    }
+
+    size_t sampleSize_;
+    size_t mask_ = 0;
+    size_t additions_ = 0;
+    std::vector<uint8_t> table_;
+};
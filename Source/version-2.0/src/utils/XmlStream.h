@@ -0,0 +1,198 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Incremental XML parser for S3's replies. Bytes are fed as they arrive
+// and only an unfinished tag is carried between chunks, so a large
+// listing is parsed while it downloads. onStart gets each opening tag,
+// onEnd each closing tag with the character data since the last tag,
+// entities decoded; for a leaf element that is its value. Attributes,
+// the prolog and comments are skipped. No DTDs or namespaces.
+class XmlStream {
+public:
+    using StartHandler = std::function<void(std::string_view name)>;
+    using EndHandler = std::function<void(std::string_view name, std::string_view text)>;
+
+    XmlStream(StartHandler onStart, EndHandler onEnd)
+        : onStart_(std::move(onStart)), onEnd_(std::move(onEnd)) {}
+
+    // False once the input is malformed
+    bool feed(std::string_view chunk) {
+        if (failed_) return false;
+        buffer_.append(chunk.data(), chunk.size());
+        size_t pos = 0;
+        while (pos < buffer_.size() && !failed_) {
+            size_t lt = buffer_.find('<', pos);
+            if (lt == std::string::npos) {
+                rawText_.append(buffer_, pos, std::string::npos);
+                pos = buffer_.size();
+                break;
+            }
+            rawText_.append(buffer_, pos, lt - pos);
+            size_t next = markup(lt);
+            if (next == std::string::npos) {
+                pos = lt;
+                break;
+            }
+            pos = next;
+        }
+        buffer_.erase(0, pos);
+        if (buffer_.size() > kMaxTagBytes || rawText_.size() > kMaxTextBytes) failed_ = true;
+        return !failed_;
+    }
+
+    // True when a whole document has been fed
+    bool complete() const { return !failed_ && seenRoot_ && stack_.empty() && buffer_.empty(); }
+    bool failed() const { return failed_; }
+
+    // Open elements, counting the one whose tag is being reported
+    size_t depth() const { return stack_.size(); }
+
+private:
+    static constexpr size_t kMaxTagBytes = 64 * 1024;
+    static constexpr size_t kMaxTextBytes = 1024 * 1024;
+
+    // Handles the markup at lt; the position after it, or npos if it has
+    // not all arrived yet
+    size_t markup(size_t lt) {
+        std::string_view rest = std::string_view(buffer_).substr(lt);
+        if (rest.size() < 2) return std::string::npos;
+
+        if (rest[1] == '!') {
+            if (rest.size() < 9) return std::string::npos;
+            if (rest.substr(0, 4) == "<!--") return skipPast(lt, "-->");
+            if (rest.substr(0, 9) == "<![CDATA[") {
+                size_t end = buffer_.find("]]>", lt + 9);
+                if (end == std::string::npos) return std::string::npos;
+                flushText();
+                text_.append(buffer_, lt + 9, end - lt - 9);
+                return end + 3;
+            }
+            return skipPast(lt, ">");
+        }
+        if (rest[1] == '?') return skipPast(lt, "?>");
+
+        size_t gt = buffer_.find('>', lt);
+        if (gt == std::string::npos) return std::string::npos;
+        std::string_view tag = std::string_view(buffer_).substr(lt + 1, gt - lt - 1);
+        flushText();
+        if (failed_) return std::string::npos;
+
+        if (!tag.empty() && tag[0] == '/') {
+            std::string_view name = trim(tag.substr(1));
+            if (stack_.empty() || stack_.back() != name) {
+                failed_ = true;
+                return std::string::npos;
+            }
+            if (onEnd_) onEnd_(name, text_);
+            stack_.pop_back();
+        } else {
+            bool selfClosing = !tag.empty() && tag.back() == '/';
+            if (selfClosing) tag.remove_suffix(1);
+            std::string_view name = tag.substr(0, tag.find_first_of(" \t\r\n"));
+            if (name.empty() || (stack_.empty() && seenRoot_)) {
+                failed_ = true;
+                return std::string::npos;
+            }
+            seenRoot_ = true;
+            stack_.emplace_back(name);
+            if (onStart_) onStart_(name);
+            if (selfClosing) {
+                if (onEnd_) onEnd_(name, {});
+                stack_.pop_back();
+            }
+        }
+        text_.clear();
+        return gt + 1;
+    }
+
+    size_t skipPast(size_t from, std::string_view terminator) {
+        size_t end = buffer_.find(terminator, from + 2);
+        return end == std::string::npos ? std::string::npos : end + terminator.size();
+    }
+
+    static std::string_view trim(std::string_view s) {
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r' || s.back() == '\n'))
+            s.remove_suffix(1);
+        return s;
+    }
+
+    // Decodes the text read since the last markup into text_. Entities
+    // cannot span markup, so the pending text always holds whole ones.
+    void flushText() {
+        size_t pos = 0;
+        while (pos < rawText_.size()) {
+            size_t amp = rawText_.find('&', pos);
+            text_.append(rawText_, pos, amp == std::string::npos ? std::string::npos : amp - pos);
+            if (amp == std::string::npos) break;
+            size_t semi = rawText_.find(';', amp);
+            if (semi == std::string::npos || !appendEntity(std::string_view(rawText_).substr(amp + 1, semi - amp - 1))) {
+                failed_ = true;
+                break;
+            }
+            pos = semi + 1;
+        }
+        rawText_.clear();
+    }
+
+    bool appendEntity(std::string_view entity) {
+        if (entity == "amp") text_ += '&';
+        else if (entity == "lt") text_ += '<';
+        else if (entity == "gt") text_ += '>';
+        else if (entity == "quot") text_ += '"';
+        else if (entity == "apos") text_ += '\'';
+        else if (entity.size() > 1 && entity[0] == '#') {
+            bool hex = entity[1] == 'x' || entity[1] == 'X';
+            std::string_view digits = entity.substr(hex ? 2 : 1);
+            if (digits.empty() || digits.size() > 8) return false;
+            uint32_t cp = 0;
+            for (char c : digits) {
+                int d;
+                if (c >= '0' && c <= '9') d = c - '0';
+                else if (hex && c >= 'a' && c <= 'f') d = c - 'a' + 10;
+                else if (hex && c >= 'A' && c <= 'F') d = c - 'A' + 10;
+                else return false;
+                cp = cp * (hex ? 16 : 10) + static_cast<uint32_t>(d);
+            }
+            return appendUtf8(cp);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool appendUtf8(uint32_t cp) {
+        if (cp < 0x80) {
+            text_ += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            text_ += static_cast<char>(0xc0 | (cp >> 6));
+            text_ += static_cast<char>(0x80 | (cp & 0x3f));
+        } else if (cp < 0x10000) {
+            if (cp >= 0xd800 && cp <= 0xdfff) return false;
+            text_ += static_cast<char>(0xe0 | (cp >> 12));
+            text_ += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            text_ += static_cast<char>(0x80 | (cp & 0x3f));
+        } else if (cp <= 0x10ffff) {
+            text_ += static_cast<char>(0xf0 | (cp >> 18));
+            text_ += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+            text_ += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            text_ += static_cast<char>(0x80 | (cp & 0x3f));
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    StartHandler onStart_;
+    EndHandler onEnd_;
+    std::string buffer_;     // unconsumed input, at most one unfinished tag
+    std::string rawText_;    // text since the last markup, entities not yet decoded
+    std::string text_;       // decoded text since the last tag
+    std::vector<std::string> stack_;
+    bool seenRoot_ = false;
+    bool failed_ = false;
+};
@@ -0,0 +1,209 @@
+#pragma once
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Minimal HTTP/1.1 server on 127.0.0.1 for tests of the HTTP clients. Every
+// connection gets its own thread and is kept alive; the handler runs on that
+// thread, so concurrent requests reach it concurrently.
+class FakeHttpServer {
+public:
+    struct Request {
+        std::string method;
+        std::string target;                         // path and query
+        std::map<std::string, std::string> headers; // lower-case names
+        std::string body;
+
+        std::string header(const std::string& name) const {
+            auto it = headers.find(name);
+            return it == headers.end() ? "" : it->second;
+        }
+    };
+
+    struct Response {
+        int status = 200;
+        std::string body;
+        std::vector<std::pair<std::string, std::string>> headers;
+    };
+
+    using Handler = std::function<Response(const Request&)>;
+
+    explicit FakeHttpServer(Handler handler) : handler_(std::move(handler)) {
+        listenFd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+            || ::listen(listenFd_, 64) != 0)
+            throw std::runtime_error("FakeHttpServer: cannot listen");
+        socklen_t len = sizeof(addr);
+        ::getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        acceptor_ = std::thread([this] { acceptLoop(); });
+    }
+
+    ~FakeHttpServer() {
+        stopping_ = true;
+        ::shutdown(listenFd_, SHUT_RDWR);
+        ::close(listenFd_);
+        acceptor_.join();
+        std::vector<std::thread> threads;
+        {
+            std::scoped_lock lock(mtx_);
+            for (int fd : openFds_) ::shutdown(fd, SHUT_RDWR);
+            threads.swap(threads_);
+        }
+        for (auto& t : threads) t.join();
+    }
+
+    FakeHttpServer(const FakeHttpServer&) = delete;
+    FakeHttpServer& operator=(const FakeHttpServer&) = delete;
+
+    std::string url() const { return "http://127.0.0.1:" + std::to_string(port_); }
+
+    // Connections accepted and requests answered so far
+    size_t connections() const { return connections_; }
+    size_t requests() const { return requests_; }
+
+private:
+    void acceptLoop() {
+        while (!stopping_) {
+            int fd = ::accept(listenFd_, nullptr, nullptr);
+            if (fd < 0) return;
+            ++connections_;
+            std::scoped_lock lock(mtx_);
+            openFds_.push_back(fd);
+            threads_.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+
+    void serve(int fd) {
+        std::string buffer;
+        while (!stopping_) {
+            Request request;
+            if (!readRequest(fd, buffer, request)) break;
+            Response response = handler_(request);
+            ++requests_;
+            if (!writeResponse(fd, request, response)) break;
+            if (request.header("connection") == "close") break;
+        }
+        {
+            std::scoped_lock lock(mtx_);
+            openFds_.erase(std::remove(openFds_.begin(), openFds_.end(), fd), openFds_.end());
+        }
+        ::close(fd);
+    }
+
+    static bool fill(int fd, std::string& buffer) {
+        char chunk[16 * 1024];
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    static bool readLine(int fd, std::string& buffer, std::string& line) {
+        size_t end;
+        while ((end = buffer.find("\r\n")) == std::string::npos)
+            if (!fill(fd, buffer)) return false;
+        line = buffer.substr(0, end);
+        buffer.erase(0, end + 2);
+        return true;
+    }
+
+    static bool readExactly(int fd, std::string& buffer, size_t n, std::string& out) {
+        while (buffer.size() < n)
+            if (!fill(fd, buffer)) return false;
+        out.append(buffer, 0, n);
+        buffer.erase(0, n);
+        return true;
+    }
+
+    static bool readRequest(int fd, std::string& buffer, Request& request) {
+        std::string line;
+        if (!readLine(fd, buffer, line)) return false;
+        auto sp1 = line.find(' ');
+        auto sp2 = line.find(' ', sp1 + 1);
+        if (sp1 == std::string::npos || sp2 == std::string::npos) return false;
+        request.method = line.substr(0, sp1);
+        request.target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+
+        while (true) {
+            if (!readLine(fd, buffer, line)) return false;
+            if (line.empty()) break;
+            auto colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            std::string name = line.substr(0, colon);
+            std::transform(name.begin(), name.end(), name.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            auto value = line.substr(colon + 1);
+            value.erase(0, value.find_first_not_of(' '));
+            request.headers[name] = value;
+        }
+
+        if (request.header("expect") == "100-continue") {
+            static const char kContinue[] = "HTTP/1.1 100 Continue\r\n\r\n";
+            if (::send(fd, kContinue, sizeof(kContinue) - 1, MSG_NOSIGNAL) < 0) return false;
+        }
+
+        if (request.header("transfer-encoding") == "chunked") {
+            while (true) {
+                if (!readLine(fd, buffer, line)) return false;
+                size_t size = std::stoul(line, nullptr, 16);
+                if (!readExactly(fd, buffer, size, request.body)) return false;
+                if (!readLine(fd, buffer, line)) return false;
+                if (size == 0) return true;
+            }
+        }
+        auto length = request.header("content-length");
+        return length.empty() || readExactly(fd, buffer, std::stoul(length), request.body);
+    }
+
+    static bool writeResponse(int fd, const Request& request, const Response& response) {
+        std::string out = "HTTP/1.1 " + std::to_string(response.status) + " Fake\r\n";
+        bool hasLength = false;
+        for (const auto& [name, value] : response.headers) {
+            out += name + ": " + value + "\r\n";
+            std::string lower = name;
+            std::transform(lower.begin(), lower.end(), lower.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            hasLength |= lower == "content-length";
+        }
+        if (!hasLength) out += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+        out += "\r\n";
+        if (request.method != "HEAD") out += response.body;
+
+        size_t sent = 0;
+        while (sent < out.size()) {
+            ssize_t n = ::send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    Handler handler_;
+    int listenFd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> stopping_{false};
+    std::atomic<size_t> connections_{0};
+    std::atomic<size_t> requests_{0};
+    std::mutex mtx_;
+    std::vector<int> openFds_;
+    std::vector<std::thread> threads_;
+    std::thread acceptor_;
+};
@@ -0,0 +1,241 @@
+#pragma once
+#include "FakeHttpServer.h"
+#include <nlohmann/json.hpp>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// In-memory stand-in for the parts of OpenSearch the search code uses:
+// indices, aliases (with require_alias), document index/create/delete,
+// _bulk, _aliases and _delete_by_query. Searches are not supported.
+class FakeOpenSearch {
+public:
+    using json = nlohmann::json;
+
+    FakeOpenSearch() : server_([this](const FakeHttpServer::Request& req) { return handle(req); }) {}
+
+    std::string url() const { return server_.url(); }
+
+    // Runs once, outside the lock, when the first _bulk request for index
+    // arrives and before it is applied
+    void beforeFirstBulk(const std::string& index, std::function<void()> hook) {
+        std::scoped_lock lock(mtx_);
+        bulkHooks_[index] = std::move(hook);
+    }
+
+    // _bulk items for index are refused with a 400, as a mapping conflict would be
+    void rejectBulkItems(const std::string& index) {
+        std::scoped_lock lock(mtx_);
+        rejected_.insert(index);
+    }
+
+    void createIndex(const std::string& name) {
+        std::scoped_lock lock(mtx_);
+        indices_[name];
+    }
+
+    void addAlias(const std::string& alias, const std::string& index) {
+        std::scoped_lock lock(mtx_);
+        aliases_[alias].insert(index);
+    }
+
+    std::optional<json> document(const std::string& index, const std::string& id) {
+        std::scoped_lock lock(mtx_);
+        auto it = indices_.find(index);
+        if (it == indices_.end()) return std::nullopt;
+        auto doc = it->second.find(id);
+        if (doc == it->second.end()) return std::nullopt;
+        return doc->second;
+    }
+
+    size_t documentCount(const std::string& index) {
+        std::scoped_lock lock(mtx_);
+        auto it = indices_.find(index);
+        return it == indices_.end() ? 0 : it->second.size();
+    }
+
+    bool hasIndex(const std::string& index) {
+        std::scoped_lock lock(mtx_);
+        return indices_.count(index) > 0;
+    }
+
+    std::set<std::string> aliasTargets(const std::string& alias) {
+        std::scoped_lock lock(mtx_);
+        auto it = aliases_.find(alias);
+        return it == aliases_.end() ? std::set<std::string>{} : it->second;
+    }
+
+private:
+    using Response = FakeHttpServer::Response;
+
+    static Response reply(int status, const json& body) { return {status, body.dump(), {}}; }
+
+    static std::vector<std::string> split(const std::string& path) {
+        std::vector<std::string> parts;
+        std::stringstream in(path);
+        std::string part;
+        while (std::getline(in, part, '/'))
+            if (!part.empty()) parts.push_back(part);
+        return parts;
+    }
+
+    // Index a write to name lands in; empty if it may not be created
+    std::string resolveLocked(const std::string& name, bool requireAlias) {
+        auto alias = aliases_.find(name);
+        if (alias != aliases_.end() && alias->second.size() == 1) return *alias->second.begin();
+        if (requireAlias) return "";
+        indices_[name];   // auto-create, as OpenSearch does by default
+        return name;
+    }
+
+    json aliasReplyLocked(const std::string& name, bool& found) {
+        json out = json::object();
+        auto alias = aliases_.find(name);
+        if (alias != aliases_.end()) {
+            for (const auto& index : alias->second) out[index]["aliases"][name] = json::object();
+        } else if (indices_.count(name)) {
+            out[name]["aliases"] = json::object();
+        }
+        found = !out.empty();
+        return out;
+    }
+
+    Response handle(const FakeHttpServer::Request& req) {
+        auto queryPos = req.target.find('?');
+        std::string path = req.target.substr(0, queryPos);
+        std::string query = queryPos == std::string::npos ? "" : req.target.substr(queryPos + 1);
+        bool requireAlias = query.find("require_alias=true") != std::string::npos;
+        auto parts = split(path);
+
+        if (req.method == "POST" && parts.size() == 1 && parts[0] == "_bulk")
+            return bulk(req.body, requireAlias);
+
+        std::scoped_lock lock(mtx_);
+        if (req.method == "POST" && parts.size() == 1 && parts[0] == "_aliases") {
+            json body = json::parse(req.body);
+            for (const auto& action : body["actions"]) {
+                std::string op = action.begin().key();
+                const json& args = action.begin().value();
+                std::string index = args["index"];
+                std::string alias = args.value("alias", "");
+                if (op == "add") aliases_[alias].insert(index);
+                else if (op == "remove") aliases_[alias].erase(index);
+                else if (op == "remove_index") dropIndexLocked(index);
+            }
+            pruneAliasesLocked();
+            return reply(200, {{"acknowledged", true}});
+        }
+        if (req.method == "GET" && parts.size() == 2 && parts[0] == "_alias") {
+            if (!aliases_.count(parts[1])) return reply(404, {{"error", "alias missing"}});
+            bool found;
+            return reply(200, aliasReplyLocked(parts[1], found));
+        }
+        if (req.method == "GET" && parts.size() == 2 && parts[1] == "_alias") {
+            bool found;
+            auto out = aliasReplyLocked(parts[0], found);
+            return found ? reply(200, out) : reply(404, {{"error", "index_not_found_exception"}});
+        }
+        if (parts.size() == 1) {
+            if (req.method == "PUT") {
+                if (indices_.count(parts[0])) return reply(400, {{"error", "resource_already_exists"}});
+                indices_[parts[0]];
+                return reply(200, {{"acknowledged", true}});
+            }
+            if (req.method == "DELETE") {
+                if (!indices_.count(parts[0])) return reply(404, {{"error", "index_not_found_exception"}});
+                dropIndexLocked(parts[0]);
+                return reply(200, {{"acknowledged", true}});
+            }
+        }
+        if (parts.size() == 2 && (parts[1] == "_settings" || parts[1] == "_refresh"))
+            return reply(200, {{"acknowledged", true}});
+        if (req.method == "POST" && parts.size() == 2 && parts[1] == "_delete_by_query") {
+            std::string index = resolveLocked(parts[0], true);
+            if (index.empty() && indices_.count(parts[0])) index = parts[0];
+            size_t deleted = 0;
+            for (auto it = indices_[index].begin(); it != indices_[index].end();) {
+                if (it->second.value("deleted", false)) { it = indices_[index].erase(it); ++deleted; }
+                else ++it;
+            }
+            return reply(200, {{"deleted", deleted}});
+        }
+        if (parts.size() == 3 && parts[1] == "_doc") {
+            if (req.method == "PUT") {
+                std::string index = resolveLocked(parts[0], requireAlias);
+                if (index.empty()) return reply(404, {{"error", "alias required"}});
+                indices_[index][parts[2]] = json::parse(req.body);
+                return reply(201, {{"result", "created"}});
+            }
+            if (req.method == "DELETE") {
+                std::string index = resolveLocked(parts[0], true);
+                if (index.empty() && indices_.count(parts[0])) index = parts[0];
+                if (index.empty() || !indices_[index].erase(parts[2]))
+                    return reply(404, {{"result", "not_found"}});
+                return reply(200, {{"result", "deleted"}});
+            }
+        }
+        return reply(400, {{"error", "unsupported " + req.method + " " + path}});
+    }
+
+    Response bulk(const std::string& body, bool requireAlias) {
+        std::vector<std::pair<json, json>> ops;
+        std::istringstream lines(body);
+        std::string action, source;
+        while (std::getline(lines, action) && std::getline(lines, source))
+            ops.emplace_back(json::parse(action), json::parse(source));
+        if (ops.empty()) return reply(400, {{"error", "empty bulk"}});
+
+        std::function<void()> hook;
+        {
+            std::scoped_lock lock(mtx_);
+            std::string first = ops.front().first.begin().value()["_index"];
+            auto it = bulkHooks_.find(first);
+            if (it != bulkHooks_.end()) {
+                hook = std::move(it->second);
+                bulkHooks_.erase(it);
+            }
+        }
+        if (hook) hook();
+
+        std::scoped_lock lock(mtx_);
+        json items = json::array();
+        bool errors = false;
+        for (const auto& [actionLine, doc] : ops) {
+            std::string op = actionLine.begin().key();
+            const json& meta = actionLine.begin().value();
+            std::string index = resolveLocked(meta["_index"].get<std::string>(), requireAlias);
+            std::string id = meta["_id"];
+            int status = 201;
+            if (index.empty()) status = 404;
+            else if (rejected_.count(index)) status = 400;
+            else if (op == "create" && indices_[index].count(id)) status = 409;
+            else indices_[index][id] = doc;
+            if (status >= 300) errors = true;
+            items.push_back({{op, {{"status", status}}}});
+        }
+        return reply(200, {{"errors", errors}, {"items", items}});
+    }
+
+    void dropIndexLocked(const std::string& index) {
+        indices_.erase(index);
+        for (auto& [_, targets] : aliases_) targets.erase(index);
+        pruneAliasesLocked();
+    }
+
+    void pruneAliasesLocked() {
+        for (auto it = aliases_.begin(); it != aliases_.end();)
+            it = it->second.empty() ? aliases_.erase(it) : std::next(it);
+    }
+
+    std::mutex mtx_;
+    std::map<std::string, std::map<std::string, json>> indices_;
+    std::map<std::string, std::set<std::string>> aliases_;
+    std::map<std::string, std::function<void()>> bulkHooks_;
+    std::set<std::string> rejected_;
+    FakeHttpServer server_;
+};
@@ -0,0 +1,372 @@
+#pragma once
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <fnmatch.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Minimal RESP2 server on 127.0.0.1 for tests of RedisClient and the caches
+// built on it. Keeps strings, sets and TTLs in memory (keys never actually
+// expire), relays pub/sub, and answers the commands RedisClient sends;
+// every connection gets its own thread. With a password, other commands
+// get NOAUTH until the connection has authenticated. SCAN and SSCAN walk
+// keys in sorted order, so keys unlinked between pages do not make them
+// skip any.
+class FakeRedis {
+public:
+    explicit FakeRedis(std::string password = "") : password_(std::move(password)) {
+        listenFd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+            || ::listen(listenFd_, 64) != 0)
+            throw std::runtime_error("FakeRedis: cannot listen");
+        socklen_t len = sizeof(addr);
+        ::getsockname(listenFd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        acceptor_ = std::thread([this] { acceptLoop(); });
+    }
+
+    ~FakeRedis() {
+        stopping_ = true;
+        ::shutdown(listenFd_, SHUT_RDWR);
+        ::close(listenFd_);
+        acceptor_.join();
+        std::vector<std::thread> threads;
+        {
+            std::scoped_lock lock(mtx_);
+            for (int fd : openFds_) ::shutdown(fd, SHUT_RDWR);
+            threads.swap(threads_);
+        }
+        for (auto& t : threads) t.join();
+    }
+
+    FakeRedis(const FakeRedis&) = delete;
+    FakeRedis& operator=(const FakeRedis&) = delete;
+
+    int port() const { return port_; }
+
+    // The next time command arrives it runs, but the connection is closed
+    // instead of replying
+    void loseNextReply(const std::string& command) {
+        std::scoped_lock lock(mtx_);
+        loseReply_ = command;
+    }
+
+    // The next time command arrives it runs at once, but its reply is sent
+    // only after delay
+    void delayNextReply(const std::string& command, std::chrono::milliseconds delay) {
+        std::scoped_lock lock(mtx_);
+        delayReply_ = command;
+        delay_ = delay;
+    }
+
+    // EXPIRE NX/GT then fail as on Redis before 7.0
+    void rejectExpireOptions() {
+        std::scoped_lock lock(mtx_);
+        rejectExpireOptions_ = true;
+    }
+
+    void put(const std::string& key, const std::string& value) {
+        std::scoped_lock lock(mtx_);
+        values_[key] = value;
+    }
+
+    // Closes every open connection, as an idle timeout or restart would
+    void closeConnections() {
+        std::scoped_lock lock(mtx_);
+        for (int fd : openFds_) ::shutdown(fd, SHUT_RDWR);
+    }
+
+    size_t openConnections() {
+        std::scoped_lock lock(mtx_);
+        return openFds_.size();
+    }
+
+    // Times command has been received, whether or not it ran
+    size_t received(const std::string& command) {
+        std::scoped_lock lock(mtx_);
+        auto it = received_.find(command);
+        return it == received_.end() ? 0 : it->second;
+    }
+
+    std::optional<std::string> value(const std::string& key) {
+        std::scoped_lock lock(mtx_);
+        auto it = values_.find(key);
+        if (it == values_.end()) return std::nullopt;
+        return it->second;
+    }
+
+    std::set<std::string> members(const std::string& key) {
+        std::scoped_lock lock(mtx_);
+        auto it = sets_.find(key);
+        return it == sets_.end() ? std::set<std::string>{} : it->second;
+    }
+
+    // Seconds, or -1 without a TTL
+    long long ttl(const std::string& key) {
+        std::scoped_lock lock(mtx_);
+        auto it = ttls_.find(key);
+        return it == ttls_.end() ? -1 : it->second;
+    }
+
+    size_t keys() {
+        std::scoped_lock lock(mtx_);
+        return values_.size() + sets_.size();
+    }
+
+private:
+    void acceptLoop() {
+        while (!stopping_) {
+            int fd = ::accept(listenFd_, nullptr, nullptr);
+            if (fd < 0) return;
+            std::scoped_lock lock(mtx_);
+            openFds_.push_back(fd);
+            threads_.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+
+    void serve(int fd) {
+        std::string buffer;
+        bool authenticated = password_.empty();
+        std::vector<std::string> args;
+        while (!stopping_ && readCommand(fd, buffer, args) && !args.empty()) {
+            std::string command = args.front();
+            std::transform(command.begin(), command.end(), command.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+            std::string reply;
+            bool lose;
+            std::chrono::milliseconds delay{0};
+            {
+                std::scoped_lock lock(mtx_);
+                ++received_[command];
+                reply = run(fd, command, args, authenticated);
+                lose = loseReply_ == command;
+                if (lose) loseReply_.clear();
+                if (delayReply_ == command) {
+                    delay = delay_;
+                    delayReply_.clear();
+                }
+            }
+            if (lose) break;
+            std::this_thread::sleep_for(delay);
+            // PUBLISH writes to subscribers from other connections' threads
+            std::scoped_lock lock(mtx_);
+            if (!send(fd, reply)) break;
+        }
+        {
+            std::scoped_lock lock(mtx_);
+            openFds_.erase(std::remove(openFds_.begin(), openFds_.end(), fd), openFds_.end());
+            for (auto& [channel, fds] : subscribers_)
+                fds.erase(std::remove(fds.begin(), fds.end(), fd), fds.end());
+        }
+        ::close(fd);
+    }
+
+    // Under mtx_
+    std::string run(int fd, const std::string& command, const std::vector<std::string>& args,
+                    bool& authenticated) {
+        if (command == "AUTH") {
+            if (args.size() == 2 && args[1] == password_) {
+                authenticated = true;
+                return "+OK\r\n";
+            }
+            return "-WRONGPASS invalid password\r\n";
+        }
+        if (!authenticated) return "-NOAUTH Authentication required.\r\n";
+        if (command == "PING") return "+PONG\r\n";
+        if (command == "SUBSCRIBE" && args.size() == 2) {
+            subscribers_[args[1]].push_back(fd);
+            return "*3\r\n" + bulk("subscribe") + bulk(args[1]) + ":1\r\n";
+        }
+        if (command == "PUBLISH" && args.size() == 3) {
+            auto& fds = subscribers_[args[1]];
+            std::string message = "*3\r\n" + bulk("message") + bulk(args[1]) + bulk(args[2]);
+            for (int subscriber : fds) send(subscriber, message);
+            return ":" + std::to_string(fds.size()) + "\r\n";
+        }
+        if (command == "GET" && args.size() == 2) {
+            auto it = values_.find(args[1]);
+            if (it == values_.end()) return "$-1\r\n";
+            return bulk(it->second);
+        }
+        if (command == "SET" && args.size() >= 3) {
+            remove(args[1]);
+            values_[args[1]] = args[2];
+            if (args.size() == 5 && args[3] == "EX") ttls_[args[1]] = std::stoll(args[4]);
+            return "+OK\r\n";
+        }
+        if (command == "INCR" && args.size() == 2) {
+            std::string& value = values_[args[1]];
+            value = std::to_string((value.empty() ? 0 : std::stoll(value)) + 1);
+            return ":" + value + "\r\n";
+        }
+        if ((command == "DEL" || command == "UNLINK") && args.size() >= 2) {
+            size_t removed = 0;
+            for (size_t i = 1; i < args.size(); ++i) removed += remove(args[i]);
+            return ":" + std::to_string(removed) + "\r\n";
+        }
+        if (command == "SADD" && args.size() >= 3) {
+            size_t added = 0;
+            for (size_t i = 2; i < args.size(); ++i) added += sets_[args[1]].insert(args[i]).second;
+            return ":" + std::to_string(added) + "\r\n";
+        }
+        if (command == "EXPIRE" && (args.size() == 3 || args.size() == 4)) {
+            if (!values_.count(args[1]) && !sets_.count(args[1])) return ":0\r\n";
+            long long seconds = std::stoll(args[2]);
+            auto current = ttls_.find(args[1]);
+            if (args.size() == 4) {
+                if (rejectExpireOptions_) return "-ERR wrong number of arguments for 'expire' command\r\n";
+                // GT treats no TTL as infinite
+                if (args[3] == "NX" && current != ttls_.end()) return ":0\r\n";
+                if (args[3] == "GT" && (current == ttls_.end() || current->second >= seconds))
+                    return ":0\r\n";
+            }
+            ttls_[args[1]] = seconds;
+            return ":1\r\n";
+        }
+        if (command == "PERSIST" && args.size() == 2) {
+            return ttls_.erase(args[1]) ? ":1\r\n" : ":0\r\n";
+        }
+        if (command == "RENAME" && args.size() == 3) {
+            auto set = sets_.find(args[1]);
+            if (set == sets_.end()) return "-ERR no such key\r\n";
+            auto members = std::move(set->second);
+            auto ttl = ttls_.find(args[1]);
+            std::optional<long long> seconds;
+            if (ttl != ttls_.end()) seconds = ttl->second;
+            remove(args[1]);
+            remove(args[2]);
+            sets_[args[2]] = std::move(members);
+            if (seconds) ttls_[args[2]] = *seconds;
+            return "+OK\r\n";
+        }
+        if (command == "SCAN" && args.size() >= 2) {
+            std::vector<std::string> all;
+            for (const auto& [key, value] : values_) all.push_back(key);
+            for (const auto& [key, members] : sets_) all.push_back(key);
+            std::sort(all.begin(), all.end());
+            return page(all, args[1], option(args, 2, "MATCH"), option(args, 2, "COUNT"));
+        }
+        if (command == "SSCAN" && args.size() >= 3) {
+            std::vector<std::string> all;
+            auto set = sets_.find(args[1]);
+            if (set != sets_.end()) all.assign(set->second.begin(), set->second.end());
+            return page(all, args[2], option(args, 3, "MATCH"), option(args, 3, "COUNT"));
+        }
+        return "-ERR unknown command '" + args.front() + "'\r\n";
+    }
+
+    // Under mtx_
+    size_t remove(const std::string& key) {
+        ttls_.erase(key);
+        return values_.erase(key) + sets_.erase(key);
+    }
+
+    static std::string option(const std::vector<std::string>& args, size_t from, const std::string& name) {
+        for (size_t i = from; i + 1 < args.size(); i += 2)
+            if (args[i] == name) return args[i + 1];
+        return "";
+    }
+
+    // The cursor is "0" or ">" and the last key returned
+    static std::string page(const std::vector<std::string>& sorted, const std::string& cursor,
+                            const std::string& match, const std::string& count) {
+        auto it = cursor == "0" ? sorted.begin()
+                                : std::upper_bound(sorted.begin(), sorted.end(), cursor.substr(1));
+        size_t limit = count.empty() ? 10 : std::stoul(count);
+        std::vector<std::string> found;
+        std::string next = "0";
+        for (size_t visited = 0; it != sorted.end(); ++it) {
+            if (visited++ == limit) {
+                next = ">" + *std::prev(it);
+                break;
+            }
+            if (match.empty() || fnmatch(match.c_str(), it->c_str(), 0) == 0) found.push_back(*it);
+        }
+        std::string out = "*2\r\n" + bulk(next) + "*" + std::to_string(found.size()) + "\r\n";
+        for (const auto& key : found) out += bulk(key);
+        return out;
+    }
+
+    static std::string bulk(const std::string& value) {
+        return "$" + std::to_string(value.size()) + "\r\n" + value + "\r\n";
+    }
+
+    static bool fill(int fd, std::string& buffer) {
+        char chunk[16 * 1024];
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    static bool readLine(int fd, std::string& buffer, std::string& line) {
+        size_t end;
+        while ((end = buffer.find("\r\n")) == std::string::npos)
+            if (!fill(fd, buffer)) return false;
+        line = buffer.substr(0, end);
+        buffer.erase(0, end + 2);
+        return true;
+    }
+
+    // A multibulk command: *N then N bulk strings
+    static bool readCommand(int fd, std::string& buffer, std::vector<std::string>& args) {
+        args.clear();
+        std::string line;
+        if (!readLine(fd, buffer, line) || line.empty() || line[0] != '*') return false;
+        size_t count = std::stoul(line.substr(1));
+        for (size_t i = 0; i < count; ++i) {
+            if (!readLine(fd, buffer, line) || line.empty() || line[0] != '$') return false;
+            size_t size = std::stoul(line.substr(1));
+            while (buffer.size() < size + 2)
+                if (!fill(fd, buffer)) return false;
+            args.push_back(buffer.substr(0, size));
+            buffer.erase(0, size + 2);
+        }
+        return true;
+    }
+
+    static bool send(int fd, const std::string& out) {
+        size_t sent = 0;
+        while (sent < out.size()) {
+            ssize_t n = ::send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    std::string password_;
+    int listenFd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> stopping_{false};
+    std::mutex mtx_;
+    std::map<std::string, std::string> values_;
+    std::map<std::string, std::set<std::string>> sets_;
+    std::map<std::string, long long> ttls_;
+    bool rejectExpireOptions_ = false;
+    std::map<std::string, size_t> received_;
+    std::string loseReply_;
+    std::string delayReply_;
+    std::chrono::milliseconds delay_{0};
+    std::map<std::string, std::vector<int>> subscribers_;
+    std::vector<int> openFds_;
+    std::vector<std::thread> threads_;
+    std::thread acceptor_;
+};
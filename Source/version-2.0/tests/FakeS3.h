@@ -0,0 +1,188 @@
+#pragma once
+#include "FakeHttpServer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Path-style S3 with one bucket, "bucket", held in memory: HEAD, GET with
+// If-Match, PUT, DELETE and a single-page ListObjectsV2 with prefix and
+// delimiter. Requests are counted by method. 'unavailable' answers
+// everything with a 503; GETs can be slowed down.
+class FakeS3 {
+public:
+    FakeS3() : server_([this](const FakeHttpServer::Request& req) { return handle(req); }) {}
+
+    FakeS3(const FakeS3&) = delete;
+    FakeS3& operator=(const FakeS3&) = delete;
+
+    void put(const std::string& key, const std::string& body) {
+        std::scoped_lock lock(mtx_);
+        store(key, body);
+    }
+
+    void remove(const std::string& key) {
+        std::scoped_lock lock(mtx_);
+        objects_.erase(key);
+    }
+
+    // Moves an object's LastModified into the past
+    void age(const std::string& key, std::chrono::seconds by) {
+        std::scoped_lock lock(mtx_);
+        objects_.at(key).modified -= static_cast<std::time_t>(by.count());
+    }
+
+    bool has(const std::string& key) {
+        std::scoped_lock lock(mtx_);
+        return objects_.count(key) > 0;
+    }
+
+    std::string body(const std::string& key) {
+        std::scoped_lock lock(mtx_);
+        return objects_.at(key).body;
+    }
+
+    std::string etag(const std::string& key) {
+        std::scoped_lock lock(mtx_);
+        return objects_.at(key).etag;
+    }
+
+    size_t objects(const std::string& prefix = "") {
+        std::scoped_lock lock(mtx_);
+        size_t n = 0;
+        for (const auto& [key, object] : objects_) n += key.compare(0, prefix.size(), prefix) == 0;
+        return n;
+    }
+
+    size_t received(const std::string& method) {
+        std::scoped_lock lock(mtx_);
+        return counts_[method];
+    }
+
+    // Runs with the prefix of each listing once it has been built, before
+    // it is sent
+    void afterList(std::function<void(const std::string& prefix)> hook) {
+        std::scoped_lock lock(mtx_);
+        afterList_ = std::move(hook);
+    }
+
+    std::string url() const { return server_.url(); }
+
+    std::atomic<bool> unavailable{false};
+    std::atomic<int> getDelayMs{0};
+
+private:
+    struct Object {
+        std::string body;
+        std::string etag;
+        std::time_t modified;
+    };
+
+    void store(const std::string& key, const std::string& body) {
+        objects_[key] = {body, "\"" + std::to_string(++version_) + "\"", std::time(nullptr)};
+    }
+
+    static std::string time(std::time_t t, const char* format) {
+        std::tm tm{};
+        gmtime_r(&t, &tm);
+        char out[64];
+        std::strftime(out, sizeof(out), format, &tm);
+        return out;
+    }
+
+    static std::string decode(const std::string& value) {
+        std::string out;
+        for (size_t i = 0; i < value.size(); ++i) {
+            if (value[i] == '%' && i + 2 < value.size()) {
+                out += static_cast<char>(std::strtol(value.substr(i + 1, 2).c_str(), nullptr, 16));
+                i += 2;
+            } else {
+                out += value[i];
+            }
+        }
+        return out;
+    }
+
+    static std::string param(const std::string& query, const std::string& name) {
+        size_t pos = 0;
+        while (pos < query.size()) {
+            size_t end = query.find('&', pos);
+            if (end == std::string::npos) end = query.size();
+            std::string pair = query.substr(pos, end - pos);
+            if (pair.compare(0, name.size() + 1, name + "=") == 0) return decode(pair.substr(name.size() + 1));
+            pos = end + 1;
+        }
+        return "";
+    }
+
+    FakeHttpServer::Response list(const std::string& prefix, const std::string& query) {
+        std::string delimiter = param(query, "delimiter");
+        std::string xml = "<ListBucketResult><IsTruncated>false</IsTruncated>";
+        std::string lastPrefix;
+        for (const auto& [key, object] : objects_) {
+            if (key.compare(0, prefix.size(), prefix) != 0) continue;
+            size_t cut = delimiter.empty() ? std::string::npos : key.find(delimiter, prefix.size());
+            if (cut != std::string::npos) {
+                std::string common = key.substr(0, cut + delimiter.size());
+                if (common != lastPrefix) xml += "<CommonPrefixes><Prefix>" + common + "</Prefix></CommonPrefixes>";
+                lastPrefix = common;
+                continue;
+            }
+            xml += "<Contents><Key>" + key + "</Key><Size>" + std::to_string(object.body.size())
+                 + "</Size><ETag>" + object.etag + "</ETag><LastModified>"
+                 + time(object.modified, "%Y-%m-%dT%H:%M:%S.000Z") + "</LastModified></Contents>";
+        }
+        return {200, xml + "</ListBucketResult>", {{"Content-Type", "application/xml"}}};
+    }
+
+    FakeHttpServer::Response handle(const FakeHttpServer::Request& req) {
+        const std::string bucket = "/bucket/";
+        std::string target = req.target.substr(bucket.size());
+        size_t question = target.find('?');
+        std::string key = decode(target.substr(0, question));
+        std::string query = question == std::string::npos ? "" : target.substr(question + 1);
+
+        std::function<void(const std::string&)> hook;
+        std::string prefix = param(query, "prefix");
+        FakeHttpServer::Response response;
+        {
+            std::scoped_lock lock(mtx_);
+            ++counts_[req.method];
+            if (unavailable) return {503, "", {}};
+            if (req.method == "GET" && key.empty()) {
+                response = list(prefix, query);
+                hook = afterList_;
+            } else if (req.method == "PUT") {
+                store(key, req.body);
+                return {200, "", {{"ETag", objects_[key].etag}}};
+            } else if (req.method == "DELETE") {
+                objects_.erase(key);
+                return {204, "", {}};
+            } else {
+                auto it = objects_.find(key);
+                if (it == objects_.end()) return {404, "", {}};
+                const Object& object = it->second;
+                if (req.method == "GET" && !req.header("if-match").empty() && req.header("if-match") != object.etag)
+                    return {412, "", {}};
+                response = {200, object.body, {{"ETag", object.etag}, {"Content-Type", "application/pdf"},
+                                               {"Last-Modified", time(object.modified, "%a, %d %b %Y %H:%M:%S GMT")}}};
+            }
+        }
+        if (hook) hook(prefix);
+        if (req.method == "GET" && !key.empty())
+            std::this_thread::sleep_for(std::chrono::milliseconds(getDelayMs.load()));
+        return response;
+    }
+
+    std::mutex mtx_;
+    std::map<std::string, Object> objects_;
+    std::map<std::string, size_t> counts_;
+    std::function<void(const std::string&)> afterList_;
+    int version_ = 0;
+    FakeHttpServer server_;
+};
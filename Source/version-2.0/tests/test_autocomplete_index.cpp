@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "../src/infrastructure/search/AutocompleteIndex.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using Docs = std::vector<AutocompleteIndex::Document>;
+using Strings = std::vector<std::string>;
+
+static void load(AutocompleteIndex& index) {
+    index.rebuild(Docs{
+        {1, "Harry Potter and the Philosopher's Stone", "J.K. Rowling", 50},
+        {2, "Harry Potter and the Chamber of Secrets", "J.K. Rowling", 80},
+        {3, "Hamlet", "William Shakespeare", 10},
+        {4, "The Hobbit", "J.R.R. Tolkien", 30},
+        {5, "Dune", "Frank Herbert", 5},
+    });
+}
+
+TEST(AutocompleteIndexTest, RanksPrefixMatchesByPopularity) {
+    AutocompleteIndex index;
+    load(index);
+    EXPECT_EQ(index.suggest("harry", 5), (Strings{
+        "Harry Potter and the Chamber of Secrets",
+        "Harry Potter and the Philosopher's Stone"}));
+    EXPECT_EQ(index.suggest("ha", 5), (Strings{
+        "Harry Potter and the Chamber of Secrets",
+        "Harry Potter and the Philosopher's Stone",
+        "Hamlet"}));
+    EXPECT_EQ(index.suggest("ha", 1), (Strings{"Harry Potter and the Chamber of Secrets"}));
+}
+
+TEST(AutocompleteIndexTest, MatchesCaseInsensitivelyAndWordStarts) {
+    AutocompleteIndex index;
+    load(index);
+    EXPECT_EQ(index.suggest("  HOB", 5), (Strings{"The Hobbit"}));
+    EXPECT_EQ(index.suggest("tolk", 5), (Strings{"J.R.R. Tolkien"}));
+    EXPECT_EQ(index.suggest("rowl", 5), (Strings{"J.K. Rowling"}));   // deduplicated
+}
+
+TEST(AutocompleteIndexTest, FallsBackToOneEditFuzzyMatches) {
+    AutocompleteIndex index;
+    load(index);
+    EXPECT_EQ(index.suggest("hsmlet", 5), (Strings{"Hamlet"}));
+    EXPECT_EQ(index.suggest("hbobit", 5), (Strings{"The Hobbit"}));
+    EXPECT_TRUE(index.suggest("xyzzy", 5).empty());
+    EXPECT_TRUE(index.suggest("du", 5).size() == 1);
+}
+
+TEST(AutocompleteIndexTest, UpsertAndRemoveTakeEffect) {
+    AutocompleteIndex index;
+    load(index);
+    index.upsert(Docs{{6, "Dune Messiah", "Frank Herbert", 0}});
+    EXPECT_EQ(index.suggest("dune", 5), (Strings{"Dune", "Dune Messiah"}));
+
+    index.upsert(Docs{{5, "Dune (Revised)", "Frank Herbert", 0}});
+    EXPECT_EQ(index.suggest("dune", 5), (Strings{"Dune (Revised)", "Dune Messiah"}));
+
+    index.remove(5);
+    EXPECT_EQ(index.suggest("dune", 5), (Strings{"Dune Messiah"}));
+    EXPECT_EQ(index.documents(), 5u);
+}
+
+TEST(AutocompleteIndexTest, WritesDuringRebuildAreReplayed) {
+    AutocompleteIndex index;
+    load(index);
+    index.beginRebuild();
+    index.upsert(Docs{{7, "Neuromancer", "William Gibson", 0}});
+    index.remove(3);
+    index.rebuild(Docs{{3, "Hamlet", "William Shakespeare", 10}});
+
+    EXPECT_EQ(index.suggest("neuro", 5), (Strings{"Neuromancer"}));
+    EXPECT_TRUE(index.suggest("hamlet", 5).empty());
+    EXPECT_EQ(index.documents(), 1u);
+}
+
+// Entries point into their document's keys; replacing documents past the
+// compaction threshold must not leave any pointing at freed ones
+TEST(AutocompleteIndexTest, RepeatedReplacementsSurviveCompaction) {
+    AutocompleteIndex index;
+    load(index);
+    for (int i = 0; i < 3000; ++i) {
+        index.upsert(Docs{{5, "Dune part " + std::to_string(i), "Frank Herbert", 0},
+                          {100 + i % 50, "Foundation volume " + std::to_string(i), "Isaac Asimov", 0}});
+        if (i % 7 == 0) index.remove(100 + i % 50);
+    }
+    EXPECT_EQ(index.suggest("dune", 5), (Strings{"Dune part 2999"}));
+    EXPECT_EQ(index.suggest("herb", 5), (Strings{"Frank Herbert"}));
+    EXPECT_EQ(index.suggest("foundation volume 2999", 1), (Strings{"Foundation volume 2999"}));
+    // Replaced titles are gone; one-edit neighbours may still be suggested
+    auto replaced = index.suggest("foundation volume 2949", 5);
+    EXPECT_EQ(std::count(replaced.begin(), replaced.end(), "Foundation volume 2949"), 0);
+    // Seven of the last 50 rounds (2954, 2961, ..., 2996) removed their id
+    EXPECT_EQ(index.documents(), 5u + 50u - 7u);
+}
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include "FakeHttpServer.h"
+#include "../src/infrastructure/search/BulkIndexer.h"
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+// Ids of the documents in a _bulk body, in request order
+std::vector<std::string> bulkIds(const std::string& body) {
+    std::vector<std::string> ids;
+    std::istringstream lines(body);
+    std::string action, source;
+    while (std::getline(lines, action) && std::getline(lines, source))
+        ids.push_back(json::parse(action)["index"]["_id"].get<std::string>());
+    return ids;
+}
+
+// _bulk reply with one item per id; statusFor picks each item's status
+FakeHttpServer::Response bulkReply(const std::vector<std::string>& ids,
+                                   const std::function<int(const std::string&)>& statusFor) {
+    json items = json::array();
+    bool errors = false;
+    for (const auto& id : ids) {
+        int status = statusFor(id);
+        json item = {{"status", status}};
+        if (status >= 300) {
+            errors = true;
+            item["error"] = {{"type", "test_error"}, {"reason", "rejected " + id}};
+        }
+        items.push_back({{"index", item}});
+    }
+    return {200, json{{"errors", errors}, {"items", items}}.dump(), {}};
+}
+
+BulkIndexerOptions smallBatches() {
+    BulkIndexerOptions options;
+    options.index = "media_test";
+    options.maxBatchDocs = 10;
+    options.concurrency = 2;
+    options.retryBackoff = std::chrono::milliseconds(1);
+    return options;
+}
+
+json doc(int id) {
+    return {{"id", id}, {"title", "Title " + std::to_string(id)}};
+}
+
+}
+
+TEST(BulkIndexerTest, SendsEveryDocumentInBoundedBatches) {
+    std::mutex mtx;
+    std::vector<std::string> seen;
+    FakeHttpServer server([&](const FakeHttpServer::Request& req) {
+        EXPECT_EQ(req.method, "POST");
+        EXPECT_EQ(req.target.rfind("/_bulk", 0), 0u);
+        auto ids = bulkIds(req.body);
+        EXPECT_LE(ids.size(), 10u);
+        std::scoped_lock lock(mtx);
+        seen.insert(seen.end(), ids.begin(), ids.end());
+        return bulkReply(ids, [](const std::string&) { return 201; });
+    });
+
+    BulkIndexer indexer(server.url(), std::nullopt, smallBatches());
+    for (int i = 0; i < 95; ++i) indexer.add(doc(i));
+    auto stats = indexer.close();
+
+    EXPECT_EQ(stats.indexed, 95u);
+    EXPECT_EQ(stats.failed, 0u);
+    EXPECT_EQ(stats.requests, 10u);
+    EXPECT_EQ(seen.size(), 95u);
+}
+
+// 429 items are resent on their own; 4xx items fail without a retry
+TEST(BulkIndexerTest, RetriesOnlyRetryableItems) {
+    std::mutex mtx;
+    std::map<std::string, int> attempts;
+    FakeHttpServer server([&](const FakeHttpServer::Request& req) {
+        std::scoped_lock lock(mtx);
+        return bulkReply(bulkIds(req.body), [&](const std::string& id) {
+            int n = ++attempts[id];
+            if (id == "3") return 400;
+            if (id == "5" && n == 1) return 429;
+            return 201;
+        });
+    });
+
+    BulkIndexer indexer(server.url(), std::nullopt, smallBatches());
+    for (int i = 0; i < 8; ++i) indexer.add(doc(i));
+    auto stats = indexer.close();
+
+    EXPECT_EQ(stats.indexed, 7u);
+    EXPECT_EQ(stats.failed, 1u);
+    EXPECT_EQ(stats.retried, 1u);
+    ASSERT_EQ(stats.errors.size(), 1u);
+    EXPECT_NE(stats.errors[0].find("rejected 3"), std::string::npos);
+    EXPECT_EQ(attempts["3"], 1);
+    EXPECT_EQ(attempts["5"], 2);
+}
+
+// A reply without "errors" is not taken as success, and does not throw
+TEST(BulkIndexerTest, UnreadableRepliesAreRetriedThenFailed) {
+    std::atomic<int> calls{0};
+    FakeHttpServer server([&](const FakeHttpServer::Request&) {
+        ++calls;
+        return FakeHttpServer::Response{200, R"({"took": 3})", {}};
+    });
+
+    auto options = smallBatches();
+    options.maxRetries = 2;
+    BulkIndexer indexer(server.url(), std::nullopt, options);
+    for (int i = 0; i < 4; ++i) indexer.add(doc(i));
+    auto stats = indexer.close();
+
+    EXPECT_EQ(stats.indexed, 0u);
+    EXPECT_EQ(stats.failed, 4u);
+    EXPECT_EQ(calls.load(), 3);
+}
+
+TEST(BulkIndexerTest, PermanentHttpErrorFailsTheBatch) {
+    FakeHttpServer server([](const FakeHttpServer::Request&) {
+        return FakeHttpServer::Response{400, R"({"error": "bad request"})", {}};
+    });
+
+    BulkIndexer indexer(server.url(), std::nullopt, smallBatches());
+    auto stats = indexer.index({doc(1), doc(2)});
+    EXPECT_EQ(stats.failed, 2u);
+    EXPECT_EQ(server.requests(), 1u);
+}
+
+// Concurrent index() calls share the indexer and each get their own stats
+TEST(BulkIndexerTest, ConcurrentIndexCallsReportTheirOwnDocuments) {
+    FakeHttpServer server([](const FakeHttpServer::Request& req) {
+        return bulkReply(bulkIds(req.body), [](const std::string& id) {
+            return std::stoi(id) % 100 == 7 ? 400 : 201;
+        });
+    });
+
+    BulkIndexer indexer(server.url(), std::nullopt, smallBatches());
+    std::vector<BulkIndexStats> results(6);
+    std::vector<std::thread> callers;
+    for (int t = 0; t < 6; ++t) {
+        callers.emplace_back([&, t] {
+            std::vector<json> docs;
+            for (int i = 0; i < 25; ++i) docs.push_back(doc(t * 100 + i));
+            results[t] = indexer.index(docs);
+        });
+    }
+    for (auto& c : callers) c.join();
+
+    for (const auto& r : results) {
+        EXPECT_EQ(r.indexed, 24u);
+        EXPECT_EQ(r.failed, 1u);
+        EXPECT_EQ(r.requests, 3u);
+    }
+    // The sender's keep-alive connections are shared by every call
+    EXPECT_LE(server.connections(), 2u);
+    EXPECT_EQ(indexer.close().indexed, 0u);
+}
+
+TEST(BulkIndexerTest, IndexAfterCloseFails) {
+    FakeHttpServer server([](const FakeHttpServer::Request& req) {
+        return bulkReply(bulkIds(req.body), [](const std::string&) { return 201; });
+    });
+    BulkIndexer indexer(server.url(), std::nullopt, smallBatches());
+    indexer.close();
+    auto stats = indexer.index({doc(1)});
+    EXPECT_EQ(stats.failed, 1u);
+    EXPECT_EQ(server.requests(), 0u);
+}
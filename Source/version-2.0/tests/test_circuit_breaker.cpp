@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include "../src/utils/CircuitBreaker.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST(CircuitBreakerTest, OpensAfterThresholdFailures) {
+    CircuitBreaker breaker(3, 1min);
+    EXPECT_FALSE(breaker.recordFailure());
+    EXPECT_FALSE(breaker.recordFailure());
+    EXPECT_TRUE(breaker.allow());
+
+    EXPECT_TRUE(breaker.recordFailure());
+    EXPECT_TRUE(breaker.open());
+    EXPECT_FALSE(breaker.allow());
+}
+
+TEST(CircuitBreakerTest, SuccessResetsTheFailureCount) {
+    CircuitBreaker breaker(2, 1min);
+    breaker.recordFailure();
+    breaker.recordSuccess();
+    EXPECT_FALSE(breaker.recordFailure());
+    EXPECT_TRUE(breaker.allow());
+}
+
+TEST(CircuitBreakerTest, LetsOneTrialThroughAfterCooldown) {
+    CircuitBreaker breaker(1, 20ms);
+    breaker.recordFailure();
+    EXPECT_FALSE(breaker.allow());
+
+    std::this_thread::sleep_for(30ms);
+    EXPECT_TRUE(breaker.allow());
+    EXPECT_FALSE(breaker.allow());
+
+    breaker.recordSuccess();
+    EXPECT_FALSE(breaker.open());
+    EXPECT_TRUE(breaker.allow());
+}
+
+TEST(CircuitBreakerTest, FailedTrialReopens) {
+    CircuitBreaker breaker(1, 20ms);
+    EXPECT_TRUE(breaker.recordFailure());
+    std::this_thread::sleep_for(30ms);
+    ASSERT_TRUE(breaker.allow());
+
+    // Already open: not reported as a new opening
+    EXPECT_FALSE(breaker.recordFailure());
+    EXPECT_FALSE(breaker.allow());
+}
+
+TEST(CircuitBreakerTest, ConcurrentCallersShareOneTrial) {
+    CircuitBreaker breaker(1, 50ms);
+    breaker.recordFailure();
+    std::this_thread::sleep_for(60ms);
+
+    std::atomic<int> allowed{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i)
+        threads.emplace_back([&] { if (breaker.allow()) ++allowed; });
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(allowed.load(), 1);
+}
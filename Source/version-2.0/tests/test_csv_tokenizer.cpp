@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include "../src/utils/CsvTokenizer.h"
+#include "../src/utils/Exceptions.h"
+#include <string>
+#include <vector>
+
+using Rows = std::vector<std::vector<std::string>>;
+
+static Rows tokenize(const std::string& input, size_t chunkSize = std::string::npos) {
+    Rows rows;
+    auto collect = [&](const CsvTokenizer::Fields& fields) {
+        rows.emplace_back(fields.begin(), fields.end());
+    };
+    CsvTokenizer tokenizer;
+    std::string_view rest(input);
+    while (!rest.empty()) {
+        auto chunk = rest.substr(0, chunkSize);
+        tokenizer.feed(chunk, collect);
+        rest.remove_prefix(chunk.size());
+    }
+    tokenizer.finish(collect);
+    return rows;
+}
+
+TEST(CsvTokenizerTest, SplitsSimpleRecords) {
+    auto rows = tokenize("type,title\nBook,Dune\nMagazine,Wired\n");
+    ASSERT_EQ(rows.size(), 3u);
+    EXPECT_EQ(rows[1], (std::vector<std::string>{"Book", "Dune"}));
+    EXPECT_EQ(rows[2], (std::vector<std::string>{"Magazine", "Wired"}));
+}
+
+TEST(CsvTokenizerTest, HandlesQuotedDelimitersQuotesAndNewlines) {
+    auto rows = tokenize("\"Smith, John\",\"He said \"\"hi\"\"\",\"line1\nline2\"\r\n");
+    ASSERT_EQ(rows.size(), 1u);
+    EXPECT_EQ(rows[0], (std::vector<std::string>{"Smith, John", "He said \"hi\"", "line1\nline2"}));
+}
+
+TEST(CsvTokenizerTest, KeepsEmptyFieldsAndSkipsBlankLines) {
+    auto rows = tokenize("a,,c,\n\r\n\n,\nlast");
+    ASSERT_EQ(rows.size(), 3u);
+    EXPECT_EQ(rows[0], (std::vector<std::string>{"a", "", "c", ""}));
+    EXPECT_EQ(rows[1], (std::vector<std::string>{"", ""}));
+    EXPECT_EQ(rows[2], (std::vector<std::string>{"last"}));
+}
+
+// Every chunk size must give the same records, including splits inside
+// quotes, escaped quotes and CRLF pairs. Long fields cover the vector path.
+TEST(CsvTokenizerTest, ChunkBoundariesDoNotChangeResult) {
+    std::string longField(70, 'x');
+    std::string input = "id,title,notes\r\n"
+                        "1,\"" + longField + ", with comma\",\"quote \"\"" + longField + "\"\"\"\r\n"
+                        "2," + longField + ",\"multi\nline\"\n";
+    auto expected = tokenize(input);
+    ASSERT_EQ(expected.size(), 3u);
+    EXPECT_EQ(expected[1][1], longField + ", with comma");
+    EXPECT_EQ(expected[1][2], "quote \"" + longField + "\"");
+
+    for (size_t chunk = 1; chunk < input.size(); ++chunk)
+        EXPECT_EQ(tokenize(input, chunk), expected) << "chunk size " << chunk;
+}
+
+TEST(CsvTokenizerTest, RejectsUnterminatedQuote) {
+    EXPECT_THROW(tokenize("a,\"open\nb,c\n"), ValidationException);
+}
+
+TEST(CsvTokenizerTest, RejectsTextAfterClosingQuote) {
+    EXPECT_THROW(tokenize("\"a\"b,c\n"), ValidationException);
+}
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include "FakeS3.h"
+#include "../src/infrastructure/storage/DiskCache.h"
+#include <unistd.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+class RejectAll : public CacheAdmission {
+public:
+    void recordAccess(const std::string&) override {}
+    bool admit(const std::string&, const std::string&) override { return false; }
+};
+
+bool waitFor(const std::function<bool()>& condition) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (condition()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), {});
+}
+
+}
+
+class DiskCacheTest : public ::testing::Test {
+protected:
+    FakeS3 s3;
+    std::shared_ptr<S3StorageClient> client =
+        std::make_shared<S3StorageClient>(s3.url(), "key", "secret", "bucket");
+    std::string dir = (fs::temp_directory_path() / ("disk_cache_test_" + std::to_string(::getpid()))).string();
+
+    void SetUp() override {
+        fs::remove_all(dir);
+        s3.put("a", std::string(100, 'a'));
+        s3.put("b", std::string(100, 'b'));
+        s3.put("c", std::string(100, 'c'));
+    }
+
+    void TearDown() override { fs::remove_all(dir); }
+
+    DiskCache::Options options() {
+        DiskCache::Options o;
+        o.directory = dir;
+        o.maxBytes = 250;
+        return o;
+    }
+
+    // Misses once, then waits for the background fill
+    static std::optional<DiskCache::Entry> fill(DiskCache& cache, const std::string& key) {
+        if (auto hit = cache.get(key).local) return hit;
+        std::optional<DiskCache::Entry> local;
+        waitFor([&] { return (local = cache.get(key).local).has_value(); });
+        return local;
+    }
+};
+
+TEST_F(DiskCacheTest, MissIsServedFromS3AndFilledInTheBackground) {
+    DiskCache cache(client, options());
+
+    auto lookup = cache.get("a");
+    EXPECT_FALSE(lookup.local);
+    ASSERT_TRUE(lookup.head.object);
+    EXPECT_EQ(lookup.head.object->size, 100u);
+    EXPECT_EQ(lookup.head.object->etag, s3.etag("a"));
+
+    auto local = fill(cache, "a");
+    ASSERT_TRUE(local);
+    EXPECT_EQ(readFile(local->path), std::string(100, 'a'));
+    EXPECT_EQ(local->etag, s3.etag("a"));
+    EXPECT_EQ(s3.received("GET"), 1u);
+}
+
+TEST_F(DiskCacheTest, FreshHitMakesNoRequest) {
+    DiskCache cache(client, options());
+    ASSERT_TRUE(fill(cache, "a"));
+    size_t heads = s3.received("HEAD");
+
+    auto lookup = cache.get("a");
+    EXPECT_TRUE(lookup.local);
+    EXPECT_EQ(lookup.head.status, 0);
+    EXPECT_EQ(s3.received("HEAD"), heads);
+    EXPECT_EQ(s3.received("GET"), 1u);
+}
+
+TEST_F(DiskCacheTest, ConcurrentMissesDownloadOnce) {
+    s3.getDelayMs = 200;
+    DiskCache cache(client, options());
+
+    for (int i = 0; i < 5; ++i) EXPECT_FALSE(cache.get("a").local);
+    ASSERT_TRUE(fill(cache, "a"));
+    EXPECT_EQ(s3.received("GET"), 1u);
+}
+
+TEST_F(DiskCacheTest, StaleHitWithTheSameEtagIsRevalidated) {
+    auto o = options();
+    o.revalidateAfter = std::chrono::seconds(0);
+    DiskCache cache(client, o);
+    ASSERT_TRUE(fill(cache, "a"));
+    size_t heads = s3.received("HEAD");
+
+    auto lookup = cache.get("a");
+    EXPECT_TRUE(lookup.local);
+    EXPECT_EQ(s3.received("HEAD"), heads + 1);
+    EXPECT_EQ(s3.received("GET"), 1u);
+}
+
+TEST_F(DiskCacheTest, ReplacedObjectIsFetchedAgain) {
+    auto o = options();
+    o.revalidateAfter = std::chrono::seconds(0);
+    DiskCache cache(client, o);
+    ASSERT_TRUE(fill(cache, "a"));
+
+    s3.put("a", std::string(50, 'A'));
+    auto lookup = cache.get("a");
+    EXPECT_FALSE(lookup.local);
+    ASSERT_TRUE(lookup.head.object);
+    EXPECT_EQ(lookup.head.object->etag, s3.etag("a"));
+
+    auto local = fill(cache, "a");
+    ASSERT_TRUE(local);
+    EXPECT_EQ(local->etag, s3.etag("a"));
+    EXPECT_EQ(readFile(local->path), std::string(50, 'A'));
+}
+
+// The evicted file outlives the grace period only
+TEST_F(DiskCacheTest, ObjectDeletedFromS3IsEvicted) {
+    auto o = options();
+    o.revalidateAfter = std::chrono::seconds(0);
+    o.retireGrace = std::chrono::milliseconds(100);
+    DiskCache cache(client, o);
+    auto local = fill(cache, "a");
+    ASSERT_TRUE(local);
+
+    s3.remove("a");
+    auto lookup = cache.get("a");
+    EXPECT_FALSE(lookup.local);
+    EXPECT_FALSE(lookup.head.object);
+    EXPECT_EQ(lookup.head.status, 404);
+    EXPECT_TRUE(fs::exists(local->path));
+    EXPECT_TRUE(waitFor([&] { return !fs::exists(local->path); }));
+}
+
+TEST_F(DiskCacheTest, StaleCopyIsServedWhenS3Fails) {
+    auto o = options();
+    o.revalidateAfter = std::chrono::seconds(0);
+    DiskCache cache(client, o);
+    ASSERT_TRUE(fill(cache, "a"));
+
+    s3.unavailable = true;
+    auto lookup = cache.get("a");
+    EXPECT_TRUE(lookup.local);
+    EXPECT_EQ(lookup.head.status, 503);
+}
+
+TEST_F(DiskCacheTest, LeastRecentlyUsedIsEvictedWhenFull) {
+    DiskCache cache(client, options());
+    ASSERT_TRUE(fill(cache, "a"));
+    ASSERT_TRUE(fill(cache, "b"));
+    ASSERT_TRUE(cache.get("a").local);
+
+    ASSERT_TRUE(fill(cache, "c"));
+    EXPECT_TRUE(cache.get("a").local);
+    EXPECT_FALSE(cache.get("b").local);
+}
+
+TEST_F(DiskCacheTest, RejectedMissIsNotDownloaded) {
+    auto o = options();
+    o.admission = std::make_shared<RejectAll>();
+    DiskCache cache(client, o);
+    ASSERT_TRUE(fill(cache, "a"));
+    ASSERT_TRUE(fill(cache, "b"));
+
+    auto lookup = cache.get("c");
+    EXPECT_FALSE(lookup.local);
+    EXPECT_TRUE(lookup.head.object);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(s3.received("GET"), 2u);
+    EXPECT_TRUE(cache.get("a").local);
+    EXPECT_TRUE(cache.get("b").local);
+}
+
+// Loaded entries are revalidated on first use; files without metadata go
+TEST_F(DiskCacheTest, IndexIsRebuiltOnRestart) {
+    std::string path;
+    {
+        DiskCache cache(client, options());
+        auto local = fill(cache, "a");
+        ASSERT_TRUE(local);
+        path = local->path;
+    }
+    std::string orphan = fs::path(path).parent_path().string() + "/orphan";
+    std::ofstream(orphan) << "x";
+
+    DiskCache cache(client, options());
+    EXPECT_FALSE(fs::exists(orphan));
+    size_t heads = s3.received("HEAD");
+    auto lookup = cache.get("a");
+    ASSERT_TRUE(lookup.local);
+    EXPECT_EQ(lookup.local->path, path);
+    EXPECT_EQ(s3.received("HEAD"), heads + 1);
+    EXPECT_EQ(s3.received("GET"), 1u);
+}
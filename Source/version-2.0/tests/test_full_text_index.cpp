@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include "../src/infrastructure/search/FullTextIndex.h"
+#include <string>
+#include <vector>
+
+using Docs = std::vector<FullTextIndex::Document>;
+using Ids = std::vector<long>;
+
+static void load(FullTextIndex& index) {
+    index.rebuild(Docs{
+        {1, "Harry Potter and the Philosopher's Stone", "J.K. Rowling", "Book"},
+        {2, "Harry Potter and the Chamber of Secrets", "J.K. Rowling", "Book"},
+        {3, "Hamlet", "William Shakespeare", "Book"},
+        {4, "The Hobbit", "J.R.R. Tolkien", "Book"},
+        {5, "Dune", "Frank Herbert", "Book"},
+        {6, "National Geographic", "National Geographic Society", "Magazine"},
+        {7, "Potter's Wheel Monthly", "Harry Crafts", "Magazine"},
+    });
+}
+
+static Ids ids(const std::vector<nlohmann::json>& hits) {
+    Ids out;
+    for (const auto& h : hits) out.push_back(h["id"].get<long>());
+    return out;
+}
+
+TEST(FullTextIndexTest, TokenizesOnNonAlphanumerics) {
+    EXPECT_EQ(FullTextIndex::tokenize("Harry Potter: the J.K. Rowling's"),
+              (std::vector<std::string>{"harry", "potter", "the", "j", "k", "rowling", "s"}));
+    EXPECT_TRUE(FullTextIndex::tokenize(" -- ").empty());
+}
+
+TEST(FullTextIndexTest, RanksTitleMatchesAboveAuthorMatches) {
+    FullTextIndex index;
+    index.rebuild(Docs{
+        {1, "Gardens of Babylon", "Ann Smith", "Book"},
+        {2, "Rivers of Stone", "Ann Babylon", "Book"},
+        {3, "Winter Light", "Tom Reed", "Book"},
+    });
+    auto hits = index.search("babylon", "0", 0, 10);
+    ASSERT_EQ(ids(hits), (Ids{1, 2}));
+    EXPECT_GT(hits[0]["_score"].get<double>(), hits[1]["_score"].get<double>());
+}
+
+TEST(FullTextIndexTest, MoreMatchingTermsScoreHigher) {
+    FullTextIndex index;
+    load(index);
+    EXPECT_EQ(ids(index.search("chamber secrets potter", "0", 0, 1)), (Ids{2}));
+    EXPECT_EQ(ids(index.search("philosopher stone", "0", 0, 1)), (Ids{1}));
+}
+
+TEST(FullTextIndexTest, MatchesTyposWithinFuzziness) {
+    FullTextIndex index;
+    load(index);
+    EXPECT_EQ(ids(index.search("hobit", "AUTO", 0, 10)), (Ids{4}));
+    EXPECT_EQ(ids(index.search("shakespaere", "AUTO", 0, 10)), (Ids{3}));
+    // The first character is not fuzzy, and no edits are allowed at "0"
+    EXPECT_TRUE(index.search("jobbit", "AUTO", 0, 10).empty());
+    EXPECT_TRUE(index.search("hobit", "0", 0, 10).empty());
+}
+
+// With as many edits as the term has characters a match would count for
+// nothing; such documents are not hits, let alone repeated ones
+TEST(FullTextIndexTest, EditsAsLongAsTheTermMatchNothing) {
+    FullTextIndex index;
+    index.rebuild(Docs{
+        {1, "acd ace", "Ann Smith", "Book"},
+        {2, "abc", "Tom Reed", "Book"},
+    });
+    auto hits = index.search("ab", "2", 0, 10);
+    EXPECT_EQ(ids(hits), (Ids{2}));
+    for (const auto& h : hits) EXPECT_GT(h["_score"].get<double>(), 0.0);
+}
+
+TEST(FullTextIndexTest, CompletesTheLastTermAsAPrefix) {
+    FullTextIndex index;
+    load(index);
+    EXPECT_EQ(ids(index.search("tolk", "0", 0, 10)), (Ids{4}));
+    EXPECT_EQ(ids(index.search("national geo", "0", 0, 10)), (Ids{6}));
+}
+
+TEST(FullTextIndexTest, MatchesCategoryAsAWhole) {
+    FullTextIndex index;
+    load(index);
+    EXPECT_EQ(ids(index.search("magazine", "0", 0, 10)), (Ids{6, 7}));
+}
+
+TEST(FullTextIndexTest, PagesThroughResults) {
+    FullTextIndex index;
+    load(index);
+    auto all = ids(index.search("harry", "0", 0, 10));
+    EXPECT_EQ(ids(index.search("harry", "0", 1, 1)), (Ids{all[1]}));
+    EXPECT_TRUE(index.search("harry", "0", 5, 10).empty());
+}
+
+TEST(FullTextIndexTest, UpsertAndRemoveTakeEffect) {
+    FullTextIndex index;
+    load(index);
+    index.upsert({{5, "Dune Messiah", "Frank Herbert", "Book"}});
+    EXPECT_EQ(index.search("dune", "0", 0, 10)[0]["title"], "Dune Messiah");
+    EXPECT_EQ(index.documents(), 7u);
+
+    index.remove(4);
+    EXPECT_TRUE(index.search("hobbit", "AUTO", 0, 10).empty());
+    EXPECT_EQ(index.documents(), 6u);
+
+    index.upsert({{8, "The Hobbit", "J.R.R. Tolkien", "Book"}});
+    EXPECT_EQ(ids(index.search("hobbit", "AUTO", 0, 10)), (Ids{8}));
+}
+
+TEST(FullTextIndexTest, StaysConsistentAcrossCompaction) {
+    FullTextIndex index;
+    load(index);
+    for (int round = 0; round < 3; ++round)
+        for (long id = 100; id < 3100; ++id)
+            index.upsert({{id, "Filler " + std::to_string(id), "Nobody", "Book"}});
+    EXPECT_EQ(index.documents(), 3007u);
+    EXPECT_EQ(ids(index.search("hobbit", "0", 0, 10)), (Ids{4}));
+    EXPECT_EQ(ids(index.search("filler 2024", "0", 0, 1)), (Ids{2024}));
+}
+
+TEST(FullTextIndexTest, RebuildReplaysWritesMadeDuringTheLoad) {
+    FullTextIndex index;
+    index.beginRebuild();
+    index.upsert({{9, "Neuromancer", "William Gibson", "Book"}});
+    index.remove(3);
+    load(index);
+    EXPECT_EQ(ids(index.search("neuromancer", "0", 0, 10)), (Ids{9}));
+    EXPECT_TRUE(index.search("hamlet", "0", 0, 10).empty());
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "../src/infrastructure/db/PostgresPool.h"
+#include <pqxx/pqxx>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// Applies a file from db/migrations; every migration is idempotent, so
+// integration tests run it in SetUp instead of relying on a prepared DB
+inline void applyMigration(PostgresPool& pool, const std::string& file) {
+    std::ifstream in(std::string(TEST_SOURCE_DIR) + "/db/migrations/" + file);
+    if (!in) throw std::runtime_error("Missing migration " + file);
+    std::stringstream sql;
+    sql << in.rdbuf();
+
+    auto conn = pool.acquire();
+    pqxx::nontransaction txn(*conn);
+    txn.exec(sql.str());
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include "../src/utils/HttpRange.h"
+
+using Kind = RangeRequest::Kind;
+
+TEST(HttpRangeTest, ResolvesSingleRanges) {
+    auto r = parseRange("bytes=0-99", 1000);
+    EXPECT_EQ(r.kind, Kind::Partial);
+    EXPECT_EQ(r.range.first, 0u);
+    EXPECT_EQ(r.range.last, 99u);
+    EXPECT_EQ(r.range.length(), 100u);
+    EXPECT_EQ(r.range.contentRange(1000), "bytes 0-99/1000");
+
+    r = parseRange("bytes=900-", 1000);
+    EXPECT_EQ(r.kind, Kind::Partial);
+    EXPECT_EQ(r.range.last, 999u);
+
+    r = parseRange("bytes=500-5000", 1000);
+    EXPECT_EQ(r.range.last, 999u);
+
+    r = parseRange("bytes=-100", 1000);
+    EXPECT_EQ(r.kind, Kind::Partial);
+    EXPECT_EQ(r.range.first, 900u);
+    EXPECT_EQ(r.range.last, 999u);
+
+    r = parseRange("bytes=-5000", 1000);
+    EXPECT_EQ(r.range.first, 0u);
+}
+
+TEST(HttpRangeTest, ServesWholeObjectForUnsupportedHeaders) {
+    EXPECT_EQ(parseRange("", 1000).kind, Kind::Whole);
+    EXPECT_EQ(parseRange("items=0-5", 1000).kind, Kind::Whole);
+    EXPECT_EQ(parseRange("bytes=0-1,5-9", 1000).kind, Kind::Whole);
+    EXPECT_EQ(parseRange("bytes=9-1", 1000).kind, Kind::Whole);
+    EXPECT_EQ(parseRange("bytes=a-", 1000).kind, Kind::Whole);
+}
+
+TEST(HttpRangeTest, FlagsUnsatisfiableRanges) {
+    EXPECT_EQ(parseRange("bytes=1000-", 1000).kind, Kind::Unsatisfiable);
+    EXPECT_EQ(parseRange("bytes=-0", 1000).kind, Kind::Unsatisfiable);
+    EXPECT_EQ(parseRange("bytes=0-", 0).kind, Kind::Unsatisfiable);
+}
+
+TEST(HttpRangeTest, MatchesEntityTagsWeakly) {
+    EXPECT_TRUE(etagMatches("\"abc\"", "\"abc\""));
+    EXPECT_TRUE(etagMatches("W/\"abc\"", "\"abc\""));
+    EXPECT_TRUE(etagMatches("\"x\", \"abc\"", "\"abc\""));
+    EXPECT_TRUE(etagMatches("*", "\"abc\""));
+    EXPECT_FALSE(etagMatches("\"abd\"", "\"abc\""));
+    EXPECT_FALSE(etagMatches("", "\"abc\""));
+    EXPECT_FALSE(etagMatches("*", ""));
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include "FakeHttpServer.h"
+#include "../src/infrastructure/http/HttpTransport.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+HttpRequest get(const std::string& url) {
+    HttpRequest request;
+    request.url = url;
+    return request;
+}
+
+}
+
+// Many threads share one transport; every reply reaches its own caller and
+// connections are reused rather than opened per request
+TEST(HttpTransportTest, ConcurrentRequestsGetTheirOwnReplies) {
+    FakeHttpServer server([](const FakeHttpServer::Request& req) {
+        return FakeHttpServer::Response{200, "echo " + req.target, {}};
+    });
+    HttpTransport transport;
+
+    constexpr int kThreads = 8;
+    constexpr int kRequests = 50;
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> callers;
+    for (int t = 0; t < kThreads; ++t) {
+        callers.emplace_back([&, t] {
+            for (int i = 0; i < kRequests; ++i) {
+                std::string path = "/t" + std::to_string(t) + "/r" + std::to_string(i);
+                auto response = transport.perform(get(server.url() + path));
+                if (!response.ok() || response.body != "echo " + path) ++mismatches;
+            }
+        });
+    }
+    for (auto& c : callers) c.join();
+
+    EXPECT_EQ(mismatches.load(), 0);
+    EXPECT_EQ(server.requests(), static_cast<size_t>(kThreads * kRequests));
+    EXPECT_LE(server.connections(), static_cast<size_t>(kThreads));
+}
+
+// A released handle keeps its connection for the next caller
+TEST(HttpTransportTest, SequentialRequestsReuseOneConnection) {
+    FakeHttpServer server([](const FakeHttpServer::Request&) {
+        return FakeHttpServer::Response{200, "ok", {}};
+    });
+    HttpTransport transport;
+    for (int i = 0; i < 20; ++i) ASSERT_TRUE(transport.perform(get(server.url() + "/")).ok());
+    EXPECT_EQ(server.connections(), 1u);
+}
+
+TEST(HttpTransportTest, RequestsPerHostAreCapped) {
+    std::atomic<int> active{0};
+    std::atomic<int> peak{0};
+    FakeHttpServer server([&](const FakeHttpServer::Request&) {
+        int now = ++active;
+        int seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        --active;
+        return FakeHttpServer::Response{200, "ok", {}};
+    });
+    HttpTransport transport(HttpTransport::Options{2, std::chrono::milliseconds(5000)});
+
+    std::vector<std::thread> callers;
+    std::atomic<int> failures{0};
+    for (int t = 0; t < 6; ++t) {
+        callers.emplace_back([&] {
+            for (int i = 0; i < 5; ++i)
+                if (!transport.perform(get(server.url() + "/")).ok()) ++failures;
+        });
+    }
+    for (auto& c : callers) c.join();
+
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_LE(peak.load(), 2);
+    EXPECT_LE(server.connections(), 2u);
+}
+
+TEST(HttpTransportTest, WaitingForASlotTimesOut) {
+    std::atomic<bool> release{false};
+    FakeHttpServer server([&](const FakeHttpServer::Request&) {
+        while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return FakeHttpServer::Response{200, "ok", {}};
+    });
+    HttpTransport transport(HttpTransport::Options{1, std::chrono::milliseconds(50)});
+
+    std::thread holder([&] { transport.perform(get(server.url() + "/slow")); });
+    while (server.connections() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    auto response = transport.perform(get(server.url() + "/queued"));
+    EXPECT_EQ(response.curlCode, CURLE_OPERATION_TIMEDOUT);
+    release = true;
+    holder.join();
+}
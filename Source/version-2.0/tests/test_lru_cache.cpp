@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include "../src/utils/LruCache.h"
+#include <string>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST(LruCacheTest, ReturnsStoredValues) {
+    LruCache<int> cache(4, 1min);
+    cache.put("a", 1);
+    cache.put("b", 2);
+    EXPECT_EQ(cache.get("a"), 1);
+    EXPECT_EQ(cache.get("b"), 2);
+    EXPECT_FALSE(cache.get("c").has_value());
+}
+
+TEST(LruCacheTest, EvictsLeastRecentlyUsed) {
+    LruCache<int> cache(2, 1min);
+    cache.put("a", 1);
+    cache.put("b", 2);
+    ASSERT_TRUE(cache.get("a").has_value());   // b is now the oldest
+    cache.put("c", 3);
+
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_TRUE(cache.get("a").has_value());
+    EXPECT_FALSE(cache.get("b").has_value());
+    EXPECT_TRUE(cache.get("c").has_value());
+}
+
+TEST(LruCacheTest, PutReplacesExistingValue) {
+    LruCache<std::string> cache(2, 1min);
+    cache.put("a", "old");
+    cache.put("a", "new");
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_EQ(cache.get("a"), "new");
+}
+
+TEST(LruCacheTest, ExpiredEntriesAreDropped) {
+    LruCache<int> cache(4, 10ms);
+    cache.put("a", 1);
+    std::this_thread::sleep_for(20ms);
+    EXPECT_FALSE(cache.get("a").has_value());
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(LruCacheTest, EraseAndClear) {
+    LruCache<int> cache(4, 1min);
+    cache.put("a", 1);
+    cache.put("b", 2);
+    EXPECT_TRUE(cache.erase("a"));
+    EXPECT_FALSE(cache.erase("a"));
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_FALSE(cache.get("b").has_value());
+}
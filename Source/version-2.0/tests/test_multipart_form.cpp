@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include "../src/utils/MultipartForm.h"
+#include <string>
+
+TEST(MultipartFormTest, ReadsBoundaryFromContentType) {
+    EXPECT_EQ(multipartBoundary("multipart/form-data; boundary=XyZ"), "XyZ");
+    EXPECT_EQ(multipartBoundary("Multipart/Form-Data;boundary=\"a b\"; charset=utf-8"), "a b");
+    EXPECT_FALSE(multipartBoundary("application/json").has_value());
+    EXPECT_FALSE(multipartBoundary("multipart/form-data").has_value());
+}
+
+TEST(MultipartFormTest, SplitsFieldsAndFiles) {
+    std::string body =
+        "preamble\r\n"
+        "--XyZ\r\n"
+        "Content-Disposition: form-data; name=\"title\"\r\n"
+        "\r\n"
+        "Dune\r\n"
+        "--XyZ\r\n"
+        "content-disposition: form-data; name=\"file\"; filename=\"dune.pdf\"\r\n"
+        "Content-Type: application/pdf\r\n"
+        "\r\n"
+        "%PDF\r\n--X not a boundary\r\n"
+        "--XyZ--\r\n";
+    auto parts = parseMultipart(body, "XyZ");
+    ASSERT_TRUE(parts.has_value());
+    ASSERT_EQ(parts->size(), 2u);
+    EXPECT_EQ((*parts)[0].name, "title");
+    EXPECT_EQ((*parts)[0].body, "Dune");
+    EXPECT_EQ((*parts)[1].name, "file");
+    EXPECT_EQ((*parts)[1].filename, "dune.pdf");
+    EXPECT_EQ((*parts)[1].contentType, "application/pdf");
+    EXPECT_EQ((*parts)[1].body, "%PDF\r\n--X not a boundary");
+    // Views into the request body, not copies
+    EXPECT_GE((*parts)[1].body.data(), body.data());
+    EXPECT_LT((*parts)[1].body.data(), body.data() + body.size());
+}
+
+TEST(MultipartFormTest, RejectsTruncatedBodies) {
+    EXPECT_FALSE(parseMultipart("no boundary here", "XyZ").has_value());
+    EXPECT_FALSE(parseMultipart("--XyZ\r\nContent-Disposition: form-data; name=\"a\"\r\n\r\nvalue", "XyZ").has_value());
+    EXPECT_FALSE(parseMultipart("--XyZ\r\nContent-Disposition: form-data; name=\"a\"", "XyZ").has_value());
+}
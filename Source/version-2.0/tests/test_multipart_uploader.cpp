@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include "../src/infrastructure/storage/MultipartUploader.h"
+#include "../src/utils/Exceptions.h"
+#include "../src/utils/Hex.h"
+#include <openssl/sha.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t kPart = 5 * 1024 * 1024;
+
+// Stores parts in memory. A part can be made to fail a number of times;
+// every part attempt is logged and takes a few milliseconds, so attempts
+// of different parts overlap.
+class FakeMultipartStorage : public MultipartStorage {
+public:
+    void failPart(int partNumber, int times) {
+        std::scoped_lock lock(mtx_);
+        failures_[partNumber] = times;
+    }
+
+    bool uploadFile(const std::string& key, const std::string& data, const std::string&) override {
+        std::scoped_lock lock(mtx_);
+        ++singlePuts;
+        objects[key] = data;
+        return true;
+    }
+
+    std::optional<std::string> createMultipartUpload(const std::string&, const std::string&) override {
+        std::scoped_lock lock(mtx_);
+        ++created;
+        return "upload-1";
+    }
+
+    std::optional<std::string> uploadPart(const std::string&, const std::string&,
+                                          int partNumber, std::string_view data) override {
+        {
+            std::scoped_lock lock(mtx_);
+            attempts.push_back(partNumber);
+            peakInFlight = std::max(peakInFlight, ++inFlight_);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::scoped_lock lock(mtx_);
+        --inFlight_;
+        if (failures_[partNumber] > 0) {
+            --failures_[partNumber];
+            return std::nullopt;
+        }
+        parts_[partNumber] = std::string(data);
+        return "etag-" + std::to_string(partNumber);
+    }
+
+    bool completeMultipartUpload(const std::string& key, const std::string&,
+                                 const std::vector<std::string>& etags) override {
+        std::scoped_lock lock(mtx_);
+        std::string object;
+        for (size_t i = 0; i < etags.size(); ++i) {
+            int number = static_cast<int>(i) + 1;
+            if (etags[i] != "etag-" + std::to_string(number)) return false;
+            object += parts_[number];
+        }
+        objects[key] = std::move(object);
+        ++completed;
+        return true;
+    }
+
+    bool abortMultipartUpload(const std::string&, const std::string&) override {
+        std::scoped_lock lock(mtx_);
+        ++aborted;
+        return true;
+    }
+
+    size_t attemptsOf(int partNumber) {
+        std::scoped_lock lock(mtx_);
+        return static_cast<size_t>(std::count(attempts.begin(), attempts.end(), partNumber));
+    }
+
+    std::map<std::string, std::string> objects;
+    std::vector<int> attempts;
+    int singlePuts = 0;
+    int created = 0;
+    int completed = 0;
+    int aborted = 0;
+    int peakInFlight = 0;
+
+private:
+    std::mutex mtx_;
+    std::map<int, int> failures_;
+    std::map<int, std::string> parts_;
+    int inFlight_ = 0;
+};
+
+std::string data(size_t size) {
+    std::string out(size, '\0');
+    for (size_t i = 0; i < size; ++i) out[i] = static_cast<char>((i * 31 + i / 7) & 0xff);
+    return out;
+}
+
+std::string sha256(const std::string& data) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(data.data()), data.size(), digest);
+    return toHex(digest, sizeof(digest));
+}
+
+MultipartUploader::Options options() {
+    MultipartUploader::Options o;
+    o.partSize = kPart;
+    o.retryBackoff = std::chrono::milliseconds(10);
+    return o;
+}
+
+}
+
+TEST(MultipartUploaderTest, SourceSmallerThanAPartIsOnePut) {
+    auto storage = std::make_shared<FakeMultipartStorage>();
+    MultipartUploader uploader(storage, options());
+    auto file = data(kPart - 1);
+
+    auto result = uploader.upload("k", "application/pdf", MultipartUploader::fromBuffer(file));
+
+    EXPECT_EQ(storage->singlePuts, 1);
+    EXPECT_EQ(storage->created, 0);
+    EXPECT_EQ(result.parts, 1u);
+    EXPECT_EQ(storage->objects["k"], file);
+}
+
+TEST(MultipartUploaderTest, SourceOfExactlyOnePartIsMultipart) {
+    auto storage = std::make_shared<FakeMultipartStorage>();
+    MultipartUploader uploader(storage, options());
+    auto file = data(kPart);
+
+    auto result = uploader.upload("k", "application/pdf", MultipartUploader::fromBuffer(file));
+
+    EXPECT_EQ(storage->singlePuts, 0);
+    EXPECT_EQ(storage->completed, 1);
+    EXPECT_EQ(result.parts, 1u);
+}
+
+TEST(MultipartUploaderTest, ResultCoversTheWholeObject) {
+    auto storage = std::make_shared<FakeMultipartStorage>();
+    MultipartUploader uploader(storage, options());
+    auto file = data(3 * kPart + 12345);
+
+    auto result = uploader.upload("k", "video/mp4", MultipartUploader::fromBuffer(file));
+
+    EXPECT_EQ(result.parts, 4u);
+    EXPECT_EQ(result.size, file.size());
+    EXPECT_EQ(result.sha256, sha256(file));
+    EXPECT_EQ(storage->objects["k"], file);
+}
+
+TEST(MultipartUploaderTest, PartsInFlightAreCapped) {
+    auto storage = std::make_shared<FakeMultipartStorage>();
+    auto o = options();
+    o.partsInFlight = 2;
+    o.threads = 8;
+    MultipartUploader uploader(storage, o);
+    auto file = data(6 * kPart);
+
+    uploader.upload("k", "video/mp4", MultipartUploader::fromBuffer(file));
+
+    EXPECT_EQ(storage->peakInFlight, 2);
+    EXPECT_EQ(storage->completed, 1);
+}
+
+TEST(MultipartUploaderTest, FailedPartIsRetriedAlone) {
+    auto storage = std::make_shared<FakeMultipartStorage>();
+    storage->failPart(2, 2);
+    MultipartUploader uploader(storage, options());
+    auto file = data(3 * kPart);
+
+    uploader.upload("k", "video/mp4", MultipartUploader::fromBuffer(file));
+
+    EXPECT_EQ(storage->attemptsOf(1), 1u);
+    EXPECT_EQ(storage->attemptsOf(2), 3u);
+    EXPECT_EQ(storage->attemptsOf(3), 1u);
+    EXPECT_EQ(storage->aborted, 0);
+    EXPECT_EQ(storage->objects["k"], file);
+}
+
+TEST(MultipartUploaderTest, PartThatKeepsFailingAbortsTheUpload) {
+    auto storage = std::make_shared<FakeMultipartStorage>();
+    storage->failPart(2, 100);
+    auto o = options();
+    o.partRetries = 2;
+    MultipartUploader uploader(storage, o);
+    auto file = data(4 * kPart);
+
+    EXPECT_THROW(uploader.upload("k", "video/mp4", MultipartUploader::fromBuffer(file)), DatabaseException);
+
+    EXPECT_EQ(storage->attemptsOf(2), 3u);
+    EXPECT_EQ(storage->aborted, 1);
+    EXPECT_EQ(storage->completed, 0);
+    EXPECT_EQ(storage->objects.count("k"), 0u);
+}
+
+// With one pool thread, the next part is uploaded while the failed one
+// waits out its backoff
+TEST(MultipartUploaderTest, BackoffDoesNotHoldAPoolThread) {
+    auto storage = std::make_shared<FakeMultipartStorage>();
+    storage->failPart(1, 1);
+    auto o = options();
+    o.threads = 1;
+    o.partsInFlight = 2;
+    o.retryBackoff = std::chrono::milliseconds(300);
+    MultipartUploader uploader(storage, o);
+    auto file = data(2 * kPart);
+
+    uploader.upload("k", "video/mp4", MultipartUploader::fromBuffer(file));
+
+    EXPECT_EQ(storage->attempts, (std::vector<int>{1, 2, 1}));
+    EXPECT_EQ(storage->objects["k"], file);
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "FakeRedis.h"
+#include "../src/infrastructure/cache/NearCache.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace {
+
+const std::string kKey = "media:1";
+
+std::shared_ptr<RedisClient> connect(const FakeRedis& redis) {
+    RedisClient::Options options;
+    options.poolSize = 4;
+    options.acquireTimeout = std::chrono::milliseconds(1000);
+    return std::make_shared<RedisClient>("127.0.0.1", redis.port(), "", options);
+}
+
+bool waitFor(const std::function<bool()>& condition) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (condition()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+std::string title(const NearCache::Value& value) {
+    return value ? (*value)["title"].get<std::string>() : "<none>";
+}
+
+}
+
+class NearCacheTest : public ::testing::Test {
+protected:
+    FakeRedis redis;
+    std::shared_ptr<RedisClient> client = connect(redis);
+    NearCache cache{client, NearCache::Options{}};
+
+    void SetUp() override {
+        redis.put(kKey, R"({"title":"Dune"})");
+        cache.start();
+        ASSERT_TRUE(waitFor([&] { return cache.subscribed(); }));
+        // The whole pool plus the async and subscriber connections, so a
+        // write never waits behind a slow read for a connection
+        ASSERT_TRUE(waitFor([&] { return redis.openConnections() >= 6; }));
+    }
+};
+
+TEST_F(NearCacheTest, RepeatedReadsAreServedLocally) {
+    EXPECT_EQ(title(cache.get(kKey)), "Dune");
+    EXPECT_EQ(title(cache.get(kKey)), "Dune");
+    EXPECT_EQ(redis.received("GET"), 1u);
+}
+
+TEST_F(NearCacheTest, ReadsGoToRedisUntilSubscribed) {
+    NearCache unsubscribed(client, NearCache::Options{});
+    EXPECT_EQ(title(unsubscribed.get(kKey)), "Dune");
+    EXPECT_EQ(title(unsubscribed.get(kKey)), "Dune");
+    EXPECT_EQ(redis.received("GET"), 2u);
+}
+
+TEST_F(NearCacheTest, AnotherInstancesWriteDropsTheLocalCopy) {
+    ASSERT_EQ(title(cache.get(kKey)), "Dune");
+
+    NearCache other(connect(redis), NearCache::Options{});
+    other.put(kKey, {{"title", "Dune Messiah"}}, 60);
+    EXPECT_TRUE(waitFor([&] { return title(cache.get(kKey)) == "Dune Messiah"; }));
+}
+
+// The read fetched the old value before the delete; storing it locally
+// afterwards would serve a deleted value until the local TTL
+TEST_F(NearCacheTest, InvalidateDuringARedisReadIsNotUndone) {
+    redis.delayNextReply("GET", std::chrono::milliseconds(300));
+    NearCache::Value read;
+    std::thread reader([&] { read = cache.get(kKey); });
+    ASSERT_TRUE(waitFor([&] { return redis.received("GET") == 1; }));
+
+    cache.invalidate(kKey);
+    reader.join();
+
+    EXPECT_EQ(title(read), "Dune");
+    EXPECT_EQ(cache.get(kKey), nullptr);
+}
+
+TEST_F(NearCacheTest, PutDuringARedisReadIsNotUndone) {
+    redis.delayNextReply("GET", std::chrono::milliseconds(300));
+    std::thread reader([&] { cache.get(kKey); });
+    ASSERT_TRUE(waitFor([&] { return redis.received("GET") == 1; }));
+
+    cache.put(kKey, {{"title", "Dune Messiah"}}, 60);
+    reader.join();
+
+    EXPECT_EQ(title(cache.get(kKey)), "Dune Messiah");
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "FakeHttpServer.h"
+#include "../src/infrastructure/search/OpenSearchClient.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+// Answers every request with success and records it, in order, next to
+// the write listener's calls
+class RecordingOpenSearch {
+public:
+    RecordingOpenSearch()
+        : server_([this](const FakeHttpServer::Request& req) { return handle(req); }) {}
+
+    std::string url() const { return server_.url(); }
+
+    void note(const std::string& entry) {
+        std::scoped_lock lock(mtx_);
+        log_.push_back(entry);
+    }
+
+    std::vector<std::string> log() {
+        std::scoped_lock lock(mtx_);
+        return log_;
+    }
+
+private:
+    FakeHttpServer::Response handle(const FakeHttpServer::Request& req) {
+        note(req.method + " " + req.target);
+        // No reindex is running
+        if (req.target.find("media_shadow") != std::string::npos) return {404, "{}", {}};
+        if (req.target.rfind("/_bulk", 0) != 0) return {200, "{}", {}};
+
+        json items = json::array();
+        std::istringstream lines(req.body);
+        std::string action, source;
+        while (std::getline(lines, action) && std::getline(lines, source))
+            items.push_back({{"index", {{"status", 201}}}});
+        return {200, json{{"errors", false}, {"items", items}}.dump(), {}};
+    }
+
+    std::mutex mtx_;
+    std::vector<std::string> log_;
+    FakeHttpServer server_;
+};
+
+std::vector<std::string> withoutShadowLookups(const std::vector<std::string>& log) {
+    std::vector<std::string> out;
+    for (const auto& entry : log)
+        if (entry.find("media_shadow") == std::string::npos) out.push_back(entry);
+    return out;
+}
+
+}
+
+// Single writes do not wait for a refresh; caches are invalidated when the
+// write is acknowledged and again once the refresh interval has passed
+TEST(OpenSearchClientTest, SingleWritesNotifyAgainAfterTheRefreshInterval) {
+    RecordingOpenSearch fake;
+    OpenSearchClient client(fake.url());
+    client.setWriteListener([&] { fake.note("notify"); });
+
+    client.indexMedia(7, "Dune", "Herbert", "Book");
+    EXPECT_EQ(withoutShadowLookups(fake.log()), (std::vector<std::string>{"PUT /media/_doc/7", "notify"}));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1600));
+    EXPECT_EQ(withoutShadowLookups(fake.log()), (std::vector<std::string>{
+        "PUT /media/_doc/7", "notify", "notify"}));
+
+    client.deleteMedia(7);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1600));
+    EXPECT_EQ(withoutShadowLookups(fake.log()), (std::vector<std::string>{
+        "PUT /media/_doc/7", "notify", "notify",
+        "DELETE /media/_doc/7", "notify", "notify"}));
+}
+
+TEST(OpenSearchClientTest, BulkIndexRefreshesBeforeNotifying) {
+    RecordingOpenSearch fake;
+    OpenSearchClient client(fake.url());
+    client.setWriteListener([&] { fake.note("notify"); });
+
+    ASSERT_TRUE(client.bulkIndex({{{"id", 1}, {"title", "Dune"}}, {{"id", 2}, {"title", "Emma"}}}));
+
+    auto log = withoutShadowLookups(fake.log());
+    ASSERT_EQ(log.size(), 3u);
+    EXPECT_EQ(log[0].rfind("POST /_bulk", 0), 0u);
+    EXPECT_EQ(log[1], "POST /media/_refresh");
+    EXPECT_EQ(log[2], "notify");
+}
+
+TEST(OpenSearchClientTest, AliasSwapRefreshesTheNewIndexBeforeNotifying) {
+    RecordingOpenSearch fake;
+    OpenSearchClient client(fake.url());
+    client.setWriteListener([&] { fake.note("notify"); });
+
+    ASSERT_TRUE(client.swapAlias("media_v2", {{"media_v1"}, true}));
+
+    EXPECT_EQ(withoutShadowLookups(fake.log()), (std::vector<std::string>{
+        "POST /_aliases", "POST /media_v2/_refresh", "notify"}));
+}
+
+// Without a reindex, writes make one shadow lookup per refresh interval
+// and no shadow writes
+TEST(OpenSearchClientTest, ShadowAliasIsLookedUpOncePerInterval) {
+    RecordingOpenSearch fake;
+    OpenSearchClient client(fake.url());
+
+    client.indexMedia(7, "Dune", "Herbert", "Book");
+    client.indexMedia(8, "Emma", "Austen", "Book");
+    client.deleteMedia(7);
+    ASSERT_TRUE(client.bulkIndex({{{"id", 9}, {"title", "Ulysses"}}}));
+
+    auto log = fake.log();
+    auto shadow = log.size() - withoutShadowLookups(log).size();
+    EXPECT_EQ(shadow, 1u);
+    EXPECT_NE(std::find(log.begin(), log.end(), "GET /_alias/media_shadow"), log.end());
+}
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include "FakeRedis.h"
+#include "../src/infrastructure/cache/RedisClient.h"
+#include <chrono>
+#include <future>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace {
+
+const std::string kHost = "127.0.0.1";
+
+RedisClient::Options options() {
+    RedisClient::Options o;
+    o.poolSize = 1;
+    o.asyncConnections = 1;
+    o.acquireTimeout = std::chrono::milliseconds(1000);
+    return o;
+}
+
+}
+
+// The INCR may have run before the reply was lost; sending it again would
+// count it twice
+TEST(RedisClientTest, WriteWithALostReplyIsNotRetried) {
+    FakeRedis redis;
+    RedisClient client(kHost, redis.port(), "", options());
+
+    redis.loseNextReply("INCR");
+    EXPECT_FALSE(client.incr("counter").has_value());
+    EXPECT_EQ(redis.received("INCR"), 1u);
+    EXPECT_EQ(redis.value("counter"), "1");
+    EXPECT_EQ(client.incr("counter"), 2);
+}
+
+TEST(RedisClientTest, ReadWithALostReplyIsRetried) {
+    FakeRedis redis;
+    RedisClient client(kHost, redis.port(), "", options());
+    ASSERT_TRUE(client.set("key", "value"));
+
+    redis.loseNextReply("GET");
+    EXPECT_EQ(client.get("key"), "value");
+    EXPECT_EQ(redis.received("GET"), 2u);
+}
+
+// A connection the server closed while idle is replaced before anything is
+// sent on it, so even a write goes through once
+TEST(RedisClientTest, ConnectionClosedWhileIdleIsReplacedBeforeSending) {
+    FakeRedis redis;
+    RedisClient client(kHost, redis.port(), "", options());
+    ASSERT_TRUE(client.ping());
+
+    redis.closeConnections();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    EXPECT_EQ(client.incr("counter"), 1);
+    EXPECT_EQ(redis.received("INCR"), 1u);
+}
+
+// Issued before the async connection is up: waits for it instead of failing
+TEST(RedisClientTest, AsyncWriteAtStartupWaitsForTheConnection) {
+    FakeRedis redis("secret");
+    RedisClient client(kHost, redis.port(), "secret", options());
+
+    std::promise<bool> written;
+    client.setAsync("key", "value", 0, [&](bool ok) { written.set_value(ok); });
+    auto result = written.get_future();
+    ASSERT_EQ(result.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_TRUE(result.get());
+    EXPECT_EQ(redis.value("key"), "value");
+}
+
+// The connection is not used until AUTH succeeds
+TEST(RedisClientTest, AsyncCommandsAreNotSentWhenAuthFails) {
+    FakeRedis redis("secret");
+    auto o = options();
+    o.connectTimeout = std::chrono::milliseconds(300);
+    RedisClient client(kHost, redis.port(), "wrong", o);
+
+    std::promise<bool> failed;
+    client.commandAsync({"SET", "key", "value"}, [&](const redisReply* reply) {
+        failed.set_value(reply == nullptr);
+    });
+    auto result = failed.get_future();
+    ASSERT_EQ(result.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_TRUE(result.get());
+    EXPECT_GE(redis.received("AUTH"), 1u);
+    EXPECT_EQ(redis.received("SET"), 0u);
+}
+
+TEST(RedisClientTest, AsyncCommandsFailWhenRedisIsDown) {
+    int port;
+    {
+        FakeRedis gone;
+        port = gone.port();
+    }
+    auto o = options();
+    o.connectTimeout = std::chrono::milliseconds(200);
+    RedisClient client(kHost, port, "", o);
+
+    std::promise<void> done;
+    client.getAsync("key", [&](std::optional<std::string> value) {
+        EXPECT_FALSE(value.has_value());
+        done.set_value();
+    });
+    EXPECT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+}
+
+TEST(RedisClientTest, InvalidateTagDropsOnlyTheGroup) {
+    FakeRedis redis;
+    RedisClient client(kHost, redis.port(), "", options());
+    ASSERT_TRUE(client.setTagged("media:1", "a", 60, {"author:7"}));
+    ASSERT_TRUE(client.setTagged("media:2", "b", 60, {"author:7", "shelf:3"}));
+    ASSERT_TRUE(client.setTagged("media:3", "c", 60, {"shelf:3"}));
+    EXPECT_EQ(redis.members("tag:author:7"), (std::set<std::string>{"media:1", "media:2"}));
+
+    EXPECT_EQ(client.invalidateTag("author:7"), 2u);
+    EXPECT_FALSE(redis.value("media:1").has_value());
+    EXPECT_FALSE(redis.value("media:2").has_value());
+    EXPECT_EQ(redis.value("media:3"), "c");
+    EXPECT_TRUE(redis.members("tag:author:7").empty());
+    EXPECT_EQ(redis.keys(), 2u);   // media:3 and tag:shelf:3
+
+    EXPECT_EQ(client.invalidateTag("author:unknown"), 0u);
+}
+
+// The set outlives its longest-lived key and a shorter TTL never cuts it
+TEST(RedisClientTest, TagSetTtlFollowsTheLongestLivedKey) {
+    FakeRedis redis;
+    RedisClient client(kHost, redis.port(), "", options());
+    ASSERT_TRUE(client.setTagged("k1", "v", 10, {"t"}));
+    EXPECT_EQ(redis.ttl("tag:t"), 10);
+    ASSERT_TRUE(client.setTagged("k2", "v", 100, {"t"}));
+    EXPECT_EQ(redis.ttl("tag:t"), 100);
+    ASSERT_TRUE(client.setTagged("k3", "v", 5, {"t"}));
+    EXPECT_EQ(redis.ttl("tag:t"), 100);
+    ASSERT_TRUE(client.setTagged("k4", "v", 0, {"t"}));
+    EXPECT_EQ(redis.ttl("tag:t"), -1);
+}
+
+// Redis before 7.0 rejects EXPIRE NX/GT; the SET goes through but the
+// caller learns the tag is incomplete
+TEST(RedisClientTest, SetTaggedFailsWhenATagCommandFails) {
+    FakeRedis redis;
+    redis.rejectExpireOptions();
+    RedisClient client(kHost, redis.port(), "", options());
+    EXPECT_FALSE(client.setTagged("k", "v", 60, {"t"}));
+    EXPECT_EQ(redis.value("k"), "v");
+}
+
+// Several SCAN pages, each unlinked in the round trip of the next
+TEST(RedisClientTest, InvalidateByPrefixRemovesMatchingKeysAcrossPages) {
+    FakeRedis redis;
+    for (int i = 0; i < 2500; ++i) redis.put("search:" + std::to_string(i), "x");
+    redis.put("search*literal", "x");
+    redis.put("session:1", "x");
+    RedisClient client(kHost, redis.port(), "", options());
+
+    EXPECT_EQ(client.invalidateByPrefix("search:"), 2500u);
+    EXPECT_EQ(redis.keys(), 2u);
+    EXPECT_GE(redis.received("SCAN"), 3u);
+
+    // Glob characters in the prefix are literal
+    EXPECT_EQ(client.invalidateByPrefix("search*"), 1u);
+    EXPECT_EQ(redis.value("session:1"), "x");
+}
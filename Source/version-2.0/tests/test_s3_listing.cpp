@@ -0,0 +1,287 @@
+#include <gtest/gtest.h>
+#include "FakeHttpServer.h"
+#include "../src/infrastructure/storage/ListingPage.h"
+#include "../src/infrastructure/storage/S3StorageClient.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string contents(const std::string& key, size_t size) {
+    return "<Contents><Key>" + key + "</Key><Size>" + std::to_string(size)
+         + "</Size><ETag>&quot;e-" + key + "&quot;</ETag><LastModified>2024-01-01T00:00:00.000Z</LastModified></Contents>";
+}
+
+std::string version(const std::string& key, const std::string& id, bool latest) {
+    return "<Version><Key>" + key + "</Key><VersionId>" + id + "</VersionId><IsLatest>"
+         + (latest ? "true" : "false") + "</IsLatest><Size>10</Size><ETag>&quot;e&quot;</ETag></Version>";
+}
+
+std::string deleteMarker(const std::string& key, const std::string& id) {
+    return "<DeleteMarker><Key>" + key + "</Key><VersionId>" + id + "</VersionId><IsLatest>true</IsLatest></DeleteMarker>";
+}
+
+std::string listBucket(const std::string& body) {
+    return "<?xml version=\"1.0\" encoding=\"UTF-8\"?><ListBucketResult>" + body + "</ListBucketResult>";
+}
+
+std::string listVersions(const std::string& body) {
+    return "<?xml version=\"1.0\" encoding=\"UTF-8\"?><ListVersionsResult>" + body + "</ListVersionsResult>";
+}
+
+// Answers listings from a script keyed by the query's marker; every target
+// is recorded
+class FakeListing {
+public:
+    // Reply for requests whose target contains marker; "" matches any
+    void page(const std::string& marker, std::string body, int status = 200) {
+        pages_.push_back({marker, std::move(body), status});
+    }
+
+    std::vector<std::string> targets() {
+        std::scoped_lock lock(mtx_);
+        return targets_;
+    }
+
+    std::shared_ptr<S3StorageClient> client() {
+        return std::make_shared<S3StorageClient>(server_.url(), "key", "secret", "bucket");
+    }
+
+private:
+    struct Page {
+        std::string marker;
+        std::string body;
+        int status;
+    };
+
+    FakeHttpServer::Response handle(const FakeHttpServer::Request& req) {
+        {
+            std::scoped_lock lock(mtx_);
+            targets_.push_back(req.target);
+        }
+        // Later pages first, so the first page's empty marker is the fallback
+        for (auto it = pages_.rbegin(); it != pages_.rend(); ++it) {
+            if (it->marker.empty() || req.target.find(it->marker) != std::string::npos)
+                return {it->status, it->body, {{"Content-Type", "application/xml"}}};
+        }
+        return {404, "", {}};
+    }
+
+    std::vector<Page> pages_;
+    std::mutex mtx_;
+    std::vector<std::string> targets_;
+    FakeHttpServer server_{[this](const FakeHttpServer::Request& req) { return handle(req); }};
+};
+
+struct Collected {
+    std::vector<S3ObjectVersion> entries;
+    std::vector<std::string> prefixes;
+    S3StorageClient::VersionVisitor onEntry = [this](const S3ObjectVersion& e) {
+        entries.push_back(e);
+        return true;
+    };
+    S3StorageClient::PrefixVisitor onPrefix = [this](const std::string& p) {
+        prefixes.push_back(p);
+        return true;
+    };
+};
+
+}
+
+TEST(ListingPageTest, ParsesAReplyFedByteByByte) {
+    Collected seen;
+    ListingPage page(seen.onEntry, seen.onPrefix);
+    std::string xml = listBucket("<IsTruncated>true</IsTruncated>" + contents("a/1", 5) + contents("a/2", 7)
+                                 + "<CommonPrefixes><Prefix>a/sub/</Prefix></CommonPrefixes>"
+                                 + "<NextContinuationToken>tok/1+=</NextContinuationToken>");
+    for (char c : xml) ASSERT_TRUE(page.feed(std::string_view(&c, 1)));
+
+    EXPECT_TRUE(page.complete());
+    EXPECT_FALSE(page.stopped());
+    EXPECT_TRUE(page.truncated);
+    EXPECT_EQ(page.continuationToken, "tok/1+=");
+    ASSERT_EQ(seen.entries.size(), 2u);
+    EXPECT_EQ(seen.entries[0].object.key, "a/1");
+    EXPECT_EQ(seen.entries[0].object.size, 5u);
+    EXPECT_EQ(seen.entries[0].object.etag, "\"e-a/1\"");
+    EXPECT_EQ(seen.entries[1].object.lastModified, "2024-01-01T00:00:00.000Z");
+    EXPECT_EQ(seen.prefixes, std::vector<std::string>{"a/sub/"});
+}
+
+TEST(ListingPageTest, VersionsAndDeleteMarkers) {
+    Collected seen;
+    ListingPage page(seen.onEntry, seen.onPrefix);
+    ASSERT_TRUE(page.feed(listVersions(version("k", "v2", false) + deleteMarker("k", "v3")
+                                       + "<IsTruncated>false</IsTruncated>")));
+
+    EXPECT_TRUE(page.complete());
+    EXPECT_FALSE(page.truncated);
+    ASSERT_EQ(seen.entries.size(), 2u);
+    EXPECT_EQ(seen.entries[0].versionId, "v2");
+    EXPECT_FALSE(seen.entries[0].isLatest);
+    EXPECT_FALSE(seen.entries[0].deleteMarker);
+    EXPECT_TRUE(seen.entries[1].deleteMarker);
+    EXPECT_TRUE(seen.entries[1].isLatest);
+    EXPECT_EQ(seen.entries[1].object.size, 0u);
+}
+
+TEST(ListingPageTest, VisitorCanStopTheTransfer) {
+    int calls = 0;
+    S3StorageClient::VersionVisitor onEntry = [&calls](const S3ObjectVersion&) { return ++calls < 1; };
+    S3StorageClient::PrefixVisitor noPrefixes;
+    ListingPage page(onEntry, noPrefixes);
+
+    EXPECT_FALSE(page.feed(listBucket(contents("a", 1) + contents("b", 1))));
+    EXPECT_TRUE(page.stopped());
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(S3ListingTest, ObjectsAcrossPagesFollowTheContinuationToken) {
+    FakeListing s3;
+    s3.page("", listBucket("<IsTruncated>true</IsTruncated>" + contents("p/1", 1) + contents("p/2", 2)
+                           + "<NextContinuationToken>page 2</NextContinuationToken>"));
+    s3.page("continuation-token=page%202", listBucket("<IsTruncated>false</IsTruncated>" + contents("p/3", 3)));
+
+    std::vector<std::string> keys;
+    bool ok = s3.client()->forEachObject("p/", [&keys](const S3Object& o) {
+        keys.push_back(o.key);
+        return true;
+    }, "", nullptr, 2);
+
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(keys, (std::vector<std::string>{"p/1", "p/2", "p/3"}));
+    auto targets = s3.targets();
+    ASSERT_EQ(targets.size(), 2u);
+    EXPECT_EQ(targets[0], "/bucket/?list-type=2&max-keys=2&prefix=p%2F");
+    EXPECT_EQ(targets[1], "/bucket/?continuation-token=page%202&list-type=2&max-keys=2&prefix=p%2F");
+}
+
+TEST(S3ListingTest, DelimitedListingReportsCommonPrefixes) {
+    FakeListing s3;
+    s3.page("", listBucket("<IsTruncated>false</IsTruncated>" + contents("top", 1)
+                           + "<CommonPrefixes><Prefix>a/</Prefix></CommonPrefixes>"
+                           + "<CommonPrefixes><Prefix>b/</Prefix></CommonPrefixes>"));
+
+    std::vector<std::string> keys, prefixes;
+    bool ok = s3.client()->forEachObject("", [&keys](const S3Object& o) {
+        keys.push_back(o.key);
+        return true;
+    }, "/", [&prefixes](const std::string& p) {
+        prefixes.push_back(p);
+        return true;
+    });
+
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(keys, std::vector<std::string>{"top"});
+    EXPECT_EQ(prefixes, (std::vector<std::string>{"a/", "b/"}));
+    EXPECT_NE(s3.targets()[0].find("delimiter=%2F"), std::string::npos);
+}
+
+// Without a token the next request would fetch the first page again
+TEST(S3ListingTest, TruncatedPageWithoutATokenFails) {
+    FakeListing s3;
+    s3.page("", listBucket("<IsTruncated>true</IsTruncated>" + contents("p/1", 1)));
+
+    size_t seen = 0;
+    bool ok = s3.client()->forEachObject("p/", [&seen](const S3Object&) {
+        ++seen;
+        return true;
+    });
+
+    EXPECT_FALSE(ok);
+    EXPECT_EQ(seen, 1u);
+    EXPECT_EQ(s3.targets().size(), 1u);
+}
+
+TEST(S3ListingTest, VisitorStoppingEarlyIsNotAFailure) {
+    FakeListing s3;
+    s3.page("", listBucket("<IsTruncated>true</IsTruncated>" + contents("p/1", 1) + contents("p/2", 1)
+                           + "<NextContinuationToken>t</NextContinuationToken>"));
+
+    size_t seen = 0;
+    bool ok = s3.client()->forEachObject("p/", [&seen](const S3Object&) { return ++seen < 1; });
+
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(seen, 1u);
+    EXPECT_EQ(s3.targets().size(), 1u);
+}
+
+TEST(S3ListingTest, ErrorReplyOrCutOffXmlFails) {
+    FakeListing error;
+    error.page("", "<Error><Code>AccessDenied</Code></Error>", 403);
+    EXPECT_FALSE(error.client()->forEachObject("p/", [](const S3Object&) { return true; }));
+
+    FakeListing cutOff;
+    cutOff.page("", "<ListBucketResult><IsTruncated>false</IsTruncated>" + contents("p/1", 1));
+    EXPECT_FALSE(cutOff.client()->forEachObject("p/", [](const S3Object&) { return true; }));
+}
+
+TEST(S3ListingTest, ListObjectsStopsAtMaxKeys) {
+    FakeListing s3;
+    s3.page("", listBucket("<IsTruncated>true</IsTruncated>" + contents("p/1", 1) + contents("p/2", 1)
+                           + "<NextContinuationToken>t</NextContinuationToken>"));
+    s3.page("continuation-token=t", listBucket("<IsTruncated>false</IsTruncated>" + contents("p/3", 1)));
+
+    auto objects = s3.client()->listObjects("p/", 2);
+    ASSERT_TRUE(objects);
+    ASSERT_EQ(objects->size(), 2u);
+    EXPECT_EQ((*objects)[1].key, "p/2");
+    EXPECT_EQ(s3.targets().size(), 1u);
+}
+
+TEST(S3ListingTest, VersionsAcrossPagesFollowBothMarkers) {
+    FakeListing s3;
+    s3.page("", listVersions("<IsTruncated>true</IsTruncated>" + version("k", "v1", false)
+                             + "<NextKeyMarker>k</NextKeyMarker><NextVersionIdMarker>v1</NextVersionIdMarker>"));
+    s3.page("key-marker=k", listVersions("<IsTruncated>false</IsTruncated>" + version("k", "v2", true)
+                                         + deleteMarker("k2", "v3")));
+
+    std::vector<std::string> ids;
+    bool ok = s3.client()->forEachVersion("k", [&ids](const S3ObjectVersion& v) {
+        ids.push_back(v.versionId);
+        return true;
+    }, 1);
+
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(ids, (std::vector<std::string>{"v1", "v2", "v3"}));
+    auto targets = s3.targets();
+    ASSERT_EQ(targets.size(), 2u);
+    EXPECT_EQ(targets[0], "/bucket/?max-keys=1&prefix=k&versions=");
+    EXPECT_EQ(targets[1], "/bucket/?key-marker=k&max-keys=1&prefix=k&version-id-marker=v1&versions=");
+}
+
+TEST(S3ListingTest, TruncatedVersionPageWithoutAKeyMarkerFails) {
+    FakeListing s3;
+    s3.page("", listVersions("<IsTruncated>true</IsTruncated>" + version("k", "v1", true)));
+
+    EXPECT_FALSE(s3.client()->forEachVersion("k", [](const S3ObjectVersion&) { return true; }));
+    EXPECT_EQ(s3.targets().size(), 1u);
+    EXPECT_FALSE(s3.client()->listVersions("k").has_value());
+}
+
+TEST(S3ListingTest, VersionVisitorStoppingEarlyIsNotAFailure) {
+    FakeListing s3;
+    s3.page("", listVersions("<IsTruncated>true</IsTruncated>" + version("k", "v1", false) + version("k", "v2", true)
+                             + "<NextKeyMarker>k</NextKeyMarker><NextVersionIdMarker>v2</NextVersionIdMarker>"));
+
+    size_t seen = 0;
+    EXPECT_TRUE(s3.client()->forEachVersion("k", [&seen](const S3ObjectVersion&) { return ++seen < 1; }));
+    EXPECT_EQ(seen, 1u);
+    EXPECT_EQ(s3.targets().size(), 1u);
+}
+
+TEST(S3ListingTest, ListVersionsReportsDeleteMarkers) {
+    FakeListing s3;
+    s3.page("", listVersions("<IsTruncated>false</IsTruncated>" + version("k", "v1", false) + deleteMarker("k", "v2")));
+
+    auto versions = s3.client()->listVersions("k");
+    ASSERT_TRUE(versions);
+    ASSERT_EQ(versions->size(), 2u);
+    EXPECT_EQ((*versions)[0]["version_id"], "v1");
+    EXPECT_EQ((*versions)[0]["size"], 10);
+    EXPECT_FALSE((*versions)[0]["delete_marker"].get<bool>());
+    EXPECT_TRUE((*versions)[1]["delete_marker"].get<bool>());
+    EXPECT_TRUE((*versions)[1]["is_latest"].get<bool>());
+}
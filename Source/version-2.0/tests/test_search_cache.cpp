@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include "FakeRedis.h"
+#include "../src/infrastructure/cache/SearchCache.h"
+#include "../src/infrastructure/metrics/MetricsRegistry.h"
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace {
+
+const std::string kGenerationKey = "search:generation";
+
+// One async connection, so bumps published through it stay in order
+std::shared_ptr<RedisClient> connect(const FakeRedis& redis) {
+    RedisClient::Options options;
+    options.poolSize = 2;
+    options.asyncConnections = 1;
+    options.acquireTimeout = std::chrono::milliseconds(1000);
+    return std::make_shared<RedisClient>("127.0.0.1", redis.port(), "", options);
+}
+
+bool waitFor(const std::function<bool()>& condition) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (condition()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+SearchCache::Options options() {
+    SearchCache::Options o;
+    o.generationSync = std::chrono::milliseconds(200);
+    return o;
+}
+
+}
+
+class SearchCacheTest : public ::testing::Test {
+protected:
+    FakeRedis redis;
+    std::shared_ptr<RedisClient> client = connect(redis);
+    std::shared_ptr<RedisClient> publisher = connect(redis);
+    SearchCache cache{client, options()};
+
+    void SetUp() override {
+        cache.start();
+        ASSERT_TRUE(waitFor([&] { return cache.subscribed(); }));
+    }
+
+    // Announces bumps as other instances would, in order
+    void publish(std::initializer_list<std::string> messages) {
+        for (const auto& m : messages) publisher->commandAsync({"PUBLISH", kGenerationKey, m}, nullptr);
+    }
+};
+
+TEST_F(SearchCacheTest, PutIsServedFromBothTiers) {
+    uint64_t g = cache.generation();
+    cache.put("dune", g, {{"hits", 1}});
+
+    ASSERT_TRUE(cache.getLocal("dune", g));
+    EXPECT_EQ((*cache.getLocal("dune", g))["hits"], 1);
+    ASSERT_TRUE(waitFor([&] { return redis.value("search:" + std::to_string(g) + ":dune").has_value(); }));
+
+    // Another instance finds it in Redis
+    SearchCache other(connect(redis), options());
+    auto shared = other.getShared("dune", g);
+    ASSERT_TRUE(shared);
+    EXPECT_EQ((*shared)["hits"], 1);
+    EXPECT_TRUE(other.getLocal("dune", g));
+}
+
+// A result computed before a write must not be cached under either generation
+TEST_F(SearchCacheTest, PutWithAStaleGenerationIsDropped) {
+    uint64_t before = cache.generation();
+    cache.bumpGeneration();
+    uint64_t after = cache.generation();
+    ASSERT_GT(after, before);
+
+    cache.put("dune", before, {{"hits", 1}});
+    EXPECT_FALSE(cache.getLocal("dune", before));
+    EXPECT_FALSE(cache.getLocal("dune", after));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(redis.value("search:" + std::to_string(before) + ":dune"));
+}
+
+TEST_F(SearchCacheTest, BumpInvalidatesEveryInstance) {
+    SearchCache other(connect(redis), options());
+    other.start();
+    ASSERT_TRUE(waitFor([&] { return other.subscribed(); }));
+
+    uint64_t g = cache.generation();
+    cache.put("dune", g, {{"hits", 1}});
+    other.bumpGeneration();
+
+    ASSERT_TRUE(waitFor([&] { return cache.generation() == other.generation(); }));
+    EXPECT_GT(cache.generation(), g);
+    EXPECT_FALSE(cache.getLocal("dune", g));
+}
+
+// Bumps from different instances can arrive out of order; an older one
+// neither moves the generation back nor clears the local tier
+TEST_F(SearchCacheTest, AnnouncedBumpsOnlyMoveForward) {
+    publish({"5"});
+    ASSERT_TRUE(waitFor([&] { return cache.generation() == 5u; }));
+    Counter& invalidations = MetricsRegistry::instance().counter(
+        "search_cache_invalidations_total", "Index generation changes");
+    double before = invalidations.value();
+
+    // Handled in order, so once 6 is in the others have been seen
+    publish({"3", "5", "not a number", "6"});
+    ASSERT_TRUE(waitFor([&] { return cache.generation() == 6u; }));
+    EXPECT_EQ(invalidations.value() - before, 1.0);
+}
+
+// Bumps made while the subscription was down were not announced; the
+// value in Redis is taken on resubscribe, even a lower one after a reset
+TEST_F(SearchCacheTest, LostSubscriptionResyncsFromRedis) {
+    publish({"5"});
+    ASSERT_TRUE(waitFor([&] { return cache.generation() == 5u; }));
+
+    redis.put(kGenerationKey, "9");
+    redis.closeConnections();
+    EXPECT_TRUE(waitFor([&] { return cache.generation() == 9u; }));
+
+    redis.put(kGenerationKey, "2");
+    redis.closeConnections();
+    EXPECT_TRUE(waitFor([&] { return cache.generation() == 2u; }));
+    EXPECT_TRUE(waitFor([&] { return cache.subscribed(); }));
+}
+
+// Without a subscription the generation is re-read in the background, at
+// most once per generationSync
+TEST_F(SearchCacheTest, UnsubscribedCacheRereadsTheGenerationPeriodically) {
+    SearchCache unsubscribed(client, options());
+    redis.put(kGenerationKey, "4");
+    EXPECT_TRUE(waitFor([&] { return unsubscribed.generation() == 4u; }));
+
+    size_t gets = redis.received("GET");
+    for (int i = 0; i < 100; ++i) unsubscribed.generation();
+    EXPECT_LE(redis.received("GET"), gets + 1);
+
+    redis.put(kGenerationKey, "7");
+    EXPECT_TRUE(waitFor([&] { return unsubscribed.generation() == 7u; }));
+}
+
+// With Redis down a bump still invalidates this instance
+TEST(SearchCacheLocalTest, BumpWithoutRedisInvalidatesLocally) {
+    SearchCache cache(nullptr, options());
+    uint64_t g = cache.generation();
+    cache.put("dune", g, {{"hits", 1}});
+    ASSERT_TRUE(cache.getLocal("dune", g));
+
+    cache.bumpGeneration();
+    EXPECT_EQ(cache.generation(), g + 1);
+    EXPECT_FALSE(cache.getLocal("dune", g));
+    EXPECT_FALSE(cache.getShared("dune", g + 1));
+}
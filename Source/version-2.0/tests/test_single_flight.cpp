@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include "../src/utils/SingleFlight.h"
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(SingleFlightTest, FirstCallerLeadsAndOthersJoin) {
+    SingleFlight<int> flights;
+    std::vector<int> seen;
+    auto record = [&](const int& v, std::exception_ptr) { seen.push_back(v); };
+
+    EXPECT_TRUE(flights.join("q", record));
+    EXPECT_FALSE(flights.join("q", record));
+    EXPECT_FALSE(flights.join("q", record));
+    EXPECT_TRUE(flights.join("other", record));
+    EXPECT_EQ(flights.inFlight(), 2u);
+
+    EXPECT_EQ(flights.complete("q", 7), 3u);
+    EXPECT_EQ(seen, (std::vector<int>{7, 7, 7}));
+    EXPECT_EQ(flights.inFlight(), 1u);
+}
+
+TEST(SingleFlightTest, CompletedKeyStartsNewFlight) {
+    SingleFlight<int> flights;
+    auto ignore = [](const int&, std::exception_ptr) {};
+    EXPECT_TRUE(flights.join("q", ignore));
+    flights.complete("q", 1);
+    EXPECT_TRUE(flights.join("q", ignore));
+    EXPECT_EQ(flights.complete("missing", 1), 0u);
+}
+
+TEST(SingleFlightTest, ErrorReachesEveryWaiter) {
+    SingleFlight<std::string> flights;
+    int errors = 0;
+    auto check = [&](const std::string&, std::exception_ptr e) {
+        try {
+            if (e) std::rethrow_exception(e);
+        } catch (const std::runtime_error&) {
+            ++errors;
+        }
+    };
+    flights.join("q", check);
+    flights.join("q", check);
+    flights.complete("q", "", std::make_exception_ptr(std::runtime_error("upstream down")));
+    EXPECT_EQ(errors, 2);
+}
+
+TEST(SingleFlightTest, ConcurrentBurstMakesOneCall) {
+    SingleFlight<int> flights;
+    std::atomic<int> leaders{0};
+    std::atomic<int> delivered{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 16; ++i) {
+        threads.emplace_back([&] {
+            if (flights.join("q", [&](const int&, std::exception_ptr) { ++delivered; }))
+                ++leaders;
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    EXPECT_EQ(leaders.load(), 1);
+    EXPECT_EQ(flights.complete("q", 42), 16u);
+    EXPECT_EQ(delivered.load(), 16);
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include "../src/utils/ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(ThreadPoolTest, ReturnsTaskResults) {
+    ThreadPool pool(4);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; ++i)
+        results.push_back(pool.submit([i] { return i * i; }));
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(results[i].get(), i * i);
+}
+
+TEST(ThreadPoolTest, ZeroThreadsMeansOne) {
+    ThreadPool pool(0);
+    EXPECT_EQ(pool.size(), 1u);
+    EXPECT_EQ(pool.submit([] { return 7; }).get(), 7);
+}
+
+// An exception thrown by a task reaches the caller through its future
+TEST(ThreadPoolTest, PropagatesExceptions) {
+    ThreadPool pool(2);
+    auto failed = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+    EXPECT_EQ(pool.submit([] { return 1; }).get(), 1);
+}
+
+TEST(ThreadPoolTest, RunsTasksConcurrently) {
+    ThreadPool pool(4);
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    std::vector<std::future<void>> done;
+    for (int i = 0; i < 8; ++i) {
+        done.push_back(pool.submit([&] {
+            int now = ++running;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            --running;
+        }));
+    }
+    for (auto& f : done) f.get();
+    EXPECT_GT(peak.load(), 1);
+    EXPECT_LE(peak.load(), 4);
+}
+
+// The destructor lets running tasks finish and drops the queued ones
+TEST(ThreadPoolTest, DestructorDropsQueuedTasks) {
+    std::atomic<int> ran{0};
+    std::promise<void> release;
+    auto gate = release.get_future().share();
+    std::future<void> running;
+    std::future<void> queued;
+    std::thread releaser;
+    {
+        ThreadPool pool(1);
+        std::promise<void> started;
+        running = pool.submit([&ran, &started, gate] { started.set_value(); gate.wait(); ++ran; });
+        started.get_future().wait();
+        queued = pool.submit([&ran] { ++ran; });
+        EXPECT_EQ(pool.queued(), 1u);
+        // Let the running task finish only once the destructor is waiting on it
+        releaser = std::thread([&release] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            release.set_value();
+        });
+    }
+    releaser.join();
+    running.get();
+    EXPECT_EQ(ran.load(), 1);
+    EXPECT_THROW(queued.get(), std::future_error);
+}
@@ -0,0 +1,35 @@
+#include <gtest/gtest.h>
+#include "../src/utils/TinyLfu.h"
+
+TEST(TinyLfuTest, EstimatesFrequency) {
+    TinyLfu sketch(1000);
+    for (int i = 0; i < 5; ++i) sketch.increment(42);
+    sketch.increment(7);
+    EXPECT_EQ(sketch.estimate(42), 5u);
+    EXPECT_EQ(sketch.estimate(7), 1u);
+    EXPECT_EQ(sketch.estimate(99), 0u);
+}
+
+TEST(TinyLfuTest, SaturatesAtFifteen) {
+    TinyLfu sketch(1000);
+    for (int i = 0; i < 40; ++i) sketch.increment(1);
+    EXPECT_EQ(sketch.estimate(1), 15u);
+}
+
+TEST(TinyLfuTest, AdmitsOnlyMoreFrequentCandidates) {
+    TinyLfu sketch(1000);
+    for (int i = 0; i < 3; ++i) sketch.increment(1);
+    sketch.increment(2);
+    EXPECT_TRUE(sketch.admit(1, 2));
+    EXPECT_FALSE(sketch.admit(2, 1));
+    // A tie keeps the resident item
+    EXPECT_FALSE(sketch.admit(3, 4));
+}
+
+TEST(TinyLfuTest, AgesCountsAfterSampleSize) {
+    TinyLfu sketch(100);
+    for (int i = 0; i < 8; ++i) sketch.increment(1);
+    for (uint64_t k = 1000; k < 1092; ++k) sketch.increment(k);
+    // 100 additions reached: every counter was halved once
+    EXPECT_EQ(sketch.estimate(1), 4u);
+}
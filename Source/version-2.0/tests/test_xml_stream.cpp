@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "../src/utils/XmlStream.h"
+#include <string>
+#include <vector>
+
+namespace {
+
+// Records closing tags as "depth:name=text"
+struct Recorder {
+    std::vector<std::string> events;
+    XmlStream parser{nullptr, [this](std::string_view name, std::string_view text) {
+        events.push_back(std::to_string(parser.depth()) + ":" + std::string(name) + "=" + std::string(text));
+    }};
+};
+
+const std::string kListing =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<ListBucketResult xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">"
+    "<Name>media</Name><IsTruncated>true</IsTruncated>"
+    "<Contents><Key>digital-media/1/v1.pdf</Key><Size>1024</Size>"
+    "<ETag>&quot;9b2cf535f27731c974343645a3985328&quot;</ETag></Contents>"
+    "<NextContinuationToken>1ueGcxLPRx1Tr/XYExHnhbYLgveDs2J/wm36Hy4vbOwM=</NextContinuationToken>"
+    "</ListBucketResult>\n";
+
+}
+
+TEST(XmlStreamTest, ReportsLeafValuesWithDepth) {
+    Recorder r;
+    ASSERT_TRUE(r.parser.feed(kListing));
+    EXPECT_TRUE(r.parser.complete());
+    ASSERT_EQ(r.events.size(), 8u);
+    EXPECT_EQ(r.events[0], "2:Name=media");
+    EXPECT_EQ(r.events[2], "3:Key=digital-media/1/v1.pdf");
+    EXPECT_EQ(r.events[4], "3:ETag=\"9b2cf535f27731c974343645a3985328\"");
+    EXPECT_EQ(r.events[6], "2:NextContinuationToken=1ueGcxLPRx1Tr/XYExHnhbYLgveDs2J/wm36Hy4vbOwM=");
+}
+
+TEST(XmlStreamTest, SameEventsForEveryChunking) {
+    Recorder whole;
+    ASSERT_TRUE(whole.parser.feed(kListing));
+
+    for (size_t chunk = 1; chunk < 40; ++chunk) {
+        Recorder split;
+        for (size_t i = 0; i < kListing.size(); i += chunk)
+            ASSERT_TRUE(split.parser.feed(std::string_view(kListing).substr(i, chunk)));
+        EXPECT_TRUE(split.parser.complete()) << "chunk " << chunk;
+        EXPECT_EQ(split.events, whole.events) << "chunk " << chunk;
+    }
+}
+
+TEST(XmlStreamTest, DecodesEntitiesAndCdata) {
+    Recorder r;
+    ASSERT_TRUE(r.parser.feed("<a><k>x &amp; y &lt;&#233;&#x4E2D;&gt;</k><c><![CDATA[<raw & kept>]]></c><e/></a>"));
+    EXPECT_TRUE(r.parser.complete());
+    ASSERT_EQ(r.events.size(), 4u);
+    EXPECT_EQ(r.events[0], "2:k=x & y <\xC3\xA9\xE4\xB8\xAD>");
+    EXPECT_EQ(r.events[1], "2:c=<raw & kept>");
+    EXPECT_EQ(r.events[2], "2:e=");
+}
+
+TEST(XmlStreamTest, RejectsMalformedInput) {
+    Recorder mismatched;
+    EXPECT_FALSE(mismatched.parser.feed("<a><b>1</c></a>"));
+
+    Recorder badEntity;
+    EXPECT_FALSE(badEntity.parser.feed("<a>&bogus;</a>"));
+
+    Recorder twoRoots;
+    EXPECT_FALSE(twoRoots.parser.feed("<a/><b/>"));
+
+    Recorder truncated;
+    EXPECT_TRUE(truncated.parser.feed("<a><b>1</b"));
+    EXPECT_FALSE(truncated.parser.complete());
+}